@@ -20,7 +20,6 @@
 #endif
 
 #include <WiFi.h>
-#include <WebServer.h>
 #include <ArduinoJson.h>
 // ESP32 3.2.0 compatibility for filesystem
 #if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
@@ -34,6 +33,9 @@
 #include "port_scanner.h"
 #include "web_interface.h"
 #include "wifi_manager.h"
+#include "scan_task.h"
+#include "net_utils.h"
+#include "service_catalog.h"
 
 // Network configuration
 bool eth_connected = false;
@@ -137,6 +139,11 @@ void setup() {
   scanner.begin();
   portScanner.begin();
   
+  // Scans run on their own task so a slow sweep never blocks the web server
+  if (!scanTask.begin(&scanner, &portScanner)) {
+    Serial.println("Scan task unavailable - scans are disabled");
+  }
+  
   // Initialize web interface
   webInterface.begin();
   
@@ -145,6 +152,8 @@ void setup() {
   Serial.printf("- Scan timeout: %d ms\n", SCAN_TIMEOUT);
   Serial.printf("- Port timeout: %d ms\n", PORT_TIMEOUT);
   Serial.printf("- Max concurrent scans: %d\n", MAX_CONCURRENT_SCANS);
+  Serial.printf("- Probe pacing: %d/s, %d per host, %d ms host gap\n",
+                PACER_PROBES_PER_SECOND, PACER_HOST_CONCURRENCY, PACER_HOST_GAP);
   Serial.printf("- WiFi backup: %s\n", WIFI_BACKUP_ENABLED ? "Enabled" : "Disabled");
   Serial.println();
   
@@ -182,13 +191,11 @@ void loop() {
   wifiManager.handleCaptivePortal();
   wifiManager.checkEthernetAndSwitch();
   
-  // Handle web interface requests
-  webInterface.handleClient();
+  // Collect results from the scan task
+  serviceScanTask();
   
-  // Handle web-initiated scans
-  if (webInterface.isScanRunning()) {
-    performWebScan();
-  }
+  // Apply WiFi settings and run scans the web pages asked for
+  webInterface.serviceWiFi();
   
   // Check for serial commands
   if (Serial.available()) {
@@ -200,10 +207,32 @@ void loop() {
   delay(50);
 }
 
+ScanJob* newSerialJob(ScanJobKind kind) {
+  ScanJob* job = new ScanJob();
+  job->source = SCAN_SOURCE_SERIAL;
+  job->kind = kind;
+  job->pacing.probesPerSecond = PACER_PROBES_PER_SECOND;
+  job->pacing.hostConcurrency = PACER_HOST_CONCURRENCY;
+  job->pacing.hostGap = PACER_HOST_GAP;
+  job->scanMethod = PORT_SCAN_CONNECT;
+  return job;
+}
+
+// Ping and port commands share the scanners with sweeps, so they run on
+// the scan task too, after whatever job is ahead of them
+void submitProbeJob(ScanJob* job) {
+  bool queuedBehind = scanTask.isBusy();
+  if (scanTask.submit(job) == 0) {
+    Serial.println("Scan queue is full, try again later.");
+    delete job;
+    return;
+  }
+  if (queuedBehind) {
+    Serial.println("Queued; runs when the current scan finishes.");
+  }
+}
+
 void performNetworkScan() {
-  Serial.println("Starting network discovery...");
-  Serial.println("=============================");
-  
   IPAddress localIP = ETH.localIP();
   IPAddress subnet = ETH.subnetMask();
   
@@ -215,118 +244,145 @@ void performNetworkScan() {
     localIP[3] & subnet[3]
   );
   
-  Serial.printf("Local IP: %s\n", localIP.toString().c_str());
-  Serial.printf("Network: %s\n", networkAddr.toString().c_str());
-  Serial.printf("Subnet: %s\n", subnet.toString().c_str());
-  Serial.println();
-  
-  // Scan for active devices
-  std::vector<IPAddress> activeDevices = scanner.scanNetwork(networkAddr, subnet);
-  
-  if (activeDevices.empty()) {
-    Serial.println("No devices found on the network.");
+  ScanJob* job = newSerialJob(SCAN_JOB_SWEEP);
+  const ScanProfile& profile = defaultScanProfile();
+  job->ports.assign(profile.tcpPorts, profile.tcpPorts + profile.tcpCount);
+  job->udpPorts.assign(profile.udpPorts, profile.udpPorts + profile.udpCount);
+  job->modbusUnits.assign(std::begin(MODBUS_UNIT_IDS), std::end(MODBUS_UNIT_IDS));
+  job->enipDiscovery = true;
+  if (!job->targets.addCidr(networkAddr, __builtin_popcount(ipToHost(subnet)))) {
+    Serial.println("Cannot scan network: " + job->targets.getLastError());
+    delete job;
     return;
   }
   
-  Serial.printf("Found %d active devices:\n", activeDevices.size());
-  Serial.println();
-  
-  // Test ports for each device
-  for (const auto& device : activeDevices) {
-    Serial.printf("Scanning device: %s\n", device.toString().c_str());
-    Serial.println("  Port  Service      Status");
-    Serial.println("  ----  -----------  ------");
-    
-    // Test each target port
-    for (int port : TARGET_PORTS) {
-      String serviceName = getServiceName(port);
-      bool isOpen = portScanner.testPort(device, port);
-      
-      Serial.printf("  %-4d  %-11s  %s\n", 
-                   port, 
-                   serviceName.c_str(), 
-                   isOpen ? "OPEN" : "CLOSED");
-    }
-    
-    Serial.println();
+  // The task owns the job once it is queued
+  uint32_t hostCount = job->targets.getTargetCount();
+  uint32_t jobId = scanTask.submit(job);
+  if (jobId == 0) {
+    Serial.println("Scan queue is full, try again later.");
+    delete job;
+    return;
   }
   
-  Serial.println("Network scan completed.");
-  Serial.println("=======================");
+  Serial.println("Starting network discovery...");
+  Serial.println("=============================");
+  Serial.printf("Local IP: %s\n", localIP.toString().c_str());
+  Serial.printf("Network: %s\n", networkAddr.toString().c_str());
+  Serial.printf("Subnet: %s\n", subnet.toString().c_str());
+  Serial.printf("Scan job %u queued (%u hosts)\n", jobId, hostCount);
   Serial.println();
 }
 
-void performWebScan() {
+void serviceScanTask() {
   static unsigned long lastUpdate = 0;
-  static int currentIP = 0;
-  static bool scanInitialized = false;
-  
-  ScanConfig config = webInterface.getScanConfig();
   
-  if (!scanInitialized) {
-    Serial.println("Starting web-initiated scan...");
-    webInterface.setScanStatus("Initializing scan...");
-    webInterface.clearScanResults();
-    currentIP = (uint32_t)config.startIP;
-    scanInitialized = true;
-    lastUpdate = millis();
-    return;
+  // Bounded per pass so a burst of results cannot starve the serial console
+  ScanEvent event;
+  for (int i = 0; i < SCAN_RESULT_QUEUE_DEPTH && scanTask.nextEvent(event); i++) {
+    if (event.source == SCAN_SOURCE_WEB) {
+      webInterface.handleScanEvent(event);
+    } else {
+      printScanEvent(event);
+    }
+    scanTask.finishEvent(event);
   }
   
   // Update progress periodically
   if (millis() - lastUpdate > 100) {
-    uint32_t startIP = (uint32_t)config.startIP;
-    uint32_t endIP = (uint32_t)config.endIP;
-    uint32_t totalIPs = endIP - startIP + 1;
-    uint32_t currentProgress = currentIP - startIP;
-    
-    int progress = (currentProgress * 100) / totalIPs;
-    webInterface.setScanProgress(progress);
-    webInterface.setScanStatus("Scanning " + IPAddress(currentIP).toString() + "...");
-    
+    webInterface.updateScanProgress();
     lastUpdate = millis();
   }
-  
-  // Scan current IP
-  IPAddress targetIP = IPAddress(currentIP);
-  
-  if (scanner.pingDevice(targetIP)) {
-    Serial.printf("Found device: %s\n", targetIP.toString().c_str());
-    
-    // Create scan result
-    ScanResult result;
-    result.deviceIP = targetIP;
-    result.hostname = "Unknown";
-    result.timestamp = millis();
-    
-    unsigned long scanStart = millis();
-    
-    // Test each target port
-    for (int port : config.targetPorts) {
-      bool isOpen = portScanner.testPort(targetIP, port);
-      if (isOpen) {
-        result.openPorts.push_back(port);
-      } else {
-        result.closedPorts.push_back(port);
-      }
+}
+
+void printScanEvent(const ScanEvent& event) {
+  if (event.type == SCAN_EVENT_PROBE) {
+    String target = IPAddress(event.target).toString();
+    if (event.kind == SCAN_JOB_PING) {
+      Serial.printf("Ping %s: %s\n", target.c_str(), event.alive ? "Success" : "Failed");
+    } else {
+      Serial.printf("%s port %u (%s) on %s: %s\n",
+                   event.kind == SCAN_JOB_UDP_PORT ? "UDP" : "TCP",
+                   event.port,
+                   serviceName(event.port),
+                   target.c_str(),
+                   portStateName(event.state));
     }
-    
-    result.responseTime = millis() - scanStart;
-    result.status = "Complete";
-    
-    webInterface.addScanResult(result);
+    return;
   }
   
-  currentIP++;
+  if (event.type == SCAN_EVENT_DONE) {
+    Serial.printf("Swept %u hosts in %lu ms (%.1f hosts/s, %s), %u alive\n",
+                 event.progress.total, event.progress.elapsed, event.progress.hostsPerSecond,
+                 event.progress.usesArp ? "ARP" : "TCP connect", event.progress.alive);
+    if (event.progress.unprobed > 0) {
+      Serial.printf("%u hosts left unprobed (no free socket)\n", event.progress.unprobed);
+    }
+    Serial.println(event.cancelled ? "Network scan cancelled." : "Network scan completed.");
+    Serial.println("=======================");
+    Serial.println();
+    return;
+  }
   
-  // Check if scan is complete
-  if (currentIP > (uint32_t)config.endIP) {
-    webInterface.setScanStatus("Scan completed - found " + String(webInterface.getScanResults().size()) + " devices");
-    webInterface.setScanProgress(100);
-    webInterface.stopScan();
-    scanInitialized = false;
-    Serial.println("Web scan completed.");
+  const ScanResult& result = *event.result;
+  if (result.hasMac) {
+    Serial.printf("Device: %s [%s]\n", result.address().toString().c_str(), result.macText().c_str());
+  } else {
+    Serial.printf("Device: %s\n", result.address().toString().c_str());
+  }
+  Serial.println("  Port  Service      Status");
+  Serial.println("  ----  -----------  ------");
+  
+  // TCP states first, then UDP; each port under its own state
+  const struct {
+    bool udp;
+    PortState state;
+  } listings[] = {
+    {false, PORT_OPEN}, {false, PORT_CLOSED}, {false, PORT_FILTERED}, {false, PORT_UNREACHABLE},
+    {true, PORT_OPEN}, {true, PORT_CLOSED}, {true, PORT_OPEN_FILTERED}, {true, PORT_FILTERED}
+  };
+  for (const auto& listing : listings) {
+    size_t cursor = 0;
+    uint16_t port;
+    while (result.nextPort(cursor, listing.udp, listing.state, port)) {
+      Serial.printf("  %-4u  %-11s  %s%s\n", port, serviceName(port),
+                    listing.udp ? "UDP " : "", portStateName(listing.state));
+    }
+  }
+  for (uint8_t i = 0; i < result.fingerprintCount; i++) {
+    const ResultFingerprint& fingerprint = result.fingerprints[i];
+    Serial.printf("  %-4u  %-11s  %s\n", fingerprint.port, fingerprintName(fingerprint.id),
+                  stringPool.get(fingerprint.detail));
   }
+  for (const BacnetDevice& device : result.bacnetDevices) {
+    Serial.printf("  BACnet device %u: vendor %u, max APDU %u", device.instance, device.vendorId, device.maxApdu);
+    if (device.network != 0) {
+      Serial.printf(", network %u", device.network);
+    }
+    Serial.println();
+    if (device.objectName.length() > 0 || device.vendorName.length() > 0) {
+      Serial.printf("    %s: %s %s, firmware %s\n", device.objectName.c_str(), device.vendorName.c_str(),
+                    device.modelName.c_str(), device.firmwareRevision.c_str());
+    }
+  }
+  for (const EnipIdentity& identity : result.enipIdentities) {
+    Serial.printf("  EtherNet/IP: \"%s\" vendor %u, type %u, product %u, rev %u.%u, serial %08X\n",
+                  identity.productName.c_str(), identity.vendorId, identity.deviceType, identity.productCode,
+                  identity.revisionMajor, identity.revisionMinor, (unsigned)identity.serialNumber);
+  }
+  if (result.modbus.status != MODBUS_NOT_PROBED) {
+    Serial.printf("  Modbus: %s\n", modbusStatusName(result.modbus.status));
+  }
+  for (const ModbusUnit& unit : result.modbus.units) {
+    if (unit.exceptionCode != 0) {
+      Serial.printf("    Unit %u: exception %u\n", unit.unitId, unit.exceptionCode);
+    } else {
+      Serial.printf("    Unit %u: %s %s %s\n", unit.unitId, unit.vendorName.c_str(),
+                    unit.productCode.c_str(), unit.revision.c_str());
+    }
+  }
+  
+  Serial.println();
 }
 
 void handleSerialCommand(String command) {
@@ -352,7 +408,7 @@ void handleSerialCommand(String command) {
   } else if (command.startsWith("ping ")) {
     String ip = command.substring(5);
     pingDevice(ip);
-  } else if (command.startsWith("port ")) {
+  } else if (command.startsWith("port ") || command.startsWith("syn ") || command.startsWith("udp ")) {
     handlePortCommand(command);
   } else {
     Serial.println("Unknown command. Type 'help' for available commands.");
@@ -398,6 +454,8 @@ void printHelp() {
   Serial.println("  scan              - Perform network scan");
   Serial.println("  ping <ip>         - Ping specific IP address");
   Serial.println("  port <ip> <port>  - Test specific port on IP");
+  Serial.println("  syn <ip> <port>   - Test port half-open (SYN only)");
+  Serial.println("  udp <ip> <port>   - Test UDP port (reply or ICMP unreachable)");
   Serial.println();
   Serial.println("System Status:");
   Serial.println("  status            - Show full system status");
@@ -421,17 +479,20 @@ void pingDevice(String ipStr) {
     return;
   }
   
-  bool result = scanner.pingDevice(ip);
-  Serial.printf("Ping %s: %s\n", ipStr.c_str(), result ? "Success" : "Failed");
+  ScanJob* job = newSerialJob(SCAN_JOB_PING);
+  job->probeTarget = ip;
+  submitProbeJob(job);
 }
 
 void handlePortCommand(String command) {
-  // Parse "port <ip> <port>"
+  // Parse "port <ip> <port>", "syn <ip> <port>" or "udp <ip> <port>"
+  bool halfOpen = command.startsWith("syn ");
+  bool udp = command.startsWith("udp ");
   int firstSpace = command.indexOf(' ');
   int secondSpace = command.indexOf(' ', firstSpace + 1);
   
   if (firstSpace == -1 || secondSpace == -1) {
-    Serial.println("Usage: port <ip> <port>");
+    Serial.printf("Usage: %s <ip> <port>\n", command.substring(0, firstSpace).c_str());
     return;
   }
   
@@ -450,14 +511,13 @@ void handlePortCommand(String command) {
     return;
   }
   
-  bool isOpen = portScanner.testPort(ip, port);
-  String serviceName = getServiceName(port);
-  
-  Serial.printf("Port %d (%s) on %s: %s\n", 
-               port, 
-               serviceName.c_str(), 
-               ipStr.c_str(), 
-               isOpen ? "OPEN" : "CLOSED");
+  ScanJob* job = newSerialJob(udp ? SCAN_JOB_UDP_PORT : SCAN_JOB_TCP_PORT);
+  job->probeTarget = ip;
+  job->probePort = port;
+  if (halfOpen) {
+    job->scanMethod = PORT_SCAN_SYN;
+  }
+  submitProbeJob(job);
 }
 
 void printWiFiStatus() {
@@ -553,13 +613,3 @@ void toggleWiFiBackup() {
     Serial.println("WiFi backup mode enabled");
   }
 }
-
-String getServiceName(int port) {
-  switch (port) {
-    case 80: return "HTTP";
-    case 443: return "HTTPS";
-    case 502: return "MODBUS TCP";
-    case 47808: return "BACnet";
-    default: return "Unknown";
-  }
-}
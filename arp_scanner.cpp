@@ -0,0 +1,387 @@
+/*
+ * ARP Scanner Implementation
+ * On-link host discovery using lwIP ARP requests and the ARP table
+ */
+
+#include "arp_scanner.h"
+#include "net_utils.h"
+#include "probe_pacer.h"
+#include <ETH.h>
+#include <lwip/etharp.h>
+#include <lwip/netif.h>
+#include <lwip/priv/tcpip_priv.h>
+
+// Replies land in the lwIP ARP table, which evicts its oldest entry when
+// full, so a burst never asks for more hosts than the table can hold
+static const uint32_t ARP_BATCH_SIZE = (ARP_TABLE_SIZE < ARP_BATCH_LIMIT) ? ARP_TABLE_SIZE : ARP_BATCH_LIMIT;
+
+struct ArpTableEntry {
+    uint32_t ip;               // Network order, as stored by lwIP
+    uint8_t mac[6];
+};
+
+// Message passed into the tcpip thread; the call header must come first
+struct ArpApiCall {
+    struct tcpip_api_call_data call;
+    uint32_t targets[ARP_BATCH_SIZE];
+    size_t targetCount;
+    ArpTableEntry entries[ARP_TABLE_SIZE];
+    size_t entryCount;
+    uint32_t stale;            // Bit per target whose cached entry stayed
+    bool onLink;
+};
+
+static struct netif* findLinkNetif(uint32_t addr) {
+    for (struct netif* netif = netif_list; netif != nullptr; netif = netif->next) {
+        if (!netif_is_up(netif) || !netif_is_link_up(netif) ||
+            !(netif->flags & NETIF_FLAG_ETHARP)) {
+            continue;
+        }
+
+        uint32_t mask = netif_ip4_netmask(netif)->addr;
+        if ((netif_ip4_addr(netif)->addr & mask) == (addr & mask)) {
+            return netif;
+        }
+    }
+    return nullptr;
+}
+
+static err_t arpSendRequests(struct tcpip_api_call_data* data) {
+    ArpApiCall* msg = (ArpApiCall*)data;
+
+    for (size_t i = 0; i < msg->targetCount; i++) {
+        struct netif* netif = findLinkNetif(msg->targets[i]);
+        if (netif) {
+            ip4_addr_t addr;
+            addr.addr = msg->targets[i];
+            etharp_request(netif, &addr);
+        }
+    }
+    return ERR_OK;
+}
+
+// An entry cached before the request (lwIP keeps them for ARP_MAXAGE)
+// says nothing about the host now, and lwIP does not expose when an entry
+// was last refreshed. So the entries of the targets are removed before
+// asking: a dynamic entry can only be removed by turning it static first.
+// Without static entry support the cached ones are flagged instead
+static err_t arpForgetEntries(struct tcpip_api_call_data* data) {
+    ArpApiCall* msg = (ArpApiCall*)data;
+    msg->stale = 0;
+
+    for (size_t i = 0; i < msg->targetCount; i++) {
+        ip4_addr_t addr;
+        addr.addr = msg->targets[i];
+        struct eth_addr* eth = nullptr;
+        const ip4_addr_t* ip = nullptr;
+
+        if (etharp_find_addr(nullptr, &addr, &eth, &ip) < 0) {
+            continue;
+        }
+
+        #if ETHARP_SUPPORT_STATIC_ENTRIES
+        struct eth_addr mac = *eth;
+        if (etharp_add_static_entry(&addr, &mac) == ERR_OK &&
+            etharp_remove_static_entry(&addr) == ERR_OK) {
+            continue;
+        }
+        #endif
+        msg->stale |= 1UL << i;
+    }
+    return ERR_OK;
+}
+
+static err_t arpReadTable(struct tcpip_api_call_data* data) {
+    ArpApiCall* msg = (ArpApiCall*)data;
+    msg->entryCount = 0;
+
+    for (size_t i = 0; i < ARP_TABLE_SIZE; i++) {
+        ip4_addr_t* ip = nullptr;
+        struct netif* netif = nullptr;
+        struct eth_addr* eth = nullptr;
+
+        if (etharp_get_entry(i, &ip, &netif, &eth) == 1) {
+            ArpTableEntry& entry = msg->entries[msg->entryCount++];
+            entry.ip = ip->addr;
+            memcpy(entry.mac, eth->addr, sizeof(entry.mac));
+        }
+    }
+    return ERR_OK;
+}
+
+static err_t arpCheckOnLink(struct tcpip_api_call_data* data) {
+    ArpApiCall* msg = (ArpApiCall*)data;
+    msg->onLink = findLinkNetif(msg->targets[0]) != nullptr;
+    return ERR_OK;
+}
+
+ArpScanner::ArpScanner() {
+    running = false;
+    batchActive = false;
+    targets = nullptr;
+    exhausted = true;
+    hasPending = false;
+    batchLength = 0;
+    batchResolved = 0;
+    batchStale = 0;
+    batchAttempts = 0;
+    batchSentTime = 0;
+    batchDeadline = 0;
+    total = 0;
+    completed = 0;
+    aliveCount = 0;
+    startTime = 0;
+    endTime = 0;
+}
+
+void ArpScanner::start(TargetIterator* targetList) {
+    stop();
+
+    targets = targetList;
+    total = targets ? targets->getTargetCount() : 0;
+    exhausted = total == 0;
+    hasPending = false;
+    completed = 0;
+    aliveCount = 0;
+    startTime = millis();
+    endTime = startTime;
+    running = total > 0;
+
+    #if DEBUG_NETWORK
+    Serial.printf("ARP sweep started: %u hosts, %u per burst\n", total, ARP_BATCH_SIZE);
+    #endif
+}
+
+bool ArpScanner::poll(ArpCallback callback, unsigned long waitMs) {
+    if (!running) {
+        return false;
+    }
+
+    if (!batchActive) {
+        batchLength = 0;
+        batchResolved = 0;
+        batchStale = 0;
+        batchAttempts = 0;
+
+        unsigned long pacerWait = 0;
+        while (batchLength < ARP_BATCH_SIZE) {
+            IPAddress ip = pendingHost;
+            if (!hasPending) {
+                if (exhausted || !targets->next(ip)) {
+                    exhausted = true;
+                    break;
+                }
+                if (!shouldProbe(ip)) {
+                    completed++;
+                    continue;
+                }
+            }
+
+            // Each host costs one token; the re-send within the window rides
+            // on it. Nothing stays in flight, so the host is released at once
+            if (!probePacer.tryAcquire(ip, &pacerWait)) {
+                pendingHost = ip;
+                hasPending = true;
+                break;
+            }
+            probePacer.release(ip);
+            hasPending = false;
+            batchHosts[batchLength++] = (uint32_t)ip;
+        }
+
+        if (batchLength == 0 && hasPending) {
+            delay(pacerWait < waitMs ? (pacerWait > 0 ? pacerWait : 1) : waitMs);
+            return true;
+        }
+
+        if (batchLength == 0) {
+            running = false;
+            endTime = millis();
+
+            #if DEBUG_NETWORK
+            Serial.printf("ARP sweep finished: %u hosts in %lu ms (%.1f hosts/s), %u alive\n",
+                          total, getElapsed(), getHostsPerSecond(), aliveCount);
+            #endif
+            return false;
+        }
+
+        batchActive = true;
+        forgetCached();
+        batchSentTime = millis();
+        batchDeadline = batchSentTime + ARP_REPLY_WINDOW;
+        sendBatch();
+        return true;
+    }
+
+    delay(waitMs);
+    harvestBatch(callback);
+
+    uint32_t batchMask = (batchLength >= 32) ? 0xFFFFFFFFUL : ((1UL << batchLength) - 1);
+    unsigned long now = millis();
+
+    if ((batchResolved & batchMask) == batchMask ||
+        (long)(now - batchDeadline) >= 0) {
+        finishBatch(callback);
+    } else if (batchAttempts < ARP_REQUEST_ATTEMPTS &&
+               now - batchSentTime >= (unsigned long)(ARP_REPLY_WINDOW / ARP_REQUEST_ATTEMPTS) * batchAttempts) {
+        // Re-ask silent hosts once partway through the window
+        sendBatch();
+    }
+
+    return true;
+}
+
+void ArpScanner::stop() {
+    if (running) {
+        endTime = millis();
+    }
+    running = false;
+    batchActive = false;
+}
+
+bool ArpScanner::probe(IPAddress target, uint8_t* mac) {
+    ArpApiCall msg;
+    msg.targets[0] = (uint32_t)target;
+    msg.targetCount = 1;
+
+    tcpip_api_call(arpForgetEntries, &msg.call);
+    if (msg.stale) {
+        // Only the stale cache would answer
+        return false;
+    }
+
+    unsigned long deadline = millis() + ARP_REPLY_WINDOW;
+    tcpip_api_call(arpSendRequests, &msg.call);
+
+    while ((long)(millis() - deadline) < 0) {
+        delay(SWEEP_POLL_INTERVAL);
+        tcpip_api_call(arpReadTable, &msg.call);
+
+        for (size_t i = 0; i < msg.entryCount; i++) {
+            if (msg.entries[i].ip == (uint32_t)target) {
+                if (mac) {
+                    memcpy(mac, msg.entries[i].mac, 6);
+                }
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool ArpScanner::isOnLink(IPAddress target) {
+    ArpApiCall msg;
+    msg.targets[0] = (uint32_t)target;
+    msg.targetCount = 1;
+    msg.onLink = false;
+    tcpip_api_call(arpCheckOnLink, &msg.call);
+    return msg.onLink;
+}
+
+bool ArpScanner::isRunning() {
+    return running;
+}
+
+uint32_t ArpScanner::getTotal() {
+    return total;
+}
+
+uint32_t ArpScanner::getCompleted() {
+    return completed;
+}
+
+uint32_t ArpScanner::getAliveCount() {
+    return aliveCount;
+}
+
+unsigned long ArpScanner::getElapsed() {
+    return (running ? millis() : endTime) - startTime;
+}
+
+float ArpScanner::getHostsPerSecond() {
+    unsigned long elapsed = getElapsed();
+    if (elapsed == 0) {
+        return 0.0f;
+    }
+    return (completed * 1000.0f) / elapsed;
+}
+
+void ArpScanner::forgetCached() {
+    ArpApiCall msg;
+    memcpy(msg.targets, batchHosts, batchLength * sizeof(batchHosts[0]));
+    msg.targetCount = batchLength;
+    tcpip_api_call(arpForgetEntries, &msg.call);
+    batchStale = msg.stale;
+}
+
+void ArpScanner::sendBatch() {
+    ArpApiCall msg;
+    msg.targetCount = 0;
+
+    for (uint32_t i = 0; i < batchLength; i++) {
+        if (!(batchResolved & (1UL << i))) {
+            msg.targets[msg.targetCount++] = batchHosts[i];
+        }
+    }
+
+    if (msg.targetCount > 0) {
+        tcpip_api_call(arpSendRequests, &msg.call);
+    }
+    batchAttempts++;
+}
+
+void ArpScanner::harvestBatch(ArpCallback& callback) {
+    ArpApiCall msg;
+    tcpip_api_call(arpReadTable, &msg.call);
+
+    unsigned long responseTime = millis() - batchSentTime;
+
+    for (size_t i = 0; i < msg.entryCount; i++) {
+        for (uint32_t slot = 0; slot < batchLength; slot++) {
+            uint32_t bit = 1UL << slot;
+            if (batchHosts[slot] != msg.entries[i].ip || (batchResolved & bit)) {
+                continue;
+            }
+
+            // Still the entry from before the burst, which says nothing
+            // about the host now
+            if (batchStale & bit) {
+                break;
+            }
+
+            batchResolved |= bit;
+            completed++;
+            aliveCount++;
+
+            if (callback) {
+                callback(IPAddress(batchHosts[slot]), msg.entries[i].mac, responseTime);
+            }
+            break;
+        }
+    }
+}
+
+void ArpScanner::finishBatch(ArpCallback& callback) {
+    for (uint32_t i = 0; i < batchLength; i++) {
+        if (batchResolved & (1UL << i)) {
+            continue;
+        }
+
+        completed++;
+        if (callback) {
+            callback(IPAddress(batchHosts[i]), nullptr, ARP_REPLY_WINDOW);
+        }
+    }
+
+    batchActive = false;
+}
+
+bool ArpScanner::shouldProbe(IPAddress ip) {
+    uint8_t first = ip[0];
+    if (first == 0 || first == 127 || first >= 224) {
+        return false;
+    }
+
+    return ip != ETH.localIP();
+}
@@ -0,0 +1,86 @@
+/*
+ * ARP Scanner Header
+ * On-link host discovery using lwIP ARP requests and the ARP table
+ */
+
+#ifndef ARP_SCANNER_H
+#define ARP_SCANNER_H
+
+#include <Arduino.h>
+#include <functional>
+#include <IPAddress.h>
+#include "config.h"
+#include "target_iterator.h"
+
+// Upper bound on hosts per ARP burst (also limited by lwIP's ARP_TABLE_SIZE)
+#define ARP_BATCH_LIMIT 32
+
+// Called once per host; mac is nullptr when the host did not answer
+typedef std::function<void(IPAddress host, const uint8_t* mac, unsigned long responseTime)> ArpCallback;
+
+class ArpScanner {
+public:
+    ArpScanner();
+
+    // Start resolving the targets in ARP-table sized bursts
+    // (the iterator must outlive the scan)
+    void start(TargetIterator* targets);
+
+    // Advance the current burst and report resolved/silent hosts
+    bool poll(ArpCallback callback, unsigned long waitMs = SWEEP_POLL_INTERVAL);
+
+    // Abort the scan
+    void stop();
+
+    // Resolve a single host, blocking for at most ARP_REPLY_WINDOW
+    bool probe(IPAddress target, uint8_t* mac);
+
+    // Check whether an address is on the same link as one of our interfaces
+    bool isOnLink(IPAddress target);
+
+    // Progress and throughput
+    bool isRunning();
+    uint32_t getTotal();
+    uint32_t getCompleted();
+    uint32_t getAliveCount();
+    unsigned long getElapsed();
+    float getHostsPerSecond();
+
+private:
+    bool running;
+    bool batchActive;
+    TargetIterator* targets;
+    bool exhausted;
+    bool hasPending;
+    IPAddress pendingHost;      // Drawn from the iterator but held back by the pacer
+    uint32_t batchHosts[ARP_BATCH_LIMIT];   // Network order, as lwIP stores them
+    uint32_t batchLength;
+    uint32_t batchResolved;     // Bit per host in the current burst
+    uint32_t batchStale;        // Cached before the burst and could not be dropped
+    int batchAttempts;
+    unsigned long batchSentTime;
+    unsigned long batchDeadline;
+    uint32_t total;
+    uint32_t completed;
+    uint32_t aliveCount;
+    unsigned long startTime;
+    unsigned long endTime;
+
+    // Drop the ARP entries lwIP already holds for the current burst, so
+    // only a reply to it can count a host as alive
+    void forgetCached();
+
+    // Send ARP requests for every unresolved host of the current burst
+    void sendBatch();
+
+    // Read the ARP table and report hosts of the current burst
+    void harvestBatch(ArpCallback& callback);
+
+    // Report the rest of the burst as silent and move on
+    void finishBatch(ArpCallback& callback);
+
+    // Check if an address should be probed at all
+    bool shouldProbe(IPAddress ip);
+};
+
+#endif // ARP_SCANNER_H
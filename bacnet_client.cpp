@@ -0,0 +1,491 @@
+/*
+ * BACnet Client Implementation
+ * Reads Device object properties from many BACnet devices at once
+ */
+
+#include "bacnet_client.h"
+#include "probe_pacer.h"
+#include <lwip/sockets.h>
+
+#define SERVICE_READ_PROPERTY 0x0C
+#define SERVICE_READ_PROPERTY_MULTIPLE 0x0E
+
+// Max segments unspecified, max APDU 1476; the whole reply has to fit in
+// one frame since segmented ACKs are not reassembled
+#define APDU_MAX_ACCEPTED 0x05
+
+// Property identifiers in BacnetReadProperty order
+static const uint8_t PROPERTY_IDS[BACNET_READ_COUNT] = {
+    77,     // object-name
+    70,     // model-name
+    121,    // vendor-name
+    44      // firmware-revision
+};
+
+static int propertyIndex(uint32_t propertyId) {
+    for (int i = 0; i < BACNET_READ_COUNT; i++) {
+        if (PROPERTY_IDS[i] == propertyId) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static size_t putObjectId(uint8_t* buffer, uint8_t contextTag, uint32_t instance) {
+    uint32_t objectId = ((uint32_t)BACNET_OBJECT_DEVICE << 22) | (instance & 0x3FFFFF);
+    buffer[0] = (contextTag << 4) | 0x08 | 4;
+    buffer[1] = (uint8_t)(objectId >> 24);
+    buffer[2] = (uint8_t)(objectId >> 16);
+    buffer[3] = (uint8_t)(objectId >> 8);
+    buffer[4] = (uint8_t)objectId;
+    return 5;
+}
+
+// Read the first value inside an opening tag into the reply, then skip
+// to the matching closing tag
+static bool readPropertyValue(const uint8_t* data, size_t length, size_t& pos,
+                              const BacnetTag& opening, int index, BacnetReply& reply) {
+    size_t valuePos = pos;
+    BacnetTag value;
+    if (index >= 0 && bacnetReadTag(data, length, valuePos, value) && !value.context &&
+        value.number == BACNET_TAG_CHARACTER_STRING &&
+        bacnetReadString(data, valuePos, value, reply.values[index], BACNET_STRING_LENGTH)) {
+        reply.found |= 1 << index;
+    }
+    return bacnetSkipValue(data, length, pos, opening);
+}
+
+// ReadPropertyMultiple-ACK: object id, then per property its id, an
+// optional array index and either a value or an error
+static bool parseMultipleAck(const uint8_t* data, size_t length, size_t pos, BacnetReply& reply) {
+    BacnetTag tag;
+    while (pos < length) {
+        if (!bacnetReadTag(data, length, pos, tag) || !tag.context || tag.number != 0) {
+            return false;
+        }
+        pos += tag.length;
+        if (!bacnetReadTag(data, length, pos, tag) || !tag.opening || tag.number != 1) {
+            return false;
+        }
+
+        for (;;) {
+            if (!bacnetReadTag(data, length, pos, tag)) {
+                return false;
+            }
+            if (tag.closing && tag.number == 1) {
+                break;
+            }
+
+            uint32_t propertyId;
+            if (!tag.context || tag.number != 2 || !bacnetReadUnsigned(data, pos, tag, propertyId)) {
+                return false;
+            }
+            if (!bacnetReadTag(data, length, pos, tag)) {
+                return false;
+            }
+            if (tag.context && tag.number == 3 && !tag.opening) {
+                pos += tag.length;
+                if (!bacnetReadTag(data, length, pos, tag)) {
+                    return false;
+                }
+            }
+
+            int index = propertyIndex(propertyId);
+            if (tag.opening && tag.number == 4) {
+                if (!readPropertyValue(data, length, pos, tag, index, reply)) {
+                    return false;
+                }
+            } else if (tag.opening && tag.number == 5) {
+                if (index >= 0) {
+                    reply.failed |= 1 << index;
+                }
+                if (!bacnetSkipValue(data, length, pos, tag)) {
+                    return false;
+                }
+            } else {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// ReadProperty-ACK: object id, property id, optional array index, value
+static bool parseSingleAck(const uint8_t* data, size_t length, size_t pos, BacnetReply& reply) {
+    BacnetTag tag;
+    uint32_t propertyId;
+    if (!bacnetReadTag(data, length, pos, tag) || !tag.context || tag.number != 0) {
+        return false;
+    }
+    pos += tag.length;
+    if (!bacnetReadTag(data, length, pos, tag) || !tag.context || tag.number != 1 ||
+        !bacnetReadUnsigned(data, pos, tag, propertyId)) {
+        return false;
+    }
+    if (!bacnetReadTag(data, length, pos, tag)) {
+        return false;
+    }
+    if (tag.context && tag.number == 2 && !tag.opening) {
+        pos += tag.length;
+        if (!bacnetReadTag(data, length, pos, tag)) {
+            return false;
+        }
+    }
+    if (!tag.opening || tag.number != 3) {
+        return false;
+    }
+    return readPropertyValue(data, length, pos, tag, propertyIndex(propertyId), reply);
+}
+
+BacnetClient::BacnetClient() {
+    sock = -1;
+    used = 0;
+    nextInvokeId = 0;
+    pacerWait = 0;
+    for (size_t i = 0; i < BACNET_CLIENT_SLOTS; i++) {
+        requests[i].used = false;
+    }
+}
+
+BacnetClient::~BacnetClient() {
+    stop();
+}
+
+bool BacnetClient::begin() {
+    if (sock >= 0) {
+        return true;
+    }
+
+    // Replies come back to whatever port the requests left from
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        return false;
+    }
+
+    int flags = fcntl(sock, F_GETFL, 0);
+    fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+    return true;
+}
+
+bool BacnetClient::add(const BacnetDevice& device) {
+    if (sock < 0 || used >= BACNET_CLIENT_SLOTS) {
+        return false;
+    }
+
+    for (size_t i = 0; i < BACNET_CLIENT_SLOTS; i++) {
+        Request& request = requests[i];
+        if (request.used) {
+            continue;
+        }
+
+        request.used = true;
+        request.sent = false;
+        request.singleReads = false;
+        request.nextProperty = 0;
+        request.attempts = 0;
+        request.found = 0;
+        request.device = device;
+        memset(request.values, 0, sizeof(request.values));
+        used++;
+        return true;
+    }
+    return false;
+}
+
+bool BacnetClient::poll(BacnetDeviceCallback callback, unsigned long waitMs) {
+    if (!isBusy()) {
+        return false;
+    }
+
+    sendPending();
+
+    // Wake for the next reply, the next expiry or the pacer
+    unsigned long now = millis();
+    unsigned long wait = waitMs;
+    for (size_t i = 0; i < BACNET_CLIENT_SLOTS; i++) {
+        const Request& request = requests[i];
+        if (!request.used) {
+            continue;
+        }
+        unsigned long left = pacerWait > 0 ? pacerWait : 1;
+        if (request.sent) {
+            unsigned long elapsed = now - request.sentAt;
+            left = elapsed < BACNET_APDU_TIMEOUT ? BACNET_APDU_TIMEOUT - elapsed : 0;
+        }
+        if (left < wait) {
+            wait = left;
+        }
+    }
+
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    FD_SET(sock, &readSet);
+    struct timeval tv;
+    tv.tv_sec = wait / 1000;
+    tv.tv_usec = (wait % 1000) * 1000;
+
+    if (select(sock + 1, &readSet, nullptr, nullptr, &tv) > 0) {
+        receiveReplies(callback);
+    }
+
+    expireRequests(callback);
+    sendPending();
+    return isBusy();
+}
+
+void BacnetClient::stop() {
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+    for (size_t i = 0; i < BACNET_CLIENT_SLOTS; i++) {
+        requests[i].used = false;
+    }
+    used = 0;
+}
+
+bool BacnetClient::isBusy() {
+    return used > 0;
+}
+
+size_t BacnetClient::buildReadPropertyMultiple(uint8_t* buffer, size_t size, const BacnetDevice& device,
+                                               uint8_t invokeId) {
+    size_t pos = bacnetBeginFrame(buffer, size, device.network, device.mac, device.macLength, true);
+    if (pos == 0 || pos + 4 + 5 + 2 + 2 * BACNET_READ_COUNT > size) {
+        return 0;
+    }
+
+    buffer[pos++] = APDU_CONFIRMED_REQUEST;
+    buffer[pos++] = APDU_MAX_ACCEPTED;
+    buffer[pos++] = invokeId;
+    buffer[pos++] = SERVICE_READ_PROPERTY_MULTIPLE;
+
+    // One ReadAccessSpecification: the Device object and its properties
+    pos += putObjectId(buffer + pos, 0, device.instance);
+    buffer[pos++] = 0x1E;                     // Opening tag 1
+    for (int i = 0; i < BACNET_READ_COUNT; i++) {
+        buffer[pos++] = 0x09;                 // Context tag 0, one byte
+        buffer[pos++] = PROPERTY_IDS[i];
+    }
+    buffer[pos++] = 0x1F;                     // Closing tag 1
+
+    bacnetFinishFrame(buffer, pos);
+    return pos;
+}
+
+size_t BacnetClient::buildReadProperty(uint8_t* buffer, size_t size, const BacnetDevice& device,
+                                       uint8_t invokeId, BacnetReadProperty property) {
+    size_t pos = bacnetBeginFrame(buffer, size, device.network, device.mac, device.macLength, true);
+    if (pos == 0 || pos + 4 + 5 + 2 > size) {
+        return 0;
+    }
+
+    buffer[pos++] = APDU_CONFIRMED_REQUEST;
+    buffer[pos++] = APDU_MAX_ACCEPTED;
+    buffer[pos++] = invokeId;
+    buffer[pos++] = SERVICE_READ_PROPERTY;
+    pos += putObjectId(buffer + pos, 0, device.instance);
+    buffer[pos++] = 0x19;                     // Context tag 1, one byte
+    buffer[pos++] = PROPERTY_IDS[property];
+
+    bacnetFinishFrame(buffer, pos);
+    return pos;
+}
+
+bool BacnetClient::parseReply(const uint8_t* data, size_t length, BacnetReply& reply) {
+    BacnetFrame frame;
+    if (!bacnetParseFrame(data, length, frame) || frame.apduLength < 2) {
+        return false;
+    }
+
+    const uint8_t* apdu = frame.apdu;
+    size_t apduLength = frame.apduLength;
+    reply.invokeId = apdu[1];
+    reply.service = 0;
+    reply.found = 0;
+    reply.failed = 0;
+
+    switch (apdu[0] & 0xF0) {
+        case APDU_COMPLEX_ACK:
+            if (apdu[0] & APDU_SEGMENTED) {
+                // Too big for one frame; the caller falls back to single reads
+                reply.type = BACNET_REPLY_ABORT;
+                return true;
+            }
+            if (apduLength < 3) {
+                return false;
+            }
+            reply.type = BACNET_REPLY_ACK;
+            reply.service = apdu[2];
+            if (reply.service == SERVICE_READ_PROPERTY_MULTIPLE) {
+                return parseMultipleAck(apdu, apduLength, 3, reply);
+            }
+            if (reply.service == SERVICE_READ_PROPERTY) {
+                return parseSingleAck(apdu, apduLength, 3, reply);
+            }
+            return false;
+        case APDU_ERROR:
+            reply.type = BACNET_REPLY_ERROR;
+            reply.service = apduLength > 2 ? apdu[2] : 0;
+            return true;
+        case APDU_REJECT:
+            reply.type = BACNET_REPLY_REJECT;
+            return true;
+        case APDU_ABORT:
+            reply.type = BACNET_REPLY_ABORT;
+            return true;
+        default:
+            reply.type = BACNET_REPLY_OTHER;
+            return false;
+    }
+}
+
+void BacnetClient::sendPending() {
+    for (size_t i = 0; i < BACNET_CLIENT_SLOTS; i++) {
+        Request& request = requests[i];
+        if (!request.used || request.sent) {
+            continue;
+        }
+        if (!probePacer.tryAcquire(request.device.address, &pacerWait)) {
+            continue;
+        }
+
+        // A fresh invoke ID per attempt keeps a late reply to an earlier
+        // attempt from being taken for this one
+        request.invokeId = allocateInvokeId();
+        size_t length = request.singleReads
+            ? buildReadProperty(frame, sizeof(frame), request.device, request.invokeId,
+                                (BacnetReadProperty)request.nextProperty)
+            : buildReadPropertyMultiple(frame, sizeof(frame), request.device, request.invokeId);
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(BACNET_PORT);
+        addr.sin_addr.s_addr = (uint32_t)request.device.address;
+
+        // A failed send is left to time out like a lost datagram
+        sendto(sock, frame, length, 0, (struct sockaddr*)&addr, sizeof(addr));
+        request.sent = true;
+        request.sentAt = millis();
+        request.attempts++;
+    }
+}
+
+void BacnetClient::receiveReplies(BacnetDeviceCallback& callback) {
+    for (;;) {
+        struct sockaddr_in from;
+        socklen_t fromLength = sizeof(from);
+        int received = recvfrom(sock, frame, sizeof(frame), 0, (struct sockaddr*)&from, &fromLength);
+        if (received <= 0) {
+            return;
+        }
+        if (!parseReply(frame, received, reply)) {
+            continue;
+        }
+
+        IPAddress source(from.sin_addr.s_addr);
+        for (size_t i = 0; i < BACNET_CLIENT_SLOTS; i++) {
+            Request& request = requests[i];
+            if (request.used && request.sent && request.invokeId == reply.invokeId &&
+                request.device.address == source) {
+                handleReply(request, callback);
+                break;
+            }
+        }
+    }
+}
+
+void BacnetClient::expireRequests(BacnetDeviceCallback& callback) {
+    unsigned long now = millis();
+
+    for (size_t i = 0; i < BACNET_CLIENT_SLOTS; i++) {
+        Request& request = requests[i];
+        if (!request.used || !request.sent || now - request.sentAt < BACNET_APDU_TIMEOUT) {
+            continue;
+        }
+
+        probePacer.release(request.device.address);
+        request.sent = false;
+
+        // A device that stops answering keeps what it already returned
+        if (request.attempts > BACNET_APDU_RETRIES) {
+            finish(request, callback);
+        }
+    }
+}
+
+void BacnetClient::handleReply(Request& request, BacnetDeviceCallback& callback) {
+    probePacer.release(request.device.address);
+    request.sent = false;
+    request.attempts = 0;
+
+    for (int i = 0; i < BACNET_READ_COUNT; i++) {
+        if (reply.found & (1 << i)) {
+            memcpy(request.values[i], reply.values[i], BACNET_STRING_LENGTH);
+            request.found |= 1 << i;
+        }
+    }
+
+    if (!request.singleReads) {
+        if (reply.type == BACNET_REPLY_ACK) {
+            finish(request, callback);
+            return;
+        }
+        // No ReadPropertyMultiple (or the answer would not fit one frame):
+        // ask for the properties one at a time
+        request.singleReads = true;
+        request.nextProperty = 0;
+        return;
+    }
+
+    // A refused property is skipped, not retried
+    request.nextProperty++;
+    if (request.nextProperty >= BACNET_READ_COUNT) {
+        finish(request, callback);
+    }
+}
+
+void BacnetClient::finish(Request& request, BacnetDeviceCallback& callback) {
+    BacnetDevice& device = request.device;
+    if (request.found & (1 << BACNET_READ_OBJECT_NAME)) {
+        device.objectName = request.values[BACNET_READ_OBJECT_NAME];
+    }
+    if (request.found & (1 << BACNET_READ_MODEL_NAME)) {
+        device.modelName = request.values[BACNET_READ_MODEL_NAME];
+    }
+    if (request.found & (1 << BACNET_READ_VENDOR_NAME)) {
+        device.vendorName = request.values[BACNET_READ_VENDOR_NAME];
+    }
+    if (request.found & (1 << BACNET_READ_FIRMWARE_REVISION)) {
+        device.firmwareRevision = request.values[BACNET_READ_FIRMWARE_REVISION];
+    }
+
+    #if DEBUG_NETWORK
+    Serial.printf("BACnet: device %u read (%s, %s)\n", device.instance,
+                  device.vendorName.c_str(), device.modelName.c_str());
+    #endif
+
+    request.used = false;
+    used--;
+
+    if (callback) {
+        callback(device);
+    }
+}
+
+uint8_t BacnetClient::allocateInvokeId() {
+    for (;;) {
+        uint8_t id = nextInvokeId++;
+        bool inUse = false;
+        for (size_t i = 0; i < BACNET_CLIENT_SLOTS; i++) {
+            if (requests[i].used && requests[i].sent && requests[i].invokeId == id) {
+                inUse = true;
+                break;
+            }
+        }
+        if (!inUse) {
+            return id;
+        }
+    }
+}
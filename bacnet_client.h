@@ -0,0 +1,103 @@
+/*
+ * BACnet Client Header
+ * Reads Device object properties from many BACnet devices at once
+ */
+
+#ifndef BACNET_CLIENT_H
+#define BACNET_CLIENT_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include "config.h"
+#include "bacnet_codec.h"
+#include "bacnet_discovery.h"
+
+// Properties read from each Device object, in BacnetReply::values order
+enum BacnetReadProperty {
+    BACNET_READ_OBJECT_NAME,
+    BACNET_READ_MODEL_NAME,
+    BACNET_READ_VENDOR_NAME,
+    BACNET_READ_FIRMWARE_REVISION,
+    BACNET_READ_COUNT
+};
+
+enum BacnetReplyType {
+    BACNET_REPLY_ACK,           // ComplexACK with values
+    BACNET_REPLY_ERROR,         // Error PDU (e.g. unknown service or property)
+    BACNET_REPLY_REJECT,        // Reject PDU (e.g. service not supported)
+    BACNET_REPLY_ABORT,         // Abort PDU, or a segmented ACK we cannot take
+    BACNET_REPLY_OTHER          // Not an answer to a confirmed request
+};
+
+// One decoded reply; fixed-size, so decoding never allocates
+struct BacnetReply {
+    BacnetReplyType type;
+    uint8_t invokeId;
+    uint8_t service;
+    uint8_t found;              // Bit per BacnetReadProperty with a value
+    uint8_t failed;             // Bit per BacnetReadProperty the device refused
+    char values[BACNET_READ_COUNT][BACNET_STRING_LENGTH];
+};
+
+class BacnetClient {
+public:
+    BacnetClient();
+    ~BacnetClient();
+
+    // Open the UDP socket all requests and replies share
+    bool begin();
+
+    // Queue a device for reading; false when every slot is taken (poll,
+    // then try again)
+    bool add(const BacnetDevice& device);
+
+    // Send requests, match replies by invoke ID and retry silent devices;
+    // each device is reported once, with whatever it returned. Returns
+    // false once nothing is queued or in flight
+    bool poll(BacnetDeviceCallback callback, unsigned long waitMs = SWEEP_POLL_INTERVAL);
+
+    // Drop everything and close the socket
+    void stop();
+
+    bool isBusy();
+
+    // Frame codecs
+    static size_t buildReadPropertyMultiple(uint8_t* buffer, size_t size, const BacnetDevice& device,
+                                            uint8_t invokeId);
+    static size_t buildReadProperty(uint8_t* buffer, size_t size, const BacnetDevice& device,
+                                    uint8_t invokeId, BacnetReadProperty property);
+    static bool parseReply(const uint8_t* data, size_t length, BacnetReply& reply);
+
+private:
+    struct Request {
+        bool used;
+        bool sent;
+        bool singleReads;         // Device refused ReadPropertyMultiple
+        uint8_t nextProperty;     // Next property in single-read mode
+        uint8_t invokeId;
+        uint8_t attempts;
+        unsigned long sentAt;
+        uint8_t found;
+        BacnetDevice device;
+        char values[BACNET_READ_COUNT][BACNET_STRING_LENGTH];
+    };
+
+    int sock;
+    Request requests[BACNET_CLIENT_SLOTS];
+    size_t used;
+    uint8_t nextInvokeId;
+    unsigned long pacerWait;
+
+    // Receive and request buffers; reused for every packet
+    uint8_t frame[BACNET_FRAME_SIZE];
+    BacnetReply reply;
+
+    void sendPending();
+    void receiveReplies(BacnetDeviceCallback& callback);
+    void expireRequests(BacnetDeviceCallback& callback);
+    void handleReply(Request& request, BacnetDeviceCallback& callback);
+    void finish(Request& request, BacnetDeviceCallback& callback);
+    uint8_t allocateInvokeId();
+};
+
+#endif // BACNET_CLIENT_H
@@ -0,0 +1,223 @@
+/*
+ * BACnet Codec Implementation
+ * BVLC/NPDU framing and tag decoding shared by the BACnet modules
+ */
+
+#include "bacnet_codec.h"
+
+bool bacnetParseFrame(const uint8_t* data, size_t length, BacnetFrame& frame) {
+    // BVLC
+    if (length < 4 || data[0] != BVLC_TYPE) {
+        return false;
+    }
+    size_t frameLength = ((size_t)data[2] << 8) | data[3];
+    if (frameLength < 4 || frameLength > length) {
+        return false;
+    }
+    length = frameLength;
+
+    size_t pos = 4;
+    frame.forwarded = false;
+    frame.origin = IPAddress(0, 0, 0, 0);
+    if (data[1] == BVLC_FORWARDED_NPDU) {
+        // A BBMD relayed it; the original sender's B/IP address comes first
+        if (length < 10) {
+            return false;
+        }
+        frame.forwarded = true;
+        frame.origin = IPAddress(data[4], data[5], data[6], data[7]);
+        pos = 10;
+    } else if (data[1] != BVLC_ORIGINAL_UNICAST && data[1] != BVLC_ORIGINAL_BROADCAST) {
+        return false;
+    }
+
+    // NPDU
+    if (pos + 2 > length || data[pos] != NPDU_VERSION) {
+        return false;
+    }
+    uint8_t control = data[pos + 1];
+    pos += 2;
+    if (control & NPDU_NETWORK_MESSAGE) {
+        return false;
+    }
+
+    if (control & NPDU_DEST_PRESENT) {
+        if (pos + 3 > length) {
+            return false;
+        }
+        pos += 3 + data[pos + 2];
+    }
+
+    frame.sourceNetwork = 0;
+    frame.sourceAddressLength = 0;
+    if (control & NPDU_SOURCE_PRESENT) {
+        if (pos + 3 > length) {
+            return false;
+        }
+        uint8_t addressLength = data[pos + 2];
+        if (addressLength > BACNET_MAX_MAC || pos + 3 + addressLength > length) {
+            return false;
+        }
+        frame.sourceNetwork = ((uint16_t)data[pos] << 8) | data[pos + 1];
+        frame.sourceAddressLength = addressLength;
+        memcpy(frame.sourceAddress, data + pos + 3, addressLength);
+        pos += 3 + addressLength;
+    }
+
+    if (control & NPDU_DEST_PRESENT) {
+        pos++;                        // Hop count
+    }
+
+    if (pos >= length) {
+        return false;
+    }
+    frame.apdu = data + pos;
+    frame.apduLength = length - pos;
+    return true;
+}
+
+size_t bacnetBeginFrame(uint8_t* buffer, size_t size, uint16_t network,
+                        const uint8_t* address, uint8_t addressLength, bool expectingReply) {
+    size_t needed = 4 + 2 + (network != 0 ? 4 + addressLength : 0);
+    if (size < needed) {
+        return 0;
+    }
+
+    buffer[0] = BVLC_TYPE;
+    buffer[1] = BVLC_ORIGINAL_UNICAST;
+    buffer[2] = 0;
+    buffer[3] = 0;
+    buffer[4] = NPDU_VERSION;
+    buffer[5] = expectingReply ? NPDU_EXPECTING_REPLY : 0;
+
+    size_t pos = 6;
+    if (network != 0) {
+        // Addressed to a device behind a router: DNET, DLEN, DADR, hop count
+        buffer[5] |= NPDU_DEST_PRESENT;
+        buffer[pos++] = (uint8_t)(network >> 8);
+        buffer[pos++] = (uint8_t)network;
+        buffer[pos++] = addressLength;
+        memcpy(buffer + pos, address, addressLength);
+        pos += addressLength;
+        buffer[pos++] = 0xFF;
+    }
+    return pos;
+}
+
+void bacnetFinishFrame(uint8_t* buffer, size_t length) {
+    buffer[2] = (uint8_t)(length >> 8);
+    buffer[3] = (uint8_t)length;
+}
+
+bool bacnetReadTag(const uint8_t* data, size_t length, size_t& pos, BacnetTag& tag) {
+    if (pos >= length) {
+        return false;
+    }
+
+    uint8_t header = data[pos++];
+    uint8_t lengthValueType = header & 0x07;
+    tag.number = header >> 4;
+    tag.context = (header & 0x08) != 0;
+    tag.opening = false;
+    tag.closing = false;
+    tag.length = 0;
+
+    if (tag.number == 15) {
+        if (pos >= length) {
+            return false;
+        }
+        tag.number = data[pos++];
+    }
+
+    if (tag.context && lengthValueType == 6) {
+        tag.opening = true;
+        return true;
+    }
+    if (tag.context && lengthValueType == 7) {
+        tag.closing = true;
+        return true;
+    }
+    if (!tag.context && tag.number == BACNET_TAG_BOOLEAN) {
+        // The value lives in the header itself
+        return true;
+    }
+
+    if (lengthValueType == 5) {
+        if (pos >= length) {
+            return false;
+        }
+        uint8_t extended = data[pos++];
+        size_t lengthBytes = (extended == 254) ? 2 : (extended == 255) ? 4 : 0;
+        if (pos + lengthBytes > length) {
+            return false;
+        }
+        if (lengthBytes == 0) {
+            tag.length = extended;
+        }
+        for (size_t i = 0; i < lengthBytes; i++) {
+            tag.length = (tag.length << 8) | data[pos++];
+        }
+    } else {
+        tag.length = lengthValueType;
+    }
+
+    return tag.length <= length - pos;
+}
+
+bool bacnetReadUnsigned(const uint8_t* data, size_t& pos, const BacnetTag& tag, uint32_t& value) {
+    if (tag.length == 0 || tag.length > 4) {
+        return false;
+    }
+
+    value = 0;
+    for (uint32_t i = 0; i < tag.length; i++) {
+        value = (value << 8) | data[pos++];
+    }
+    return true;
+}
+
+bool bacnetReadString(const uint8_t* data, size_t& pos, const BacnetTag& tag, char* text, size_t size) {
+    if (tag.length == 0 || size == 0) {
+        return false;
+    }
+
+    // First byte is the character set; UCS-2 (4) keeps the low byte of
+    // each character, everything else is copied byte for byte
+    uint8_t charset = data[pos];
+    size_t step = (charset == 4) ? 2 : 1;
+    size_t out = 0;
+    for (size_t i = 1 + (step - 1); i < tag.length && out + 1 < size; i += step) {
+        char c = (char)data[pos + i];
+        if (c < 0x20 || c > 0x7E || c == '"' || c == '<' || c == '>') {
+            c = '?';
+        }
+        text[out++] = c;
+    }
+    text[out] = '\0';
+
+    pos += tag.length;
+    return true;
+}
+
+bool bacnetSkipValue(const uint8_t* data, size_t length, size_t& pos, const BacnetTag& tag) {
+    if (!tag.opening) {
+        pos += tag.length;
+        return true;
+    }
+
+    int depth = 1;
+    BacnetTag inner;
+    while (depth > 0) {
+        if (!bacnetReadTag(data, length, pos, inner)) {
+            return false;
+        }
+        if (inner.opening) {
+            depth++;
+        } else if (inner.closing) {
+            depth--;
+        } else {
+            pos += inner.length;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+/*
+ * BACnet Codec Header
+ * BVLC/NPDU framing and tag decoding shared by the BACnet modules
+ */
+
+#ifndef BACNET_CODEC_H
+#define BACNET_CODEC_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+// Largest B/IP frame (1476-byte APDU plus headers)
+#define BACNET_FRAME_SIZE 1497
+
+// Longest MAC (SADR/DADR) kept for a device behind a router
+#define BACNET_MAX_MAC 8
+
+#define BVLC_TYPE 0x81
+#define BVLC_FORWARDED_NPDU 0x04
+#define BVLC_ORIGINAL_UNICAST 0x0A
+#define BVLC_ORIGINAL_BROADCAST 0x0B
+
+#define NPDU_VERSION 0x01
+#define NPDU_NETWORK_MESSAGE 0x80
+#define NPDU_DEST_PRESENT 0x20
+#define NPDU_SOURCE_PRESENT 0x08
+#define NPDU_EXPECTING_REPLY 0x04
+
+// APDU types (high nibble of the first byte)
+#define APDU_CONFIRMED_REQUEST 0x00
+#define APDU_UNCONFIRMED_REQUEST 0x10
+#define APDU_COMPLEX_ACK 0x30
+#define APDU_ERROR 0x50
+#define APDU_REJECT 0x60
+#define APDU_ABORT 0x70
+#define APDU_SEGMENTED 0x08
+
+// Application tag numbers
+#define BACNET_TAG_BOOLEAN 1
+#define BACNET_TAG_UNSIGNED 2
+#define BACNET_TAG_CHARACTER_STRING 7
+#define BACNET_TAG_ENUMERATED 9
+#define BACNET_TAG_OBJECT_ID 12
+
+#define BACNET_OBJECT_DEVICE 8
+
+// Routing fields and APDU of a received frame; apdu points into the
+// caller's buffer
+struct BacnetFrame {
+    bool forwarded;           // Relayed by a BBMD; origin holds the sender
+    IPAddress origin;
+    uint16_t sourceNetwork;   // 0 = sent on the B/IP segment itself
+    uint8_t sourceAddress[BACNET_MAX_MAC];
+    uint8_t sourceAddressLength;
+    const uint8_t* apdu;
+    size_t apduLength;
+};
+
+struct BacnetTag {
+    uint8_t number;
+    bool context;             // Context-specific rather than application tag
+    bool opening;
+    bool closing;
+    uint32_t length;          // Value bytes following the header
+};
+
+// Split a B/IP datagram into routing fields and APDU; false for anything
+// that is not an application-layer frame
+bool bacnetParseFrame(const uint8_t* data, size_t length, BacnetFrame& frame);
+
+// Write BVLC + NPDU for a unicast to a device, routed when network != 0.
+// Returns the header length (0 if it does not fit); bacnetFinishFrame
+// fills in the BVLC length once the APDU has been appended
+size_t bacnetBeginFrame(uint8_t* buffer, size_t size, uint16_t network,
+                        const uint8_t* address, uint8_t addressLength, bool expectingReply);
+void bacnetFinishFrame(uint8_t* buffer, size_t length);
+
+// Decode the tag header at pos and advance past it; fails if the value
+// would run past length
+bool bacnetReadTag(const uint8_t* data, size_t length, size_t& pos, BacnetTag& tag);
+
+// Decode a tag's value (at most four bytes) as unsigned and advance past it
+bool bacnetReadUnsigned(const uint8_t* data, size_t& pos, const BacnetTag& tag, uint32_t& value);
+
+// Copy a CharacterString value into text and advance past it; text is
+// always terminated, and anything unsafe in HTML or CSV becomes '?'
+bool bacnetReadString(const uint8_t* data, size_t& pos, const BacnetTag& tag, char* text, size_t size);
+
+// Skip the value of tag; for an opening tag, skip to its matching closing tag
+bool bacnetSkipValue(const uint8_t* data, size_t length, size_t& pos, const BacnetTag& tag);
+
+#endif // BACNET_CODEC_H
@@ -0,0 +1,248 @@
+/*
+ * BACnet Discovery Implementation
+ * Finds BACnet/IP devices with one Who-Is broadcast and their I-Am replies
+ */
+
+#include "bacnet_discovery.h"
+#include "net_utils.h"
+#include "probe_pacer.h"
+#include <lwip/sockets.h>
+
+#define SERVICE_I_AM 0x00
+#define SERVICE_WHO_IS 0x08
+
+// Read an application-tagged unsigned-style value of the given tag number
+static bool readAppTag(const uint8_t* data, size_t length, size_t& pos, uint8_t number, uint32_t& value) {
+    BacnetTag tag;
+    return bacnetReadTag(data, length, pos, tag) && !tag.context && tag.number == number &&
+           bacnetReadUnsigned(data, pos, tag, value);
+}
+
+BacnetDiscovery::BacnetDiscovery() {
+    sock = -1;
+    startTime = 0;
+    window = 0;
+}
+
+BacnetDiscovery::~BacnetDiscovery() {
+    stop();
+}
+
+bool BacnetDiscovery::start(const TargetIterator& scanTargets, unsigned long discoveryWindow) {
+    stop();
+    devices.clear();
+    targets = scanTargets;
+    window = discoveryWindow;
+
+    if (!openSocket()) {
+        return false;
+    }
+
+    // One broadcast reaches the local segment; directed broadcasts reach
+    // target ranges behind a router that forwards them
+    sendWhoIs(IPAddress(255, 255, 255, 255));
+
+    for (size_t i = 0; i < targets.getRangeCount(); i++) {
+        IPAddress first, last;
+        targets.getRange(i, first, last);
+
+        // A single address gets a unicast Who-Is
+        sendWhoIs(coveringBroadcast(first, last));
+    }
+
+    startTime = millis();
+
+    #if DEBUG_NETWORK
+    Serial.printf("BACnet: Who-Is sent, listening %lu ms\n", window);
+    #endif
+    return true;
+}
+
+bool BacnetDiscovery::poll(BacnetDeviceCallback callback, unsigned long waitMs) {
+    if (sock < 0) {
+        return false;
+    }
+
+    unsigned long elapsed = millis() - startTime;
+    if (elapsed >= window) {
+        stop();
+        return false;
+    }
+
+    unsigned long wait = window - elapsed;
+    if (wait > waitMs) {
+        wait = waitMs;
+    }
+
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    FD_SET(sock, &readSet);
+    struct timeval tv;
+    tv.tv_sec = wait / 1000;
+    tv.tv_usec = (wait % 1000) * 1000;
+
+    if (select(sock + 1, &readSet, nullptr, nullptr, &tv) <= 0) {
+        return true;
+    }
+
+    uint8_t frame[BACNET_FRAME_SIZE];
+    for (;;) {
+        struct sockaddr_in from;
+        socklen_t fromLength = sizeof(from);
+        int received = recvfrom(sock, frame, sizeof(frame), 0, (struct sockaddr*)&from, &fromLength);
+        if (received <= 0) {
+            break;
+        }
+
+        BacnetDevice device;
+        device.address = IPAddress(from.sin_addr.s_addr);
+        if (!parseIAm(frame, received, device)) {
+            continue;
+        }
+
+        // Other scanners' Who-Is also draws I-Ams from outside our targets
+        if (!targets.contains(device.address) || isKnown(device) ||
+            devices.size() >= BACNET_MAX_DEVICES) {
+            continue;
+        }
+
+        devices.push_back(device);
+
+        #if DEBUG_NETWORK
+        Serial.printf("BACnet: device %u at %s (net %u, vendor %u, max APDU %u)\n",
+                      device.instance, device.address.toString().c_str(),
+                      device.network, device.vendorId, device.maxApdu);
+        #endif
+
+        if (callback) {
+            callback(device);
+        }
+    }
+
+    return true;
+}
+
+void BacnetDiscovery::stop() {
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+}
+
+bool BacnetDiscovery::isActive() {
+    return sock >= 0;
+}
+
+const std::vector<BacnetDevice>& BacnetDiscovery::getDevices() {
+    return devices;
+}
+
+size_t BacnetDiscovery::buildWhoIs(uint8_t* buffer, size_t size) {
+    // Unbounded Who-Is, global broadcast on every network (DNET 0xFFFF)
+    static const uint8_t whoIs[] = {
+        BVLC_TYPE, BVLC_ORIGINAL_BROADCAST, 0x00, 0x0C,
+        NPDU_VERSION, NPDU_DEST_PRESENT, 0xFF, 0xFF, 0x00, 0xFF,
+        APDU_UNCONFIRMED_REQUEST, SERVICE_WHO_IS
+    };
+
+    if (size < sizeof(whoIs)) {
+        return 0;
+    }
+    memcpy(buffer, whoIs, sizeof(whoIs));
+    return sizeof(whoIs);
+}
+
+bool BacnetDiscovery::parseIAm(const uint8_t* data, size_t length, BacnetDevice& device) {
+    BacnetFrame frame;
+    if (!bacnetParseFrame(data, length, frame)) {
+        return false;
+    }
+    if (frame.forwarded) {
+        device.address = frame.origin;
+    }
+    device.network = frame.sourceNetwork;
+    device.macLength = frame.sourceAddressLength;
+    memcpy(device.mac, frame.sourceAddress, frame.sourceAddressLength);
+
+    // I-Am: object id, max APDU, segmentation, vendor id
+    const uint8_t* apdu = frame.apdu;
+    size_t apduLength = frame.apduLength;
+    if (apduLength < 2 || apdu[0] != APDU_UNCONFIRMED_REQUEST || apdu[1] != SERVICE_I_AM) {
+        return false;
+    }
+
+    size_t pos = 2;
+    uint32_t objectId, maxApdu, segmentation, vendorId;
+    if (!readAppTag(apdu, apduLength, pos, BACNET_TAG_OBJECT_ID, objectId) ||
+        !readAppTag(apdu, apduLength, pos, BACNET_TAG_UNSIGNED, maxApdu) ||
+        !readAppTag(apdu, apduLength, pos, BACNET_TAG_ENUMERATED, segmentation) ||
+        !readAppTag(apdu, apduLength, pos, BACNET_TAG_UNSIGNED, vendorId)) {
+        return false;
+    }
+
+    if ((objectId >> 22) != BACNET_OBJECT_DEVICE) {
+        return false;
+    }
+
+    device.instance = objectId & 0x3FFFFF;
+    device.maxApdu = maxApdu;
+    device.segmentation = (uint8_t)segmentation;
+    device.vendorId = (uint16_t)vendorId;
+    return true;
+}
+
+bool BacnetDiscovery::openSocket() {
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        return false;
+    }
+
+    int enable = 1;
+    setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable));
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    int flags = fcntl(sock, F_GETFL, 0);
+    fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+
+    // Most devices broadcast their I-Am to 47808, so listen there; if the
+    // port is taken, unicast replies still reach an ephemeral port
+    struct sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons(BACNET_PORT);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (struct sockaddr*)&local, sizeof(local)) < 0) {
+        #if DEBUG_NETWORK
+        Serial.println("BACnet: port 47808 busy, only unicast I-Am replies will be seen");
+        #endif
+        local.sin_port = 0;
+        bind(sock, (struct sockaddr*)&local, sizeof(local));
+    }
+
+    return true;
+}
+
+void BacnetDiscovery::sendWhoIs(IPAddress destination) {
+    uint8_t frame[16];
+    size_t length = buildWhoIs(frame, sizeof(frame));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(BACNET_PORT);
+    addr.sin_addr.s_addr = (uint32_t)destination;
+
+    probePacer.acquire(destination);
+    sendto(sock, frame, length, 0, (struct sockaddr*)&addr, sizeof(addr));
+    probePacer.release(destination);
+}
+
+bool BacnetDiscovery::isKnown(const BacnetDevice& device) {
+    for (const auto& known : devices) {
+        if (known.instance == device.instance && known.network == device.network &&
+            known.address == device.address) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,72 @@
+/*
+ * BACnet Discovery Header
+ * Finds BACnet/IP devices with one Who-Is broadcast and their I-Am replies
+ */
+
+#ifndef BACNET_DISCOVERY_H
+#define BACNET_DISCOVERY_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+#include <IPAddress.h>
+#include "config.h"
+#include "target_iterator.h"
+#include "bacnet_codec.h"
+
+// Identity announced in an I-Am
+struct BacnetDevice {
+    IPAddress address;        // B/IP node the I-Am came from (the router for remote networks)
+    uint16_t network;         // Source network of a routed device, 0 = on the B/IP segment
+    uint8_t mac[BACNET_MAX_MAC];  // Its address on that network (SADR)
+    uint8_t macLength;
+    uint32_t instance;        // Device object instance
+    uint32_t maxApdu;         // Max APDU length accepted
+    uint8_t segmentation;     // 0 both, 1 transmit, 2 receive, 3 none
+    uint16_t vendorId;
+
+    // Device object properties, filled in by BacnetClient
+    String objectName;
+    String modelName;
+    String vendorName;
+    String firmwareRevision;
+};
+
+// Called once per device, the first time its I-Am is seen
+typedef std::function<void(const BacnetDevice&)> BacnetDeviceCallback;
+
+class BacnetDiscovery {
+public:
+    BacnetDiscovery();
+    ~BacnetDiscovery();
+
+    // Open the socket and broadcast Who-Is to the segment and to every
+    // target range; I-Am replies are then collected for window ms
+    bool start(const TargetIterator& targets, unsigned long window = BACNET_DISCOVERY_WINDOW);
+
+    // Collect replies; returns false once the window has closed
+    bool poll(BacnetDeviceCallback callback, unsigned long waitMs = SWEEP_POLL_INTERVAL);
+
+    // Close the socket; discovered devices stay available until the next start
+    void stop();
+
+    bool isActive();
+    const std::vector<BacnetDevice>& getDevices();
+
+    // Frame codecs (BVLC + NPDU + APDU)
+    static size_t buildWhoIs(uint8_t* buffer, size_t size);
+    static bool parseIAm(const uint8_t* data, size_t length, BacnetDevice& device);
+
+private:
+    int sock;
+    unsigned long startTime;
+    unsigned long window;
+    TargetIterator targets;
+    std::vector<BacnetDevice> devices;
+
+    bool openSocket();
+    void sendWhoIs(IPAddress destination);
+    bool isKnown(const BacnetDevice& device);
+};
+
+#endif // BACNET_DISCOVERY_H
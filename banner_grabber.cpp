@@ -0,0 +1,169 @@
+/*
+ * Banner Grabber Implementation
+ * Reads service replies on connected sockets into fixed per-probe buffers
+ */
+
+#include "banner_grabber.h"
+#include "connect_pool.h"
+#include <lwip/sockets.h>
+
+BannerGrabber::BannerGrabber() {
+    activeCount = 0;
+}
+
+BannerGrabber::~BannerGrabber() {
+    cancelAll();
+}
+
+void BannerGrabber::begin(size_t maxSlots) {
+    cancelAll();
+
+    if (maxSlots == 0) {
+        maxSlots = 1;
+    }
+
+    slots.assign(maxSlots, Slot());
+    for (auto& slot : slots) {
+        slot.active = false;
+        slot.fd = -1;
+    }
+    activeCount = 0;
+}
+
+bool BannerGrabber::start(int fd, IPAddress target, uint16_t port, uint32_t tag, unsigned long responseTime) {
+    Slot* freeSlot = nullptr;
+    for (auto& slot : slots) {
+        if (!slot.active) {
+            freeSlot = &slot;
+            break;
+        }
+    }
+
+    if (!freeSlot) {
+        ConnectPool::closeSocket(fd);
+        return false;
+    }
+
+    const ServiceProbe& probe = findServiceProbe(port);
+    if (probe.payload) {
+        // A few dozen bytes always fit the empty send buffer of a new connection
+        send(fd, probe.payload, probe.length, 0);
+    }
+
+    freeSlot->active = true;
+    freeSlot->fd = fd;
+    freeSlot->target = target;
+    freeSlot->port = port;
+    freeSlot->tag = tag;
+    freeSlot->responseTime = responseTime;
+    freeSlot->startTime = millis();
+    freeSlot->wait = serviceReplyWait(port);
+    freeSlot->probe = &probe;
+    freeSlot->length = 0;
+    freeSlot->armed = false;
+    if (probe.framing == REPLY_TLS) {
+        freeSlot->tls.reset();
+    }
+    activeCount++;
+    return true;
+}
+
+int BannerGrabber::poll(unsigned long waitMs, BannerCallback callback) {
+    if (activeCount == 0) {
+        return 0;
+    }
+
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    int maxFd = -1;
+
+    for (auto& slot : slots) {
+        slot.armed = slot.active;
+        if (slot.active) {
+            FD_SET(slot.fd, &readSet);
+            if (slot.fd > maxFd) {
+                maxFd = slot.fd;
+            }
+        }
+    }
+
+    struct timeval tv;
+    tv.tv_sec = waitMs / 1000;
+    tv.tv_usec = (waitMs % 1000) * 1000;
+
+    int ready = select(maxFd + 1, &readSet, nullptr, nullptr, &tv);
+    int completed = 0;
+    unsigned long now = millis();
+
+    for (auto& slot : slots) {
+        if (!slot.active || !slot.armed) {
+            continue;
+        }
+
+        bool done = false;
+        if (ready > 0 && FD_ISSET(slot.fd, &readSet)) {
+            int received = recv(slot.fd, slot.buffer + slot.length, sizeof(slot.buffer) - slot.length, 0);
+            if (received > 0 && slot.probe->framing == REPLY_TLS) {
+                // The buffer only holds one read; certificate chains run to
+                // several kilobytes and are parsed as they stream past
+                done = slot.tls.feed(slot.buffer, received);
+            } else if (received > 0) {
+                slot.length += received;
+                done = slot.length == sizeof(slot.buffer) ||
+                       serviceReplyComplete(*slot.probe, slot.buffer, slot.length);
+            } else if (received == 0 || errno != EWOULDBLOCK) {
+                // Closed by the server, or reset
+                done = true;
+            }
+        }
+
+        if (done || now - slot.startTime >= slot.wait) {
+            complete(slot, callback);
+            completed++;
+        }
+    }
+
+    return completed;
+}
+
+void BannerGrabber::cancelAll() {
+    for (auto& slot : slots) {
+        if (slot.active) {
+            ConnectPool::closeSocket(slot.fd);
+            slot.active = false;
+            slot.fd = -1;
+        }
+    }
+    activeCount = 0;
+}
+
+size_t BannerGrabber::active() {
+    return activeCount;
+}
+
+bool BannerGrabber::hasFreeSlot() {
+    return activeCount < slots.size();
+}
+
+void BannerGrabber::complete(Slot& slot, BannerCallback& callback) {
+    ConnectPool::closeSocket(slot.fd);
+
+    BannerCompletion completion;
+    completion.target = slot.target;
+    completion.port = slot.port;
+    completion.tag = slot.tag;
+    completion.responseTime = slot.responseTime;
+    completion.data = slot.buffer;
+    completion.length = slot.length;
+    completion.tls = slot.probe->framing == REPLY_TLS ? &slot.tls.getSummary() : nullptr;
+
+    // Free the slot only after the callback so nothing reuses the buffer
+    // it is reading
+    if (callback) {
+        callback(completion);
+    }
+
+    slot.active = false;
+    slot.fd = -1;
+    activeCount--;
+}
@@ -0,0 +1,73 @@
+/*
+ * Banner Grabber Header
+ * Reads service replies on connected sockets into fixed per-probe buffers
+ */
+
+#ifndef BANNER_GRABBER_H
+#define BANNER_GRABBER_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+#include <IPAddress.h>
+#include "config.h"
+#include "fingerprint.h"
+
+struct BannerCompletion {
+    IPAddress target;
+    uint16_t port;
+    uint32_t tag;
+    unsigned long responseTime;   // Of the connect that opened the socket
+    const uint8_t* data;          // Reply bytes; only valid during the callback
+    size_t length;
+    const TlsSummary* tls;        // Set instead of data for REPLY_TLS probes
+};
+
+typedef std::function<void(const BannerCompletion&)> BannerCallback;
+
+class BannerGrabber {
+public:
+    BannerGrabber();
+    ~BannerGrabber();
+
+    // Allocate the slots and their buffers (call once, before starting)
+    void begin(size_t maxSlots = MAX_CONCURRENT_PORT_PROBES);
+
+    // Take over a connected socket, send the port's probe and start the
+    // reply deadline; false (socket closed) when no slot is free
+    bool start(int fd, IPAddress target, uint16_t port, uint32_t tag, unsigned long responseTime);
+
+    // Wait up to waitMs for data and report every finished read
+    int poll(unsigned long waitMs, BannerCallback callback);
+
+    // Close every socket without reporting it
+    void cancelAll();
+
+    size_t active();
+    bool hasFreeSlot();
+
+private:
+    struct Slot {
+        bool active;
+        int fd;
+        IPAddress target;
+        uint16_t port;
+        uint32_t tag;
+        unsigned long responseTime;
+        unsigned long startTime;
+        unsigned long wait;   // Reply deadline of the port's timeout class
+        const ServiceProbe* probe;
+        size_t length;
+        bool armed;           // Part of the current select() set
+        uint8_t buffer[BANNER_BUFFER_SIZE];
+        TlsProbe tls;         // Parses REPLY_TLS replies as they arrive
+    };
+
+    std::vector<Slot> slots;
+    size_t activeCount;
+
+    // Close the socket and hand the reply to the callback
+    void complete(Slot& slot, BannerCallback& callback);
+};
+
+#endif // BANNER_GRABBER_H
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""
+ESP32 Network Discovery Tool - Web Asset Builder
+Gzips the static files in web/ into flash-resident arrays (web_assets.h/.cpp)
+"""
+
+import gzip
+import hashlib
+import os
+import sys
+
+ASSET_DIR = 'web'
+HEADER_FILE = 'web_assets.h'
+SOURCE_FILE = 'web_assets.cpp'
+
+# (file in web/, URL path, content type, macro naming the versioned URL)
+ASSETS = [
+    ('style.css', '/style.css', 'text/css', 'WEB_ASSET_STYLE_CSS'),
+    ('app.js', '/app.js', 'application/javascript', 'WEB_ASSET_APP_JS'),
+]
+
+def compress(data):
+    """Gzip with a fixed timestamp so unchanged files build to the same bytes"""
+    return gzip.compress(data, compresslevel=9, mtime=0)
+
+def identifier(name):
+    return 'ASSET_' + name.upper().replace('.', '_').replace('-', '_')
+
+def c_array(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append('    ' + ', '.join('0x%02x' % b for b in data[i:i + 16]))
+    return ',\n'.join(lines)
+
+def build():
+    """Return the generated header and source, and (name, raw, gzipped) sizes"""
+    assets = []
+    for name, path, content_type, macro in ASSETS:
+        with open(os.path.join(ASSET_DIR, name), 'rb') as f:
+            raw = f.read()
+        packed = compress(raw)
+        # Content hash of what is served: a changed file gets a new ETag and URL
+        etag = hashlib.sha256(packed).hexdigest()[:16]
+        assets.append((name, path, content_type, macro, raw, packed, etag))
+
+    header = ['/*',
+              ' * Web Assets Header',
+              ' * Generated by build_web_assets.py from web/; do not edit',
+              ' */',
+              '',
+              '#ifndef WEB_ASSETS_H',
+              '#define WEB_ASSETS_H',
+              '',
+              '#include <Arduino.h>',
+              '',
+              '// A gzipped static file kept in flash',
+              'struct WebAsset {',
+              '    const char* path;',
+              '    const char* contentType;',
+              '    const char* etag;             // Quoted, as sent in the ETag header',
+              '    const uint8_t* data;',
+              '    size_t length;',
+              '};',
+              '',
+              '// Versioned URLs for pages to link; the version is the ETag, so a',
+              '// browser may keep what it has under one of them forever']
+    for name, path, content_type, macro, raw, packed, etag in assets:
+        header.append('#define %s "%s?v=%s"' % (macro, path, etag))
+    header += ['',
+               'extern const WebAsset WEB_ASSETS[];',
+               'extern const size_t WEB_ASSET_COUNT;',
+               '',
+               '#endif // WEB_ASSETS_H',
+               '']
+
+    source = ['/*',
+              ' * Web Assets Implementation',
+              ' * Generated by build_web_assets.py from web/; do not edit',
+              ' */',
+              '',
+              '#include "web_assets.h"',
+              '']
+    for name, path, content_type, macro, raw, packed, etag in assets:
+        source.append('// %s: %d bytes, %d gzipped' % (name, len(raw), len(packed)))
+        source.append('static const uint8_t %s[] PROGMEM = {' % identifier(name))
+        source.append(c_array(packed))
+        source.append('};')
+        source.append('')
+    source.append('const WebAsset WEB_ASSETS[] = {')
+    for name, path, content_type, macro, raw, packed, etag in assets:
+        source.append('    {"%s", "%s", "\\"%s\\"", %s, sizeof(%s)},' %
+                      (path, content_type, etag, identifier(name), identifier(name)))
+    source += ['};',
+               '',
+               'const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);',
+               '']
+
+    sizes = [(name, len(raw), len(packed)) for name, path, content_type, macro, raw, packed, etag in assets]
+    return '\n'.join(header), '\n'.join(source), sizes
+
+def is_current():
+    """True when web_assets.h/.cpp match what web/ builds to"""
+    header, source, sizes = build()
+    for file, content in ((HEADER_FILE, header), (SOURCE_FILE, source)):
+        if not os.path.exists(file):
+            return False
+        with open(file, 'r') as f:
+            if f.read() != content:
+                return False
+    return True
+
+def main():
+    if '--check' in sys.argv:
+        if is_current():
+            print("✅ Web assets are up to date")
+            return 0
+        print("❌ Web assets are stale; run python3 build_web_assets.py")
+        return 1
+
+    header, source, sizes = build()
+    with open(HEADER_FILE, 'w') as f:
+        f.write(header)
+    with open(SOURCE_FILE, 'w') as f:
+        f.write(source)
+
+    total_raw = 0
+    total_packed = 0
+    for name, raw, packed in sizes:
+        print("%-12s %6d bytes -> %5d gzipped" % (name, raw, packed))
+        total_raw += raw
+        total_packed += packed
+    print("%-12s %6d bytes -> %5d gzipped" % ('total', total_raw, total_packed))
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,127 @@
+/*
+ * Chunked Response Implementation
+ * Streams a web response through one fixed buffer with chunked transfer encoding
+ */
+
+#include "chunked_response.h"
+#include <stdarg.h>
+
+static_assert(WEB_SEND_BUFFER_SIZE <= 0xFFFF, "Chunk sizes are written as four hex digits");
+
+static const size_t CAPACITY = WEB_SEND_BUFFER_SIZE;
+
+ChunkedResponse::ChunkedResponse() {
+    length = 0;
+    framed = false;
+    overflow = false;
+}
+
+void ChunkedResponse::reset(bool chunked) {
+    length = 0;
+    framed = chunked;
+    overflow = false;
+}
+
+void ChunkedResponse::write(const char* data, size_t dataLength) {
+    if (dataLength > CAPACITY - length) {
+        dataLength = CAPACITY - length;
+        overflow = true;
+    }
+    memcpy(buffer + CHUNK_HEAD_SIZE + length, data, dataLength);
+    length += dataLength;
+}
+
+void ChunkedResponse::print(const char* text) {
+    write(text, strlen(text));
+}
+
+void ChunkedResponse::print(const String& text) {
+    write(text.c_str(), text.length());
+}
+
+void ChunkedResponse::printf(const char* format, ...) {
+    // The terminating NUL lands in the tail reserve, which finish() overwrites
+    va_list args;
+    va_start(args, format);
+    int needed = vsnprintf(buffer + CHUNK_HEAD_SIZE + length, CAPACITY - length + 1, format, args);
+    va_end(args);
+    if (needed < 0) {
+        return;
+    }
+
+    if ((size_t)needed > CAPACITY - length) {
+        needed = CAPACITY - length;
+        overflow = true;
+    }
+    length += needed;
+}
+
+size_t ChunkedResponse::mark() const {
+    return length;
+}
+
+bool ChunkedResponse::commit(size_t mark) {
+    if (!overflow) {
+        return true;
+    }
+    overflow = false;
+    if (mark == 0) {
+        return true;
+    }
+    length = mark;
+    return false;
+}
+
+size_t ChunkedResponse::size() const {
+    return length;
+}
+
+const char* ChunkedResponse::finish(bool last, size_t& size) {
+    char* payload = buffer + CHUNK_HEAD_SIZE;
+    if (!framed) {
+        size = length;
+        return payload;
+    }
+
+    if (length == 0) {
+        // An empty chunk ends the body, so it is only sent last
+        if (!last) {
+            size = 0;
+            return payload;
+        }
+        memcpy(payload, "0\r\n\r\n", 5);
+        size = 5;
+        return payload;
+    }
+
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+    buffer[0] = HEX_DIGITS[(length >> 12) & 0xF];
+    buffer[1] = HEX_DIGITS[(length >> 8) & 0xF];
+    buffer[2] = HEX_DIGITS[(length >> 4) & 0xF];
+    buffer[3] = HEX_DIGITS[length & 0xF];
+    buffer[4] = '\r';
+    buffer[5] = '\n';
+    size_t end = CHUNK_HEAD_SIZE + length;
+    memcpy(buffer + end, "\r\n", 2);
+    end += 2;
+    if (last) {
+        memcpy(buffer + end, "0\r\n\r\n", 5);
+        end += 5;
+    }
+    size = end;
+    return buffer;
+}
+
+ChunkedPrint::ChunkedPrint(ChunkedResponse& response) : out(response) {
+}
+
+size_t ChunkedPrint::write(uint8_t c) {
+    out.write((const char*)&c, 1);
+    return 1;
+}
+
+size_t ChunkedPrint::write(const uint8_t* data, size_t length) {
+    // What does not fit is cut off and noted, as with any other write
+    out.write((const char*)data, length);
+    return length;
+}
@@ -0,0 +1,69 @@
+/*
+ * Chunked Response Header
+ * Streams a web response through one fixed buffer with chunked transfer encoding
+ */
+
+#ifndef CHUNKED_RESPONSE_H
+#define CHUNKED_RESPONSE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Room kept in front of the payload for the chunk size line ("XXXX\r\n")
+// and behind it for the chunk end plus the terminating chunk ("\r\n0\r\n\r\n")
+#define CHUNK_HEAD_SIZE 6
+#define CHUNK_TAIL_SIZE 7
+
+// One connection's output buffer. Pages that grow with the result count
+// are written into it a piece at a time and sent as one chunk per fill,
+// so a response costs WEB_SEND_BUFFER_SIZE bytes however many rows it has.
+// Writes past the end are cut off and remembered, so a writer can take
+// back a row that did not fit and start the next chunk with it
+class ChunkedResponse {
+public:
+    ChunkedResponse();
+
+    // Empty the buffer; framed output is sent as one chunk, unframed
+    // output (headers, HTTP/1.0 bodies) as it is
+    void reset(bool framed);
+
+    void write(const char* data, size_t length);
+    void print(const char* text);
+    void print(const String& text);
+
+    // Formatted text longer than the space left is cut to fit it
+    void printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    // Start of a piece that should not be split across chunks
+    size_t mark() const;
+
+    // False, with the piece taken back, if it ran past the buffer; a piece
+    // too big even for an empty buffer is kept, cut off
+    bool commit(size_t mark);
+
+    // Payload bytes buffered
+    size_t size() const;
+
+    // Add the framing (last also ends the body) and return what to send
+    const char* finish(bool last, size_t& length);
+
+private:
+    char buffer[CHUNK_HEAD_SIZE + WEB_SEND_BUFFER_SIZE + CHUNK_TAIL_SIZE];
+    size_t length;
+    bool framed;
+    bool overflow;
+};
+
+// A Print onto a response, so ArduinoJson can serialize straight into it
+class ChunkedPrint : public Print {
+public:
+    explicit ChunkedPrint(ChunkedResponse& out);
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* data, size_t length) override;
+
+private:
+    ChunkedResponse& out;
+};
+
+#endif // CHUNKED_RESPONSE_H
@@ -6,39 +6,131 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-#include <vector>
 #include <IPAddress.h>
 
 // Network configuration
 #define ETH_CONNECTION_TIMEOUT 10000  // 10 seconds
 #define SCAN_TIMEOUT 1000            // 1 second per IP
 #define PORT_TIMEOUT 3000            // 3 seconds per port
-#define MAX_CONCURRENT_SCANS 5       // Maximum concurrent scans
+#define MAX_CONCURRENT_SCANS 5       // Maximum concurrent scans (bounded by LWIP_MAX_SOCKETS)
+#define MAX_CONCURRENT_PORT_PROBES 4 // Port connects in flight alongside the sweep (same socket budget)
+#define PORT_PROBE_QUEUE_SIZE 64     // (host, port) pairs waiting for a port probe socket
+#define SYN_SCAN_SLOTS 64            // (host, port) pairs queued or awaiting a SYN reply (no sockets used)
+#define SYN_SEND_BATCH 16            // SYNs handed to the lwIP thread per call
+#define SYN_REPLY_RING 32            // Replies buffered between the lwIP thread and the scan task
 #define SCAN_INTERVAL 60000          // 1 minute between automatic scans
 
-// Target ports for scanning
-const std::vector<int> TARGET_PORTS = {
-    80,     // HTTP
-    443,    // HTTPS
-    502,    // MODBUS TCP
-    47808   // BACnet
-};
+// Target ports for scanning (profiles and port names live in service_catalog.cpp)
+#define DEFAULT_SCAN_PROFILE "default" // TCP and UDP ports scanned unless the scan page names others
+#define SCAN_MAX_PORTS 128           // TCP plus UDP ports per scan (the largest profile must fit)
 
 // Network scanning configuration
 #define PING_TIMEOUT 1000           // 1 second ping timeout
 #define MAX_PING_ATTEMPTS 3         // Maximum ping attempts
-#define SCAN_DELAY 10               // Delay between scans in ms
+#define SWEEP_POLL_INTERVAL 10      // select() wait per sweep poll in ms
+#define SWEEP_SOCKET_RETRIES 20     // Submits of a host while all sockets are held outside the sweep
+#define SWEEP_SOCKET_BACKOFF 50     // Idle wait per poll while those are retried in ms
+#define TARGET_MAX_RANGES 8         // CIDR blocks or ranges per target list (and per exclusion list)
+#define TARGET_MIN_PREFIX 8         // Largest block accepted in a target list
+#define ARP_SCAN_ENABLED 1          // Use ARP for on-link ranges instead of TCP connects
+#define ARP_REPLY_WINDOW 200        // Time to collect ARP replies per burst in ms
+#define ARP_REQUEST_ATTEMPTS 2      // ARP requests sent per host within the window
+
+// Ports tried in order to decide whether a host is alive
+constexpr uint16_t LIVENESS_PORTS[] = {
+    80,     // HTTP
+    443     // HTTPS
+};
+
+// BACnet/IP discovery (UDP); 47808 in a port list selects it instead of a TCP probe
+#define BACNET_PORT 47808           // BACnet/IP UDP port
+#define BACNET_DISCOVERY_WINDOW 2000 // Time to collect I-Am replies after the Who-Is in ms
+#define BACNET_MAX_DEVICES 64       // I-Am replies kept per scan
+#define BACNET_CLIENT_SLOTS 8       // Devices whose properties are read in parallel
+#define BACNET_APDU_TIMEOUT 2000    // Wait for a confirmed-request reply in ms
+#define BACNET_APDU_RETRIES 2       // Resends before a device is reported with what it returned
+#define BACNET_STRING_LENGTH 64     // Longest property string kept, including the terminator
+
+// EtherNet/IP discovery (UDP ListIdentity); ScanConfig turns it on and off
+#define ENIP_PORT 44818             // EtherNet/IP encapsulation port
+#define ENIP_DISCOVERY_WINDOW 2000  // Time to collect ListIdentity replies in ms
+#define ENIP_MAX_DEVICES 64         // ListIdentity replies kept per scan
+
+// Modbus TCP device identification (FC 0x2B/0x0E) of hosts with 502 open
+#define MODBUS_PORT 502             // Modbus TCP port
+#define MODBUS_CLIENT_SLOTS 2       // Hosts identified in parallel (one socket each, bounded by LWIP_MAX_SOCKETS)
+#define MODBUS_PIPELINE_DEPTH 4     // Requests in flight on one connection
+#define MODBUS_RESPONSE_TIMEOUT 3000 // Wait for a reply in ms (gateways take their own serial timeout first)
+#define MODBUS_RECONNECTS 2         // Reconnects after a device hangs up mid-sweep
+#define MODBUS_STRING_LENGTH 32     // Longest identification string kept, including the terminator
+
+// Unit IDs asked on every Modbus host (the scan page can override; 255 and 1
+// reach most direct devices, gateways need their serial addresses listed)
+constexpr uint8_t MODBUS_UNIT_IDS[] = {
+    255,    // Direct devices, per the Modbus TCP spec
+    1       // Devices that ignore the spec, and a gateway's first address
+};
+
+// Banner grabbing on open ports (TCP connect scans; one read buffer per probe socket)
+#define BANNER_BUFFER_SIZE 1024     // Reply bytes kept per open port
+#define BANNER_TIMEOUT 2000         // Wait for the reply to a sent probe (HTTP, Modbus) in ms
+#define BANNER_WAIT 1000            // Wait for a server that speaks first (SSH, FTP, ...) in ms
+#define FINGERPRINT_DETAIL_LENGTH 48 // Longest fingerprint string kept, including the terminator
+#define FINGERPRINT_MAX 4           // Fingerprints kept per open port
+
+// UDP port scanning (one socket per scan; closed ports answer with ICMP port unreachable)
+#define UDP_SCAN_SLOTS 32           // (host, port) pairs queued or awaiting a reply
+#define UDP_SEND_BATCH 16           // Datagrams sent per poll
+#define UDP_ICMP_RING 16            // ICMP errors buffered between the lwIP thread and the scan task
+#define UDP_MIN_TIMEOUT 1000        // Floor for the reply wait in ms (services answer slower than stacks)
+#define UDP_HOST_SLOTS 16           // Hosts with an ICMP budget tracked at once
+#define UDP_ICMP_BURST 6            // Probes a host gets before its ICMP rate limit applies (Linux default)
+#define UDP_ICMP_INTERVAL 1000      // One more probe per host per interval in ms
+
+// Probe pacing defaults (the scan page can override the first three; 0 = no limit)
+#define PACER_PROBES_PER_SECOND 200 // Global probe budget across all scan engines
+#define PACER_HOST_CONCURRENCY 2    // Probes in flight to any one host
+#define PACER_HOST_GAP 20           // Minimum ms between probes to one host
+#define PACER_BURST 10              // Probes the global bucket can save up
+#define PACER_HOST_SLOTS 32         // Hosts tracked at once (must exceed MAX_CONCURRENT_SCANS)
+
+// Adaptive probe timeouts (RFC 6298 style RTT estimation)
+// PING_TIMEOUT and PORT_TIMEOUT act as the ceilings
+#define RTT_MIN_TIMEOUT 100         // Floor for estimated probe timeouts in ms
+#define RTT_CLOCK_GRANULARITY 10    // Clock granularity term of the timeout formula in ms
+#define RTT_MIN_SAMPLES 3           // Samples before a subnet estimate is trusted
+#define RTT_MAX_BACKOFF 3           // Maximum timeout doublings for a silent host
+#define RTT_HOST_SLOTS 64           // Per-host estimates kept
+#define RTT_SUBNET_SLOTS 8          // Per-subnet estimates kept
+#define RTT_SUBNET_MASK 0xFFFFFF00  // Hosts sharing a /24 share a subnet estimate
+
+// Scan task (loop() and the web server run on core 1)
+#define SCAN_TASK_CORE 0            // Core the scan task is pinned to
+#define SCAN_TASK_PRIORITY 1        // Same as loop() so neither starves the other
+#define SCAN_TASK_STACK 8192        // Scan task stack in bytes
+#define SCAN_JOB_QUEUE_DEPTH 4      // Jobs waiting behind the running one
+#define SCAN_RESULT_QUEUE_DEPTH 16  // Results waiting to be drained by loop()
+
+// Web server task (woken by socket events, never polled)
+#define WEB_TASK_CORE 1             // Same core as loop(); the scan task has core 0
+#define WEB_TASK_PRIORITY 2         // Above loop() so requests are answered while loop() works
+#define WEB_TASK_STACK 8192         // Web task stack in bytes (handlers build their pages here)
 
 // Serial configuration
 #define SERIAL_BAUD_RATE 115200
 
 // Memory management
 #define MAX_DEVICES 254             // Maximum devices to track
-#define DEVICE_CACHE_SIZE 50        // Cache size for discovered devices
+#define PORT_RESULT_CAPACITY 1024   // Port results cached by PortScanner, oldest dropped first (power of two)
+#define SCAN_RESULT_MAX_PORTS 24    // TCP plus UDP ports recorded per host; longer port lists are cut
+#define SCAN_RESULT_FINGERPRINTS 8  // Fingerprints kept per host
+#define STRING_POOL_SIZE 8192       // Interned result strings (hostnames, banners) in bytes
+#define STRING_POOL_BUCKETS 512     // Dedup index slots (power of two)
+#define HOST_TABLE_PAGES 16         // 256-host pages in the device table (16 = a /20, ~57 KB)
+#define DEVICE_MAX_AGE (SCAN_INTERVAL * 5)  // Forget devices not seen for this long
 
 // Error handling
-#define MAX_RETRY_ATTEMPTS 3        // Maximum retry attempts for failed operations
-#define RETRY_DELAY 1000           // Delay between retry attempts
+#define MAX_RETRY_ATTEMPTS 3        // Connect attempts per port when it times out
 
 // Debug configuration
 #define DEBUG_NETWORK 1             // Enable network debugging
@@ -49,7 +141,20 @@ const std::vector<int> TARGET_PORTS = {
 #define WEB_SERVER_PORT 80          // Web server port
 #define MAX_SCAN_RESULTS 100        // Maximum scan results to store
 #define WEB_UPDATE_INTERVAL 1000    // Web interface update interval in ms
-#define CSV_BUFFER_SIZE 8192        // CSV export buffer size
+#define WEB_MAX_CONNECTIONS 4       // Clients served at once (one socket each, bounded by LWIP_MAX_SOCKETS); more wait in the backlog
+#define WEB_REQUEST_BUFFER_SIZE 2048 // Request line, headers and form body of one request
+#define WEB_SEND_BUFFER_SIZE 2048   // Response buffer of each connection; streamed pages are refilled as it drains
+#define WEB_IDLE_TIMEOUT 5000       // Close connections idle (or not reading their response) this long, in ms
+#define WEB_EVICT_IDLE 1000         // A keep-alive connection idle this long gives its slot to a waiting client, in ms
+#define WEB_SELECT_TIMEOUT 250      // Longest select() wait of the web task in ms (bounds idle checks only)
+#define WEB_MAX_EVENT_CLIENTS 2     // Pages following /events at once (each also takes a connection)
+#define WEB_EVENT_BUFFER_SIZE 4096  // Events queued per client; one that falls further behind misses events (and is told)
+#define WEB_EVENT_LATEST_SIZE 256   // Newest status event per client (replaced, never queued)
+#define WEB_EVENT_RETRY 3000        // Reconnect delay browsers are given for /events, in ms
+#define WEB_API_RESULTS_LIMIT 100   // /api/results page size when no limit is given
+#define WEB_API_RESULTS_MAX 1000    // Largest page /api/results serves
+#define WEB_API_RECORD_SIZE 3072    // ArduinoJson pool for one /api/results record (pages are streamed record by record)
+#define WEB_ASSET_MAX_AGE 31536000 // Cache lifetime of the static assets in s (their URLs change with their content)
 
 // Network configuration options
 #define SUPPORT_STATIC_IP 1         // Enable static IP configuration
@@ -73,6 +178,8 @@ const std::vector<int> TARGET_PORTS = {
 #define WIFI_RETRY_DELAY 5000       // 5 seconds between WiFi retry attempts
 #define WIFI_MAX_RETRIES 3          // Maximum WiFi connection retries
 #define WIFI_SCAN_TIMEOUT 10000     // 10 seconds for WiFi network scan
+#define WIFI_SCAN_CACHE_AGE 10000   // /wifi-scan reuses a scan this recent
+#define WIFI_STATUS_REFRESH 2000    // How often the WiFi page's status is copied
 #define WIFI_AP_MODE_TIMEOUT 300000 // 5 minutes in AP mode before retry
 
 // Access Point configuration (when no known networks available)
@@ -0,0 +1,217 @@
+/*
+ * Connect Pool Implementation
+ * Keeps several non-blocking TCP connect attempts in flight at once
+ */
+
+#include "connect_pool.h"
+#include <lwip/sockets.h>
+
+ConnectPool::ConnectPool() {
+    activeCount = 0;
+}
+
+ConnectPool::~ConnectPool() {
+    cancelAll();
+}
+
+void ConnectPool::begin(size_t maxSlots) {
+    cancelAll();
+
+    if (maxSlots == 0) {
+        maxSlots = 1;
+    }
+
+    slots.assign(maxSlots, Slot());
+    for (auto& slot : slots) {
+        slot.active = false;
+        slot.fd = -1;
+    }
+    activeCount = 0;
+}
+
+bool ConnectPool::submit(IPAddress target, uint16_t port, unsigned long timeout,
+                         uint32_t tag, bool keepOpen) {
+    Slot* freeSlot = nullptr;
+    for (auto& slot : slots) {
+        if (!slot.active) {
+            freeSlot = &slot;
+            break;
+        }
+    }
+
+    if (!freeSlot) {
+        return false;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) {
+        return false;
+    }
+
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = (uint32_t)target;
+
+    freeSlot->active = true;
+    freeSlot->fd = fd;
+    freeSlot->target = target;
+    freeSlot->port = port;
+    freeSlot->tag = tag;
+    freeSlot->keepOpen = keepOpen;
+    freeSlot->startTime = millis();
+    freeSlot->timeout = timeout;
+    freeSlot->immediateError = 0;
+    freeSlot->armed = false;
+    activeCount++;
+
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+        // Immediate failures are reported on the next poll so callers
+        // see a single completion path
+        freeSlot->immediateError = errno;
+    }
+
+    return true;
+}
+
+int ConnectPool::poll(unsigned long waitMs, ConnectCallback callback) {
+    if (activeCount == 0) {
+        return 0;
+    }
+
+    fd_set writeSet;
+    fd_set errorSet;
+    FD_ZERO(&writeSet);
+    FD_ZERO(&errorSet);
+    int maxFd = -1;
+
+    for (auto& slot : slots) {
+        slot.armed = slot.active;
+        if (slot.active) {
+            FD_SET(slot.fd, &writeSet);
+            FD_SET(slot.fd, &errorSet);
+            if (slot.fd > maxFd) {
+                maxFd = slot.fd;
+            }
+        }
+    }
+
+    struct timeval tv;
+    tv.tv_sec = waitMs / 1000;
+    tv.tv_usec = (waitMs % 1000) * 1000;
+
+    int ready = select(maxFd + 1, nullptr, &writeSet, &errorSet, &tv);
+    int completed = 0;
+    unsigned long now = millis();
+
+    for (auto& slot : slots) {
+        // Slots refilled by a callback during this pass were not part of
+        // the select() set and may reuse a descriptor number
+        if (!slot.active || !slot.armed) {
+            continue;
+        }
+
+        if (slot.immediateError != 0) {
+            complete(slot, classifyError(slot.immediateError), callback);
+            completed++;
+        } else if (ready > 0 && (FD_ISSET(slot.fd, &writeSet) || FD_ISSET(slot.fd, &errorSet))) {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(slot.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            complete(slot, err == 0 ? CONNECT_OPEN : classifyError(err), callback);
+            completed++;
+        } else if (now - slot.startTime >= slot.timeout) {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(slot.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            complete(slot, err == 0 ? CONNECT_TIMEOUT : classifyError(err), callback);
+            completed++;
+        }
+    }
+
+    return completed;
+}
+
+void ConnectPool::cancelAll() {
+    for (auto& slot : slots) {
+        if (slot.active) {
+            closeSocket(slot.fd);
+            slot.active = false;
+            slot.fd = -1;
+        }
+    }
+    activeCount = 0;
+}
+
+bool ConnectPool::hasFreeSlot() {
+    return activeCount < slots.size();
+}
+
+size_t ConnectPool::inFlight() {
+    return activeCount;
+}
+
+size_t ConnectPool::capacity() {
+    return slots.size();
+}
+
+void ConnectPool::complete(Slot& slot, ConnectOutcome outcome, ConnectCallback& callback) {
+    ConnectCompletion completion;
+    completion.target = slot.target;
+    completion.port = slot.port;
+    completion.tag = slot.tag;
+    completion.outcome = outcome;
+    completion.responseTime = millis() - slot.startTime;
+    completion.fd = -1;
+
+    if (outcome == CONNECT_OPEN && slot.keepOpen) {
+        // Ownership of the socket moves to the callback
+        completion.fd = slot.fd;
+    } else {
+        closeSocket(slot.fd);
+    }
+
+    // Free the slot before the callback so it can submit a follow-up
+    slot.active = false;
+    slot.fd = -1;
+    activeCount--;
+
+    if (callback) {
+        callback(completion);
+    } else if (completion.fd >= 0) {
+        closeSocket(completion.fd);
+    }
+}
+
+ConnectOutcome ConnectPool::classifyError(int err) {
+    switch (err) {
+        case ECONNREFUSED:
+        case ECONNRESET:
+            return CONNECT_REFUSED;
+        case ETIMEDOUT:
+        case EINPROGRESS:
+            return CONNECT_TIMEOUT;
+        case EHOSTUNREACH:
+        case ENETUNREACH:
+            return CONNECT_UNREACHABLE;
+        default:
+            return CONNECT_ERROR;
+    }
+}
+
+void ConnectPool::closeSocket(int fd) {
+    if (fd < 0) {
+        return;
+    }
+
+    // Abort with RST so lwIP frees the PCB immediately
+    struct linger lingerOpt;
+    lingerOpt.l_onoff = 1;
+    lingerOpt.l_linger = 0;
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &lingerOpt, sizeof(lingerOpt));
+    close(fd);
+}
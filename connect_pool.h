@@ -0,0 +1,84 @@
+/*
+ * Connect Pool Header
+ * Keeps several non-blocking TCP connect attempts in flight at once
+ */
+
+#ifndef CONNECT_POOL_H
+#define CONNECT_POOL_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+#include <IPAddress.h>
+#include "config.h"
+
+enum ConnectOutcome {
+    CONNECT_OPEN,         // Handshake completed
+    CONNECT_REFUSED,      // Host answered with RST
+    CONNECT_TIMEOUT,      // No answer before the deadline
+    CONNECT_UNREACHABLE,  // Host or network unreachable
+    CONNECT_ERROR         // Local socket failure
+};
+
+struct ConnectCompletion {
+    IPAddress target;
+    uint16_t port;
+    uint32_t tag;
+    ConnectOutcome outcome;
+    unsigned long responseTime;
+    int fd;                    // Connected socket when keepOpen was requested, else -1
+};
+
+typedef std::function<void(const ConnectCompletion&)> ConnectCallback;
+
+class ConnectPool {
+public:
+    ConnectPool();
+    ~ConnectPool();
+
+    // Allocate the slot table (call once, before submitting)
+    void begin(size_t maxSlots = MAX_CONCURRENT_SCANS);
+
+    // Start a non-blocking connect; returns false when no slot is free
+    bool submit(IPAddress target, uint16_t port, unsigned long timeout,
+                uint32_t tag, bool keepOpen = false);
+
+    // Wait up to waitMs for activity and report every finished attempt
+    int poll(unsigned long waitMs, ConnectCallback callback);
+
+    // Abort all in-flight attempts without reporting them
+    void cancelAll();
+
+    // Slot accounting
+    bool hasFreeSlot();
+    size_t inFlight();
+    size_t capacity();
+
+    // Close a socket without lingering in TIME_WAIT (also for kept sockets)
+    static void closeSocket(int fd);
+
+private:
+    struct Slot {
+        bool active;
+        int fd;
+        IPAddress target;
+        uint16_t port;
+        uint32_t tag;
+        bool keepOpen;
+        unsigned long startTime;
+        unsigned long timeout;
+        int immediateError;
+        bool armed;           // Part of the current select() set
+    };
+
+    std::vector<Slot> slots;
+    size_t activeCount;
+
+    // Finish a slot and hand the result to the callback
+    void complete(Slot& slot, ConnectOutcome outcome, ConnectCallback& callback);
+
+    // Map a socket error code to an outcome
+    ConnectOutcome classifyError(int err);
+};
+
+#endif // CONNECT_POOL_H
@@ -0,0 +1,285 @@
+/*
+ * EtherNet/IP Discovery Implementation
+ * Finds EtherNet/IP adapters with one ListIdentity broadcast per subnet
+ */
+
+#include "enip_discovery.h"
+#include "net_utils.h"
+#include "probe_pacer.h"
+#include <lwip/sockets.h>
+
+#define ENIP_HEADER_LENGTH 24
+#define COMMAND_LIST_IDENTITY 0x0063
+#define ITEM_CIP_IDENTITY 0x000C
+
+// Encapsulation fields are little-endian, unlike everything else on the wire
+static uint16_t readLE16(const uint8_t* data) {
+    return (uint16_t)data[0] | ((uint16_t)data[1] << 8);
+}
+
+static uint32_t readLE32(const uint8_t* data) {
+    return (uint32_t)readLE16(data) | ((uint32_t)readLE16(data + 2) << 16);
+}
+
+EnipDiscovery::EnipDiscovery() {
+    sock = -1;
+    startTime = 0;
+    window = 0;
+    memset(context, 0, sizeof(context));
+}
+
+EnipDiscovery::~EnipDiscovery() {
+    stop();
+}
+
+bool EnipDiscovery::start(const TargetIterator& scanTargets, unsigned long discoveryWindow) {
+    stop();
+    identities.clear();
+    sentTo.clear();
+    targets = scanTargets;
+    window = discoveryWindow;
+
+    // Replies echo the sender context; a fresh one per scan keeps late
+    // replies to an earlier scan out of this one
+    uint32_t cookie[2] = {esp_random(), esp_random()};
+    memcpy(context, cookie, sizeof(context));
+
+    if (!openSocket()) {
+        return false;
+    }
+
+    // One packet per subnet: a broadcast for the local segment, then a
+    // directed broadcast per target range that is not already covered
+    sendListIdentity(IPAddress(255, 255, 255, 255));
+
+    for (size_t i = 0; i < targets.getRangeCount(); i++) {
+        IPAddress first, last;
+        targets.getRange(i, first, last);
+        sendListIdentity(coveringBroadcast(first, last));
+    }
+
+    startTime = millis();
+
+    #if DEBUG_NETWORK
+    Serial.printf("EtherNet/IP: ListIdentity sent to %u subnets, listening %lu ms\n",
+                  (unsigned)sentTo.size(), window);
+    #endif
+    return true;
+}
+
+bool EnipDiscovery::poll(EnipIdentityCallback callback, unsigned long waitMs) {
+    if (sock < 0) {
+        return false;
+    }
+
+    unsigned long elapsed = millis() - startTime;
+    if (elapsed >= window) {
+        stop();
+        return false;
+    }
+
+    unsigned long wait = window - elapsed;
+    if (wait > waitMs) {
+        wait = waitMs;
+    }
+
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    FD_SET(sock, &readSet);
+    struct timeval tv;
+    tv.tv_sec = wait / 1000;
+    tv.tv_usec = (wait % 1000) * 1000;
+
+    if (select(sock + 1, &readSet, nullptr, nullptr, &tv) <= 0) {
+        return true;
+    }
+
+    uint8_t frame[ENIP_FRAME_SIZE];
+    std::vector<EnipIdentity> found;
+    for (;;) {
+        struct sockaddr_in from;
+        socklen_t fromLength = sizeof(from);
+        int received = recvfrom(sock, frame, sizeof(frame), 0, (struct sockaddr*)&from, &fromLength);
+        if (received <= 0) {
+            break;
+        }
+
+        IPAddress source(from.sin_addr.s_addr);
+        if (!targets.contains(source)) {
+            continue;
+        }
+
+        found.clear();
+        if (!parseListIdentity(frame, received, context, source, found)) {
+            continue;
+        }
+
+        for (const auto& identity : found) {
+            if (isKnown(identity) || identities.size() >= ENIP_MAX_DEVICES) {
+                continue;
+            }
+            identities.push_back(identity);
+
+            #if DEBUG_NETWORK
+            Serial.printf("EtherNet/IP: \"%s\" at %s (vendor %u, type %u, product %u, serial %08X)\n",
+                          identity.productName.c_str(), identity.address.toString().c_str(),
+                          identity.vendorId, identity.deviceType, identity.productCode,
+                          identity.serialNumber);
+            #endif
+
+            if (callback) {
+                callback(identity);
+            }
+        }
+    }
+
+    return true;
+}
+
+void EnipDiscovery::stop() {
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+}
+
+bool EnipDiscovery::isActive() {
+    return sock >= 0;
+}
+
+const std::vector<EnipIdentity>& EnipDiscovery::getIdentities() {
+    return identities;
+}
+
+size_t EnipDiscovery::buildListIdentity(uint8_t* buffer, size_t size, const uint8_t* senderContext) {
+    if (size < ENIP_HEADER_LENGTH) {
+        return 0;
+    }
+
+    // Command, length 0, session 0, status 0, sender context, options 0
+    memset(buffer, 0, ENIP_HEADER_LENGTH);
+    buffer[0] = (uint8_t)COMMAND_LIST_IDENTITY;
+    buffer[1] = (uint8_t)(COMMAND_LIST_IDENTITY >> 8);
+    memcpy(buffer + 12, senderContext, ENIP_CONTEXT_LENGTH);
+    return ENIP_HEADER_LENGTH;
+}
+
+bool EnipDiscovery::parseListIdentity(const uint8_t* data, size_t length, const uint8_t* senderContext,
+                                      IPAddress source, std::vector<EnipIdentity>& found) {
+    if (length < ENIP_HEADER_LENGTH + 2 || readLE16(data) != COMMAND_LIST_IDENTITY) {
+        return false;
+    }
+
+    // Our own broadcast looping back is too short to get here; a reply to
+    // someone else's request carries their context
+    size_t dataLength = readLE16(data + 2);
+    if (readLE32(data + 8) != 0 || memcmp(data + 12, senderContext, ENIP_CONTEXT_LENGTH) != 0 ||
+        ENIP_HEADER_LENGTH + dataLength > length) {
+        return false;
+    }
+    length = ENIP_HEADER_LENGTH + dataLength;
+
+    size_t pos = ENIP_HEADER_LENGTH;
+    if (pos + 2 > length) {
+        return false;
+    }
+    uint16_t itemCount = readLE16(data + pos);
+    pos += 2;
+
+    for (uint16_t item = 0; item < itemCount; item++) {
+        if (pos + 4 > length) {
+            return false;
+        }
+        uint16_t type = readLE16(data + pos);
+        size_t itemLength = readLE16(data + pos + 2);
+        pos += 4;
+        if (pos + itemLength > length) {
+            return false;
+        }
+
+        // Protocol version, socket address (16), vendor, device type,
+        // product code, revision, status, serial, name, state
+        const uint8_t* body = data + pos;
+        if (type == ITEM_CIP_IDENTITY && itemLength >= 33 && 33 + (size_t)body[32] <= itemLength) {
+            EnipIdentity identity;
+            identity.address = source;
+            identity.vendorId = readLE16(body + 18);
+            identity.deviceType = readLE16(body + 20);
+            identity.productCode = readLE16(body + 22);
+            identity.revisionMajor = body[24];
+            identity.revisionMinor = body[25];
+            identity.serialNumber = readLE32(body + 28);
+
+            char name[ENIP_NAME_LENGTH];
+            size_t out = 0;
+            for (size_t i = 0; i < body[32] && out + 1 < sizeof(name); i++) {
+                char c = (char)body[33 + i];
+                if (c < 0x20 || c > 0x7E || c == '"' || c == '<' || c == '>') {
+                    c = '?';
+                }
+                name[out++] = c;
+            }
+            name[out] = '\0';
+            identity.productName = name;
+            found.push_back(identity);
+        }
+        pos += itemLength;
+    }
+
+    return !found.empty();
+}
+
+bool EnipDiscovery::openSocket() {
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        return false;
+    }
+
+    int enable = 1;
+    setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable));
+
+    int flags = fcntl(sock, F_GETFL, 0);
+    fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+
+    // Adapters answer the port the request came from
+    struct sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = 0;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    bind(sock, (struct sockaddr*)&local, sizeof(local));
+    return true;
+}
+
+void EnipDiscovery::sendListIdentity(IPAddress destination) {
+    uint32_t address = (uint32_t)destination;
+    for (uint32_t sent : sentTo) {
+        if (sent == address) {
+            return;
+        }
+    }
+    sentTo.push_back(address);
+
+    uint8_t frame[ENIP_HEADER_LENGTH];
+    size_t length = buildListIdentity(frame, sizeof(frame), context);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(ENIP_PORT);
+    addr.sin_addr.s_addr = address;
+
+    probePacer.acquire(destination);
+    sendto(sock, frame, length, 0, (struct sockaddr*)&addr, sizeof(addr));
+    probePacer.release(destination);
+}
+
+bool EnipDiscovery::isKnown(const EnipIdentity& identity) {
+    for (const auto& known : identities) {
+        if (known.address == identity.address && known.serialNumber == identity.serialNumber &&
+            known.vendorId == identity.vendorId) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,73 @@
+/*
+ * EtherNet/IP Discovery Header
+ * Finds EtherNet/IP adapters with one ListIdentity broadcast per subnet
+ */
+
+#ifndef ENIP_DISCOVERY_H
+#define ENIP_DISCOVERY_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+#include <IPAddress.h>
+#include "config.h"
+#include "target_iterator.h"
+
+#define ENIP_FRAME_SIZE 576           // Largest ListIdentity reply we accept
+#define ENIP_CONTEXT_LENGTH 8         // Sender context echoed by every reply
+#define ENIP_NAME_LENGTH 33           // Product name (SHORT_STRING, 32 max) plus the terminator
+
+// CIP Identity item of a ListIdentity reply
+struct EnipIdentity {
+    IPAddress address;        // Where the reply came from
+    uint16_t vendorId;
+    uint16_t deviceType;
+    uint16_t productCode;
+    uint8_t revisionMajor;
+    uint8_t revisionMinor;
+    uint32_t serialNumber;
+    String productName;
+};
+
+// Called once per identity, the first time it is seen
+typedef std::function<void(const EnipIdentity&)> EnipIdentityCallback;
+
+class EnipDiscovery {
+public:
+    EnipDiscovery();
+    ~EnipDiscovery();
+
+    // Open the socket and send ListIdentity to the segment and to every
+    // target range; replies are then collected for window ms
+    bool start(const TargetIterator& targets, unsigned long window = ENIP_DISCOVERY_WINDOW);
+
+    // Collect replies; returns false once the window has closed
+    bool poll(EnipIdentityCallback callback, unsigned long waitMs = SWEEP_POLL_INTERVAL);
+
+    // Close the socket; identities stay available until the next start
+    void stop();
+
+    bool isActive();
+    const std::vector<EnipIdentity>& getIdentities();
+
+    // Frame codecs (encapsulation header + CPF items). parseListIdentity
+    // appends one identity per CIP Identity item in the reply
+    static size_t buildListIdentity(uint8_t* buffer, size_t size, const uint8_t* context);
+    static bool parseListIdentity(const uint8_t* data, size_t length, const uint8_t* context,
+                                  IPAddress source, std::vector<EnipIdentity>& found);
+
+private:
+    int sock;
+    unsigned long startTime;
+    unsigned long window;
+    uint8_t context[ENIP_CONTEXT_LENGTH];
+    TargetIterator targets;
+    std::vector<EnipIdentity> identities;
+    std::vector<uint32_t> sentTo;     // Destinations already sent to this scan
+
+    bool openSocket();
+    void sendListIdentity(IPAddress destination);
+    bool isKnown(const EnipIdentity& identity);
+};
+
+#endif // ENIP_DISCOVERY_H
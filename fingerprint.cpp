@@ -0,0 +1,344 @@
+/*
+ * Fingerprint Implementation
+ * Table-driven service probes and banner parsers
+ */
+
+#include "fingerprint.h"
+#include "modbus_client.h"
+
+// Parsers read the reply in place and copy out only the detail string
+typedef bool (*FingerprintParser)(const uint8_t* data, size_t length, char* detail, size_t size);
+
+struct FingerprintSignature {
+    FingerprintId id;
+    const char* name;
+    FingerprintParser parse;
+};
+
+static const uint8_t HTTP_REQUEST[] = "GET / HTTP/1.0\r\nUser-Agent: ESP32-NetScanner\r\n\r\n";
+
+// Read one holding register of unit 1; devices that do not serve it say
+// so with an exception
+static const uint8_t MODBUS_REQUEST[] = {0x00, 0x01, 0x00, 0x00, 0x00, 0x06, 0x01, 0x03, 0x00, 0x00, 0x00, 0x01};
+
+static const ServiceProbe SERVICE_PROBES[] = {
+    {PAYLOAD_HTTP,   HTTP_REQUEST, sizeof(HTTP_REQUEST) - 1, REPLY_UNTIL_CLOSE},
+    {PAYLOAD_TLS,    TlsProbe::CLIENT_HELLO, TlsProbe::CLIENT_HELLO_LENGTH, REPLY_TLS},
+    {PAYLOAD_MODBUS, MODBUS_REQUEST, sizeof(MODBUS_REQUEST), REPLY_MODBUS},
+    {PAYLOAD_NONE,   nullptr, 0, REPLY_FIRST_LINE}
+};
+
+// Copy printable text, trimmed, into detail; characters that would need
+// escaping in HTML or CSV become '?'
+static void copyText(const uint8_t* text, size_t length, char* detail, size_t size) {
+    while (length > 0 && (text[0] == ' ' || text[0] == '\t')) {
+        text++;
+        length--;
+    }
+    while (length > 0 && (text[length - 1] == ' ' || text[length - 1] == '\t')) {
+        length--;
+    }
+
+    size_t out = 0;
+    for (size_t i = 0; i < length && out + 1 < size; i++) {
+        char c = (char)text[i];
+        if (c < 0x20 || c > 0x7E || c == '"' || c == '<' || c == '>' || c == '&') {
+            c = '?';
+        }
+        detail[out++] = c;
+    }
+    detail[out] = '\0';
+}
+
+static bool startsWith(const uint8_t* data, size_t length, const char* prefix) {
+    size_t prefixLength = strlen(prefix);
+    return length >= prefixLength && memcmp(data, prefix, prefixLength) == 0;
+}
+
+// Length of the line starting at data, without its CR/LF
+static size_t lineLength(const uint8_t* data, size_t length) {
+    size_t i = 0;
+    while (i < length && data[i] != '\r' && data[i] != '\n') {
+        i++;
+    }
+    return i;
+}
+
+// Case-insensitive search for needle; returns its offset or length
+static size_t findText(const uint8_t* data, size_t length, const char* needle) {
+    size_t needleLength = strlen(needle);
+    for (size_t i = 0; i + needleLength <= length; i++) {
+        size_t j = 0;
+        while (j < needleLength && tolower(data[i + j]) == needle[j]) {
+            j++;
+        }
+        if (j == needleLength) {
+            return i;
+        }
+    }
+    return length;
+}
+
+static bool parseHttp(const uint8_t* data, size_t length, char* detail, size_t size) {
+    if (!startsWith(data, length, "HTTP/")) {
+        return false;
+    }
+
+    // Header lines up to the blank line; the Server value names the software
+    size_t pos = lineLength(data, length);
+    size_t statusLength = pos;
+    while (pos < length) {
+        while (pos < length && (data[pos] == '\r' || data[pos] == '\n')) {
+            if (data[pos] == '\n' && pos + 1 < length && (data[pos + 1] == '\r' || data[pos + 1] == '\n')) {
+                pos = length;
+                break;
+            }
+            pos++;
+        }
+        if (pos >= length) {
+            break;
+        }
+
+        size_t line = lineLength(data + pos, length - pos);
+        if (line > 7 && findText(data + pos, 7, "server:") == 0) {
+            copyText(data + pos + 7, line - 7, detail, size);
+            return true;
+        }
+        pos += line;
+    }
+
+    copyText(data, statusLength, detail, size);
+    return true;
+}
+
+static bool parseHttpTitle(const uint8_t* data, size_t length, char* detail, size_t size) {
+    if (!startsWith(data, length, "HTTP/")) {
+        return false;
+    }
+
+    size_t open = findText(data, length, "<title");
+    if (open >= length) {
+        return false;
+    }
+    size_t start = open + 6;
+    while (start < length && data[start] != '>') {
+        start++;
+    }
+    start++;
+    if (start >= length) {
+        return false;
+    }
+
+    size_t end = start + findText(data + start, length - start, "</");
+    copyText(data + start, end - start, detail, size);
+    return detail[0] != '\0';
+}
+
+static bool parseSsh(const uint8_t* data, size_t length, char* detail, size_t size) {
+    if (!startsWith(data, length, "SSH-")) {
+        return false;
+    }
+    copyText(data, lineLength(data, length), detail, size);
+    return true;
+}
+
+// 220 greetings name the protocol somewhere in the first line
+static bool parseGreeting(const uint8_t* data, size_t length, char* detail, size_t size, const char* protocol) {
+    if (!startsWith(data, length, "220")) {
+        return false;
+    }
+    size_t line = lineLength(data, length);
+    if (line < 4 || findText(data, line, protocol) >= line) {
+        return false;
+    }
+    copyText(data + 4, line - 4, detail, size);
+    return true;
+}
+
+static bool parseFtp(const uint8_t* data, size_t length, char* detail, size_t size) {
+    return parseGreeting(data, length, detail, size, "ftp");
+}
+
+static bool parseSmtp(const uint8_t* data, size_t length, char* detail, size_t size) {
+    return parseGreeting(data, length, detail, size, "smtp");
+}
+
+static bool parseTelnet(const uint8_t* data, size_t length, char* detail, size_t size) {
+    // IAC followed by SB/WILL/WONT/DO/DONT
+    if (length < 3 || data[0] != 0xFF || data[1] < 0xFA || data[1] > 0xFE) {
+        return false;
+    }
+
+    // Skip the option negotiation; a login prompt may follow
+    size_t pos = 0;
+    while (pos + 1 < length && data[pos] == 0xFF) {
+        if (data[pos + 1] == 0xFA) {
+            // Subnegotiation runs to IAC SE
+            pos += 2;
+            while (pos + 1 < length && !(data[pos] == 0xFF && data[pos + 1] == 0xF0)) {
+                pos++;
+            }
+            pos += 2;
+        } else {
+            pos += 3;
+        }
+    }
+    while (pos < length && (data[pos] == '\r' || data[pos] == '\n')) {
+        pos++;
+    }
+
+    if (pos < length) {
+        copyText(data + pos, lineLength(data + pos, length - pos), detail, size);
+    }
+    if (detail[0] == '\0') {
+        strncpy(detail, "option negotiation", size - 1);
+        detail[size - 1] = '\0';
+    }
+    return true;
+}
+
+static bool parseModbus(const uint8_t* data, size_t length, char* detail, size_t size) {
+    int frame = ModbusClient::frameLength(data, length);
+    if (frame < 9) {
+        return false;
+    }
+
+    uint8_t function = data[7];
+    if (function & 0x80) {
+        static const char* const EXCEPTIONS[] = {
+            "", "illegal function", "illegal data address", "illegal data value",
+            "server device failure", "acknowledge", "server device busy", "",
+            "memory parity error", "", "gateway path unavailable", "gateway target failed to respond"
+        };
+        uint8_t code = data[8];
+        const char* name = code < sizeof(EXCEPTIONS) / sizeof(EXCEPTIONS[0]) ? EXCEPTIONS[code] : "";
+        snprintf(detail, size, "unit %u exception %u %s", data[6], code, name);
+    } else {
+        snprintf(detail, size, "unit %u function %u answered", data[6], function);
+    }
+    return true;
+}
+
+// Last resort: the first line of a server that said something readable
+static bool parseBanner(const uint8_t* data, size_t length, char* detail, size_t size) {
+    size_t line = lineLength(data, length);
+    size_t printable = 0;
+    for (size_t i = 0; i < line; i++) {
+        if (data[i] >= 0x20 && data[i] <= 0x7E) {
+            printable++;
+        }
+    }
+    if (line < 3 || printable * 4 < line * 3) {
+        return false;
+    }
+    copyText(data, line, detail, size);
+    return true;
+}
+
+// Tried in order; a new signature only needs a parser and a row here.
+// The banner row only fires when nothing above it matched, and rows
+// without a parser are filled in by fingerprintTls
+static const FingerprintSignature SIGNATURES[] = {
+    {FINGERPRINT_HTTP,        "HTTP",    parseHttp},
+    {FINGERPRINT_HTTP_TITLE,  "Title",   parseHttpTitle},
+    {FINGERPRINT_SSH,         "SSH",     parseSsh},
+    {FINGERPRINT_FTP,         "FTP",     parseFtp},
+    {FINGERPRINT_SMTP,        "SMTP",    parseSmtp},
+    {FINGERPRINT_TELNET,      "Telnet",  parseTelnet},
+    {FINGERPRINT_MODBUS,      "Modbus",  parseModbus},
+    {FINGERPRINT_TLS,         "TLS",     nullptr},
+    {FINGERPRINT_TLS_SUBJECT, "Subject", nullptr},
+    {FINGERPRINT_TLS_ISSUER,  "Issuer",  nullptr},
+    {FINGERPRINT_TLS_EXPIRY,  "Expires", nullptr},
+    {FINGERPRINT_BANNER,      "Banner",  parseBanner}
+};
+
+const char* fingerprintName(uint8_t id) {
+    for (const auto& signature : SIGNATURES) {
+        if (signature.id == id) {
+            return signature.name;
+        }
+    }
+    return "Unknown";
+}
+
+const ServiceProbe& findServiceProbe(uint16_t port) {
+    const ServiceEntry* service = findService(port, SERVICE_TCP);
+    ProbePayload id = service ? service->payload : PAYLOAD_NONE;
+
+    size_t count = sizeof(SERVICE_PROBES) / sizeof(SERVICE_PROBES[0]);
+    for (size_t i = 0; i < count - 1; i++) {
+        if (SERVICE_PROBES[i].id == id) {
+            return SERVICE_PROBES[i];
+        }
+    }
+    return SERVICE_PROBES[count - 1];
+}
+
+bool serviceReplyComplete(const ServiceProbe& probe, const uint8_t* data, size_t length) {
+    switch (probe.framing) {
+        case REPLY_FIRST_LINE:
+            return memchr(data, '\n', length) != nullptr;
+        case REPLY_MODBUS:
+            return ModbusClient::frameLength(data, length) != 0;
+        default:
+            return false;
+    }
+}
+
+size_t fingerprintReply(uint16_t port, const uint8_t* data, size_t length,
+                        ServiceFingerprint* out, size_t maxCount) {
+    size_t count = 0;
+    for (const auto& signature : SIGNATURES) {
+        if (count >= maxCount || length == 0) {
+            break;
+        }
+        if (signature.id == FINGERPRINT_BANNER && count > 0) {
+            break;
+        }
+        if (!signature.parse) {
+            continue;
+        }
+
+        ServiceFingerprint& fingerprint = out[count];
+        fingerprint.detail[0] = '\0';
+        if (signature.parse(data, length, fingerprint.detail, sizeof(fingerprint.detail))) {
+            fingerprint.port = port;
+            fingerprint.id = signature.id;
+            count++;
+        }
+    }
+    return count;
+}
+
+size_t fingerprintTls(uint16_t port, const TlsSummary& tls, ServiceFingerprint* out, size_t maxCount) {
+    size_t count = 0;
+    auto add = [&](FingerprintId id, const char* text) {
+        if (count < maxCount) {
+            out[count].port = port;
+            out[count].id = id;
+            copyText((const uint8_t*)text, strlen(text), out[count].detail, sizeof(out[count].detail));
+            count++;
+        }
+    };
+
+    char line[FINGERPRINT_DETAIL_LENGTH];
+    if (tls.alerted) {
+        snprintf(line, sizeof(line), "alert %u %s", tls.alert, TlsProbe::alertName(tls.alert));
+        add(FINGERPRINT_TLS, line);
+    } else if (tls.serverHello) {
+        snprintf(line, sizeof(line), "%s %s", TlsProbe::versionName(tls.version), TlsProbe::cipherName(tls.cipher));
+        add(FINGERPRINT_TLS, line);
+    }
+
+    if (tls.subject[0] != '\0') {
+        add(FINGERPRINT_TLS_SUBJECT, tls.subject);
+    }
+    if (tls.issuer[0] != '\0') {
+        add(FINGERPRINT_TLS_ISSUER, strcmp(tls.issuer, tls.subject) == 0 ? "self-signed" : tls.issuer);
+    }
+    if (tls.notAfter[0] != '\0') {
+        add(FINGERPRINT_TLS_EXPIRY, tls.notAfter);
+    }
+    return count;
+}
@@ -0,0 +1,72 @@
+/*
+ * Fingerprint Header
+ * Table-driven service probes and banner parsers
+ */
+
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "tls_probe.h"
+#include "service_catalog.h"
+
+// Compact identifiers stored with each result; names come from the
+// signature table
+enum FingerprintId : uint8_t {
+    FINGERPRINT_HTTP,             // Server header, or the status line without one
+    FINGERPRINT_HTTP_TITLE,       // <title> of the page
+    FINGERPRINT_SSH,              // Identification string
+    FINGERPRINT_FTP,              // 220 greeting
+    FINGERPRINT_SMTP,             // 220 greeting
+    FINGERPRINT_TELNET,           // Option negotiation and any prompt
+    FINGERPRINT_MODBUS,           // Exception code or a normal reply
+    FINGERPRINT_TLS,              // Negotiated version and cipher, or the alert
+    FINGERPRINT_TLS_SUBJECT,      // Leaf certificate subject
+    FINGERPRINT_TLS_ISSUER,       // Leaf certificate issuer ("self-signed" when the same)
+    FINGERPRINT_TLS_EXPIRY,       // Leaf certificate notAfter date
+    FINGERPRINT_BANNER            // First line of anything else that speaks
+};
+
+// One fact learned from a reply; fixed-size so results stay compact
+struct ServiceFingerprint {
+    uint16_t port;
+    uint8_t id;                               // FingerprintId
+    char detail[FINGERPRINT_DETAIL_LENGTH];
+};
+
+// How a reply is read and when it is complete
+enum ReplyFraming : uint8_t {
+    REPLY_UNTIL_CLOSE,            // Buffer until the server closes or the buffer fills
+    REPLY_FIRST_LINE,             // The first line end completes the reply
+    REPLY_MODBUS,                 // One Modbus TCP frame
+    REPLY_TLS                     // Streamed through TlsProbe, never buffered whole
+};
+
+// What to send once a port is connected; the reply deadline comes from
+// the port's timeout class (serviceReplyWait)
+struct ServiceProbe {
+    ProbePayload id;
+    const uint8_t* payload;       // nullptr = wait for the server to speak first
+    size_t length;
+    ReplyFraming framing;
+};
+
+// Display name of a fingerprint id ("HTTP", "SSH", ...)
+const char* fingerprintName(uint8_t id);
+
+// Probe the service catalog names for a TCP port; ports without one
+// get PAYLOAD_NONE
+const ServiceProbe& findServiceProbe(uint16_t port);
+
+// True once a reply holds everything the probe waits for
+bool serviceReplyComplete(const ServiceProbe& probe, const uint8_t* data, size_t length);
+
+// Run every signature over a reply; returns the number written to out
+size_t fingerprintReply(uint16_t port, const uint8_t* data, size_t length,
+                        ServiceFingerprint* out, size_t maxCount);
+
+// Fingerprints of a TLS handshake; returns the number written to out
+size_t fingerprintTls(uint16_t port, const TlsSummary& tls, ServiceFingerprint* out, size_t maxCount);
+
+#endif // FINGERPRINT_H
@@ -0,0 +1,207 @@
+/*
+ * Host Table Implementation
+ * Fixed-size device table keyed by host offset within the scanned prefix
+ */
+
+#include "host_table.h"
+#include "net_utils.h"
+
+#if HOST_TABLE_PAGES >= HOST_TABLE_NO_PAGE
+#error "HOST_TABLE_PAGES must fit the 8-bit page directory"
+#endif
+
+HostTable::HostTable() {
+    reset(IPAddress(0, 0, 0, 0));
+}
+
+void HostTable::reset(IPAddress baseIP) {
+    base = ipToHost(baseIP) & 0xFFFF0000;
+    memset(directory, HOST_TABLE_NO_PAGE, sizeof(directory));
+    memset(pageOwner, 0, sizeof(pageOwner));
+    memset(pageCount, 0, sizeof(pageCount));
+    memset(liveBits, 0, sizeof(liveBits));
+    memset(macBits, 0, sizeof(macBits));
+    liveCount = 0;
+    dropped = 0;
+}
+
+bool HostTable::inWindow(IPAddress ip) {
+    return (ipToHost(ip) & 0xFFFF0000) == base;
+}
+
+bool HostTable::markSeen(IPAddress ip, unsigned long now, const uint8_t* mac) {
+    if (!inWindow(ip)) {
+        dropped++;
+        return false;
+    }
+
+    uint32_t offset = ipToHost(ip) - base;
+    uint8_t directoryIndex = offset >> 8;
+    int page = directory[directoryIndex];
+
+    if (page == HOST_TABLE_NO_PAGE) {
+        page = allocatePage(directoryIndex);
+        if (page < 0) {
+            dropped++;
+            return false;
+        }
+    }
+
+    uint32_t index = (uint32_t)page * HOST_TABLE_PAGE_SIZE + (offset & 0xFF);
+    uint32_t word = index >> 5;
+    uint32_t bit = 1UL << (index & 31);
+
+    if (!(liveBits[word] & bit)) {
+        liveBits[word] |= bit;
+        macBits[word] &= ~bit;
+        firstSeen[index] = now;
+        pageCount[page]++;
+        liveCount++;
+    }
+
+    lastSeen[index] = now;
+
+    if (mac) {
+        memcpy(macs[index], mac, 6);
+        macBits[word] |= bit;
+    }
+
+    return true;
+}
+
+bool HostTable::isLive(IPAddress ip) {
+    return indexOf(ip) >= 0;
+}
+
+bool HostTable::getMac(IPAddress ip, uint8_t* mac) {
+    int32_t index = indexOf(ip);
+    if (index < 0 || !(macBits[index >> 5] & (1UL << (index & 31)))) {
+        return false;
+    }
+
+    memcpy(mac, macs[index], 6);
+    return true;
+}
+
+unsigned long HostTable::getLastSeen(IPAddress ip) {
+    int32_t index = indexOf(ip);
+    return (index < 0) ? 0 : lastSeen[index];
+}
+
+unsigned long HostTable::getFirstSeen(IPAddress ip) {
+    int32_t index = indexOf(ip);
+    return (index < 0) ? 0 : firstSeen[index];
+}
+
+size_t HostTable::ageOut(unsigned long now, unsigned long maxAge) {
+    size_t removed = 0;
+
+    for (uint32_t word = 0; word < HOST_TABLE_CAPACITY / 32; word++) {
+        uint32_t bits = liveBits[word];
+        while (bits) {
+            uint32_t index = (word << 5) + __builtin_ctz(bits);
+            bits &= bits - 1;
+
+            if (now - lastSeen[index] > maxAge) {
+                removeIndex(index);
+                removed++;
+            }
+        }
+    }
+
+    return removed;
+}
+
+bool HostTable::next(uint32_t& cursor, IPAddress& ip) {
+    // The cursor is a window offset, so iteration follows address order
+    // even though pages are allocated in discovery order
+    while (cursor < HOST_TABLE_DIRECTORY * HOST_TABLE_PAGE_SIZE) {
+        uint8_t page = directory[cursor >> 8];
+        if (page == HOST_TABLE_NO_PAGE) {
+            cursor = (cursor | 0xFF) + 1;
+            continue;
+        }
+
+        uint32_t index = (uint32_t)page * HOST_TABLE_PAGE_SIZE + (cursor & 0xFF);
+        uint32_t offset = cursor++;
+
+        if (liveBits[index >> 5] & (1UL << (index & 31))) {
+            ip = hostToIP(base + offset);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t HostTable::count() {
+    return liveCount;
+}
+
+size_t HostTable::pagesInUse() {
+    size_t used = 0;
+    for (size_t i = 0; i < HOST_TABLE_PAGES; i++) {
+        if (pageCount[i] > 0) {
+            used++;
+        }
+    }
+    return used;
+}
+
+uint32_t HostTable::getDropped() {
+    return dropped;
+}
+
+int32_t HostTable::indexOf(IPAddress ip) {
+    if (!inWindow(ip)) {
+        return -1;
+    }
+
+    uint32_t offset = ipToHost(ip) - base;
+    uint8_t page = directory[offset >> 8];
+    if (page == HOST_TABLE_NO_PAGE) {
+        return -1;
+    }
+
+    uint32_t index = (uint32_t)page * HOST_TABLE_PAGE_SIZE + (offset & 0xFF);
+    if (!(liveBits[index >> 5] & (1UL << (index & 31)))) {
+        return -1;
+    }
+
+    return (int32_t)index;
+}
+
+int HostTable::allocatePage(uint8_t directoryIndex) {
+    for (int page = 0; page < HOST_TABLE_PAGES; page++) {
+        if (pageCount[page] == 0) {
+            // Reclaim the slot from whichever /24 emptied it last
+            if (directory[pageOwner[page]] == page) {
+                directory[pageOwner[page]] = HOST_TABLE_NO_PAGE;
+            }
+
+            directory[directoryIndex] = page;
+            pageOwner[page] = directoryIndex;
+            return page;
+        }
+    }
+
+    return -1;
+}
+
+void HostTable::removeIndex(uint32_t index) {
+    uint32_t word = index >> 5;
+    uint32_t bit = 1UL << (index & 31);
+
+    if (!(liveBits[word] & bit)) {
+        return;
+    }
+
+    liveBits[word] &= ~bit;
+    macBits[word] &= ~bit;
+    liveCount--;
+
+    uint32_t page = index / HOST_TABLE_PAGE_SIZE;
+    if (--pageCount[page] == 0) {
+        directory[pageOwner[page]] = HOST_TABLE_NO_PAGE;
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ * Host Table Header
+ * Fixed-size device table keyed by host offset within the scanned prefix
+ */
+
+#ifndef HOST_TABLE_H
+#define HOST_TABLE_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include "config.h"
+
+// The table addresses a /16 window as 256 pages of 256 hosts. Only pages
+// that hold a live host get one of the HOST_TABLE_PAGES backing slots, so
+// a sparse /16 or a dense /20 fits the same fixed budget.
+#define HOST_TABLE_PAGE_SIZE 256
+#define HOST_TABLE_DIRECTORY 256
+#define HOST_TABLE_CAPACITY (HOST_TABLE_PAGES * HOST_TABLE_PAGE_SIZE)
+#define HOST_TABLE_NO_PAGE 0xFF
+
+class HostTable {
+public:
+    HostTable();
+
+    // Drop every host and re-key the table on the /16 containing base
+    void reset(IPAddress base);
+
+    // Check if an address falls inside the current window
+    bool inWindow(IPAddress ip);
+
+    // Mark a host as seen now (O(1)); mac may be nullptr
+    bool markSeen(IPAddress ip, unsigned long now, const uint8_t* mac);
+
+    // Lookups (O(1))
+    bool isLive(IPAddress ip);
+    bool getMac(IPAddress ip, uint8_t* mac);
+    unsigned long getLastSeen(IPAddress ip);
+    unsigned long getFirstSeen(IPAddress ip);
+
+    // Remove hosts whose last-seen time is older than maxAge
+    size_t ageOut(unsigned long now, unsigned long maxAge);
+
+    // Iterate live hosts in address order; start with cursor = 0
+    bool next(uint32_t& cursor, IPAddress& ip);
+
+    // Statistics
+    size_t count();
+    size_t pagesInUse();
+    uint32_t getDropped();
+
+private:
+    uint32_t base;                                   // Host-order /16 network
+    uint8_t directory[HOST_TABLE_DIRECTORY];         // Page slot per /24, or HOST_TABLE_NO_PAGE
+    uint8_t pageOwner[HOST_TABLE_PAGES];             // Directory index owning each slot
+    uint16_t pageCount[HOST_TABLE_PAGES];            // Live hosts per slot (0 = free)
+
+    // Struct-of-arrays host state, indexed by slot * 256 + low octet
+    uint32_t liveBits[HOST_TABLE_CAPACITY / 32];
+    uint32_t macBits[HOST_TABLE_CAPACITY / 32];
+    uint32_t firstSeen[HOST_TABLE_CAPACITY];
+    uint32_t lastSeen[HOST_TABLE_CAPACITY];
+    uint8_t macs[HOST_TABLE_CAPACITY][6];
+
+    size_t liveCount;
+    uint32_t dropped;
+
+    // Resolve an address to its index; returns -1 when it has no page
+    int32_t indexOf(IPAddress ip);
+
+    // Claim a backing page for a /24 of the window
+    int allocatePage(uint8_t directoryIndex);
+
+    // Clear one host and release its page when it empties
+    void removeIndex(uint32_t index);
+};
+
+#endif // HOST_TABLE_H
@@ -0,0 +1,842 @@
+/*
+ * HTTP Server Implementation
+ * Event-driven HTTP/1.1 server: one task multiplexes every connection with select()
+ */
+
+#include "http_server.h"
+#include <lwip/sockets.h>
+
+static_assert(WEB_MAX_EVENT_CLIENTS < WEB_MAX_CONNECTIONS, "Event streams must leave a connection for requests");
+
+static const char* statusText(int code) {
+    switch (code) {
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 413: return "Payload Too Large";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default:  return "";
+    }
+}
+
+// Event data goes out as one "data:" line, so line breaks become spaces
+static void copyLine(char* dest, const char* src, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        dest[i] = (src[i] == '\n' || src[i] == '\r') ? ' ' : src[i];
+    }
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+HttpServer::HttpServer(uint16_t listenPort) {
+    port = listenPort;
+    listenFd = -1;
+    handle = nullptr;
+    current = nullptr;
+    for (auto& conn : connections) {
+        conn.fd = -1;
+        conn.state = CONNECTION_FREE;
+        conn.events = nullptr;
+    }
+    for (auto& client : eventClients) {
+        client.conn = nullptr;
+    }
+    eventLock = portMUX_INITIALIZER_UNLOCKED;
+    eventClientCount = 0;
+    wakeFd = -1;
+}
+
+bool HttpServer::begin() {
+    listenFd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listenFd < 0) {
+        Serial.println("Web server: failed to create socket");
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    // Clients beyond WEB_MAX_CONNECTIONS wait in the backlog
+    if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(listenFd, WEB_MAX_CONNECTIONS) < 0) {
+        Serial.printf("Web server: cannot listen on port %u\n", port);
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    int flags = fcntl(listenFd, F_GETFL, 0);
+    fcntl(listenFd, F_SETFL, flags | O_NONBLOCK);
+    openWakeSocket();
+
+    if (xTaskCreatePinnedToCore(taskEntry, "web", WEB_TASK_STACK, this,
+                                WEB_TASK_PRIORITY, &handle, WEB_TASK_CORE) != pdPASS) {
+        Serial.println("Web server: failed to create task");
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    return true;
+}
+
+void HttpServer::openWakeSocket() {
+    wakeFd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (wakeFd < 0) {
+        return;
+    }
+
+    // Bound to an ephemeral loopback port, which is also where wakes go
+    memset(&wakeAddr, 0, sizeof(wakeAddr));
+    wakeAddr.sin_family = AF_INET;
+    wakeAddr.sin_port = 0;
+    wakeAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLength = sizeof(wakeAddr);
+    if (bind(wakeFd, (struct sockaddr*)&wakeAddr, sizeof(wakeAddr)) < 0 ||
+        getsockname(wakeFd, (struct sockaddr*)&wakeAddr, &addrLength) < 0) {
+        // Events then go out at the next select() timeout
+        close(wakeFd);
+        wakeFd = -1;
+        return;
+    }
+
+    int flags = fcntl(wakeFd, F_GETFL, 0);
+    fcntl(wakeFd, F_SETFL, flags | O_NONBLOCK);
+}
+
+void HttpServer::wake() {
+    if (wakeFd >= 0) {
+        char signal = 0;
+        sendto(wakeFd, &signal, 1, 0, (struct sockaddr*)&wakeAddr, sizeof(wakeAddr));
+    }
+}
+
+void HttpServer::on(const char* path, HttpMethod method, HttpHandler handler) {
+    Route route;
+    route.path = path;
+    route.method = method;
+    route.handler = handler;
+    routes.push_back(route);
+}
+
+void HttpServer::onNotFound(HttpHandler handler) {
+    notFoundHandler = handler;
+}
+
+void HttpServer::taskEntry(void* param) {
+    static_cast<HttpServer*>(param)->run();
+}
+
+void HttpServer::run() {
+    for (;;) {
+        fd_set readSet;
+        fd_set writeSet;
+        FD_ZERO(&readSet);
+        FD_ZERO(&writeSet);
+        int maxFd = listenFd;
+        if (wakeFd >= 0) {
+            FD_SET(wakeFd, &readSet);
+            if (wakeFd > maxFd) {
+                maxFd = wakeFd;
+            }
+        }
+
+        for (auto& conn : connections) {
+            if (conn.state == CONNECTION_FREE) {
+                continue;
+            }
+            if (conn.state == CONNECTION_EVENTS) {
+                // Read only to notice the close; written while events wait
+                EventClient& client = *conn.events;
+                portENTER_CRITICAL(&eventLock);
+                bool waiting = client.length > 0 || client.latestLength > 0 || client.dropped > 0;
+                portEXIT_CRITICAL(&eventLock);
+                FD_SET(conn.fd, &readSet);
+                if (waiting || conn.pendingLength > 0) {
+                    FD_SET(conn.fd, &writeSet);
+                }
+            } else {
+                FD_SET(conn.fd, conn.state == CONNECTION_READING ? &readSet : &writeSet);
+            }
+            if (conn.fd > maxFd) {
+                maxFd = conn.fd;
+            }
+        }
+        // With every slot taken new clients stay in the backlog
+        if (findSlot(false)) {
+            FD_SET(listenFd, &readSet);
+        }
+
+        struct timeval timeout;
+        timeout.tv_sec = WEB_SELECT_TIMEOUT / 1000;
+        timeout.tv_usec = (WEB_SELECT_TIMEOUT % 1000) * 1000;
+        if (select(maxFd + 1, &readSet, &writeSet, nullptr, &timeout) < 0) {
+            vTaskDelay(pdMS_TO_TICKS(WEB_SELECT_TIMEOUT));
+            continue;
+        }
+
+        if (wakeFd >= 0 && FD_ISSET(wakeFd, &readSet)) {
+            char signal[16];
+            while (recv(wakeFd, signal, sizeof(signal), 0) > 0) {
+            }
+        }
+
+        unsigned long now = millis();
+        for (auto& conn : connections) {
+            if (conn.state == CONNECTION_READING && FD_ISSET(conn.fd, &readSet)) {
+                readRequest(conn);
+            } else if (conn.state == CONNECTION_WRITING && FD_ISSET(conn.fd, &writeSet)) {
+                writeResponse(conn);
+            } else if (conn.state == CONNECTION_EVENTS && FD_ISSET(conn.fd, &readSet)) {
+                // A stream's client has nothing more to say, so this is its close
+                int received = recv(conn.fd, conn.request, WEB_REQUEST_BUFFER_SIZE, 0);
+                if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    closeConnection(conn);
+                }
+            } else if (conn.state == CONNECTION_EVENTS && FD_ISSET(conn.fd, &writeSet)) {
+                writeResponse(conn);
+            } else if (conn.state == CONNECTION_EVENTS && now - conn.lastActivity > WEB_IDLE_TIMEOUT) {
+                // A quiet stream gets a comment line, so a vanished client is
+                // noticed; one that stopped taking its events is closed
+                portENTER_CRITICAL(&eventLock);
+                bool quiet = conn.pendingLength == 0 && conn.events->length == 0;
+                if (quiet) {
+                    ringWrite(*conn.events, ":\n\n", 3, false);
+                }
+                portEXIT_CRITICAL(&eventLock);
+                if (quiet) {
+                    conn.lastActivity = now;
+                } else {
+                    closeConnection(conn);
+                }
+            } else if (conn.state != CONNECTION_FREE && now - conn.lastActivity > WEB_IDLE_TIMEOUT) {
+                closeConnection(conn);
+            }
+        }
+
+        if (FD_ISSET(listenFd, &readSet)) {
+            acceptClient();
+        }
+    }
+}
+
+HttpServer::Connection* HttpServer::findSlot(bool evict) {
+    for (auto& conn : connections) {
+        if (conn.state == CONNECTION_FREE) {
+            return &conn;
+        }
+    }
+
+    // A keep-alive connection left idle gives up its slot; its browser
+    // simply opens a new one next time
+    unsigned long now = millis();
+    Connection* idlest = nullptr;
+    for (auto& conn : connections) {
+        if (conn.state == CONNECTION_READING && conn.received == 0 &&
+            now - conn.lastActivity >= WEB_EVICT_IDLE &&
+            (!idlest || conn.lastActivity < idlest->lastActivity)) {
+            idlest = &conn;
+        }
+    }
+    if (idlest && evict) {
+        closeConnection(*idlest);
+    }
+    return idlest;
+}
+
+void HttpServer::acceptClient() {
+    Connection* slot = findSlot(true);
+    if (!slot) {
+        return;
+    }
+
+    struct sockaddr_in addr;
+    socklen_t addrLength = sizeof(addr);
+    int fd = accept(listenFd, (struct sockaddr*)&addr, &addrLength);
+    if (fd < 0) {
+        return;
+    }
+
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+    // Headers and body often go out in separate sends
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    slot->fd = fd;
+    slot->state = CONNECTION_READING;
+    slot->received = 0;
+    slot->requestLength = 0;
+    slot->keepAlive = false;
+    slot->lastActivity = millis();
+}
+
+void HttpServer::closeConnection(Connection& conn) {
+    if (conn.events) {
+        portENTER_CRITICAL(&eventLock);
+        conn.events->conn = nullptr;
+        eventClientCount--;
+        portEXIT_CRITICAL(&eventLock);
+        conn.events = nullptr;
+    }
+    if (conn.fd >= 0) {
+        close(conn.fd);
+    }
+    conn.fd = -1;
+    conn.state = CONNECTION_FREE;
+    conn.body = String();
+    conn.filler = nullptr;
+}
+
+void HttpServer::readRequest(Connection& conn) {
+    int received = recv(conn.fd, conn.request + conn.received, WEB_REQUEST_BUFFER_SIZE - conn.received, 0);
+    if (received <= 0) {
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        closeConnection(conn);
+        return;
+    }
+
+    conn.received += received;
+    conn.lastActivity = millis();
+    processRequest(conn);
+}
+
+void HttpServer::processRequest(Connection& conn) {
+    int status = parseRequest(conn);
+    if (status == 0 && conn.received == WEB_REQUEST_BUFFER_SIZE) {
+        status = 413;
+    }
+
+    if (status == 200) {
+        dispatch(conn);
+    } else if (status != 0) {
+        sendError(conn, status);
+    }
+}
+
+int HttpServer::parseRequest(Connection& conn) {
+    char* head = conn.request;
+    head[conn.received] = '\0';
+    char* headEnd = strstr(head, "\r\n\r\n");
+    if (!headEnd) {
+        return 0;
+    }
+
+    // Request line: method, target and version
+    char* lineEnd = strstr(head, "\r\n");
+    char* target = (char*)memchr(head, ' ', lineEnd - head);
+    if (!target) {
+        return 400;
+    }
+    char* version = (char*)memchr(target + 1, ' ', lineEnd - target - 1);
+    if (!version || target[1] != '/' || strncmp(version + 1, "HTTP/1.", 7) != 0) {
+        return 400;
+    }
+
+    size_t methodLength = target - head;
+    if (methodLength == 3 && memcmp(head, "GET", 3) == 0) {
+        conn.method = HTTP_METHOD_GET;
+    } else if (methodLength == 4 && memcmp(head, "POST", 4) == 0) {
+        conn.method = HTTP_METHOD_POST;
+    } else {
+        conn.method = HTTP_METHOD_OTHER;
+    }
+
+    target++;
+    char* query = (char*)memchr(target, '?', version - target);
+    conn.pathStart = target - head;
+    conn.pathLength = (query ? query : version) - target;
+    conn.queryStart = query ? query + 1 - head : 0;
+    conn.queryLength = query ? version - query - 1 : 0;
+    conn.http10 = version[8] == '0';
+    conn.headersStart = lineEnd + 2 - head;
+    conn.bodyStart = headEnd + 4 - head;
+
+    const char* value;
+    size_t valueLength;
+    conn.bodyLength = 0;
+    if (findHeader(conn, "Content-Length", value, valueLength)) {
+        conn.bodyLength = strtoul(value, nullptr, 10);
+    }
+    if (conn.bodyLength > WEB_REQUEST_BUFFER_SIZE - conn.bodyStart) {
+        return 413;
+    }
+    if (conn.received < conn.bodyStart + conn.bodyLength) {
+        return 0;
+    }
+    conn.requestLength = conn.bodyStart + conn.bodyLength;
+
+    // HTTP/1.1 keeps the connection unless told otherwise; 1.0 closes it
+    conn.keepAlive = !conn.http10;
+    if (findHeader(conn, "Connection", value, valueLength) &&
+        valueLength == 5 && strncasecmp(value, "close", 5) == 0) {
+        conn.keepAlive = false;
+    }
+    return 200;
+}
+
+void HttpServer::dispatch(Connection& conn) {
+    current = &conn;
+    extraHeaders = "";
+    conn.pendingLength = 0;
+    conn.contentLength = 0;
+    conn.streaming = false;
+
+    const char* path = conn.request + conn.pathStart;
+    HttpHandler* handler = nullptr;
+    for (auto& route : routes) {
+        if (route.method == conn.method && strlen(route.path) == conn.pathLength &&
+            memcmp(route.path, path, conn.pathLength) == 0) {
+            handler = &route.handler;
+            break;
+        }
+    }
+    if (!handler && notFoundHandler) {
+        handler = &notFoundHandler;
+    }
+
+    if (handler) {
+        (*handler)();
+    }
+    current = nullptr;
+
+    if (conn.state == CONNECTION_READING) {
+        sendError(conn, handler ? 500 : 404);
+        return;
+    }
+    writeResponse(conn);
+}
+
+void HttpServer::sendError(Connection& conn, int code) {
+    current = &conn;
+    extraHeaders = "";
+    conn.keepAlive = false;
+    conn.streaming = false;
+    conn.contentLength = 0;
+    send(code, "text/plain", statusText(code));
+    current = nullptr;
+    writeResponse(conn);
+}
+
+void HttpServer::writeResponse(Connection& conn) {
+    // About a buffer's worth per pass, so a long download takes turns
+    // with the other clients instead of filling chunk after chunk
+    size_t budget = WEB_SEND_BUFFER_SIZE;
+    for (;;) {
+        if (conn.pendingLength == 0) {
+            if (budget == 0) {
+                return;
+            }
+            if (!nextPending(conn)) {
+                // An event stream stays open for the events still to come
+                if (conn.state != CONNECTION_EVENTS) {
+                    finishResponse(conn);
+                }
+                return;
+            }
+        }
+
+        int sent = ::send(conn.fd, conn.pending, conn.pendingLength, 0);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            closeConnection(conn);
+            return;
+        }
+        conn.pending += sent;
+        conn.pendingLength -= sent;
+        budget -= (size_t)sent < budget ? (size_t)sent : budget;
+        conn.lastActivity = millis();
+    }
+}
+
+bool HttpServer::nextPending(Connection& conn) {
+    if (conn.contentLength > 0) {
+        conn.pending = conn.content;
+        conn.pendingLength = conn.contentLength;
+        conn.contentLength = 0;
+        return true;
+    }
+    if (conn.state == CONNECTION_EVENTS) {
+        return nextEvents(conn);
+    }
+
+    // Fill the next chunk; a filler that wrote nothing yet is asked again
+    while (conn.streaming) {
+        conn.out.reset(!conn.http10);
+        bool more = conn.filler(conn.out, conn.cursor);
+        conn.pending = conn.out.finish(!more, conn.pendingLength);
+        if (!more) {
+            conn.streaming = false;
+            conn.filler = nullptr;
+        }
+        if (conn.pendingLength > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HttpServer::nextEvents(Connection& conn) {
+    EventClient& client = *conn.events;
+    conn.out.reset(!conn.http10);
+    uint32_t dropped = 0;
+
+    // Queued events as they are (the chunk may end inside one); the
+    // latest event and a loss notice only once the queue is empty, so
+    // they never land in the middle of another event
+    portENTER_CRITICAL(&eventLock);
+    size_t take = client.length < WEB_SEND_BUFFER_SIZE ? client.length : WEB_SEND_BUFFER_SIZE;
+    size_t first = WEB_EVENT_BUFFER_SIZE - client.head;
+    if (first > take) {
+        first = take;
+    }
+    conn.out.write(client.buffer + client.head, first);
+    conn.out.write(client.buffer, take - first);
+    client.head = (client.head + take) % WEB_EVENT_BUFFER_SIZE;
+    client.length -= take;
+    if (client.length == 0) {
+        if (client.latestLength > 0 && client.latestLength <= WEB_SEND_BUFFER_SIZE - conn.out.size()) {
+            conn.out.write(client.latest, client.latestLength);
+            client.latestLength = 0;
+        }
+        if (client.dropped > 0 && WEB_SEND_BUFFER_SIZE - conn.out.size() >= 48) {
+            dropped = client.dropped;
+            client.dropped = 0;
+        }
+    }
+    portEXIT_CRITICAL(&eventLock);
+
+    if (dropped > 0) {
+        conn.out.printf("event: dropped\ndata: %lu\n\n", (unsigned long)dropped);
+    }
+    conn.pending = conn.out.finish(false, conn.pendingLength);
+    return conn.pendingLength > 0;
+}
+
+void HttpServer::finishResponse(Connection& conn) {
+    if (!conn.keepAlive) {
+        closeConnection(conn);
+        return;
+    }
+
+    // Keep any pipelined request and wait for the next one
+    size_t leftover = conn.received - conn.requestLength;
+    memmove(conn.request, conn.request + conn.requestLength, leftover);
+    conn.received = leftover;
+    conn.requestLength = 0;
+    conn.body = String();
+    conn.state = CONNECTION_READING;
+    conn.lastActivity = millis();
+    if (leftover > 0) {
+        processRequest(conn);
+    }
+}
+
+void HttpServer::beginResponse(int code, const char* contentType, long contentLength) {
+    Connection& conn = *current;
+    conn.state = CONNECTION_WRITING;
+    conn.out.reset(false);
+    conn.out.printf("HTTP/1.1 %d %s\r\n", code, statusText(code));
+    if (contentType) {
+        conn.out.printf("Content-Type: %s\r\n", contentType);
+    }
+    if (contentLength >= 0) {
+        if (code != 204 && code != 304) {
+            conn.out.printf("Content-Length: %ld\r\n", contentLength);
+        }
+    } else if (!conn.http10) {
+        conn.out.print("Transfer-Encoding: chunked\r\n");
+    } else {
+        // Unframed, so the close ends the body
+        conn.keepAlive = false;
+    }
+    // With every slot taken the connection is handed back, so clients
+    // waiting in the backlog get a turn
+    if (conn.keepAlive) {
+        conn.keepAlive = false;
+        for (auto& other : connections) {
+            if (other.state == CONNECTION_FREE) {
+                conn.keepAlive = true;
+                break;
+            }
+        }
+    }
+    conn.out.print(conn.keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
+    conn.out.print(extraHeaders);
+    conn.out.print("\r\n");
+}
+
+HttpMethod HttpServer::method() {
+    return current ? current->method : HTTP_METHOD_OTHER;
+}
+
+bool HttpServer::hasArg(const char* name) {
+    if (!current) {
+        return false;
+    }
+    return findArg(current->request + current->queryStart, current->queryLength, name, nullptr) ||
+           findArg(current->request + current->bodyStart, current->bodyLength, name, nullptr);
+}
+
+String HttpServer::arg(const char* name) {
+    String value;
+    if (current && !findArg(current->request + current->queryStart, current->queryLength, name, &value)) {
+        findArg(current->request + current->bodyStart, current->bodyLength, name, &value);
+    }
+    return value;
+}
+
+String HttpServer::header(const char* name) {
+    const char* value;
+    size_t length;
+    String text;
+    if (current && findHeader(*current, name, value, length)) {
+        text.concat(value, length);
+    }
+    return text;
+}
+
+void HttpServer::sendHeader(const char* name, const String& value) {
+    extraHeaders += name;
+    extraHeaders += ": ";
+    extraHeaders += value;
+    extraHeaders += "\r\n";
+}
+
+void HttpServer::send(int code, const char* contentType, const String& content) {
+    if (!current || current->state == CONNECTION_WRITING) {
+        return;
+    }
+    Connection& conn = *current;
+    beginResponse(code, contentType, content.length());
+
+    // Short bodies go out with the headers
+    size_t mark = conn.out.mark();
+    conn.out.print(content);
+    if (!conn.out.commit(mark)) {
+        conn.body = content;
+        conn.content = conn.body.c_str();
+        conn.contentLength = conn.body.length();
+    }
+    conn.pending = conn.out.finish(false, conn.pendingLength);
+}
+
+void HttpServer::send_P(int code, const char* contentType, const char* content, size_t length) {
+    if (!current || current->state == CONNECTION_WRITING) {
+        return;
+    }
+    Connection& conn = *current;
+    beginResponse(code, contentType, length);
+    conn.content = content;
+    conn.contentLength = length;
+    conn.pending = conn.out.finish(false, conn.pendingLength);
+}
+
+void HttpServer::sendStream(int code, const char* contentType, HttpStreamFiller filler) {
+    if (!current || current->state == CONNECTION_WRITING) {
+        return;
+    }
+    Connection& conn = *current;
+    beginResponse(code, contentType, -1);
+    conn.filler = filler;
+    conn.cursor = 0;
+    conn.streaming = true;
+    conn.pending = conn.out.finish(false, conn.pendingLength);
+}
+
+bool HttpServer::sendEventStream() {
+    if (!current || current->state == CONNECTION_WRITING) {
+        return false;
+    }
+    Connection& conn = *current;
+
+    EventClient* client = nullptr;
+    for (auto& candidate : eventClients) {
+        if (!candidate.conn) {
+            client = &candidate;
+            break;
+        }
+    }
+    if (!client) {
+        send(503, "text/plain", statusText(503));
+        return false;
+    }
+
+    // The stream never ends, so the connection is not kept for another request
+    conn.keepAlive = false;
+    sendHeader("Cache-Control", "no-cache");
+    beginResponse(200, "text/event-stream", -1);
+    conn.pending = conn.out.finish(false, conn.pendingLength);
+    conn.state = CONNECTION_EVENTS;
+    conn.events = client;
+
+    char retry[24];
+    int retryLength = snprintf(retry, sizeof(retry), "retry: %d\n\n", WEB_EVENT_RETRY);
+    portENTER_CRITICAL(&eventLock);
+    client->conn = &conn;
+    client->head = 0;
+    client->length = 0;
+    client->latestLength = 0;
+    client->dropped = 0;
+    ringWrite(*client, retry, retryLength, false);
+    eventClientCount++;
+    portEXIT_CRITICAL(&eventLock);
+    return true;
+}
+
+bool HttpServer::hasEventClients() {
+    return eventClientCount > 0;
+}
+
+void HttpServer::sendEvent(const char* event, const char* data, size_t length, uint32_t id) {
+    if (eventClientCount == 0) {
+        return;
+    }
+
+    char head[64];
+    int headLength = id ? snprintf(head, sizeof(head), "id: %lu\nevent: %s\ndata: ", (unsigned long)id, event)
+                        : snprintf(head, sizeof(head), "event: %s\ndata: ", event);
+    size_t total = headLength + length + 2;
+
+    portENTER_CRITICAL(&eventLock);
+    for (auto& client : eventClients) {
+        if (!client.conn) {
+            continue;
+        }
+        if (total > WEB_EVENT_BUFFER_SIZE - client.length) {
+            client.dropped++;
+            continue;
+        }
+        ringWrite(client, head, headLength, false);
+        ringWrite(client, data, length, true);
+        ringWrite(client, "\n\n", 2, false);
+    }
+    portEXIT_CRITICAL(&eventLock);
+
+    // The web task itself sends what it queued before its next select()
+    if (xTaskGetCurrentTaskHandle() != handle) {
+        wake();
+    }
+}
+
+void HttpServer::sendLatestEvent(const char* event, const char* data, size_t length) {
+    if (eventClientCount == 0) {
+        return;
+    }
+
+    char head[48];
+    int headLength = snprintf(head, sizeof(head), "event: %s\ndata: ", event);
+    size_t total = headLength + length + 2;
+    if (total > WEB_EVENT_LATEST_SIZE) {
+        return;
+    }
+
+    portENTER_CRITICAL(&eventLock);
+    for (auto& client : eventClients) {
+        if (!client.conn) {
+            continue;
+        }
+        memcpy(client.latest, head, headLength);
+        copyLine(client.latest + headLength, data, length);
+        memcpy(client.latest + headLength + length, "\n\n", 2);
+        client.latestLength = total;
+    }
+    portEXIT_CRITICAL(&eventLock);
+
+    if (xTaskGetCurrentTaskHandle() != handle) {
+        wake();
+    }
+}
+
+void HttpServer::ringWrite(EventClient& client, const char* data, size_t length, bool oneLine) {
+    size_t tail = (client.head + client.length) % WEB_EVENT_BUFFER_SIZE;
+    size_t first = WEB_EVENT_BUFFER_SIZE - tail;
+    if (first > length) {
+        first = length;
+    }
+    if (oneLine) {
+        copyLine(client.buffer + tail, data, first);
+        copyLine(client.buffer, data + first, length - first);
+    } else {
+        memcpy(client.buffer + tail, data, first);
+        memcpy(client.buffer, data + first, length - first);
+    }
+    client.length += length;
+}
+
+bool HttpServer::findHeader(const Connection& conn, const char* name, const char*& value, size_t& length) {
+    size_t nameLength = strlen(name);
+    const char* line = conn.request + conn.headersStart;
+    const char* end = conn.request + conn.bodyStart - 2;
+
+    while (line < end) {
+        const char* lineEnd = strstr(line, "\r\n");
+        if (lineEnd - line > (long)nameLength && line[nameLength] == ':' &&
+            strncasecmp(line, name, nameLength) == 0) {
+            value = line + nameLength + 1;
+            while (value < lineEnd && (*value == ' ' || *value == '\t')) {
+                value++;
+            }
+            length = lineEnd - value;
+            while (length > 0 && (value[length - 1] == ' ' || value[length - 1] == '\t')) {
+                length--;
+            }
+            return true;
+        }
+        line = lineEnd + 2;
+    }
+    return false;
+}
+
+bool HttpServer::findArg(const char* params, size_t length, const char* name, String* value) {
+    // name=value pairs joined by '&', URL-encoded ('+' for space)
+    size_t nameLength = strlen(name);
+    const char* end = params + length;
+    const char* pair = params;
+
+    while (pair < end) {
+        const char* pairEnd = (const char*)memchr(pair, '&', end - pair);
+        if (!pairEnd) {
+            pairEnd = end;
+        }
+        const char* equals = (const char*)memchr(pair, '=', pairEnd - pair);
+        const char* keyEnd = equals ? equals : pairEnd;
+
+        if ((size_t)(keyEnd - pair) == nameLength && memcmp(pair, name, nameLength) == 0) {
+            if (value) {
+                *value = "";
+                for (const char* c = equals ? equals + 1 : pairEnd; c < pairEnd; c++) {
+                    if (*c == '+') {
+                        *value += ' ';
+                    } else if (*c == '%' && pairEnd - c > 2 && hexValue(c[1]) >= 0 && hexValue(c[2]) >= 0) {
+                        *value += (char)(hexValue(c[1]) * 16 + hexValue(c[2]));
+                        c += 2;
+                    } else {
+                        *value += *c;
+                    }
+                }
+            }
+            return true;
+        }
+        pair = pairEnd + 1;
+    }
+    return false;
+}
@@ -0,0 +1,190 @@
+/*
+ * HTTP Server Header
+ * Event-driven HTTP/1.1 server: one task multiplexes every connection with select()
+ */
+
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <lwip/sockets.h>
+#include "config.h"
+#include "chunked_response.h"
+
+enum HttpMethod : uint8_t {
+    HTTP_METHOD_GET,
+    HTTP_METHOD_POST,
+    HTTP_METHOD_OTHER
+};
+
+typedef std::function<void()> HttpHandler;
+
+// Writes the next piece of a streamed body into out; cursor starts at 0
+// and is the filler's own. Returns false once the body is complete
+typedef std::function<bool(ChunkedResponse& out, size_t& cursor)> HttpStreamFiller;
+
+// Handlers run on the server task, one at a time, and answer through the
+// same calls as the core WebServer (arg, header, send...). Nothing blocks
+// on a client: requests are read and responses written as their sockets
+// become ready, so a slow download never holds up another client
+class HttpServer {
+public:
+    HttpServer(uint16_t port);
+
+    // Open the listening socket and start the task on WEB_TASK_CORE
+    bool begin();
+
+    void on(const char* path, HttpMethod method, HttpHandler handler);
+    void onNotFound(HttpHandler handler);
+
+    // The request being handled
+    HttpMethod method();
+    bool hasArg(const char* name);
+    String arg(const char* name);       // Query string, then form body; URL-decoded
+    String header(const char* name);    // Case-insensitive; empty when absent
+
+    // Extra header for the response sent next
+    void sendHeader(const char* name, const String& value);
+
+    void send(int code, const char* contentType = nullptr, const String& content = String());
+
+    // Body stays where it is (flash) and is sent straight from there
+    void send_P(int code, const char* contentType, const char* content, size_t length);
+
+    // Body produced by filler, one chunk per call as the client takes it
+    void sendStream(int code, const char* contentType, HttpStreamFiller filler);
+
+    // Turn the request into a text/event-stream that stays open and
+    // receives every event sent from now on; answers 503 and returns
+    // false when WEB_MAX_EVENT_CLIENTS streams are already open
+    bool sendEventStream();
+    bool hasEventClients();
+
+    // Queue an event for every stream; safe from any task and never
+    // blocks. A client whose buffer is full misses it and later gets a
+    // "dropped" event. Line breaks in data are sent as spaces; id (when
+    // not 0) becomes the event's id
+    void sendEvent(const char* event, const char* data, size_t length, uint32_t id = 0);
+    // Like sendEvent, but an undelivered one is replaced rather than
+    // queued behind, so only the newest state goes out
+    void sendLatestEvent(const char* event, const char* data, size_t length);
+
+private:
+    enum ConnectionState : uint8_t {
+        CONNECTION_FREE,
+        CONNECTION_READING,
+        CONNECTION_WRITING,
+        CONNECTION_EVENTS               // Event stream, written as events arrive
+    };
+
+    // Events waiting for one stream (a ring buffer) and its latest event
+    struct EventClient;
+
+    struct Connection {
+        int fd;
+        ConnectionState state;
+        bool keepAlive;
+        bool http10;                    // HTTP/1.0 client: no chunked framing
+        unsigned long lastActivity;
+
+        // Request, parsed in place
+        char request[WEB_REQUEST_BUFFER_SIZE + 1];
+        size_t received;
+        size_t requestLength;           // Head plus body, once complete
+        HttpMethod method;
+        size_t pathStart;
+        size_t pathLength;
+        size_t queryStart;
+        size_t queryLength;
+        size_t headersStart;
+        size_t bodyStart;
+        size_t bodyLength;
+
+        // Response: headers (and a short body) in out, then a long body
+        // from flash or from body, then the filler's chunks
+        ChunkedResponse out;
+        const char* pending;            // Being sent
+        size_t pendingLength;
+        String body;
+        const char* content;            // Long body not sent yet
+        size_t contentLength;
+        HttpStreamFiller filler;
+        size_t cursor;
+        bool streaming;
+        EventClient* events;
+    };
+
+    struct EventClient {
+        Connection* conn;               // nullptr while unused
+        char buffer[WEB_EVENT_BUFFER_SIZE];
+        size_t head;
+        size_t length;
+        char latest[WEB_EVENT_LATEST_SIZE];
+        size_t latestLength;
+        uint32_t dropped;               // Events missed since the last notice
+    };
+
+    struct Route {
+        const char* path;
+        HttpMethod method;
+        HttpHandler handler;
+    };
+
+    uint16_t port;
+    int listenFd;
+    TaskHandle_t handle;
+    std::vector<Route> routes;
+    HttpHandler notFoundHandler;
+    Connection connections[WEB_MAX_CONNECTIONS];
+    Connection* current;                // Connection whose handler is running
+    String extraHeaders;
+
+    // Shared with the tasks sending events
+    EventClient eventClients[WEB_MAX_EVENT_CLIENTS];
+    portMUX_TYPE eventLock;
+    volatile int eventClientCount;
+
+    // Loopback UDP socket in the select() set; other tasks send it a byte
+    // so queued events go out at once, not at the next timeout
+    int wakeFd;
+    struct sockaddr_in wakeAddr;
+
+    static void taskEntry(void* param);
+    void run();
+
+    // A free connection, or one that may be closed to make room (and is,
+    // if evict); nullptr when every connection is busy
+    Connection* findSlot(bool evict);
+    void acceptClient();
+    void closeConnection(Connection& conn);
+
+    // Read what has arrived; dispatches once the request is complete
+    void readRequest(Connection& conn);
+    void processRequest(Connection& conn);
+    // 0 while incomplete, else 200 or the error status to answer with
+    int parseRequest(Connection& conn);
+    void dispatch(Connection& conn);
+
+    // Send until the socket is full or the response is complete
+    void writeResponse(Connection& conn);
+    bool nextPending(Connection& conn);
+    bool nextEvents(Connection& conn);
+    void finishResponse(Connection& conn);
+
+    void beginResponse(int code, const char* contentType, long contentLength);
+    void sendError(Connection& conn, int code);
+
+    void openWakeSocket();
+    void wake();
+    // Append to a client's ring (with eventLock held; the caller checked the room)
+    void ringWrite(EventClient& client, const char* data, size_t length, bool oneLine);
+
+    bool findHeader(const Connection& conn, const char* name, const char*& value, size_t& length);
+    bool findArg(const char* params, size_t length, const char* name, String* value);
+};
+
+#endif // HTTP_SERVER_H
@@ -0,0 +1,586 @@
+/*
+ * Modbus Client Implementation
+ * Identifies Modbus TCP devices, and the units behind gateways, over kept-open connections
+ */
+
+#include "modbus_client.h"
+#include "connect_pool.h"
+#include "rtt_estimator.h"
+#include "probe_pacer.h"
+#include <lwip/sockets.h>
+
+#define FUNCTION_ENCAPSULATED 0x2B
+#define MEI_READ_DEVICE_ID 0x0E
+#define READ_DEVICE_ID_BASIC 0x01
+#define EXCEPTION_FLAG 0x80
+#define MORE_FOLLOWS 0xFF
+
+// Gateway exceptions: the gateway is Modbus, but no unit sits at that ID
+#define EXCEPTION_GATEWAY_PATH 0x0A
+#define EXCEPTION_GATEWAY_TARGET 0x0B
+
+const char* modbusStatusName(ModbusStatus status) {
+    switch (status) {
+        case MODBUS_DEVICE: return "Modbus";
+        case MODBUS_NOT_MODBUS: return "not Modbus";
+        case MODBUS_NO_REPLY: return "no reply";
+        default: return "";
+    }
+}
+
+ModbusClient::ModbusClient() {
+    used = 0;
+    nextTransactionId = 1;
+    pacerWait = 0;
+    for (size_t i = 0; i < MODBUS_CLIENT_SLOTS; i++) {
+        hosts[i].used = false;
+        hosts[i].fd = -1;
+    }
+}
+
+ModbusClient::~ModbusClient() {
+    stop();
+}
+
+void ModbusClient::setUnitIds(const std::vector<uint8_t>& ids) {
+    unitIds = ids;
+}
+
+bool ModbusClient::add(IPAddress address) {
+    if (used >= MODBUS_CLIENT_SLOTS) {
+        return false;
+    }
+
+    for (size_t i = 0; i < MODBUS_CLIENT_SLOTS; i++) {
+        Host& host = hosts[i];
+        if (host.used) {
+            continue;
+        }
+
+        host.used = true;
+        host.fd = -1;
+        host.connected = false;
+        host.reconnects = 0;
+        host.depth = MODBUS_PIPELINE_DEPTH;
+        host.nextUnit = 0;
+        host.receivedLength = 0;
+        for (size_t t = 0; t < MODBUS_PIPELINE_DEPTH; t++) {
+            host.transactions[t].used = false;
+        }
+        host.identity.address = address;
+        host.identity.status = MODBUS_NO_REPLY;
+        host.identity.units.clear();
+        used++;
+        return true;
+    }
+    return false;
+}
+
+bool ModbusClient::poll(ModbusIdentityCallback callback, unsigned long waitMs) {
+    if (!isBusy()) {
+        return false;
+    }
+
+    startConnects(callback);
+
+    // Connecting sockets wait to become writable, connected ones readable;
+    // wake early for the nearest connect or reply deadline
+    fd_set readSet;
+    fd_set writeSet;
+    FD_ZERO(&readSet);
+    FD_ZERO(&writeSet);
+    int maxFd = -1;
+    unsigned long now = millis();
+    unsigned long wait = waitMs;
+
+    for (size_t i = 0; i < MODBUS_CLIENT_SLOTS; i++) {
+        const Host& host = hosts[i];
+        if (!host.used) {
+            continue;
+        }
+
+        unsigned long left = pacerWait > 0 ? pacerWait : 1;
+        if (host.fd >= 0 && !host.connected) {
+            FD_SET(host.fd, &writeSet);
+            unsigned long elapsed = now - host.connectStart;
+            left = elapsed < host.connectTimeout ? host.connectTimeout - elapsed : 0;
+        } else if (host.fd >= 0) {
+            FD_SET(host.fd, &readSet);
+            left = waitMs;
+            for (size_t t = 0; t < MODBUS_PIPELINE_DEPTH; t++) {
+                const Transaction& transaction = host.transactions[t];
+                if (!transaction.used) {
+                    continue;
+                }
+                unsigned long elapsed = now - transaction.sentAt;
+                unsigned long remaining = elapsed < MODBUS_RESPONSE_TIMEOUT ? MODBUS_RESPONSE_TIMEOUT - elapsed : 0;
+                if (remaining < left) {
+                    left = remaining;
+                }
+            }
+        }
+        if (host.fd > maxFd) {
+            maxFd = host.fd;
+        }
+        if (left < wait) {
+            wait = left;
+        }
+    }
+
+    if (maxFd >= 0) {
+        struct timeval tv;
+        tv.tv_sec = wait / 1000;
+        tv.tv_usec = (wait % 1000) * 1000;
+        if (select(maxFd + 1, &readSet, &writeSet, nullptr, &tv) <= 0) {
+            FD_ZERO(&readSet);
+            FD_ZERO(&writeSet);
+        }
+    } else {
+        // Only the pacer is holding us back; nothing to select() on
+        delay(wait > 0 ? wait : 1);
+    }
+
+    for (size_t i = 0; i < MODBUS_CLIENT_SLOTS; i++) {
+        Host& host = hosts[i];
+        if (host.used && host.fd >= 0 && !host.connected && FD_ISSET(host.fd, &writeSet)) {
+            checkConnect(host, callback);
+        } else if (host.used && host.fd >= 0 && host.connected && FD_ISSET(host.fd, &readSet)) {
+            receive(host, callback);
+        }
+        if (host.used) {
+            expire(host, callback);
+        }
+        if (host.used && host.connected) {
+            sendRequests(host, callback);
+        }
+    }
+
+    return isBusy();
+}
+
+void ModbusClient::stop() {
+    for (size_t i = 0; i < MODBUS_CLIENT_SLOTS; i++) {
+        if (hosts[i].used) {
+            closeConnection(hosts[i]);
+            hosts[i].used = false;
+        }
+    }
+    used = 0;
+}
+
+bool ModbusClient::isBusy() {
+    return used > 0;
+}
+
+size_t ModbusClient::buildReadDeviceId(uint8_t* buffer, size_t size, uint16_t transactionId,
+                                       uint8_t unitId, uint8_t objectId) {
+    if (size < 11) {
+        return 0;
+    }
+
+    // MBAP: transaction, protocol 0, length of what follows, unit
+    buffer[0] = (uint8_t)(transactionId >> 8);
+    buffer[1] = (uint8_t)transactionId;
+    buffer[2] = 0;
+    buffer[3] = 0;
+    buffer[4] = 0;
+    buffer[5] = 5;
+    buffer[6] = unitId;
+
+    // Read Device Identification, basic category, starting at objectId
+    buffer[7] = FUNCTION_ENCAPSULATED;
+    buffer[8] = MEI_READ_DEVICE_ID;
+    buffer[9] = READ_DEVICE_ID_BASIC;
+    buffer[10] = objectId;
+    return 11;
+}
+
+int ModbusClient::frameLength(const uint8_t* data, size_t length) {
+    // Protocol identifier is always 0; anything else (an HTTP status
+    // line, a TLS alert, a banner) is some other service
+    if (length >= 3 && data[2] != 0) {
+        return -1;
+    }
+    if (length >= 4 && data[3] != 0) {
+        return -1;
+    }
+    if (length < 6) {
+        return 0;
+    }
+
+    // The length counts the unit ID and the PDU, which is at least a
+    // function code and at most 253 bytes
+    size_t pduLength = ((size_t)data[4] << 8) | data[5];
+    if (pduLength < 2 || pduLength > MODBUS_ADU_SIZE - 6) {
+        return -1;
+    }
+    if (length < 6 + pduLength) {
+        return 0;
+    }
+    return (int)(6 + pduLength);
+}
+
+bool ModbusClient::parseReply(const uint8_t* data, size_t length, ModbusReply& reply) {
+    if (frameLength(data, length) != (int)length) {
+        return false;
+    }
+
+    reply.transactionId = ((uint16_t)data[0] << 8) | data[1];
+    reply.unitId = data[6];
+    reply.exceptionCode = 0;
+    reply.moreFollows = false;
+    reply.nextObjectId = 0;
+    reply.found = 0;
+
+    uint8_t function = data[7];
+    if (function & EXCEPTION_FLAG) {
+        if (length < 9) {
+            return false;
+        }
+        reply.type = MODBUS_REPLY_EXCEPTION;
+        reply.exceptionCode = data[8];
+        return true;
+    }
+    if (function != FUNCTION_ENCAPSULATED || length < 9 || data[8] != MEI_READ_DEVICE_ID) {
+        reply.type = MODBUS_REPLY_OTHER;
+        return true;
+    }
+
+    // Read device ID code, conformity level, more follows, next object id,
+    // object count, then (id, length, value) per object
+    if (length < 14) {
+        return false;
+    }
+    reply.type = MODBUS_REPLY_IDENTIFICATION;
+    reply.moreFollows = data[11] == MORE_FOLLOWS;
+    reply.nextObjectId = data[12];
+    uint8_t count = data[13];
+
+    size_t pos = 14;
+    for (uint8_t i = 0; i < count; i++) {
+        if (pos + 2 > length || pos + 2 + data[pos + 1] > length) {
+            return false;
+        }
+        uint8_t objectId = data[pos];
+        uint8_t objectLength = data[pos + 1];
+        pos += 2;
+
+        if (objectId < MODBUS_ID_OBJECTS) {
+            char* text = reply.objects[objectId];
+            size_t out = 0;
+            for (size_t j = 0; j < objectLength && out + 1 < MODBUS_STRING_LENGTH; j++) {
+                char c = (char)data[pos + j];
+                if (c < 0x20 || c > 0x7E || c == '"' || c == '<' || c == '>') {
+                    c = '?';
+                }
+                text[out++] = c;
+            }
+            text[out] = '\0';
+            reply.found |= 1 << objectId;
+        }
+        pos += objectLength;
+    }
+    return true;
+}
+
+void ModbusClient::startConnects(ModbusIdentityCallback& callback) {
+    for (size_t i = 0; i < MODBUS_CLIENT_SLOTS; i++) {
+        Host& host = hosts[i];
+        if (!host.used || host.fd >= 0) {
+            continue;
+        }
+        if (!probePacer.tryAcquire(host.identity.address, &pacerWait)) {
+            continue;
+        }
+        if (!openConnection(host)) {
+            probePacer.release(host.identity.address);
+            finish(host, callback);
+        }
+    }
+}
+
+bool ModbusClient::openConnection(Host& host) {
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) {
+        return false;
+    }
+
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(MODBUS_PORT);
+    addr.sin_addr.s_addr = (uint32_t)host.identity.address;
+
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+        ConnectPool::closeSocket(fd);
+        return false;
+    }
+
+    host.fd = fd;
+    host.connected = false;
+    host.connectStart = millis();
+    host.connectTimeout = rttEstimator.getTimeout(host.identity.address, PORT_TIMEOUT);
+    host.receivedLength = 0;
+    return true;
+}
+
+void ModbusClient::checkConnect(Host& host, ModbusIdentityCallback& callback) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(host.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+    if (err != 0) {
+        closeConnection(host);
+        finish(host, callback);
+        return;
+    }
+
+    host.connected = true;
+    rttEstimator.addSample(host.identity.address, millis() - host.connectStart);
+
+    #if DEBUG_PORT_SCAN
+    Serial.printf("Modbus: connected to %s, %u unit IDs to try\n",
+                  host.identity.address.toString().c_str(), (unsigned)(unitIds.size() - host.nextUnit));
+    #endif
+}
+
+void ModbusClient::receive(Host& host, ModbusIdentityCallback& callback) {
+    int received = recv(host.fd, host.received + host.receivedLength,
+                        sizeof(host.received) - host.receivedLength, 0);
+    if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        connectionLost(host, callback);
+        return;
+    }
+    if (received < 0) {
+        return;
+    }
+    host.receivedLength += received;
+
+    // Replies arrive back to back and may be split anywhere
+    for (;;) {
+        int length = frameLength(host.received, host.receivedLength);
+        if (length < 0) {
+            if (host.identity.status != MODBUS_DEVICE) {
+                host.identity.status = MODBUS_NOT_MODBUS;
+            }
+            closeConnection(host);
+            finish(host, callback);
+            return;
+        }
+        if (length == 0) {
+            break;
+        }
+
+        if (parseReply(host.received, length, reply)) {
+            handleReply(host);
+        }
+
+        host.receivedLength -= length;
+        memmove(host.received, host.received + length, host.receivedLength);
+    }
+}
+
+void ModbusClient::handleReply(Host& host) {
+    Transaction* transaction = nullptr;
+    for (size_t t = 0; t < MODBUS_PIPELINE_DEPTH; t++) {
+        if (host.transactions[t].used && host.transactions[t].id == reply.transactionId) {
+            transaction = &host.transactions[t];
+            break;
+        }
+    }
+    host.identity.status = MODBUS_DEVICE;
+
+    // Late reply to a request that already timed out
+    if (!transaction) {
+        return;
+    }
+    uint8_t unitIndex = transaction->unitIndex;
+    uint8_t objectId = transaction->objectId;
+    transaction->used = false;
+
+    if (reply.type == MODBUS_REPLY_EXCEPTION) {
+        if (reply.exceptionCode == EXCEPTION_GATEWAY_PATH || reply.exceptionCode == EXCEPTION_GATEWAY_TARGET) {
+            return;
+        }
+        // Illegal function and the like: a unit, just not one that
+        // supports identification
+        ModbusUnit& unit = unitEntry(host, unitIds[unitIndex]);
+        if (unit.vendorName.length() == 0) {
+            unit.exceptionCode = reply.exceptionCode;
+        }
+        return;
+    }
+
+    ModbusUnit& unit = unitEntry(host, unitIds[unitIndex]);
+    if (reply.type != MODBUS_REPLY_IDENTIFICATION) {
+        return;
+    }
+
+    unit.exceptionCode = 0;
+    if (reply.found & (1 << 0)) {
+        unit.vendorName = reply.objects[0];
+    }
+    if (reply.found & (1 << 1)) {
+        unit.productCode = reply.objects[1];
+    }
+    if (reply.found & (1 << 2)) {
+        unit.revision = reply.objects[2];
+    }
+
+    // The objects did not fit in one response; ask for the rest right
+    // away in the slot this reply freed. Only ever move forward, so a
+    // confused device cannot keep us asking
+    if (reply.moreFollows && reply.nextObjectId > objectId && reply.nextObjectId < MODBUS_ID_OBJECTS) {
+        sendRequest(host, unitIndex, reply.nextObjectId);
+    }
+}
+
+void ModbusClient::sendRequests(Host& host, ModbusIdentityCallback& callback) {
+    size_t inFlight = 0;
+    for (size_t t = 0; t < MODBUS_PIPELINE_DEPTH; t++) {
+        if (host.transactions[t].used) {
+            inFlight++;
+        }
+    }
+
+    while (inFlight < host.depth && host.nextUnit < unitIds.size()) {
+        if (!sendRequest(host, (uint8_t)host.nextUnit, 0)) {
+            connectionLost(host, callback);
+            return;
+        }
+        host.nextUnit++;
+        inFlight++;
+    }
+
+    if (inFlight == 0 && host.nextUnit >= unitIds.size()) {
+        closeConnection(host);
+        finish(host, callback);
+    }
+}
+
+bool ModbusClient::sendRequest(Host& host, uint8_t unitIndex, uint8_t objectId) {
+    Transaction* transaction = nullptr;
+    for (size_t t = 0; t < MODBUS_PIPELINE_DEPTH; t++) {
+        if (!host.transactions[t].used) {
+            transaction = &host.transactions[t];
+            break;
+        }
+    }
+    if (!transaction) {
+        return true;
+    }
+
+    // IDs are unique across hosts, so a stray reply never matches
+    uint16_t id = nextTransactionId++;
+    if (nextTransactionId == 0) {
+        nextTransactionId = 1;
+    }
+
+    size_t length = buildReadDeviceId(frame, sizeof(frame), id, unitIds[unitIndex], objectId);
+    if (send(host.fd, frame, length, 0) != (int)length) {
+        return false;
+    }
+
+    transaction->used = true;
+    transaction->id = id;
+    transaction->unitIndex = unitIndex;
+    transaction->objectId = objectId;
+    transaction->sentAt = millis();
+    return true;
+}
+
+void ModbusClient::expire(Host& host, ModbusIdentityCallback& callback) {
+    if (host.fd < 0) {
+        return;
+    }
+
+    unsigned long now = millis();
+    if (!host.connected) {
+        if (now - host.connectStart >= host.connectTimeout) {
+            rttEstimator.addTimeout(host.identity.address);
+            closeConnection(host);
+            finish(host, callback);
+        }
+        return;
+    }
+
+    // A unit that never answers is simply absent; its slot goes to the next
+    for (size_t t = 0; t < MODBUS_PIPELINE_DEPTH; t++) {
+        Transaction& transaction = host.transactions[t];
+        if (transaction.used && now - transaction.sentAt >= MODBUS_RESPONSE_TIMEOUT) {
+            transaction.used = false;
+        }
+    }
+}
+
+void ModbusClient::connectionLost(Host& host, ModbusIdentityCallback& callback) {
+    // Some devices hang up on a unit ID they do not serve, taking the
+    // pipelined requests with them; ask those again, one at a time
+    size_t resume = host.nextUnit;
+    bool outstanding = false;
+    for (size_t t = 0; t < MODBUS_PIPELINE_DEPTH; t++) {
+        if (host.transactions[t].used && host.transactions[t].unitIndex < resume) {
+            resume = host.transactions[t].unitIndex;
+            outstanding = true;
+        }
+    }
+    closeConnection(host);
+
+    // The unit outstanding longest is the likely cause; asking it again
+    // would only repeat the hang-up
+    if (outstanding) {
+        resume++;
+    }
+
+    if (resume < unitIds.size() && host.reconnects < MODBUS_RECONNECTS) {
+        host.reconnects++;
+        host.depth = 1;
+        host.nextUnit = resume;
+        return;
+    }
+
+    finish(host, callback);
+}
+
+void ModbusClient::closeConnection(Host& host) {
+    if (host.fd < 0) {
+        return;
+    }
+    ConnectPool::closeSocket(host.fd);
+    host.fd = -1;
+    host.connected = false;
+    host.receivedLength = 0;
+    for (size_t t = 0; t < MODBUS_PIPELINE_DEPTH; t++) {
+        host.transactions[t].used = false;
+    }
+    probePacer.release(host.identity.address);
+}
+
+void ModbusClient::finish(Host& host, ModbusIdentityCallback& callback) {
+    #if DEBUG_PORT_SCAN
+    Serial.printf("Modbus: %s %s, %u units\n", host.identity.address.toString().c_str(),
+                  modbusStatusName(host.identity.status), (unsigned)host.identity.units.size());
+    #endif
+
+    host.used = false;
+    used--;
+    if (callback) {
+        callback(host.identity);
+    }
+}
+
+ModbusUnit& ModbusClient::unitEntry(Host& host, uint8_t unitId) {
+    for (auto& unit : host.identity.units) {
+        if (unit.unitId == unitId) {
+            return unit;
+        }
+    }
+
+    ModbusUnit unit;
+    unit.unitId = unitId;
+    unit.exceptionCode = 0;
+    host.identity.units.push_back(unit);
+    return host.identity.units.back();
+}
@@ -0,0 +1,143 @@
+/*
+ * Modbus Client Header
+ * Identifies Modbus TCP devices, and the units behind gateways, over kept-open connections
+ */
+
+#ifndef MODBUS_CLIENT_H
+#define MODBUS_CLIENT_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+#include <IPAddress.h>
+#include "config.h"
+
+#define MODBUS_ADU_SIZE 260           // MBAP header plus the largest PDU
+#define MODBUS_ID_OBJECTS 3           // VendorName, ProductCode, MajorMinorRevision
+
+enum ModbusStatus {
+    MODBUS_NOT_PROBED,        // Port closed, or identification turned off
+    MODBUS_DEVICE,            // At least one well-formed Modbus reply
+    MODBUS_NOT_MODBUS,        // Port open, but what came back was not Modbus
+    MODBUS_NO_REPLY           // Port open, but nothing came back
+};
+
+// Display name of a Modbus status ("Modbus", "not Modbus", ...)
+const char* modbusStatusName(ModbusStatus status);
+
+// A unit ID that answered
+struct ModbusUnit {
+    uint8_t unitId;
+    uint8_t exceptionCode;    // 0 when the identification was read
+    String vendorName;
+    String productCode;
+    String revision;
+};
+
+struct ModbusIdentity {
+    IPAddress address;
+    ModbusStatus status;
+    std::vector<ModbusUnit> units;
+};
+
+// Called once per host, when every unit ID has answered or timed out
+typedef std::function<void(const ModbusIdentity&)> ModbusIdentityCallback;
+
+enum ModbusReplyType {
+    MODBUS_REPLY_IDENTIFICATION,  // Read Device Identification response
+    MODBUS_REPLY_EXCEPTION,       // Exception response (function code | 0x80)
+    MODBUS_REPLY_OTHER            // Some other well-formed Modbus response
+};
+
+// One decoded response; fixed-size, so decoding never allocates
+struct ModbusReply {
+    ModbusReplyType type;
+    uint16_t transactionId;
+    uint8_t unitId;
+    uint8_t exceptionCode;
+    bool moreFollows;             // Objects left; ask again from nextObjectId
+    uint8_t nextObjectId;
+    uint8_t found;                // Bit per identification object with a value
+    char objects[MODBUS_ID_OBJECTS][MODBUS_STRING_LENGTH];
+};
+
+class ModbusClient {
+public:
+    ModbusClient();
+    ~ModbusClient();
+
+    // Unit IDs tried on every host, in order
+    void setUnitIds(const std::vector<uint8_t>& unitIds);
+
+    // Queue a host with port 502 open; false when every slot is taken
+    // (poll, then try again)
+    bool add(IPAddress address);
+
+    // Connect, pipeline requests and collect replies; each host is
+    // reported once. Returns false once nothing is queued or in flight
+    bool poll(ModbusIdentityCallback callback, unsigned long waitMs = SWEEP_POLL_INTERVAL);
+
+    // Drop every host without reporting it
+    void stop();
+
+    bool isBusy();
+
+    // Frame codecs (MBAP + PDU)
+    static size_t buildReadDeviceId(uint8_t* buffer, size_t size, uint16_t transactionId,
+                                    uint8_t unitId, uint8_t objectId);
+
+    // Length of the ADU at the front of data; 0 when more bytes are
+    // needed, -1 when the bytes cannot be Modbus TCP
+    static int frameLength(const uint8_t* data, size_t length);
+
+    static bool parseReply(const uint8_t* data, size_t length, ModbusReply& reply);
+
+private:
+    struct Transaction {
+        bool used;
+        uint16_t id;
+        uint8_t unitIndex;
+        uint8_t objectId;         // First object asked for
+        unsigned long sentAt;
+    };
+
+    struct Host {
+        bool used;
+        int fd;
+        bool connected;
+        unsigned long connectStart;
+        unsigned long connectTimeout;
+        uint8_t reconnects;
+        uint8_t depth;            // Requests allowed in flight
+        size_t nextUnit;          // Next entry of unitIds to ask
+        Transaction transactions[MODBUS_PIPELINE_DEPTH];
+        uint8_t received[MODBUS_ADU_SIZE];
+        size_t receivedLength;
+        ModbusIdentity identity;
+    };
+
+    Host hosts[MODBUS_CLIENT_SLOTS];
+    size_t used;
+    std::vector<uint8_t> unitIds;
+    uint16_t nextTransactionId;
+    unsigned long pacerWait;
+
+    // Request buffer and decoded reply; reused for every packet
+    uint8_t frame[16];
+    ModbusReply reply;
+
+    void startConnects(ModbusIdentityCallback& callback);
+    bool openConnection(Host& host);
+    void checkConnect(Host& host, ModbusIdentityCallback& callback);
+    void receive(Host& host, ModbusIdentityCallback& callback);
+    void handleReply(Host& host);
+    void sendRequests(Host& host, ModbusIdentityCallback& callback);
+    bool sendRequest(Host& host, uint8_t unitIndex, uint8_t objectId);
+    void expire(Host& host, ModbusIdentityCallback& callback);
+    void connectionLost(Host& host, ModbusIdentityCallback& callback);
+    void closeConnection(Host& host);
+    void finish(Host& host, ModbusIdentityCallback& callback);
+    ModbusUnit& unitEntry(Host& host, uint8_t unitId);
+};
+
+#endif // MODBUS_CLIENT_H
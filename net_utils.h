@@ -0,0 +1,43 @@
+/*
+ * Network Utility Helpers
+ * Address conversions shared by the scanning modules
+ */
+
+#ifndef NET_UTILS_H
+#define NET_UTILS_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+// IPAddress stores its octets in network order, so casting it to uint32_t
+// does not give a value that can be incremented or compared as a range.
+// These helpers convert to and from host-order integers.
+inline uint32_t ipToHost(IPAddress ip) {
+    return ((uint32_t)ip[0] << 24) | ((uint32_t)ip[1] << 16) |
+           ((uint32_t)ip[2] << 8) | (uint32_t)ip[3];
+}
+
+inline IPAddress hostToIP(uint32_t value) {
+    return IPAddress((uint8_t)(value >> 24), (uint8_t)(value >> 16),
+                     (uint8_t)(value >> 8), (uint8_t)value);
+}
+
+// Broadcast address of the smallest block covering first..last; a single
+// address comes back unchanged (a unicast)
+inline IPAddress coveringBroadcast(IPAddress first, IPAddress last) {
+    uint32_t low = ipToHost(first);
+    uint32_t high = ipToHost(last);
+    uint32_t hostBits = (low == high) ? 0 : 32 - __builtin_clz(low ^ high);
+    uint32_t hostMask = (hostBits >= 32) ? 0xFFFFFFFF : ((1UL << hostBits) - 1);
+    return hostToIP(low | hostMask);
+}
+
+// Format a 6-byte hardware address as AA:BB:CC:DD:EE:FF
+inline String macToString(const uint8_t* mac) {
+    char buffer[18];
+    snprintf(buffer, sizeof(buffer), "%02X:%02X:%02X:%02X:%02X:%02X",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    return String(buffer);
+}
+
+#endif // NET_UTILS_H
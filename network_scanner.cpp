@@ -4,20 +4,25 @@
  */
 
 #include "network_scanner.h"
+#include "net_utils.h"
+#include "rtt_estimator.h"
+#include "probe_pacer.h"
 
 NetworkScanner::NetworkScanner() {
     lastScanTime = 0;
-    activeDevices.reserve(MAX_DEVICES);
+    sweepStartTime = 0;
+    sweepUsesArp = false;
 }
 
 NetworkScanner::~NetworkScanner() {
-    activeDevices.clear();
 }
 
 void NetworkScanner::begin() {
     Serial.println("Initializing Network Scanner...");
-    activeDevices.clear();
+    hostTable.reset(IPAddress(0, 0, 0, 0));
     lastScanTime = 0;
+    sweepEngine.begin(MAX_CONCURRENT_SCANS);
+    pingPool.begin(1);
     
     #if DEBUG_NETWORK
     Serial.println("Network Scanner initialized successfully");
@@ -29,58 +34,43 @@ std::vector<IPAddress> NetworkScanner::scanNetwork(IPAddress networkAddr, IPAddr
     Serial.println("Starting network scan...");
     #endif
     
-    activeDevices.clear();
-    
-    IPAddress startIP, endIP;
-    calculateScanRange(networkAddr, subnetMask, startIP, endIP);
+    TargetIterator targets;
+    uint8_t prefixLength = __builtin_popcount(ipToHost(subnetMask));
+    if (!targets.addCidr(networkAddr, prefixLength)) {
+        Serial.println("Cannot scan network: " + targets.getLastError());
+        return std::vector<IPAddress>();
+    }
     
     #if DEBUG_NETWORK
-    Serial.printf("Scanning range: %s to %s\n", 
-                  startIP.toString().c_str(), 
-                  endIP.toString().c_str());
+    Serial.printf("Scanning %s/%d (%u hosts)\n", 
+                  networkAddr.toString().c_str(), 
+                  prefixLength, targets.getTargetCount());
     #endif
     
-    // Scan each IP in the range
-    for (uint32_t ip = startIP; ip <= endIP; ip++) {
-        IPAddress currentIP = IPAddress(ip);
-        
-        // Skip network and broadcast addresses
-        if (currentIP == networkAddr || 
-            currentIP == IPAddress(ip | ~((uint32_t)subnetMask))) {
-            continue;
-        }
-        
-        // Skip our own IP
-        if (currentIP == ETH.localIP()) {
-            continue;
-        }
-        
+    SweepCallback onHost = [](IPAddress host, bool alive, unsigned long responseTime) {
         #if DEBUG_NETWORK
-        Serial.printf("Scanning: %s\r", currentIP.toString().c_str());
-        #endif
-        
-        if (pingDevice(currentIP)) {
-            activeDevices.push_back(currentIP);
-            updateDeviceCache(currentIP);
-            
-            #if DEBUG_NETWORK
-            Serial.printf("Found device: %s\n", currentIP.toString().c_str());
-            #endif
+        if (alive) {
+            Serial.printf("Found device: %s (%lu ms)\n", host.toString().c_str(), responseTime);
         }
-        
-        delay(SCAN_DELAY);
-        
+        #endif
+    };
+    
+    // ARP bursts for on-link ranges, otherwise MAX_CONCURRENT_SCANS
+    // connect probes in flight until the range is done
+    startSweep(targets);
+    while (pollSweep(onHost)) {
         // Watchdog reset to prevent timeout
         yield();
     }
     
     lastScanTime = millis();
+    std::vector<IPAddress> found = collectDevices(sweepStartTime);
     
     #if DEBUG_NETWORK
-    Serial.printf("Network scan completed. Found %d devices.\n", activeDevices.size());
+    Serial.printf("Network scan completed. Found %d devices.\n", found.size());
     #endif
     
-    return activeDevices;
+    return found;
 }
 
 bool NetworkScanner::pingDevice(IPAddress target) {
@@ -88,70 +78,162 @@ bool NetworkScanner::pingDevice(IPAddress target) {
         return false;
     }
     
-    // Try ARP ping first (faster)
-    if (arpPing(target)) {
-        return true;
+    // On-link hosts must answer ARP, so a silent one is down
+    if (ARP_SCAN_ENABLED && arpScanner.isOnLink(target)) {
+        return arpPing(target);
     }
     
-    // Fallback to TCP ping
+    // Routed hosts can only be reached with a TCP ping
     return tcpPing(target);
 }
 
-std::vector<IPAddress> NetworkScanner::getActiveDevices() {
-    return activeDevices;
-}
-
-void NetworkScanner::clearCache() {
-    activeDevices.clear();
-    lastScanTime = 0;
+void NetworkScanner::startSweep(IPAddress startIP, IPAddress endIP) {
+    TargetIterator targets;
+    targets.addRange(startIP, endIP);
+    startSweep(targets);
 }
 
-void NetworkScanner::calculateScanRange(IPAddress networkAddr, IPAddress subnetMask, 
-                                       IPAddress& startIP, IPAddress& endIP) {
-    uint32_t network = (uint32_t)networkAddr;
-    uint32_t mask = (uint32_t)subnetMask;
-    uint32_t broadcast = network | ~mask;
+void NetworkScanner::startSweep(const TargetIterator& targets) {
+    stopSweep();
+    sweepTargets = targets;
     
-    startIP = IPAddress(network + 1);
-    endIP = IPAddress(broadcast - 1);
-}
-
-bool NetworkScanner::arpPing(IPAddress target) {
-    // Simple ARP-style ping using UDP
-    WiFiUDP udp;
+    IPAddress first, last;
+    sweepTargets.getRange(0, first, last);
     
-    if (!udp.begin(0)) {
-        return false;
+    // Hosts from earlier sweeps stay until they age out, unless the new
+    // targets lie outside the table's /16 window
+    cleanupCache();
+    if (!hostTable.inWindow(first)) {
+        hostTable.reset(first);
     }
+    sweepStartTime = millis();
     
-    // Send a small UDP packet to trigger ARP resolution
-    udp.beginPacket(target, 7); // Echo port
-    udp.write((const uint8_t*)"ping", 4);
-    bool result = udp.endPacket();
+    // ARP only works when every target range is on-link
+    sweepUsesArp = ARP_SCAN_ENABLED && sweepTargets.getRangeCount() > 0;
+    for (size_t i = 0; sweepUsesArp && sweepTargets.getRange(i, first, last); i++) {
+        sweepUsesArp = arpScanner.isOnLink(first) && arpScanner.isOnLink(last);
+    }
     
-    udp.stop();
+    // A new order every sweep keeps consecutive probes spread across the
+    // targets instead of walking one subnet at a time
+    sweepTargets.start(esp_random());
     
-    return result;
+    if (sweepUsesArp) {
+        arpScanner.start(&sweepTargets);
+    } else {
+        sweepEngine.start(&sweepTargets);
+    }
 }
 
-bool NetworkScanner::tcpPing(IPAddress target) {
-    WiFiClient client;
-    client.setTimeout(PING_TIMEOUT);
+bool NetworkScanner::pollSweep(SweepCallback callback) {
+    if (sweepUsesArp) {
+        return arpScanner.poll([this, &callback](IPAddress host, const uint8_t* mac, unsigned long responseTime) {
+            if (mac) {
+                updateDeviceCache(host, mac);
+            }
+            if (callback) {
+                callback(host, mac != nullptr, responseTime);
+            }
+        });
+    }
     
-    // Try to connect to a common port (80)
-    bool connected = client.connect(target, 80);
+    return sweepEngine.poll([this, &callback](IPAddress host, bool alive, unsigned long responseTime) {
+        if (alive) {
+            updateDeviceCache(host);
+        }
+        if (callback) {
+            callback(host, alive, responseTime);
+        }
+    });
+}
+
+void NetworkScanner::stopSweep() {
+    arpScanner.stop();
+    sweepEngine.stop();
+}
+
+SweepProgress NetworkScanner::getSweepProgress() {
+    SweepProgress progress;
+    progress.usesArp = sweepUsesArp;
     
-    if (connected) {
-        client.stop();
-        return true;
+    if (sweepUsesArp) {
+        progress.total = arpScanner.getTotal();
+        progress.completed = arpScanner.getCompleted();
+        progress.alive = arpScanner.getAliveCount();
+        progress.unprobed = 0;
+        progress.elapsed = arpScanner.getElapsed();
+        progress.hostsPerSecond = arpScanner.getHostsPerSecond();
+    } else {
+        progress.total = sweepEngine.getTotal();
+        progress.completed = sweepEngine.getCompleted();
+        progress.alive = sweepEngine.getAliveCount();
+        progress.unprobed = sweepEngine.getUnprobedCount();
+        progress.elapsed = sweepEngine.getElapsed();
+        progress.hostsPerSecond = sweepEngine.getHostsPerSecond();
     }
     
-    // If port 80 fails, try port 443
-    connected = client.connect(target, 443);
+    return progress;
+}
+
+bool NetworkScanner::getMacAddress(IPAddress device, uint8_t* mac) {
+    return hostTable.getMac(device, mac);
+}
+
+std::vector<IPAddress> NetworkScanner::getActiveDevices() {
+    return collectDevices(0);
+}
+
+HostTable& NetworkScanner::getHostTable() {
+    return hostTable;
+}
+
+void NetworkScanner::clearCache() {
+    hostTable.reset(IPAddress(0, 0, 0, 0));
+    lastScanTime = 0;
+}
+
+bool NetworkScanner::arpPing(IPAddress target) {
+    uint8_t mac[6];
     
-    if (connected) {
-        client.stop();
-        return true;
+    if (!arpScanner.probe(target, mac)) {
+        return false;
+    }
+    
+    updateDeviceCache(target, mac);
+    return true;
+}
+
+bool NetworkScanner::tcpPing(IPAddress target) {
+    // Try each liveness port in turn; an RST proves the host is up as
+    // much as a completed handshake does
+    for (int port : LIVENESS_PORTS) {
+        unsigned long timeout = rttEstimator.getTimeout(target, PING_TIMEOUT);
+        probePacer.acquire(target);
+        if (!pingPool.submit(target, port, timeout, 0)) {
+            probePacer.release(target);
+            return false;
+        }
+        
+        ConnectOutcome outcome = CONNECT_ERROR;
+        unsigned long responseTime = 0;
+        while (pingPool.inFlight() > 0) {
+            pingPool.poll(SWEEP_POLL_INTERVAL, [&](const ConnectCompletion& completion) {
+                outcome = completion.outcome;
+                responseTime = completion.responseTime;
+            });
+            yield();
+        }
+        probePacer.release(target);
+        
+        if (outcome == CONNECT_OPEN || outcome == CONNECT_REFUSED) {
+            rttEstimator.addSample(target, responseTime);
+            updateDeviceCache(target);
+            return true;
+        }
+        
+        if (outcome == CONNECT_TIMEOUT) {
+            rttEstimator.addTimeout(target);
+        }
     }
     
     return false;
@@ -175,26 +257,36 @@ bool NetworkScanner::isValidIP(IPAddress ip) {
     return true;
 }
 
-void NetworkScanner::updateDeviceCache(IPAddress device) {
-    // Check if device already exists in cache
-    for (auto it = activeDevices.begin(); it != activeDevices.end(); ++it) {
-        if (*it == device) {
-            return; // Already in cache
-        }
+void NetworkScanner::updateDeviceCache(IPAddress device, const uint8_t* mac) {
+    if (!hostTable.markSeen(device, millis(), mac)) {
+        #if DEBUG_NETWORK
+        Serial.printf("Device table full or out of window, dropped %s\n", device.toString().c_str());
+        #endif
     }
+}
+
+void NetworkScanner::cleanupCache() {
+    size_t removed = hostTable.ageOut(millis(), DEVICE_MAX_AGE);
     
-    // Add to cache if not full
-    if (activeDevices.size() < DEVICE_CACHE_SIZE) {
-        activeDevices.push_back(device);
+    #if DEBUG_NETWORK
+    if (removed > 0) {
+        Serial.printf("Aged out %d devices\n", removed);
     }
+    #endif
 }
 
-void NetworkScanner::cleanupCache() {
-    // Remove devices that haven't been seen recently
-    // This is a simple implementation - in practice, you might want
-    // to track last seen timestamps
+std::vector<IPAddress> NetworkScanner::collectDevices(unsigned long since) {
+    std::vector<IPAddress> devices;
+    devices.reserve(hostTable.count());
+    unsigned long now = millis();
     
-    if (millis() - lastScanTime > SCAN_INTERVAL * 5) {
-        activeDevices.clear();
+    uint32_t cursor = 0;
+    IPAddress device;
+    while (hostTable.next(cursor, device)) {
+        if (now - hostTable.getLastSeen(device) <= now - since) {
+            devices.push_back(device);
+        }
     }
+    
+    return devices;
 }
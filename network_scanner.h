@@ -25,6 +25,20 @@
 #include <vector>
 #include <IPAddress.h>
 #include "config.h"
+#include "sweep_engine.h"
+#include "arp_scanner.h"
+#include "host_table.h"
+#include "target_iterator.h"
+
+struct SweepProgress {
+    uint32_t total;
+    uint32_t completed;
+    uint32_t alive;
+    uint32_t unprobed;         // Hosts the sweep found no socket for
+    unsigned long elapsed;
+    float hostsPerSecond;
+    bool usesArp;
+};
 
 class NetworkScanner {
 public:
@@ -40,21 +54,37 @@ public:
     // Ping a specific device
     bool pingDevice(IPAddress target);
     
+    // Incremental concurrent sweep (non-blocking, one poll per call);
+    // targets are visited in a fresh random order on every sweep
+    void startSweep(IPAddress startIP, IPAddress endIP);
+    void startSweep(const TargetIterator& targets);
+    bool pollSweep(SweepCallback callback);
+    void stopSweep();
+    SweepProgress getSweepProgress();
+    
+    // Look up the hardware address learned for a device
+    bool getMacAddress(IPAddress device, uint8_t* mac);
+    
     // Get list of recently discovered devices
     std::vector<IPAddress> getActiveDevices();
     
+    // Device table access (last-seen/first-seen per host)
+    HostTable& getHostTable();
+    
     // Clear device cache
     void clearCache();
     
 private:
-    std::vector<IPAddress> activeDevices;
+    HostTable hostTable;
     unsigned long lastScanTime;
+    unsigned long sweepStartTime;
+    SweepEngine sweepEngine;
+    ArpScanner arpScanner;
+    ConnectPool pingPool;
+    TargetIterator sweepTargets;
+    bool sweepUsesArp;
     
-    // Calculate network range
-    void calculateScanRange(IPAddress networkAddr, IPAddress subnetMask, 
-                           IPAddress& startIP, IPAddress& endIP);
-    
-    // Perform ARP scan
+    // Resolve a single on-link host over ARP
     bool arpPing(IPAddress target);
     
     // Perform TCP connect scan
@@ -63,11 +93,14 @@ private:
     // Check if IP is in valid range
     bool isValidIP(IPAddress ip);
     
-    // Update device cache
-    void updateDeviceCache(IPAddress device);
+    // Update device cache (mac may be nullptr)
+    void updateDeviceCache(IPAddress device, const uint8_t* mac = nullptr);
     
-    // Remove stale devices from cache
+    // Remove devices whose own last-seen time is older than DEVICE_MAX_AGE
     void cleanupCache();
+    
+    // Collect devices seen at or after a point in time
+    std::vector<IPAddress> collectDevices(unsigned long since);
 };
 
 #endif // NETWORK_SCANNER_H
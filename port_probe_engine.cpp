@@ -0,0 +1,201 @@
+/*
+ * Port Probe Engine Implementation
+ * Multiplexed TCP port probing over many (host, port) pairs at once
+ */
+
+#include "port_probe_engine.h"
+#include "rtt_estimator.h"
+#include "probe_pacer.h"
+#include <lwip/sockets.h>
+
+const char* portStateName(PortState state) {
+    switch (state) {
+        case PORT_OPEN: return "OPEN";
+        case PORT_CLOSED: return "CLOSED";
+        case PORT_FILTERED: return "FILTERED";
+        case PORT_UNREACHABLE: return "UNREACHABLE";
+        case PORT_OPEN_FILTERED: return "OPEN|FILTERED";
+        default: return "UNKNOWN";
+    }
+}
+
+PortProbeEngine::PortProbeEngine() {
+    queueLimit = 0;
+    pacerWait = 0;
+}
+
+void PortProbeEngine::begin(size_t maxInFlight, size_t queueSize) {
+    pool.begin(maxInFlight);
+    grabber.begin(maxInFlight);
+    queueLimit = queueSize;
+
+    // Timed-out probes re-enter the queue even when it is full
+    queue.reserve(queueSize + maxInFlight);
+}
+
+bool PortProbeEngine::add(IPAddress target, uint16_t port) {
+    if (queue.size() >= queueLimit) {
+        return false;
+    }
+
+    QueuedProbe probe = {target, port, 0};
+    queue.push_back(probe);
+    return true;
+}
+
+bool PortProbeEngine::poll(PortProbeCallback callback, unsigned long waitMs) {
+    refill(callback);
+
+    if (pool.inFlight() == 0 && grabber.active() == 0) {
+        if (queue.empty()) {
+            return false;
+        }
+        // Only the pacer is holding us back; nothing to select() on
+        delay(pacerWait < waitMs ? (pacerWait > 0 ? pacerWait : 1) : waitMs);
+        return true;
+    }
+
+    // Connects first; replies already waiting are read without blocking
+    if (pool.inFlight() > 0) {
+        pool.poll(grabber.active() > 0 ? 0 : waitMs, [this, &callback](const ConnectCompletion& completion) {
+            handleCompletion(completion, callback);
+        });
+    }
+    if (grabber.active() > 0) {
+        grabber.poll(pool.inFlight() > 0 ? 0 : waitMs, [this, &callback](const BannerCompletion& banner) {
+            handleBanner(banner, callback);
+        });
+    }
+
+    refill(callback);
+    return isBusy();
+}
+
+void PortProbeEngine::stop() {
+    pool.cancelAll();
+    grabber.cancelAll();
+    queue.clear();
+}
+
+bool PortProbeEngine::isBusy() {
+    return !queue.empty() || pool.inFlight() > 0 || grabber.active() > 0;
+}
+
+size_t PortProbeEngine::getQueued() {
+    return queue.size();
+}
+
+size_t PortProbeEngine::getInFlight() {
+    return pool.inFlight();
+}
+
+void PortProbeEngine::refill(PortProbeCallback& callback) {
+    // Walk the whole queue so one host waiting out its gap does not hold
+    // up probes to the others
+    for (size_t i = 0; i < queue.size() && hasFreeSocket();) {
+        QueuedProbe& probe = queue[i];
+
+        if (!probePacer.tryAcquire(probe.target, &pacerWait)) {
+            i++;
+            continue;
+        }
+
+        unsigned long timeout = rttEstimator.getTimeout(probe.target, PORT_TIMEOUT);
+        bool submitted = pool.submit(probe.target, probe.port, timeout, probe.attempts, true);
+        if (!submitted) {
+            probePacer.release(probe.target);
+            if (pool.inFlight() > 0 || grabber.active() > 0) {
+                // Out of sockets - retry once a probe finishes
+                break;
+            }
+
+            // Nothing left to free a socket; give up on this probe
+            PortProbeResult result = {probe.target, probe.port, PORT_FILTERED, 0, (uint8_t)(probe.attempts + 1), nullptr, 0};
+            queue.erase(queue.begin() + i);
+            if (callback) {
+                callback(result);
+            }
+            continue;
+        }
+
+        queue.erase(queue.begin() + i);
+    }
+}
+
+void PortProbeEngine::handleCompletion(const ConnectCompletion& completion, PortProbeCallback& callback) {
+    PortProbeResult result;
+    result.target = completion.target;
+    result.port = completion.port;
+    result.responseTime = completion.responseTime;
+    result.attempts = completion.tag + 1;
+    result.fingerprints = nullptr;
+    result.fingerprintCount = 0;
+
+    probePacer.release(completion.target);
+
+    switch (completion.outcome) {
+        case CONNECT_OPEN:
+            rttEstimator.addSample(completion.target, completion.responseTime);
+
+            // Reported once the reply has been read; without a free read
+            // slot the socket is closed and the port reported bare
+            if (!grabber.start(completion.fd, completion.target, completion.port,
+                               completion.tag, completion.responseTime)) {
+                result.state = PORT_OPEN;
+                break;
+            }
+            return;
+        case CONNECT_REFUSED:
+            // The RST is as good an RTT sample as a SYN-ACK
+            rttEstimator.addSample(completion.target, completion.responseTime);
+            result.state = PORT_CLOSED;
+            break;
+        case CONNECT_UNREACHABLE:
+            result.state = PORT_UNREACHABLE;
+            break;
+        case CONNECT_TIMEOUT:
+            rttEstimator.addTimeout(completion.target);
+            result.state = PORT_FILTERED;
+            break;
+        default:
+            // Local socket trouble says nothing about the port
+            result.state = PORT_FILTERED;
+            break;
+    }
+
+    // An RST or ICMP unreachable is a definite answer; only a timeout
+    // (lost SYN or a silent firewall) is worth another attempt, and the
+    // RTT estimator has already backed the timeout off
+    if (result.state == PORT_FILTERED && result.attempts < MAX_RETRY_ATTEMPTS) {
+        QueuedProbe retry = {completion.target, completion.port, result.attempts};
+        queue.push_back(retry);
+        return;
+    }
+
+    if (callback) {
+        callback(result);
+    }
+}
+
+void PortProbeEngine::handleBanner(const BannerCompletion& banner, PortProbeCallback& callback) {
+    ServiceFingerprint fingerprints[FINGERPRINT_MAX];
+    size_t count = banner.tls ? fingerprintTls(banner.port, *banner.tls, fingerprints, FINGERPRINT_MAX)
+                              : fingerprintReply(banner.port, banner.data, banner.length, fingerprints, FINGERPRINT_MAX);
+
+#if DEBUG_PORT_SCAN
+    for (size_t i = 0; i < count; i++) {
+        Serial.printf("Fingerprint %s:%u %s: %s\n", banner.target.toString().c_str(), banner.port,
+                      fingerprintName(fingerprints[i].id), fingerprints[i].detail);
+    }
+#endif
+
+    PortProbeResult result = {banner.target, banner.port, PORT_OPEN, banner.responseTime,
+                              (uint8_t)(banner.tag + 1), fingerprints, (uint8_t)count};
+    if (callback) {
+        callback(result);
+    }
+}
+
+bool PortProbeEngine::hasFreeSocket() {
+    return pool.inFlight() + grabber.active() < pool.capacity();
+}
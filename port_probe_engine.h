@@ -0,0 +1,89 @@
+/*
+ * Port Probe Engine Header
+ * Multiplexed TCP port probing over many (host, port) pairs at once
+ */
+
+#ifndef PORT_PROBE_ENGINE_H
+#define PORT_PROBE_ENGINE_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+#include <IPAddress.h>
+#include "config.h"
+#include "connect_pool.h"
+#include "banner_grabber.h"
+#include "fingerprint.h"
+
+enum PortState {
+    PORT_OPEN,            // Handshake completed
+    PORT_CLOSED,          // Host answered with RST
+    PORT_FILTERED,        // No answer, even after retries
+    PORT_UNREACHABLE,     // ICMP host/network unreachable
+    PORT_OPEN_FILTERED    // UDP: no reply and no ICMP error, even after retries
+};
+
+// Display name of a port state ("OPEN", "CLOSED", ...)
+const char* portStateName(PortState state);
+
+struct PortProbeResult {
+    IPAddress target;
+    uint16_t port;
+    PortState state;
+    unsigned long responseTime;   // Of the final attempt
+    uint8_t attempts;
+    const ServiceFingerprint* fingerprints;   // Open ports only; valid during the callback
+    uint8_t fingerprintCount;
+};
+
+// Called once per (host, port) pair as soon as it has a final state
+typedef std::function<void(const PortProbeResult&)> PortProbeCallback;
+
+class PortProbeEngine {
+public:
+    PortProbeEngine();
+
+    // Size the socket pool and the pending queue
+    void begin(size_t maxInFlight = MAX_CONCURRENT_PORT_PROBES,
+               size_t queueSize = PORT_PROBE_QUEUE_SIZE);
+
+    // Queue a probe; false when the queue is full (poll, then try again)
+    bool add(IPAddress target, uint16_t port);
+
+    // Launch queued probes and report finished ones; returns false once
+    // nothing is queued or in flight
+    bool poll(PortProbeCallback callback, unsigned long waitMs = SWEEP_POLL_INTERVAL);
+
+    // Drop everything queued or in flight without reporting it
+    void stop();
+
+    bool isBusy();
+    size_t getQueued();
+    size_t getInFlight();
+
+private:
+    struct QueuedProbe {
+        IPAddress target;
+        uint16_t port;
+        uint8_t attempts;         // Attempts already made (timeouts only)
+    };
+
+    ConnectPool pool;
+    BannerGrabber grabber;
+    std::vector<QueuedProbe> queue;
+    size_t queueLimit;
+    unsigned long pacerWait;
+
+    // Submit queued probes while slots and the pacer allow
+    void refill(PortProbeCallback& callback);
+
+    void handleCompletion(const ConnectCompletion& completion, PortProbeCallback& callback);
+
+    // Fingerprint the reply read on an open port and report the port
+    void handleBanner(const BannerCompletion& banner, PortProbeCallback& callback);
+
+    // Connects and banner reads share the socket budget
+    bool hasFreeSocket();
+};
+
+#endif // PORT_PROBE_ENGINE_H
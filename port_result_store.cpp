@@ -0,0 +1,156 @@
+/*
+ * Port Result Store Implementation
+ * Fixed-capacity port result cache keyed by (host, port)
+ */
+
+#include "port_result_store.h"
+#include "net_utils.h"
+
+#if (PORT_RESULT_CAPACITY & (PORT_RESULT_CAPACITY - 1)) != 0
+#error "PORT_RESULT_CAPACITY must be a power of two"
+#endif
+
+#if PORT_RESULT_CAPACITY >= PORT_RESULT_NO_ENTRY
+#error "PORT_RESULT_CAPACITY must fit the 16-bit bucket index"
+#endif
+
+IPAddress PortResultEntry::target() const {
+    return hostToIP(host);
+}
+
+PortState PortResultEntry::portState() const {
+    return (PortState)state;
+}
+
+PortResultStore::Iterator::Iterator(const PortResultStore* owner, size_t start) {
+    store = owner;
+    position = start;
+}
+
+const PortResultEntry& PortResultStore::Iterator::operator*() const {
+    return store->entries[(store->head + position) & (PORT_RESULT_CAPACITY - 1)];
+}
+
+const PortResultEntry* PortResultStore::Iterator::operator->() const {
+    return &**this;
+}
+
+PortResultStore::Iterator& PortResultStore::Iterator::operator++() {
+    position++;
+    return *this;
+}
+
+bool PortResultStore::Iterator::operator!=(const Iterator& other) const {
+    return position != other.position;
+}
+
+PortResultStore::PortResultStore() {
+    clear();
+}
+
+void PortResultStore::clear() {
+    memset(buckets, 0xFF, sizeof(buckets));
+    head = 0;
+    count = 0;
+    evicted = 0;
+}
+
+void PortResultStore::put(IPAddress target, uint16_t port, PortState state, unsigned long responseTime) {
+    uint32_t host = ipToHost(target);
+    size_t bucket = probe(host, port);
+
+    if (buckets[bucket] != PORT_RESULT_NO_ENTRY) {
+        PortResultEntry& entry = entries[buckets[bucket]];
+        entry.state = state;
+        entry.responseTime = responseTime;
+        return;
+    }
+
+    if (count == PORT_RESULT_CAPACITY) {
+        // The oldest slot is reused for the new entry; removing its key may
+        // shift the cluster the new key probed into, so probe again
+        const PortResultEntry& oldest = entries[head];
+        removeBucket(probe(oldest.host, oldest.port));
+        head = (head + 1) & (PORT_RESULT_CAPACITY - 1);
+        count--;
+        evicted++;
+        bucket = probe(host, port);
+    }
+
+    size_t index = (head + count) & (PORT_RESULT_CAPACITY - 1);
+    PortResultEntry& entry = entries[index];
+    entry.host = host;
+    entry.port = port;
+    entry.state = state;
+    entry.responseTime = responseTime;
+    buckets[bucket] = index;
+    count++;
+}
+
+const PortResultEntry* PortResultStore::find(IPAddress target, uint16_t port) const {
+    size_t bucket = probe(ipToHost(target), port);
+    if (buckets[bucket] == PORT_RESULT_NO_ENTRY) {
+        return nullptr;
+    }
+    return &entries[buckets[bucket]];
+}
+
+PortResultStore::Iterator PortResultStore::begin() const {
+    return Iterator(this, 0);
+}
+
+PortResultStore::Iterator PortResultStore::end() const {
+    return Iterator(this, count);
+}
+
+size_t PortResultStore::size() const {
+    return count;
+}
+
+uint32_t PortResultStore::getEvicted() const {
+    return evicted;
+}
+
+size_t PortResultStore::bucketOf(uint32_t host, uint16_t port) {
+    // Hosts in one subnet differ only in the low bits, and most share a
+    // handful of ports; a multiplicative hash spreads both over the table
+    uint32_t key = host * 0x9E3779B1u ^ (uint32_t)port * 0x85EBCA77u;
+    key ^= key >> 15;
+    key *= 0x2C1B3C6Du;
+    key ^= key >> 12;
+    return key & (PORT_RESULT_BUCKETS - 1);
+}
+
+size_t PortResultStore::probe(uint32_t host, uint16_t port) const {
+    // At most half the buckets are used, so an empty one is always found
+    size_t bucket = bucketOf(host, port);
+    while (buckets[bucket] != PORT_RESULT_NO_ENTRY) {
+        const PortResultEntry& entry = entries[buckets[bucket]];
+        if (entry.host == host && entry.port == port) {
+            break;
+        }
+        bucket = (bucket + 1) & (PORT_RESULT_BUCKETS - 1);
+    }
+    return bucket;
+}
+
+void PortResultStore::removeBucket(size_t gap) {
+    buckets[gap] = PORT_RESULT_NO_ENTRY;
+
+    size_t bucket = (gap + 1) & (PORT_RESULT_BUCKETS - 1);
+    while (buckets[bucket] != PORT_RESULT_NO_ENTRY) {
+        const PortResultEntry& entry = entries[buckets[bucket]];
+        size_t home = bucketOf(entry.host, entry.port);
+
+        // An entry may move back into the gap only if its home bucket does
+        // not lie cyclically in (gap, bucket]
+        size_t fromGap = (bucket - gap) & (PORT_RESULT_BUCKETS - 1);
+        size_t fromHome = (bucket - home) & (PORT_RESULT_BUCKETS - 1);
+        if (fromHome >= fromGap) {
+            buckets[gap] = buckets[bucket];
+            buckets[bucket] = PORT_RESULT_NO_ENTRY;
+            gap = bucket;
+        }
+        bucket = (bucket + 1) & (PORT_RESULT_BUCKETS - 1);
+    }
+}
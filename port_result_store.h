@@ -0,0 +1,82 @@
+/*
+ * Port Result Store Header
+ * Fixed-capacity port result cache keyed by (host, port)
+ */
+
+#ifndef PORT_RESULT_STORE_H
+#define PORT_RESULT_STORE_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include "config.h"
+#include "port_probe_engine.h"
+
+// Entries live in a ring in insertion order, so the oldest one is always
+// at the head and eviction is O(1). An open-addressing index over twice
+// as many buckets (linear probing, load at most 1/2) finds a key in O(1).
+#define PORT_RESULT_BUCKETS (PORT_RESULT_CAPACITY * 2)
+#define PORT_RESULT_NO_ENTRY 0xFFFF
+
+struct PortResultEntry {
+    uint32_t host;                // Host order
+    uint16_t port;
+    uint8_t state;                // PortState
+    uint32_t responseTime;
+
+    IPAddress target() const;
+    PortState portState() const;
+};
+
+class PortResultStore {
+public:
+    // Walks the entries from oldest to newest
+    class Iterator {
+    public:
+        Iterator(const PortResultStore* store, size_t position);
+        const PortResultEntry& operator*() const;
+        const PortResultEntry* operator->() const;
+        Iterator& operator++();
+        bool operator!=(const Iterator& other) const;
+
+    private:
+        const PortResultStore* store;
+        size_t position;              // 0 = oldest
+    };
+
+    PortResultStore();
+
+    // Drop every entry
+    void clear();
+
+    // Insert or update a result (O(1), no allocation); when full the
+    // oldest entry makes room
+    void put(IPAddress target, uint16_t port, PortState state, unsigned long responseTime);
+
+    // Lookup (O(1)); nullptr when the pair is not cached
+    const PortResultEntry* find(IPAddress target, uint16_t port) const;
+
+    Iterator begin() const;
+    Iterator end() const;
+
+    // Statistics
+    size_t size() const;
+    uint32_t getEvicted() const;
+
+private:
+    PortResultEntry entries[PORT_RESULT_CAPACITY];
+    uint16_t buckets[PORT_RESULT_BUCKETS];    // Entry index, or PORT_RESULT_NO_ENTRY
+    size_t head;                              // Oldest entry
+    size_t count;
+    uint32_t evicted;
+
+    static size_t bucketOf(uint32_t host, uint16_t port);
+
+    // Bucket holding the pair, or the empty bucket where it would go
+    size_t probe(uint32_t host, uint16_t port) const;
+
+    // Empty a bucket and pull later members of its cluster back into the
+    // gap, so lookups never need tombstones
+    void removeBucket(size_t bucket);
+};
+
+#endif // PORT_RESULT_STORE_H
@@ -4,208 +4,216 @@
  */
 
 #include "port_scanner.h"
+#include "service_catalog.h"
 
 PortScanner::PortScanner() {
-    scanResults.reserve(MAX_DEVICES * TARGET_PORTS.size());
+    scanMethod = PORT_SCAN_CONNECT;
 }
 
 PortScanner::~PortScanner() {
-    scanResults.clear();
 }
 
 void PortScanner::begin() {
     Serial.println("Initializing Port Scanner...");
-    scanResults.clear();
+    results.clear();
+    engine.begin(MAX_CONCURRENT_PORT_PROBES);
+    
+    if (!synScanner.begin()) {
+        Serial.println("SYN scan unavailable, using TCP connect only");
+    }
+    
+    if (!udpScanner.begin()) {
+        Serial.println("ICMP hook unavailable, closed UDP ports will read OPEN|FILTERED");
+    }
     
     #if DEBUG_PORT_SCAN
     Serial.println("Port Scanner initialized successfully");
     #endif
 }
 
-bool PortScanner::testPort(IPAddress target, int port) {
+PortState PortScanner::testPort(IPAddress target, int port) {
     if (!isValidPort(port)) {
         #if DEBUG_PORT_SCAN
         Serial.printf("Invalid port number: %d\n", port);
         #endif
-        return false;
+        return PORT_UNREACHABLE;
     }
     
-    unsigned long responseTime = 0;
-    bool isOpen = tcpConnect(target, port, responseTime);
+    PortState state = PORT_FILTERED;
+    scanPorts(target, std::vector<int>(1, port), [&state](const PortProbeResult& result) {
+        state = result.state;
+    });
     
-    // Add result to cache
-    addResult(target, port, isOpen, responseTime);
+    return state;
+}
+
+PortState PortScanner::synScan(IPAddress target, int port) {
+    if (!isValidPort(port)) {
+        return PORT_UNREACHABLE;
+    }
+    if (!synScanner.isReady()) {
+        return testPort(target, port);
+    }
     
-    #if DEBUG_PORT_SCAN
-    Serial.printf("Port scan: %s:%d - %s (Response: %lu ms)\n", 
-                  target.toString().c_str(), 
-                  port, 
-                  isOpen ? "OPEN" : "CLOSED", 
-                  responseTime);
-    #endif
+    PortState state = PORT_FILTERED;
+    synScanner.add(target, port);
+    while (synScanner.poll([this, &state](const PortProbeResult& result) {
+        addResult(result.target, result.port, result.state, result.responseTime);
+        state = result.state;
+    })) {
+        yield();
+    }
     
-    return isOpen;
+    return state;
 }
 
-std::vector<PortScanResult> PortScanner::scanPorts(IPAddress target, const std::vector<int>& ports) {
-    std::vector<PortScanResult> results;
-    
-    #if DEBUG_PORT_SCAN
-    Serial.printf("Scanning %d ports on %s\n", ports.size(), target.toString().c_str());
-    #endif
+PortState PortScanner::udpScan(IPAddress target, int port) {
+    if (!isValidPort(port)) {
+        return PORT_UNREACHABLE;
+    }
     
-    for (int port : ports) {
-        unsigned long responseTime = 0;
-        bool isOpen = tcpConnect(target, port, responseTime);
-        
-        PortScanResult result;
-        result.target = target;
-        result.port = port;
-        result.isOpen = isOpen;
-        result.responseTime = responseTime;
-        result.serviceName = getServiceName(port);
-        
-        results.push_back(result);
-        addResult(target, port, isOpen, responseTime);
-        
-        // Small delay between port scans
-        delay(50);
+    PortState state = PORT_OPEN_FILTERED;
+    while (!queueUdpProbe(target, port)) {
+        pollUdpProbes(nullptr);
+    }
+    while (pollUdpProbes([target, port, &state](const PortProbeResult& result) {
+        if (result.target == target && result.port == port) {
+            state = result.state;
+        }
+    })) {
         yield();
     }
     
-    return results;
+    return state;
 }
 
-std::vector<PortScanResult> PortScanner::getLastResults() {
-    return scanResults;
+void PortScanner::setScanMethod(PortScanMethod method) {
+    if (method == PORT_SCAN_SYN && !synScanner.isReady()) {
+        method = PORT_SCAN_CONNECT;
+    }
+    scanMethod = method;
 }
 
-void PortScanner::clearResults() {
-    scanResults.clear();
+PortScanMethod PortScanner::getScanMethod() {
+    return scanMethod;
 }
 
-bool PortScanner::tcpConnect(IPAddress target, int port, unsigned long& responseTime) {
-    WiFiClient client;
+std::vector<PortScanResult> PortScanner::scanPorts(IPAddress target, const std::vector<int>& ports) {
+    std::vector<PortScanResult> results;
+    results.reserve(ports.size());
     
-    // Set timeout for connection attempt
-    client.setTimeout(PORT_TIMEOUT);
+    scanPorts(target, ports, [this, &results](const PortProbeResult& probe) {
+        PortScanResult result;
+        result.target = probe.target;
+        result.port = probe.port;
+        result.state = probe.state;
+        result.responseTime = probe.responseTime;
+        result.serviceName = serviceName(probe.port);
+        results.push_back(result);
+    });
     
-    unsigned long startTime = millis();
-    bool connected = false;
+    return results;
+}
+
+void PortScanner::scanPorts(IPAddress target, const std::vector<int>& ports, PortProbeCallback callback) {
+    #if DEBUG_PORT_SCAN
+    Serial.printf("Scanning %d ports on %s\n", ports.size(), target.toString().c_str());
+    #endif
     
-    // Attempt connection with retry logic
-    for (int attempt = 0; attempt < MAX_RETRY_ATTEMPTS; attempt++) {
-        connected = client.connect(target, port);
-        
-        if (connected) {
-            break;
+    // Ports go out MAX_CONCURRENT_PORT_PROBES at a time; spacing between
+    // them is left to the probe pacer
+    for (int port : ports) {
+        if (!isValidPort(port)) {
+            continue;
         }
-        
-        if (attempt < MAX_RETRY_ATTEMPTS - 1) {
-            delay(RETRY_DELAY);
+        while (!queueProbe(target, port)) {
+            pollProbes(callback);
         }
     }
     
-    responseTime = millis() - startTime;
-    
-    if (connected) {
-        // Send a minimal request for specific protocols
-        if (port == 80) {
-            client.print("HEAD / HTTP/1.1\r\nHost: ");
-            client.print(target.toString());
-            client.print("\r\nConnection: close\r\n\r\n");
-        } else if (port == 443) {
-            // For HTTPS, just the connection attempt is enough
-            // as SSL handshake would require more complex implementation
-        } else if (port == 502) {
-            // MODBUS TCP - send a simple query
-            uint8_t modbusQuery[] = {0x00, 0x01, 0x00, 0x00, 0x00, 0x06, 0x01, 0x03, 0x00, 0x00, 0x00, 0x01};
-            client.write(modbusQuery, sizeof(modbusQuery));
-        } else if (port == 47808) {
-            // BACnet - send a simple who-is request
-            uint8_t bacnetQuery[] = {0x81, 0x0B, 0x00, 0x0C, 0x01, 0x20, 0xFF, 0xFF, 0x00, 0xFF, 0x10, 0x08};
-            client.write(bacnetQuery, sizeof(bacnetQuery));
-        }
-        
-        // Wait for response (brief)
-        delay(100);
-        
-        // Check if we got any response
-        bool hasResponse = client.available() > 0;
+    while (pollProbes(callback)) {
+        yield();
+    }
+}
+
+bool PortScanner::queueProbe(IPAddress target, int port) {
+    if (scanMethod == PORT_SCAN_SYN) {
+        return synScanner.add(target, port);
+    }
+    return engine.add(target, port);
+}
+
+bool PortScanner::pollProbes(PortProbeCallback callback, unsigned long waitMs) {
+    PortProbeCallback report = [this, &callback](const PortProbeResult& result) {
+        // Add result to cache
+        addResult(result.target, result.port, result.state, result.responseTime);
         
-        client.stop();
+        #if DEBUG_PORT_SCAN
+        Serial.printf("Port scan: %s:%d - %s (Response: %lu ms, %d attempts)\n", 
+                      result.target.toString().c_str(), 
+                      result.port, 
+                      portStateName(result.state), 
+                      result.responseTime,
+                      result.attempts);
+        #endif
         
+        if (callback) {
+            callback(result);
+        }
+    };
+    
+    if (scanMethod == PORT_SCAN_SYN) {
+        return synScanner.poll(report, waitMs);
+    }
+    return engine.poll(report, waitMs);
+}
+
+void PortScanner::cancelProbes() {
+    engine.stop();
+    synScanner.stop();
+    udpScanner.stop();
+}
+
+bool PortScanner::queueUdpProbe(IPAddress target, int port) {
+    if (!isValidPort(port)) {
         return true;
     }
-    
-    return false;
+    return udpScanner.add(target, port);
+}
+
+bool PortScanner::pollUdpProbes(PortProbeCallback callback, unsigned long waitMs) {
+    return udpScanner.poll([&callback](const PortProbeResult& result) {
+        #if DEBUG_PORT_SCAN
+        Serial.printf("UDP scan: %s:%d - %s (Response: %lu ms, %d attempts)\n",
+                      result.target.toString().c_str(),
+                      result.port,
+                      portStateName(result.state),
+                      result.responseTime,
+                      result.attempts);
+        #endif
+        
+        if (callback) {
+            callback(result);
+        }
+    }, waitMs);
+}
+
+const PortResultStore& PortScanner::getLastResults() {
+    return results;
 }
 
-bool PortScanner::synScan(IPAddress target, int port) {
-    // Simplified SYN scan - not implementing raw sockets
-    // Fall back to TCP connect
-    unsigned long responseTime;
-    return tcpConnect(target, port, responseTime);
+void PortScanner::clearResults() {
+    results.clear();
 }
 
 bool PortScanner::isCommonPort(int port) {
-    // Check if port is in our target list
-    for (int targetPort : TARGET_PORTS) {
-        if (port == targetPort) {
-            return true;
-        }
-    }
-    return false;
-}
-
-String PortScanner::getServiceName(int port) {
-    switch (port) {
-        case 80: return "HTTP";
-        case 443: return "HTTPS";
-        case 502: return "MODBUS TCP";
-        case 47808: return "BACnet";
-        case 21: return "FTP";
-        case 22: return "SSH";
-        case 23: return "Telnet";
-        case 25: return "SMTP";
-        case 53: return "DNS";
-        case 110: return "POP3";
-        case 143: return "IMAP";
-        case 993: return "IMAPS";
-        case 995: return "POP3S";
-        case 1883: return "MQTT";
-        case 8080: return "HTTP-Alt";
-        case 8443: return "HTTPS-Alt";
-        default: return "Unknown";
-    }
+    return isValidPort(port) && findService(port, SERVICE_TCP) != nullptr;
 }
 
 bool PortScanner::isValidPort(int port) {
     return (port > 0 && port <= 65535);
 }
 
-void PortScanner::addResult(IPAddress target, int port, bool isOpen, unsigned long responseTime) {
-    // Check if we already have this result
-    for (auto& result : scanResults) {
-        if (result.target == target && result.port == port) {
-            result.isOpen = isOpen;
-            result.responseTime = responseTime;
-            return;
-        }
-    }
-    
-    // Add new result
-    PortScanResult result;
-    result.target = target;
-    result.port = port;
-    result.isOpen = isOpen;
-    result.responseTime = responseTime;
-    result.serviceName = getServiceName(port);
-    
-    scanResults.push_back(result);
-    
-    // Limit cache size
-    if (scanResults.size() > MAX_DEVICES * TARGET_PORTS.size()) {
-        scanResults.erase(scanResults.begin());
-    }
+void PortScanner::addResult(IPAddress target, int port, PortState state, unsigned long responseTime) {
+    results.put(target, port, state, responseTime);
 }
@@ -12,13 +12,22 @@
 #include <vector>
 #include <IPAddress.h>
 #include "config.h"
+#include "port_probe_engine.h"
+#include "syn_scanner.h"
+#include "udp_scanner.h"
+#include "port_result_store.h"
+
+enum PortScanMethod {
+    PORT_SCAN_CONNECT,        // Full handshake plus a service request
+    PORT_SCAN_SYN             // Half-open: raw SYN, classify the reply
+};
 
 struct PortScanResult {
     IPAddress target;
-    int port;
-    bool isOpen;
+    uint16_t port;
+    PortState state;
     unsigned long responseTime;
-    String serviceName;
+    const char* serviceName;      // Static string
 };
 
 class PortScanner {
@@ -30,37 +39,56 @@ public:
     void begin();
     
     // Test a specific port on a target IP
-    bool testPort(IPAddress target, int port);
+    PortState testPort(IPAddress target, int port);
+    
+    // Probe a single port half-open, without completing the handshake
+    PortState synScan(IPAddress target, int port);
+    
+    // Probe a single UDP port; OPEN needs a reply, CLOSED an ICMP port
+    // unreachable, and silence leaves it OPEN_FILTERED
+    PortState udpScan(IPAddress target, int port);
+    
+    // Backend for queued probes; SYN falls back to connect when the raw
+    // PCB could not be opened. Only change it while no probes are queued
+    void setScanMethod(PortScanMethod method);
+    PortScanMethod getScanMethod();
     
     // Scan multiple ports on a target
     std::vector<PortScanResult> scanPorts(IPAddress target, const std::vector<int>& ports);
+    void scanPorts(IPAddress target, const std::vector<int>& ports, PortProbeCallback callback);
     
-    // Get scan results
-    std::vector<PortScanResult> getLastResults();
+    // Multiplexed probing across hosts: queue (host, port) pairs, then
+    // poll; each pair is reported as soon as it has a final state
+    bool queueProbe(IPAddress target, int port);
+    bool pollProbes(PortProbeCallback callback, unsigned long waitMs = SWEEP_POLL_INTERVAL);
+    void cancelProbes();
+    
+    // The same for UDP ports, which always go through the UDP scanner
+    // and run alongside the TCP probes (results are not cached)
+    bool queueUdpProbe(IPAddress target, int port);
+    bool pollUdpProbes(PortProbeCallback callback, unsigned long waitMs = SWEEP_POLL_INTERVAL);
+    
+    // Cached TCP results, oldest first; a view that the next probe may change
+    const PortResultStore& getLastResults();
     
     // Clear scan results
     void clearResults();
     
 private:
-    std::vector<PortScanResult> scanResults;
-    
-    // Perform TCP connect scan
-    bool tcpConnect(IPAddress target, int port, unsigned long& responseTime);
-    
-    // Perform SYN scan (simplified)
-    bool synScan(IPAddress target, int port);
+    PortResultStore results;
+    PortProbeEngine engine;
+    SynScanner synScanner;
+    UdpScanner udpScanner;
+    PortScanMethod scanMethod;
     
     // Check if port is commonly open
     bool isCommonPort(int port);
     
-    // Get service name for port
-    String getServiceName(int port);
-    
     // Validate port number
     bool isValidPort(int port);
     
     // Add result to cache
-    void addResult(IPAddress target, int port, bool isOpen, unsigned long responseTime);
+    void addResult(IPAddress target, int port, PortState state, unsigned long responseTime);
 };
 
 #endif // PORT_SCANNER_H
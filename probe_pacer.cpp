@@ -0,0 +1,157 @@
+/*
+ * Probe Pacer Implementation
+ * Token-bucket rate limiting of outgoing probes, globally and per host
+ */
+
+#include "probe_pacer.h"
+
+ProbePacer probePacer;
+
+ProbePacer::ProbePacer() {
+    lock = portMUX_INITIALIZER_UNLOCKED;
+    settings.probesPerSecond = PACER_PROBES_PER_SECOND;
+    settings.hostConcurrency = PACER_HOST_CONCURRENCY;
+    settings.hostGap = PACER_HOST_GAP;
+    tokens = PACER_BURST * 1000;
+    lastRefill = 0;
+    granted = 0;
+    deferred = 0;
+    memset(hosts, 0, sizeof(hosts));
+}
+
+void ProbePacer::configure(const PacerSettings& newSettings) {
+    portENTER_CRITICAL(&lock);
+    settings = newSettings;
+    memset(hosts, 0, sizeof(hosts));
+    granted = 0;
+    deferred = 0;
+    portEXIT_CRITICAL(&lock);
+}
+
+PacerSettings ProbePacer::getSettings() {
+    portENTER_CRITICAL(&lock);
+    PacerSettings copy = settings;
+    portEXIT_CRITICAL(&lock);
+    return copy;
+}
+
+bool ProbePacer::tryAcquire(IPAddress host, unsigned long* waitMs) {
+    unsigned long now = millis();
+    unsigned long wait = 0;
+    bool allowed = true;
+
+    portENTER_CRITICAL(&lock);
+
+    refill(now);
+
+    HostSlot* slot = findSlot((uint32_t)host, now);
+    if (!slot) {
+        // Every slot belongs to a host that is still busy
+        allowed = false;
+        wait = 1;
+    } else {
+        if (settings.hostConcurrency > 0 && slot->inFlight >= settings.hostConcurrency) {
+            allowed = false;
+            wait = 1;
+        }
+        if (settings.hostGap > 0 && slot->address == (uint32_t)host &&
+            now - slot->lastSend < settings.hostGap) {
+            unsigned long gapLeft = settings.hostGap - (now - slot->lastSend);
+            allowed = false;
+            wait = (gapLeft > wait) ? gapLeft : wait;
+        }
+    }
+
+    if (settings.probesPerSecond > 0 && tokens < 1000) {
+        unsigned long refillTime = (1000 - tokens + settings.probesPerSecond - 1) / settings.probesPerSecond;
+        allowed = false;
+        wait = (refillTime > wait) ? refillTime : wait;
+    }
+
+    if (allowed) {
+        if (settings.probesPerSecond > 0) {
+            tokens -= 1000;
+        }
+        slot->address = (uint32_t)host;
+        slot->inFlight++;
+        slot->lastSend = now;
+        granted++;
+    } else {
+        deferred++;
+    }
+
+    portEXIT_CRITICAL(&lock);
+
+    if (waitMs) {
+        *waitMs = wait;
+    }
+    return allowed;
+}
+
+void ProbePacer::acquire(IPAddress host) {
+    unsigned long wait = 0;
+    while (!tryAcquire(host, &wait)) {
+        delay(wait > 0 ? wait : 1);
+    }
+}
+
+void ProbePacer::release(IPAddress host) {
+    portENTER_CRITICAL(&lock);
+    for (size_t i = 0; i < PACER_HOST_SLOTS; i++) {
+        if (hosts[i].address == (uint32_t)host) {
+            if (hosts[i].inFlight > 0) {
+                hosts[i].inFlight--;
+            }
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void ProbePacer::reset() {
+    portENTER_CRITICAL(&lock);
+    memset(hosts, 0, sizeof(hosts));
+    portEXIT_CRITICAL(&lock);
+}
+
+uint32_t ProbePacer::getGranted() {
+    return granted;
+}
+
+uint32_t ProbePacer::getDeferred() {
+    return deferred;
+}
+
+void ProbePacer::refill(unsigned long now) {
+    unsigned long elapsed = now - lastRefill;
+    lastRefill = now;
+
+    // rate probes/s is exactly rate thousandths per ms
+    uint64_t level = tokens + (uint64_t)elapsed * settings.probesPerSecond;
+    uint64_t capacity = (uint64_t)PACER_BURST * 1000;
+    tokens = (uint32_t)(level > capacity ? capacity : level);
+}
+
+ProbePacer::HostSlot* ProbePacer::findSlot(uint32_t address, unsigned long now) {
+    HostSlot* reusable = nullptr;
+
+    for (size_t i = 0; i < PACER_HOST_SLOTS; i++) {
+        HostSlot& slot = hosts[i];
+        if (slot.address == address) {
+            return &slot;
+        }
+
+        // An idle slot is only recycled once its gap has passed, otherwise
+        // a host could dodge its gap by being evicted and re-added
+        if (!reusable && (slot.address == 0 ||
+            (slot.inFlight == 0 && now - slot.lastSend >= settings.hostGap))) {
+            reusable = &slot;
+        }
+    }
+
+    if (reusable) {
+        reusable->address = 0;
+        reusable->inFlight = 0;
+    }
+    return reusable;
+}
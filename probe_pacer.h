@@ -0,0 +1,69 @@
+/*
+ * Probe Pacer Header
+ * Token-bucket rate limiting of outgoing probes, globally and per host
+ */
+
+#ifndef PROBE_PACER_H
+#define PROBE_PACER_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <freertos/FreeRTOS.h>
+#include "config.h"
+
+// Limits applied to a scan; 0 disables the corresponding limit
+struct PacerSettings {
+    uint32_t probesPerSecond;   // Global budget across all engines
+    uint8_t hostConcurrency;    // Probes in flight to one host
+    uint16_t hostGap;           // Minimum ms between probes to one host
+};
+
+class ProbePacer {
+public:
+    ProbePacer();
+
+    // Apply new limits; forgets per-host state but keeps the bucket level
+    void configure(const PacerSettings& settings);
+    PacerSettings getSettings();
+
+    // Book a probe to host if every limit allows it right now. On refusal
+    // waitMs (if given) is set to how long until the next attempt can pass
+    bool tryAcquire(IPAddress host, unsigned long* waitMs = nullptr);
+
+    // Block (yielding) until a probe to host may be sent, then book it
+    void acquire(IPAddress host);
+
+    // Report that a booked probe finished
+    void release(IPAddress host);
+
+    // Drop per-host bookkeeping (e.g. after a sweep was aborted)
+    void reset();
+
+    // Statistics
+    uint32_t getGranted();
+    uint32_t getDeferred();
+
+private:
+    struct HostSlot {
+        uint32_t address;         // 0 = free
+        uint8_t inFlight;
+        unsigned long lastSend;
+    };
+
+    PacerSettings settings;
+    uint32_t tokens;              // Thousandths of a probe
+    unsigned long lastRefill;
+    HostSlot hosts[PACER_HOST_SLOTS];
+    uint32_t granted;
+    uint32_t deferred;
+    portMUX_TYPE lock;
+
+    void refill(unsigned long now);
+
+    // Slot tracking host, or a reusable one; nullptr if all are busy
+    HostSlot* findSlot(uint32_t address, unsigned long now);
+};
+
+extern ProbePacer probePacer;
+
+#endif // PROBE_PACER_H
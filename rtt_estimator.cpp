@@ -0,0 +1,180 @@
+/*
+ * RTT Estimator Implementation
+ * TCP-style smoothed round-trip estimates that drive probe timeouts
+ */
+
+#include "rtt_estimator.h"
+#include "net_utils.h"
+
+// Global instance
+RttEstimator rttEstimator;
+
+RttEstimator::RttEstimator() {
+    reset();
+}
+
+void RttEstimator::reset() {
+    memset(hosts, 0, sizeof(hosts));
+    memset(subnets, 0, sizeof(subnets));
+    nextSubnet = 0;
+}
+
+void RttEstimator::addSample(IPAddress host, unsigned long rtt) {
+    uint32_t key = ipToHost(host);
+    uint32_t sample = (rtt == 0) ? 1 : (uint32_t)rtt;
+
+    Estimate* hostEstimate = findHost(key, true);
+    update(*hostEstimate, sample);
+    hostEstimate->backoff = 0;
+
+    Estimate* subnetEstimate = findSubnet(key & RTT_SUBNET_MASK, true);
+    update(*subnetEstimate, sample);
+}
+
+void RttEstimator::addTimeout(IPAddress host) {
+    // Karn's rule: no sample from a timed-out probe, only back off this host.
+    // Dead hosts never touch the subnet estimate.
+    Estimate* hostEstimate = findHost(ipToHost(host), false);
+    if (hostEstimate && hostEstimate->backoff < RTT_MAX_BACKOFF) {
+        hostEstimate->backoff++;
+    }
+}
+
+unsigned long RttEstimator::getTimeout(IPAddress host, unsigned long ceiling) {
+    uint32_t key = ipToHost(host);
+    uint32_t timeout = ceiling;
+
+    Estimate* hostEstimate = findHost(key, false);
+    if (hostEstimate) {
+        timeout = computeTimeout(*hostEstimate) << hostEstimate->backoff;
+    } else {
+        Estimate* subnetEstimate = findSubnet(key & RTT_SUBNET_MASK, false);
+        if (subnetEstimate && subnetEstimate->samples >= RTT_MIN_SAMPLES) {
+            timeout = computeTimeout(*subnetEstimate);
+        }
+    }
+
+    if (timeout < RTT_MIN_TIMEOUT) {
+        timeout = RTT_MIN_TIMEOUT;
+    }
+    if (timeout > ceiling) {
+        timeout = ceiling;
+    }
+
+    return timeout;
+}
+
+size_t RttEstimator::getSubnetCount() {
+    size_t count = 0;
+    for (const auto& estimate : subnets) {
+        if (estimate.used) {
+            count++;
+        }
+    }
+    return count;
+}
+
+size_t RttEstimator::getHostCount() {
+    size_t count = 0;
+    for (const auto& estimate : hosts) {
+        if (estimate.used) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool RttEstimator::getSubnetStats(size_t index, RttStats& stats) {
+    for (const auto& estimate : subnets) {
+        if (estimate.used && index-- == 0) {
+            fillStats(estimate, stats);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RttEstimator::getHostStats(size_t index, RttStats& stats) {
+    for (const auto& estimate : hosts) {
+        if (estimate.used && index-- == 0) {
+            fillStats(estimate, stats);
+            return true;
+        }
+    }
+    return false;
+}
+
+RttEstimator::Estimate* RttEstimator::findHost(uint32_t key, bool create) {
+    // Direct-mapped on the low address bits; a new host simply replaces
+    // whatever shared its slot
+    Estimate& slot = hosts[key % RTT_HOST_SLOTS];
+
+    if (slot.used && slot.key == key) {
+        return &slot;
+    }
+
+    if (!create) {
+        return nullptr;
+    }
+
+    memset(&slot, 0, sizeof(slot));
+    slot.key = key;
+    slot.used = true;
+    return &slot;
+}
+
+RttEstimator::Estimate* RttEstimator::findSubnet(uint32_t key, bool create) {
+    for (auto& estimate : subnets) {
+        if (estimate.used && estimate.key == key) {
+            return &estimate;
+        }
+    }
+
+    if (!create) {
+        return nullptr;
+    }
+
+    Estimate& slot = subnets[nextSubnet];
+    nextSubnet = (nextSubnet + 1) % RTT_SUBNET_SLOTS;
+
+    memset(&slot, 0, sizeof(slot));
+    slot.key = key;
+    slot.used = true;
+    return &slot;
+}
+
+void RttEstimator::update(Estimate& estimate, uint32_t rtt) {
+    if (estimate.samples == 0) {
+        // First measurement: SRTT = R, RTTVAR = R/2
+        estimate.srtt8 = rtt << 3;
+        estimate.rttvar4 = rtt << 1;
+    } else {
+        // RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|, SRTT = 7/8 SRTT + 1/8 R
+        int32_t delta = (int32_t)rtt - (int32_t)(estimate.srtt8 >> 3);
+        if (delta < 0) {
+            delta = -delta;
+        }
+        estimate.rttvar4 = estimate.rttvar4 - (estimate.rttvar4 >> 2) + (uint32_t)delta;
+        estimate.srtt8 = estimate.srtt8 - (estimate.srtt8 >> 3) + rtt;
+    }
+
+    estimate.samples++;
+}
+
+uint32_t RttEstimator::computeTimeout(const Estimate& estimate) {
+    // RTO = SRTT + max(G, 4 * RTTVAR), with the clock granularity G in ms
+    uint32_t variance = estimate.rttvar4;
+    if (variance < RTT_CLOCK_GRANULARITY) {
+        variance = RTT_CLOCK_GRANULARITY;
+    }
+    return (estimate.srtt8 >> 3) + variance;
+}
+
+void RttEstimator::fillStats(const Estimate& estimate, RttStats& stats) {
+    stats.address = hostToIP(estimate.key);
+    stats.srtt = estimate.srtt8 >> 3;
+    stats.rttvar = estimate.rttvar4 >> 2;
+    stats.rto = computeTimeout(estimate) << estimate.backoff;
+    stats.samples = estimate.samples;
+    stats.backoff = estimate.backoff;
+}
@@ -0,0 +1,72 @@
+/*
+ * RTT Estimator Header
+ * TCP-style smoothed round-trip estimates that drive probe timeouts
+ */
+
+#ifndef RTT_ESTIMATOR_H
+#define RTT_ESTIMATOR_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include "config.h"
+
+struct RttStats {
+    IPAddress address;        // Host address, or subnet prefix for subnet entries
+    uint32_t srtt;            // Smoothed RTT in ms
+    uint32_t rttvar;          // RTT variation in ms
+    uint32_t rto;             // Timeout currently derived from the estimate
+    uint32_t samples;         // Number of samples folded in
+    uint8_t backoff;          // Consecutive timeouts (host entries only)
+};
+
+class RttEstimator {
+public:
+    RttEstimator();
+
+    // Forget every estimate
+    void reset();
+
+    // Feed a measured round trip (connect answered with SYN-ACK or RST)
+    void addSample(IPAddress host, unsigned long rtt);
+
+    // Note that a probe to this host timed out
+    void addTimeout(IPAddress host);
+
+    // Timeout to use for the next probe, clamped to [RTT_MIN_TIMEOUT, ceiling]
+    unsigned long getTimeout(IPAddress host, unsigned long ceiling);
+
+    // Inspect estimator state for the status API
+    size_t getSubnetCount();
+    size_t getHostCount();
+    bool getSubnetStats(size_t index, RttStats& stats);
+    bool getHostStats(size_t index, RttStats& stats);
+
+private:
+    // Fixed-point state as in RFC 6298: srtt scaled by 8, rttvar by 4
+    struct Estimate {
+        uint32_t key;
+        uint32_t srtt8;
+        uint32_t rttvar4;
+        uint32_t samples;
+        uint8_t backoff;
+        bool used;
+    };
+
+    Estimate hosts[RTT_HOST_SLOTS];
+    Estimate subnets[RTT_SUBNET_SLOTS];
+    size_t nextSubnet;
+
+    // Slot lookup (hosts are direct-mapped, subnets replace round-robin)
+    Estimate* findHost(uint32_t key, bool create);
+    Estimate* findSubnet(uint32_t key, bool create);
+
+    // Estimator math
+    void update(Estimate& estimate, uint32_t rtt);
+    uint32_t computeTimeout(const Estimate& estimate);
+    void fillStats(const Estimate& estimate, RttStats& stats);
+};
+
+// Global instance declaration
+extern RttEstimator rttEstimator;
+
+#endif // RTT_ESTIMATOR_H
@@ -0,0 +1,110 @@
+/*
+ * Scan Result Implementation
+ * Compact per-host scan record shared by the scan task, web and serial output
+ */
+
+#include "scan_result.h"
+#include "net_utils.h"
+
+#define PORT_STATE_UDP 0x8
+#define PORT_STATE_MASK 0x7
+
+ScanResult::ScanResult() {
+    host = 0;
+    timestamp = 0;
+    responseTime = 0;
+    hostname = 0;
+    memset(mac, 0, sizeof(mac));
+    hasMac = false;
+    portCount = 0;
+    fingerprintCount = 0;
+    memset(ports, 0, sizeof(ports));
+    memset(portStates, 0, sizeof(portStates));
+    memset(fingerprints, 0, sizeof(fingerprints));
+    modbus.status = MODBUS_NOT_PROBED;
+}
+
+IPAddress ScanResult::address() const {
+    return hostToIP(host);
+}
+
+const char* ScanResult::hostName() const {
+    return hostname ? stringPool.get(hostname) : "Unknown";
+}
+
+String ScanResult::macText() const {
+    return hasMac ? macToString(mac) : String("");
+}
+
+static uint8_t getState(const uint8_t* states, size_t index) {
+    return (states[index / 2] >> ((index & 1) * 4)) & 0x0F;
+}
+
+static void putState(uint8_t* states, size_t index, uint8_t value) {
+    uint8_t shift = (index & 1) * 4;
+    states[index / 2] = (states[index / 2] & ~(0x0F << shift)) | (value << shift);
+}
+
+bool ScanResult::setPort(uint16_t port, bool udp, PortState state) {
+    uint8_t protocol = udp ? PORT_STATE_UDP : 0;
+    size_t index = 0;
+    while (index < portCount &&
+           !(ports[index] == port && (getState(portStates, index) & PORT_STATE_UDP) == protocol)) {
+        index++;
+    }
+
+    if (index == portCount) {
+        if (portCount < SCAN_RESULT_MAX_PORTS) {
+            portCount++;
+        } else if (state == PORT_OPEN) {
+            // Long port lists are mostly closed; an open port takes the
+            // place of the latest port that is not
+            do {
+                if (index == 0) {
+                    return false;
+                }
+                index--;
+            } while ((getState(portStates, index) & PORT_STATE_MASK) == PORT_OPEN);
+        } else {
+            return false;
+        }
+        ports[index] = port;
+    }
+
+    putState(portStates, index, protocol | ((uint8_t)state & PORT_STATE_MASK));
+    return true;
+}
+
+bool ScanResult::hasPort(uint16_t port, bool udp, PortState state) const {
+    uint8_t wanted = (udp ? PORT_STATE_UDP : 0) | ((uint8_t)state & PORT_STATE_MASK);
+    for (size_t i = 0; i < portCount; i++) {
+        if (ports[i] == port && getState(portStates, i) == wanted) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ScanResult::nextPort(size_t& cursor, bool udp, PortState state, uint16_t& port) const {
+    uint8_t wanted = (udp ? PORT_STATE_UDP : 0) | ((uint8_t)state & PORT_STATE_MASK);
+    while (cursor < portCount) {
+        size_t index = cursor++;
+        if (getState(portStates, index) == wanted) {
+            port = ports[index];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ScanResult::addFingerprint(const ServiceFingerprint& fingerprint) {
+    if (fingerprintCount >= SCAN_RESULT_FINGERPRINTS) {
+        return false;
+    }
+
+    ResultFingerprint& kept = fingerprints[fingerprintCount++];
+    kept.port = fingerprint.port;
+    kept.id = fingerprint.id;
+    kept.detail = stringPool.intern(fingerprint.detail);
+    return true;
+}
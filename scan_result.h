@@ -0,0 +1,66 @@
+/*
+ * Scan Result Header
+ * Compact per-host scan record shared by the scan task, web and serial output
+ */
+
+#ifndef SCAN_RESULT_H
+#define SCAN_RESULT_H
+
+#include <Arduino.h>
+#include <vector>
+#include <IPAddress.h>
+#include "config.h"
+#include "port_probe_engine.h"
+#include "fingerprint.h"
+#include "bacnet_discovery.h"
+#include "modbus_client.h"
+#include "enip_discovery.h"
+#include "string_pool.h"
+
+// A fingerprint as kept in a result; the detail string lives in stringPool
+struct ResultFingerprint {
+    uint16_t port;
+    uint8_t id;                   // FingerprintId
+    uint16_t detail;              // stringPool handle
+};
+
+// Everything but the protocol identities is fixed-size, so a result costs
+// one allocation however many ports it lists. The identities stay vectors:
+// only the few BACnet, Modbus and EtherNet/IP hosts ever fill them.
+struct ScanResult {
+    uint32_t host;                // Host order
+    uint32_t timestamp;           // millis() when the host was found
+    uint16_t responseTime;        // ms from discovery to the last port (saturates)
+    uint16_t hostname;            // stringPool handle; 0 = unknown
+    uint8_t mac[6];
+    bool hasMac;
+    uint8_t portCount;
+    uint8_t fingerprintCount;
+    uint16_t ports[SCAN_RESULT_MAX_PORTS];
+    uint8_t portStates[(SCAN_RESULT_MAX_PORTS + 1) / 2];   // 4 bits per port: PortState, 0x8 = UDP
+    ResultFingerprint fingerprints[SCAN_RESULT_FINGERPRINTS];
+    std::vector<BacnetDevice> bacnetDevices;    // I-Am identities (several behind a router)
+    ModbusIdentity modbus;                      // Read Device Identification of port 502
+    std::vector<EnipIdentity> enipIdentities;   // ListIdentity replies (one per CIP identity item)
+
+    ScanResult();
+
+    IPAddress address() const;
+    const char* hostName() const;     // "Unknown" without a name
+    String macText() const;           // Empty without a MAC
+
+    // Record a port's state, replacing an earlier one for the same port
+    // and protocol; false when the port table is full. An open port
+    // still gets in while the table holds ports in other states
+    bool setPort(uint16_t port, bool udp, PortState state);
+    bool hasPort(uint16_t port, bool udp, PortState state) const;
+
+    // Iterate the ports in one state in the order they were recorded;
+    // start with cursor = 0
+    bool nextPort(size_t& cursor, bool udp, PortState state, uint16_t& port) const;
+
+    // Intern the detail; false when the fingerprint table is full
+    bool addFingerprint(const ServiceFingerprint& fingerprint);
+};
+
+#endif // SCAN_RESULT_H
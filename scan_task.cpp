@@ -0,0 +1,576 @@
+/*
+ * Scan Task Implementation
+ * Runs scan jobs on a dedicated FreeRTOS task, away from loop()
+ */
+
+#include "scan_task.h"
+#include "net_utils.h"
+#include "string_pool.h"
+#include <algorithm>
+
+ScanTask scanTask;
+
+ScanTask::ScanTask() {
+    scanner = nullptr;
+    portScanner = nullptr;
+    handle = nullptr;
+    jobQueue = nullptr;
+    eventQueue = nullptr;
+    statusLock = portMUX_INITIALIZER_UNLOCKED;
+    nextJobId = 1;
+    currentJob = 0;
+    cancelledJob = 0;
+    unfinishedEvents = 0;
+    activeJob = nullptr;
+    memset(&progress, 0, sizeof(progress));
+}
+
+bool ScanTask::begin(NetworkScanner* networkScanner, PortScanner* ports) {
+    scanner = networkScanner;
+    portScanner = ports;
+
+    // Both queues hold pointers or PODs; FreeRTOS copies items by value
+    jobQueue = xQueueCreate(SCAN_JOB_QUEUE_DEPTH, sizeof(ScanJob*));
+    eventQueue = xQueueCreate(SCAN_RESULT_QUEUE_DEPTH, sizeof(ScanEvent));
+    if (!jobQueue || !eventQueue) {
+        Serial.println("Scan task: failed to create queues");
+        return false;
+    }
+
+    if (xTaskCreatePinnedToCore(taskEntry, "scan", SCAN_TASK_STACK, this,
+                                SCAN_TASK_PRIORITY, &handle, SCAN_TASK_CORE) != pdPASS) {
+        Serial.println("Scan task: failed to create task");
+        return false;
+    }
+
+    #if DEBUG_NETWORK
+    Serial.printf("Scan task started on core %d\n", SCAN_TASK_CORE);
+    #endif
+    return true;
+}
+
+uint32_t ScanTask::submit(ScanJob* job) {
+    if (!jobQueue) {
+        return 0;
+    }
+
+    // loop() and the web task both submit
+    portENTER_CRITICAL(&statusLock);
+    job->id = nextJobId++;
+    if (nextJobId == 0) {
+        nextJobId = 1;
+    }
+    portEXIT_CRITICAL(&statusLock);
+
+    if (xQueueSend(jobQueue, &job, 0) != pdTRUE) {
+        return 0;
+    }
+    return job->id;
+}
+
+void ScanTask::cancel(uint32_t jobId) {
+    cancelledJob = jobId;
+}
+
+bool ScanTask::nextEvent(ScanEvent& event) {
+    if (!eventQueue) {
+        return false;
+    }
+    return xQueueReceive(eventQueue, &event, 0) == pdTRUE;
+}
+
+void ScanTask::finishEvent(ScanEvent& event) {
+    delete event.result;
+    event.result = nullptr;
+
+    portENTER_CRITICAL(&statusLock);
+    unfinishedEvents--;
+    portEXIT_CRITICAL(&statusLock);
+}
+
+bool ScanTask::isBusy() {
+    return currentJob != 0 || (jobQueue && uxQueueMessagesWaiting(jobQueue) > 0);
+}
+
+uint32_t ScanTask::getCurrentJob() {
+    return currentJob;
+}
+
+SweepProgress ScanTask::getProgress() {
+    portENTER_CRITICAL(&statusLock);
+    SweepProgress copy = progress;
+    portEXIT_CRITICAL(&statusLock);
+    return copy;
+}
+
+void ScanTask::taskEntry(void* param) {
+    static_cast<ScanTask*>(param)->run();
+}
+
+void ScanTask::run() {
+    for (;;) {
+        ScanJob* job = nullptr;
+        if (xQueueReceive(jobQueue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        currentJob = job->id;
+        runJob(job);
+        currentJob = 0;
+        delete job;
+    }
+}
+
+void ScanTask::runJob(ScanJob* job) {
+    // Until a job starts, the one before it still interns into the pool
+    releaseStrings(job);
+
+    if (job->kind != SCAN_JOB_SWEEP) {
+        runProbe(job);
+        return;
+    }
+
+    #if DEBUG_NETWORK
+    Serial.printf("Scan job %u: %u targets, %u ports, %u UDP ports\n",
+                  job->id, job->targets.getTargetCount(), (unsigned)job->ports.size(),
+                  (unsigned)job->udpPorts.size());
+    #endif
+
+    probePacer.configure(job->pacing);
+    portScanner->setScanMethod(job->scanMethod);
+
+    SweepProgress initial;
+    memset(&initial, 0, sizeof(initial));
+    initial.total = job->targets.getTargetCount();
+    setProgress(initial);
+
+    // Port 0 and out-of-range entries come from unparsable form input.
+    // BACnet/IP is UDP; the discovery stage covers it, not a TCP probe
+    bool bacnetWanted = false;
+    for (size_t i = job->ports.size(); i-- > 0;) {
+        if (job->ports[i] == BACNET_PORT) {
+            bacnetWanted = true;
+        }
+        if (job->ports[i] <= 0 || job->ports[i] > 65535 || job->ports[i] == BACNET_PORT) {
+            job->ports.erase(job->ports.begin() + i);
+        }
+    }
+    for (size_t i = job->udpPorts.size(); i-- > 0;) {
+        if (job->udpPorts[i] <= 0 || job->udpPorts[i] > 65535) {
+            job->udpPorts.erase(job->udpPorts.begin() + i);
+        }
+    }
+
+    // Every profile fits; a longer typed-in list loses its tail. A result
+    // lists fewer ports still, and gives open ones priority (setPort)
+    if (job->ports.size() > SCAN_MAX_PORTS) {
+        job->ports.resize(SCAN_MAX_PORTS);
+    }
+    if (job->udpPorts.size() > SCAN_MAX_PORTS - job->ports.size()) {
+        job->udpPorts.resize(SCAN_MAX_PORTS - job->ports.size());
+    }
+
+    // A SYN scan promises no service requests, so nothing is identified
+    if (job->scanMethod == PORT_SCAN_SYN) {
+        job->modbusUnits.clear();
+    }
+    modbusClient.setUnitIds(job->modbusUnits);
+
+    // A job cancelled while still queued never touches the network
+    bool swept = cancelledJob != job->id;
+    if (swept) {
+        activeJob = job;
+        if (bacnetWanted) {
+            discoverBacnet(job);
+        }
+        if (job->enipDiscovery && cancelledJob != job->id) {
+            discoverEnip(job);
+        }
+        queueDiscovered();
+        scanner->startSweep(job->targets);
+
+        SweepCallback onHost = [this](IPAddress host, bool alive, unsigned long responseTime) {
+            if (alive && std::find(discoveredHosts.begin(), discoveredHosts.end(), (uint32_t)host) == discoveredHosts.end()) {
+                queuePorts(host);
+            }
+        };
+        PortProbeCallback onPort = [this](const PortProbeResult& probe) {
+            handlePortResult(probe);
+        };
+        PortProbeCallback onUdp = [this](const PortProbeResult& probe) {
+            handleUdpResult(probe);
+        };
+
+        // The sweep, the TCP and UDP probes of hosts it already found and
+        // the Modbus identification of their open 502s run side by side;
+        // only the last phase waits in select()
+        bool sweeping = true;
+        bool probing = true;
+        bool probingUdp = false;
+        bool identifying = false;
+        while (cancelledJob != job->id && (sweeping || probing || probingUdp || identifying)) {
+            if (sweeping) {
+                sweeping = scanner->pollSweep(onHost);
+            }
+            probing = portScanner->pollProbes(onPort, sweeping ? 0 : SWEEP_POLL_INTERVAL);
+            probingUdp = portScanner->pollUdpProbes(onUdp, (sweeping || probing) ? 0 : SWEEP_POLL_INTERVAL);
+            identifying = pollModbus((sweeping || probing || probingUdp) ? 0 : SWEEP_POLL_INTERVAL);
+            setProgress(scanner->getSweepProgress());
+        }
+
+        scanner->stopSweep();
+        portScanner->cancelProbes();
+        modbusClient.stop();
+        modbusWaiting.clear();
+
+        // Hosts still waiting on ports belong to a cancelled job
+        for (auto& pending : pendingHosts) {
+            delete pending.result;
+        }
+        pendingHosts.clear();
+        bacnetDevices.clear();
+        enipIdentities.clear();
+        discoveredHosts.clear();
+        activeJob = nullptr;
+
+        // An aborted sweep leaves probes booked with the pacer
+        probePacer.reset();
+    }
+    
+    // Interactive port commands always get a full connect
+    portScanner->setScanMethod(PORT_SCAN_CONNECT);
+
+    ScanEvent done;
+    memset(&done, 0, sizeof(done));
+    done.type = SCAN_EVENT_DONE;
+    done.source = job->source;
+    done.jobId = job->id;
+    done.result = nullptr;
+    done.progress = swept ? scanner->getSweepProgress() : initial;
+    done.cancelled = cancelledJob == job->id;
+    setProgress(done.progress);
+
+    // loop() must always learn that the job ended
+    queueEvent(done, portMAX_DELAY);
+
+    // The web shows this sweep's results until it submits the next one
+    if (job->source == SCAN_SOURCE_WEB) {
+        stringPool.keep();
+    }
+
+    #if DEBUG_NETWORK
+    Serial.printf("Scan job %u %s (%u probes paced, %u deferred)\n", job->id,
+                  done.cancelled ? "cancelled" : "finished",
+                  probePacer.getGranted(), probePacer.getDeferred());
+    #endif
+}
+
+void ScanTask::releaseStrings(ScanJob* job) {
+    // loop() prints from the pool after taking an event off the queue,
+    // so an empty queue is not enough: wait for it to finish them all
+    for (;;) {
+        portENTER_CRITICAL(&statusLock);
+        uint32_t unfinished = unfinishedEvents;
+        portEXIT_CRITICAL(&statusLock);
+        if (unfinished == 0) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    if (job->kind == SCAN_JOB_SWEEP && job->source == SCAN_SOURCE_WEB) {
+        stringPool.clear();
+    } else {
+        stringPool.trim();
+    }
+}
+
+void ScanTask::runProbe(ScanJob* job) {
+    probePacer.configure(job->pacing);
+
+    ScanEvent answer;
+    memset(&answer, 0, sizeof(answer));
+    answer.type = SCAN_EVENT_PROBE;
+    answer.source = job->source;
+    answer.jobId = job->id;
+    answer.result = nullptr;
+    answer.kind = job->kind;
+    answer.target = (uint32_t)job->probeTarget;
+    answer.port = job->probePort;
+    answer.cancelled = cancelledJob == job->id;
+
+    if (!answer.cancelled) {
+        switch (job->kind) {
+            case SCAN_JOB_PING:
+                answer.alive = scanner->pingDevice(job->probeTarget);
+                break;
+            case SCAN_JOB_UDP_PORT:
+                answer.state = portScanner->udpScan(job->probeTarget, job->probePort);
+                break;
+            default:
+                answer.state = job->scanMethod == PORT_SCAN_SYN ?
+                               portScanner->synScan(job->probeTarget, job->probePort) :
+                               portScanner->testPort(job->probeTarget, job->probePort);
+                break;
+        }
+    }
+
+    queueEvent(answer, portMAX_DELAY);
+}
+
+void ScanTask::discoverBacnet(ScanJob* job) {
+    if (!bacnet.start(job->targets)) {
+        return;
+    }
+
+    while (cancelledJob != job->id && bacnet.poll(nullptr)) {
+    }
+    bacnet.stop();
+
+    // Names, model and firmware; requests to all devices are in flight
+    // together over one socket
+    bacnetDevices = bacnet.getDevices();
+    if (!bacnetDevices.empty() && bacnetClient.begin()) {
+        BacnetDeviceCallback onRead = [this](const BacnetDevice& read) {
+            for (auto& device : bacnetDevices) {
+                if (device.instance == read.instance && device.network == read.network &&
+                    device.address == read.address) {
+                    device = read;
+                    break;
+                }
+            }
+        };
+
+        size_t next = 0;
+        while (cancelledJob != job->id && (next < bacnetDevices.size() || bacnetClient.isBusy())) {
+            while (next < bacnetDevices.size() && bacnetClient.add(bacnetDevices[next])) {
+                next++;
+            }
+            bacnetClient.poll(onRead);
+        }
+        bacnetClient.stop();
+    }
+}
+
+void ScanTask::discoverEnip(ScanJob* job) {
+    if (!enip.start(job->targets)) {
+        return;
+    }
+
+    while (cancelledJob != job->id && enip.poll(nullptr)) {
+    }
+    enip.stop();
+    enipIdentities = enip.getIdentities();
+}
+
+void ScanTask::queueDiscovered() {
+    std::vector<IPAddress> hosts;
+    for (const auto& device : bacnetDevices) {
+        hosts.push_back(device.address);
+    }
+    for (const auto& identity : enipIdentities) {
+        hosts.push_back(identity.address);
+    }
+
+    for (IPAddress host : hosts) {
+        if (cancelledJob == activeJob->id) {
+            return;
+        }
+        if (std::find(discoveredHosts.begin(), discoveredHosts.end(), (uint32_t)host) != discoveredHosts.end()) {
+            continue;
+        }
+        discoveredHosts.push_back((uint32_t)host);
+        queuePorts(host);
+    }
+}
+
+void ScanTask::queuePorts(IPAddress host) {
+    PendingHost pending;
+    pending.result = new ScanResult();
+    pending.result->host = ipToHost(host);
+    pending.result->timestamp = millis();
+    pending.result->modbus.address = host;
+    pending.remaining = activeJob->ports.size() + activeJob->udpPorts.size();
+    pending.startTime = millis();
+    pending.result->hasMac = scanner->getMacAddress(host, pending.result->mac);
+
+    // Devices behind a BACnet router all answer from the router's address
+    // and are reported together under it
+    for (const auto& device : bacnetDevices) {
+        if (device.address == host) {
+            pending.result->bacnetDevices.push_back(device);
+        }
+    }
+    for (const auto& identity : enipIdentities) {
+        if (identity.address == host) {
+            pending.result->enipIdentities.push_back(identity);
+        }
+    }
+    if (!pending.result->bacnetDevices.empty()) {
+        pending.result->setPort(BACNET_PORT, false, PORT_OPEN);
+    }
+    if (!pending.result->enipIdentities.empty()) {
+        pending.result->setPort(ENIP_PORT, false, PORT_OPEN);
+    }
+
+    pendingHosts.push_back(pending);
+    if (pending.remaining == 0) {
+        finishHost(pendingHosts.size() - 1);
+        return;
+    }
+
+    PortProbeCallback onPort = [this](const PortProbeResult& probe) {
+        handlePortResult(probe);
+    };
+    PortProbeCallback onUdp = [this](const PortProbeResult& probe) {
+        handleUdpResult(probe);
+    };
+
+    for (int port : activeJob->ports) {
+        // A full probe queue drains as results come in
+        while (!portScanner->queueProbe(host, port)) {
+            if (cancelledJob == activeJob->id) {
+                return;
+            }
+            portScanner->pollProbes(onPort);
+        }
+    }
+    for (int port : activeJob->udpPorts) {
+        while (!portScanner->queueUdpProbe(host, port)) {
+            if (cancelledJob == activeJob->id) {
+                return;
+            }
+            portScanner->pollUdpProbes(onUdp);
+        }
+    }
+}
+
+void ScanTask::handlePortResult(const PortProbeResult& probe) {
+    for (size_t i = 0; i < pendingHosts.size(); i++) {
+        PendingHost& pending = pendingHosts[i];
+        if (pending.result->host != ipToHost(probe.target)) {
+            continue;
+        }
+
+        // 44818 may already be open from ListIdentity; a probe never
+        // takes that back
+        if (probe.state == PORT_OPEN || !pending.result->hasPort(probe.port, false, PORT_OPEN)) {
+            pending.result->setPort(probe.port, false, probe.state);
+        }
+
+        if (probe.state == PORT_OPEN) {
+            for (uint8_t f = 0; f < probe.fingerprintCount; f++) {
+                pending.result->addFingerprint(probe.fingerprints[f]);
+            }
+            if (probe.port == MODBUS_PORT && !activeJob->modbusUnits.empty()) {
+                // The host stays pending until handleModbusIdentity
+                modbusWaiting.push_back(probe.target);
+                return;
+            }
+        }
+
+        if (--pending.remaining == 0) {
+            finishHost(i);
+        }
+        return;
+    }
+}
+
+void ScanTask::handleUdpResult(const PortProbeResult& probe) {
+    for (size_t i = 0; i < pendingHosts.size(); i++) {
+        PendingHost& pending = pendingHosts[i];
+        if (pending.result->host != ipToHost(probe.target)) {
+            continue;
+        }
+
+        // Results show UDP ports as open, closed, open|filtered or filtered
+        PortState state = probe.state == PORT_UNREACHABLE ? PORT_FILTERED : probe.state;
+        pending.result->setPort(probe.port, true, state);
+
+        if (--pending.remaining == 0) {
+            finishHost(i);
+        }
+        return;
+    }
+}
+
+bool ScanTask::pollModbus(unsigned long waitMs) {
+    while (!modbusWaiting.empty() && modbusClient.add(modbusWaiting.front())) {
+        modbusWaiting.erase(modbusWaiting.begin());
+    }
+    if (!modbusClient.isBusy()) {
+        return false;
+    }
+
+    ModbusIdentityCallback onIdentity = [this](const ModbusIdentity& identity) {
+        handleModbusIdentity(identity);
+    };
+    modbusClient.poll(onIdentity, waitMs);
+    return modbusClient.isBusy() || !modbusWaiting.empty();
+}
+
+void ScanTask::handleModbusIdentity(const ModbusIdentity& identity) {
+    for (size_t i = 0; i < pendingHosts.size(); i++) {
+        PendingHost& pending = pendingHosts[i];
+        if (pending.result->host != ipToHost(identity.address)) {
+            continue;
+        }
+
+        pending.result->modbus = identity;
+        if (--pending.remaining == 0) {
+            finishHost(i);
+        }
+        return;
+    }
+}
+
+void ScanTask::finishHost(size_t index) {
+    ScanResult* result = pendingHosts[index].result;
+    unsigned long elapsed = millis() - pendingHosts[index].startTime;
+    result->responseTime = elapsed > 0xFFFF ? 0xFFFF : elapsed;
+    pendingHosts.erase(pendingHosts.begin() + index);
+
+    ScanEvent event;
+    memset(&event, 0, sizeof(event));
+    event.type = SCAN_EVENT_RESULT;
+    event.source = activeJob->source;
+    event.jobId = activeJob->id;
+    event.result = result;
+
+    if (!pushEvent(event, activeJob->id)) {
+        delete result;
+    }
+}
+
+bool ScanTask::pushEvent(const ScanEvent& event, uint32_t jobId) {
+    // A full queue means loop() is behind; wait for it rather than drop
+    // results, which also throttles the sweep to what the UI can absorb
+    while (!queueEvent(event, pdMS_TO_TICKS(SWEEP_POLL_INTERVAL))) {
+        if (cancelledJob == activeJob->id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ScanTask::queueEvent(const ScanEvent& event, TickType_t wait) {
+    // Counted first, so loop() never finishes an event it was not counted for
+    portENTER_CRITICAL(&statusLock);
+    unfinishedEvents++;
+    portEXIT_CRITICAL(&statusLock);
+
+    if (xQueueSend(eventQueue, &event, wait) == pdTRUE) {
+        return true;
+    }
+
+    portENTER_CRITICAL(&statusLock);
+    unfinishedEvents--;
+    portEXIT_CRITICAL(&statusLock);
+    return false;
+}
+
+void ScanTask::setProgress(const SweepProgress& value) {
+    portENTER_CRITICAL(&statusLock);
+    progress = value;
+    portEXIT_CRITICAL(&statusLock);
+}
@@ -0,0 +1,183 @@
+/*
+ * Scan Task Header
+ * Runs scan jobs on a dedicated FreeRTOS task, away from loop()
+ */
+
+#ifndef SCAN_TASK_H
+#define SCAN_TASK_H
+
+#include <Arduino.h>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include "config.h"
+#include "network_scanner.h"
+#include "port_scanner.h"
+#include "target_iterator.h"
+#include "probe_pacer.h"
+#include "bacnet_discovery.h"
+#include "bacnet_client.h"
+#include "modbus_client.h"
+#include "enip_discovery.h"
+#include "web_interface.h"
+
+// Who submitted a job; events are routed back to the same place
+enum ScanJobSource {
+    SCAN_SOURCE_SERIAL,
+    SCAN_SOURCE_WEB
+};
+
+// Serial probe commands run as jobs too, so nothing but the task ever
+// drives the scanners
+enum ScanJobKind {
+    SCAN_JOB_SWEEP,           // Sweep the targets and probe the ports of live hosts
+    SCAN_JOB_PING,            // Liveness of probeTarget
+    SCAN_JOB_TCP_PORT,        // probePort on probeTarget with scanMethod
+    SCAN_JOB_UDP_PORT         // probePort on probeTarget over UDP
+};
+
+struct ScanJob {
+    uint32_t id;
+    ScanJobSource source;
+    ScanJobKind kind;
+    IPAddress probeTarget;              // Ping and port jobs only
+    uint16_t probePort;
+    TargetIterator targets;
+    std::vector<int> ports;
+    std::vector<int> udpPorts;          // Probed on every live host next to the TCP ports
+    PacerSettings pacing;
+    PortScanMethod scanMethod;
+    std::vector<uint8_t> modbusUnits;   // Empty turns Modbus identification off
+    bool enipDiscovery;                 // ListIdentity broadcast before the sweep
+};
+
+enum ScanEventType {
+    SCAN_EVENT_RESULT,        // One live host with its ports tested
+    SCAN_EVENT_PROBE,         // Answer to a ping or port job (no DONE follows)
+    SCAN_EVENT_DONE           // Sweep job finished or was cancelled
+};
+
+// Queue item; copied by value, so it only carries a pointer to the result
+struct ScanEvent {
+    ScanEventType type;
+    ScanJobSource source;
+    uint32_t jobId;
+    ScanResult* result;       // SCAN_EVENT_RESULT only; the receiver deletes it
+    SweepProgress progress;   // Final counts for SCAN_EVENT_DONE
+    bool cancelled;
+    ScanJobKind kind;         // SCAN_EVENT_PROBE: what was asked,
+    uint32_t target;          // of which host (network order)
+    uint16_t port;            // and port,
+    bool alive;               // and the answer to a ping
+    PortState state;          // or to a port job
+};
+
+class ScanTask {
+public:
+    ScanTask();
+
+    // Create the queues and start the task on SCAN_TASK_CORE
+    bool begin(NetworkScanner* scanner, PortScanner* portScanner);
+
+    // Queue a job (ownership passes to the task); returns its id, 0 if full
+    uint32_t submit(ScanJob* job);
+
+    // Cancel a queued or running job
+    void cancel(uint32_t jobId);
+
+    // Take the next event without blocking; call from loop()
+    bool nextEvent(ScanEvent& event);
+
+    // Hand an event from nextEvent() back once it has been handled; frees
+    // its result. Until then the next job leaves the string pool alone
+    void finishEvent(ScanEvent& event);
+
+    // Progress of the running job (safe to call from any task)
+    bool isBusy();
+    uint32_t getCurrentJob();
+    SweepProgress getProgress();
+
+private:
+    NetworkScanner* scanner;
+    PortScanner* portScanner;
+    TaskHandle_t handle;
+    QueueHandle_t jobQueue;
+    QueueHandle_t eventQueue;
+    portMUX_TYPE statusLock;
+    uint32_t nextJobId;
+    volatile uint32_t currentJob;
+    volatile uint32_t cancelledJob;
+    uint32_t unfinishedEvents;          // Queued or still being handled by loop()
+    SweepProgress progress;
+
+    // Live hosts whose ports are still being probed
+    struct PendingHost {
+        ScanResult* result;
+        size_t remaining;
+        unsigned long startTime;
+    };
+    std::vector<PendingHost> pendingHosts;
+    ScanJob* activeJob;
+
+    // What the broadcast stages found; their hosts are queued before the
+    // sweep and skipped by it
+    BacnetDiscovery bacnet;
+    BacnetClient bacnetClient;
+    EnipDiscovery enip;
+    std::vector<BacnetDevice> bacnetDevices;
+    std::vector<EnipIdentity> enipIdentities;
+    std::vector<uint32_t> discoveredHosts;
+
+    // Hosts with 502 open wait here for a Modbus client slot; they stay
+    // pending until identified
+    ModbusClient modbusClient;
+    std::vector<IPAddress> modbusWaiting;
+
+    static void taskEntry(void* param);
+    void run();
+    void runJob(ScanJob* job);
+    void runProbe(ScanJob* job);
+
+    // Free the strings of the jobs before this one once loop() has
+    // finished every event they sent. A web sweep empties the pool (the
+    // web dropped its results when it submitted it); any other job keeps
+    // what the last web sweep interned, which the web still shows
+    void releaseStrings(ScanJob* job);
+
+    // Who-Is/I-Am stage, then a property read of every device found
+    void discoverBacnet(ScanJob* job);
+
+    // ListIdentity stage
+    void discoverEnip(ScanJob* job);
+
+    // Queue every host the broadcast stages found for its ports
+    void queueDiscovered();
+
+    // Queue the job's TCP and UDP ports for a live host; anything the
+    // broadcast stages found for it goes into its result
+    void queuePorts(IPAddress host);
+
+    // Fold one port result into its host; hands the host to loop() once
+    // its last port is in
+    void handlePortResult(const PortProbeResult& probe);
+    void handleUdpResult(const PortProbeResult& probe);
+
+    // Hand waiting hosts to the Modbus client and collect identities;
+    // returns false once no host is waiting or being identified
+    bool pollModbus(unsigned long waitMs);
+    void handleModbusIdentity(const ModbusIdentity& identity);
+    void finishHost(size_t index);
+
+    // Blocks while the event queue is full; gives up if the job is cancelled
+    bool pushEvent(const ScanEvent& event, uint32_t jobId);
+
+    // xQueueSend that counts the event as unfinished once it is queued
+    bool queueEvent(const ScanEvent& event, TickType_t wait);
+
+    void setProgress(const SweepProgress& value);
+};
+
+extern ScanTask scanTask;
+
+#endif // SCAN_TASK_H
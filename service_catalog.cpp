@@ -0,0 +1,90 @@
+/*
+ * Service Catalog Implementation
+ * Compile-time table of known ports: names, probes, reply waits and scan profiles
+ */
+
+#include "service_catalog.h"
+
+static_assert(serviceCatalogSorted(), "SERVICE_CATALOG must be sorted by port, TCP before UDP");
+static_assert(serviceIndex(MODBUS_PORT, SERVICE_TCP) < SERVICE_CATALOG_SIZE &&
+              SERVICE_CATALOG[serviceIndex(MODBUS_PORT, SERVICE_TCP)].payload == PAYLOAD_MODBUS,
+              "Modbus identification expects the Modbus probe on MODBUS_PORT");
+static_assert(serviceIndex(BACNET_PORT, SERVICE_TCP) == SERVICE_CATALOG_SIZE,
+              "BACNET_PORT in a TCP list selects discovery, not a TCP probe");
+
+// Today's defaults: the field devices this tool was written for
+static const uint16_t DEFAULT_TCP[] = {80, 443, 502, 47808};
+static const uint16_t DEFAULT_UDP[] = {161, 1900, 20000};
+
+// Control-system protocols and the web servers of their HMIs and gateways
+static const uint16_t INDUSTRIAL_TCP[] = {80, 102, 443, 502, 1911, 2404, 4840, 20000, 44818, 47808};
+static const uint16_t INDUSTRIAL_UDP[] = {161, 1900, 20000, 44818};
+
+static const uint16_t WEB_TCP[] = {80, 443, 8000, 8008, 8080, 8081, 8443, 8888};
+
+// nmap's 100 most frequently open TCP ports, and the UDP services with a payload
+static const uint16_t TOP_100_TCP[] = {
+    7, 9, 13, 21, 22, 23, 25, 26, 37, 53, 79, 80, 81, 88, 106, 110, 111, 113, 119, 135,
+    139, 143, 144, 179, 199, 389, 427, 443, 444, 445, 465, 513, 514, 515, 543, 544, 548, 554, 587, 631,
+    646, 873, 990, 993, 995, 1025, 1026, 1027, 1028, 1029, 1110, 1433, 1720, 1723, 1755, 1900, 2000, 2001, 2049, 2121,
+    2717, 3000, 3128, 3306, 3389, 3986, 4899, 5000, 5009, 5051, 5060, 5101, 5190, 5357, 5432, 5631, 5666, 5800, 5900, 6000,
+    6001, 6646, 7070, 8000, 8008, 8009, 8080, 8081, 8443, 8888, 9100, 9999, 10000, 32768, 49152, 49153, 49154, 49155, 49156, 49157
+};
+static const uint16_t TOP_100_UDP[] = {53, 123, 161, 1900};
+
+#define PROFILE_PORTS(ports) ports, (uint8_t)(sizeof(ports) / sizeof(ports[0]))
+
+const ScanProfile SCAN_PROFILES[] = {
+    {"default",    PROFILE_PORTS(DEFAULT_TCP),    PROFILE_PORTS(DEFAULT_UDP)},
+    {"industrial", PROFILE_PORTS(INDUSTRIAL_TCP), PROFILE_PORTS(INDUSTRIAL_UDP)},
+    {"web",        PROFILE_PORTS(WEB_TCP),        nullptr, 0},
+    {"top-100",    PROFILE_PORTS(TOP_100_TCP),    PROFILE_PORTS(TOP_100_UDP)}
+};
+
+const size_t SCAN_PROFILE_COUNT = sizeof(SCAN_PROFILES) / sizeof(SCAN_PROFILES[0]);
+
+static_assert(sizeof(TOP_100_TCP) / sizeof(TOP_100_TCP[0]) + sizeof(TOP_100_UDP) / sizeof(TOP_100_UDP[0])
+              <= SCAN_MAX_PORTS, "Every profile must fit SCAN_MAX_PORTS");
+
+const ServiceEntry* findService(uint16_t port, ServiceProtocol protocol) {
+    size_t index = serviceIndex(port, protocol);
+    return index < SERVICE_CATALOG_SIZE ? &SERVICE_CATALOG[index] : nullptr;
+}
+
+const ServiceEntry* findServiceByName(const char* name, ServiceProtocol protocol) {
+    for (size_t i = 0; i < SERVICE_CATALOG_SIZE; i++) {
+        const ServiceEntry& entry = SERVICE_CATALOG[i];
+        if (entry.protocol == protocol && strcasecmp(entry.name, name) == 0) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+const char* serviceName(uint16_t port) {
+    size_t index = serviceIndexAny(port);
+    return index < SERVICE_CATALOG_SIZE ? SERVICE_CATALOG[index].name : "Unknown";
+}
+
+unsigned long serviceReplyWait(uint16_t port) {
+    const ServiceEntry* entry = findService(port, SERVICE_TCP);
+    switch (entry ? entry->timeout : TIMEOUT_BANNER) {
+        case TIMEOUT_REPLY: return BANNER_TIMEOUT;
+        case TIMEOUT_GATEWAY: return MODBUS_RESPONSE_TIMEOUT;
+        default: return BANNER_WAIT;
+    }
+}
+
+const ScanProfile* findScanProfile(const char* name) {
+    for (size_t i = 0; i < SCAN_PROFILE_COUNT; i++) {
+        if (strcasecmp(SCAN_PROFILES[i].name, name) == 0) {
+            return &SCAN_PROFILES[i];
+        }
+    }
+    return nullptr;
+}
+
+const ScanProfile& defaultScanProfile() {
+    const ScanProfile* profile = findScanProfile(DEFAULT_SCAN_PROFILE);
+    return profile ? *profile : SCAN_PROFILES[0];
+}
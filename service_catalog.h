@@ -0,0 +1,172 @@
+/*
+ * Service Catalog Header
+ * Compile-time table of known ports: names, probes, reply waits and scan profiles
+ */
+
+#ifndef SERVICE_CATALOG_H
+#define SERVICE_CATALOG_H
+
+#include <Arduino.h>
+#include "config.h"
+
+enum ServiceProtocol : uint8_t {
+    SERVICE_TCP,
+    SERVICE_UDP
+};
+
+// What the scanners send once a port is reachable; the TCP probes are
+// built in fingerprint.cpp, the UDP ones in udp_scanner.cpp
+enum ProbePayload : uint8_t {
+    PAYLOAD_NONE,                 // TCP: wait for the server to speak; UDP: an empty datagram
+    PAYLOAD_HTTP,                 // TCP GET /
+    PAYLOAD_TLS,                  // TCP ClientHello
+    PAYLOAD_MODBUS,               // TCP Read Holding Registers
+    PAYLOAD_DNS,                  // UDP version.bind query
+    PAYLOAD_NTP,                  // UDP client request
+    PAYLOAD_SNMP,                 // UDP GetRequest sysDescr.0
+    PAYLOAD_SSDP,                 // UDP M-SEARCH
+    PAYLOAD_DNP3,                 // UDP Request Link Status
+    PAYLOAD_ENIP,                 // UDP ListIdentity
+    PAYLOAD_BACNET                // UDP ReadProperty
+};
+
+// How long a connected TCP service takes to answer
+enum TimeoutClass : uint8_t {
+    TIMEOUT_BANNER,               // Speaks first or not at all (BANNER_WAIT)
+    TIMEOUT_REPLY,                // Answers the probe (BANNER_TIMEOUT)
+    TIMEOUT_GATEWAY               // Asks a serial bus first (MODBUS_RESPONSE_TIMEOUT)
+};
+
+struct ServiceEntry {
+    uint16_t port;
+    ServiceProtocol protocol;
+    const char* name;
+    ProbePayload payload;
+    TimeoutClass timeout;
+};
+
+// Sorted by port, TCP before UDP. It is constexpr so lookups can run at
+// compile time; at run time use the functions further down, which keep
+// the one copy of the table (in flash) in service_catalog.cpp
+constexpr ServiceEntry SERVICE_CATALOG[] = {
+    {21,    SERVICE_TCP, "FTP",         PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {22,    SERVICE_TCP, "SSH",         PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {23,    SERVICE_TCP, "Telnet",      PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {25,    SERVICE_TCP, "SMTP",        PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {53,    SERVICE_TCP, "DNS",         PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {53,    SERVICE_UDP, "DNS",         PAYLOAD_DNS,    TIMEOUT_REPLY},
+    {80,    SERVICE_TCP, "HTTP",        PAYLOAD_HTTP,   TIMEOUT_REPLY},
+    {102,   SERVICE_TCP, "S7comm",      PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {110,   SERVICE_TCP, "POP3",        PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {123,   SERVICE_UDP, "NTP",         PAYLOAD_NTP,    TIMEOUT_REPLY},
+    {135,   SERVICE_TCP, "MSRPC",       PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {139,   SERVICE_TCP, "NetBIOS",     PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {143,   SERVICE_TCP, "IMAP",        PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {161,   SERVICE_UDP, "SNMP",        PAYLOAD_SNMP,   TIMEOUT_REPLY},
+    {389,   SERVICE_TCP, "LDAP",        PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {443,   SERVICE_TCP, "HTTPS",       PAYLOAD_TLS,    TIMEOUT_REPLY},
+    {445,   SERVICE_TCP, "SMB",         PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {502,   SERVICE_TCP, "MODBUS TCP",  PAYLOAD_MODBUS, TIMEOUT_GATEWAY},
+    {554,   SERVICE_TCP, "RTSP",        PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {631,   SERVICE_TCP, "IPP",         PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {993,   SERVICE_TCP, "IMAPS",       PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {995,   SERVICE_TCP, "POP3S",       PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {1433,  SERVICE_TCP, "MSSQL",       PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {1883,  SERVICE_TCP, "MQTT",        PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {1900,  SERVICE_UDP, "SSDP",        PAYLOAD_SSDP,   TIMEOUT_REPLY},
+    {1911,  SERVICE_TCP, "Niagara Fox", PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {2404,  SERVICE_TCP, "IEC 104",     PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {3306,  SERVICE_TCP, "MySQL",       PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {3389,  SERVICE_TCP, "RDP",         PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {4840,  SERVICE_TCP, "OPC UA",      PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {5432,  SERVICE_TCP, "PostgreSQL",  PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {5900,  SERVICE_TCP, "VNC",         PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {8000,  SERVICE_TCP, "HTTP-Alt",    PAYLOAD_HTTP,   TIMEOUT_REPLY},
+    {8008,  SERVICE_TCP, "HTTP-Alt",    PAYLOAD_HTTP,   TIMEOUT_REPLY},
+    {8080,  SERVICE_TCP, "HTTP-Alt",    PAYLOAD_HTTP,   TIMEOUT_REPLY},
+    {8081,  SERVICE_TCP, "HTTP-Alt",    PAYLOAD_HTTP,   TIMEOUT_REPLY},
+    {8443,  SERVICE_TCP, "HTTPS-Alt",   PAYLOAD_TLS,    TIMEOUT_REPLY},
+    {8888,  SERVICE_TCP, "HTTP-Alt",    PAYLOAD_HTTP,   TIMEOUT_REPLY},
+    {9100,  SERVICE_TCP, "JetDirect",   PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {20000, SERVICE_TCP, "DNP3",        PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {20000, SERVICE_UDP, "DNP3",        PAYLOAD_DNP3,   TIMEOUT_REPLY},
+    {44818, SERVICE_TCP, "EtherNet/IP", PAYLOAD_NONE,   TIMEOUT_BANNER},
+    {44818, SERVICE_UDP, "EtherNet/IP", PAYLOAD_ENIP,   TIMEOUT_REPLY},
+    {47808, SERVICE_UDP, "BACnet",      PAYLOAD_BACNET, TIMEOUT_REPLY}
+};
+
+constexpr size_t SERVICE_CATALOG_SIZE = sizeof(SERVICE_CATALOG) / sizeof(SERVICE_CATALOG[0]);
+
+// The lookups are single-return recursions so they stay valid C++11
+// constexpr (the 2.x board packages build with -std=gnu++11)
+
+constexpr uint32_t serviceKey(uint16_t port, ServiceProtocol protocol) {
+    return ((uint32_t)port << 1) | protocol;
+}
+
+constexpr uint32_t serviceKeyAt(size_t index) {
+    return serviceKey(SERVICE_CATALOG[index].port, SERVICE_CATALOG[index].protocol);
+}
+
+// Index of the first entry whose key is not below key
+constexpr size_t serviceLowerBound(uint32_t key, size_t low = 0, size_t high = SERVICE_CATALOG_SIZE) {
+    return low >= high ? low
+         : serviceKeyAt(low + (high - low) / 2) < key
+           ? serviceLowerBound(key, low + (high - low) / 2 + 1, high)
+           : serviceLowerBound(key, low, low + (high - low) / 2);
+}
+
+constexpr size_t serviceIndexIfPort(size_t index, uint16_t port) {
+    return index < SERVICE_CATALOG_SIZE && SERVICE_CATALOG[index].port == port ? index : SERVICE_CATALOG_SIZE;
+}
+
+constexpr size_t serviceIndexIfKey(size_t index, uint32_t key) {
+    return index < SERVICE_CATALOG_SIZE && serviceKeyAt(index) == key ? index : SERVICE_CATALOG_SIZE;
+}
+
+// Index of a port's entry, or SERVICE_CATALOG_SIZE
+constexpr size_t serviceIndex(uint16_t port, ServiceProtocol protocol) {
+    return serviceIndexIfKey(serviceLowerBound(serviceKey(port, protocol)), serviceKey(port, protocol));
+}
+
+// Index of a port's first entry, whatever its protocol
+constexpr size_t serviceIndexAny(uint16_t port) {
+    return serviceIndexIfPort(serviceLowerBound(serviceKey(port, SERVICE_TCP)), port);
+}
+
+constexpr bool serviceCatalogSorted(size_t index = 1) {
+    return index >= SERVICE_CATALOG_SIZE ||
+           (serviceKeyAt(index - 1) < serviceKeyAt(index) && serviceCatalogSorted(index + 1));
+}
+
+// A named port list for the scan page and the serial console
+struct ScanProfile {
+    const char* name;
+    const uint16_t* tcpPorts;
+    uint8_t tcpCount;
+    const uint16_t* udpPorts;
+    uint8_t udpCount;
+};
+
+extern const ScanProfile SCAN_PROFILES[];
+extern const size_t SCAN_PROFILE_COUNT;
+
+// Entry of a port, or nullptr
+const ServiceEntry* findService(uint16_t port, ServiceProtocol protocol);
+
+// Entry with the given name (case-insensitive), or nullptr
+const ServiceEntry* findServiceByName(const char* name, ServiceProtocol protocol);
+
+// Display name of a port under either protocol; "Unknown" without an entry
+const char* serviceName(uint16_t port);
+
+// Reply deadline in ms for a connected TCP port
+unsigned long serviceReplyWait(uint16_t port);
+
+// Profile with the given name (case-insensitive), or nullptr
+const ScanProfile* findScanProfile(const char* name);
+
+// The DEFAULT_SCAN_PROFILE profile
+const ScanProfile& defaultScanProfile();
+
+#endif // SERVICE_CATALOG_H
@@ -0,0 +1,114 @@
+/*
+ * String Pool Implementation
+ * Interned, append-only storage for the variable strings in scan results
+ */
+
+#include "string_pool.h"
+
+#if STRING_POOL_SIZE > 65536
+#error "STRING_POOL_SIZE must fit the 16-bit handle"
+#endif
+
+#if (STRING_POOL_BUCKETS & (STRING_POOL_BUCKETS - 1)) != 0
+#error "STRING_POOL_BUCKETS must be a power of two"
+#endif
+
+StringPool stringPool;
+
+StringPool::StringPool() {
+    lock = portMUX_INITIALIZER_UNLOCKED;
+    clear();
+}
+
+void StringPool::clear() {
+    portENTER_CRITICAL(&lock);
+    arena[0] = '\0';
+    length = 1;
+    kept = 1;
+    memset(buckets, 0, sizeof(buckets));
+    indexed = 0;
+    dropped = 0;
+    portEXIT_CRITICAL(&lock);
+}
+
+void StringPool::keep() {
+    portENTER_CRITICAL(&lock);
+    kept = length;
+    portEXIT_CRITICAL(&lock);
+}
+
+void StringPool::trim() {
+    portENTER_CRITICAL(&lock);
+    // Handles grow with time, so every string indexed before keep() was
+    // placed before any later one; dropping the later ones cannot break
+    // the probe run of an earlier string
+    for (size_t i = 0; i < STRING_POOL_BUCKETS; i++) {
+        if (buckets[i] >= kept) {
+            buckets[i] = 0;
+            indexed--;
+        }
+    }
+    length = kept;
+    portEXIT_CRITICAL(&lock);
+}
+
+uint16_t StringPool::intern(const char* text) {
+    size_t textLength = text ? strlen(text) : 0;
+    if (textLength == 0) {
+        return 0;
+    }
+
+    uint32_t bucket = hash(text, textLength) & (STRING_POOL_BUCKETS - 1);
+    uint16_t handle = 0;
+
+    portENTER_CRITICAL(&lock);
+    while (buckets[bucket] != 0) {
+        if (strcmp(arena + buckets[bucket], text) == 0) {
+            handle = buckets[bucket];
+            break;
+        }
+        bucket = (bucket + 1) & (STRING_POOL_BUCKETS - 1);
+    }
+
+    if (handle == 0) {
+        if (length + textLength + 1 > STRING_POOL_SIZE) {
+            dropped++;
+        } else {
+            handle = length;
+            memcpy(arena + length, text, textLength + 1);
+            length += textLength + 1;
+
+            // Past 3/4 load the index stops growing; later strings are
+            // still stored, just not shared
+            if (indexed < STRING_POOL_BUCKETS * 3 / 4) {
+                buckets[bucket] = handle;
+                indexed++;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+
+    return handle;
+}
+
+const char* StringPool::get(uint16_t handle) const {
+    return handle < length ? arena + handle : arena;
+}
+
+size_t StringPool::used() const {
+    return length;
+}
+
+uint32_t StringPool::getDropped() const {
+    return dropped;
+}
+
+uint32_t StringPool::hash(const char* text, size_t textLength) {
+    // FNV-1a
+    uint32_t value = 2166136261u;
+    for (size_t i = 0; i < textLength; i++) {
+        value ^= (uint8_t)text[i];
+        value *= 16777619u;
+    }
+    return value;
+}
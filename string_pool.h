@@ -0,0 +1,57 @@
+/*
+ * String Pool Header
+ * Interned, append-only storage for the variable strings in scan results
+ */
+
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include "config.h"
+
+// Results refer to strings by a 16-bit handle (an offset into the pool).
+// Handle 0 is the empty string. Identical strings share one copy, so a
+// rack of identical devices costs one banner, not one per host.
+class StringPool {
+public:
+    StringPool();
+
+    // Forget every string; only safe once no result holds a handle
+    void clear();
+
+    // Strings interned so far survive trim()
+    void keep();
+
+    // Forget the strings interned since keep() (or clear()); only safe
+    // once no result holds one of their handles
+    void trim();
+
+    // Store text once and return its handle; 0 for "" or when the pool
+    // is full (the string is then reported empty)
+    uint16_t intern(const char* text);
+
+    // Text of a handle; never nullptr
+    const char* get(uint16_t handle) const;
+
+    // Statistics
+    size_t used() const;
+    uint32_t getDropped() const;
+
+private:
+    char arena[STRING_POOL_SIZE];
+    size_t length;
+    size_t kept;                            // Length at keep()
+    uint16_t buckets[STRING_POOL_BUCKETS];  // Handle, or 0 = empty
+    size_t indexed;
+    uint32_t dropped;
+
+    // The scan task interns while loop() reads
+    portMUX_TYPE lock;
+
+    static uint32_t hash(const char* text, size_t textLength);
+};
+
+extern StringPool stringPool;
+
+#endif // STRING_POOL_H
@@ -0,0 +1,231 @@
+/*
+ * Sweep Engine Implementation
+ * Concurrent host liveness sweep built on the connect pool
+ */
+
+#include "sweep_engine.h"
+#include "rtt_estimator.h"
+#include "probe_pacer.h"
+#include <ETH.h>
+
+SweepEngine::SweepEngine() {
+    running = false;
+    targets = nullptr;
+    exhausted = true;
+    pacerWait = 0;
+    total = 0;
+    completed = 0;
+    aliveCount = 0;
+    unprobedCount = 0;
+    startTime = 0;
+    endTime = 0;
+}
+
+void SweepEngine::begin(size_t maxInFlight) {
+    pool.begin(maxInFlight);
+
+    // At most one deferred probe per slot plus the host that found the pool full
+    deferred.reserve(maxInFlight + 1);
+}
+
+void SweepEngine::start(TargetIterator* targetList) {
+    stop();
+
+    targets = targetList;
+    total = targets ? targets->getTargetCount() : 0;
+    exhausted = total == 0;
+    deferred.clear();
+    completed = 0;
+    aliveCount = 0;
+    unprobedCount = 0;
+    startTime = millis();
+    endTime = startTime;
+    running = total > 0;
+
+    #if DEBUG_NETWORK
+    Serial.printf("Sweep started: %u hosts, %u probes in flight\n",
+                  total, (unsigned)pool.capacity());
+    #endif
+}
+
+bool SweepEngine::poll(SweepCallback callback, unsigned long waitMs) {
+    if (!running) {
+        return false;
+    }
+
+    refill(callback);
+
+    if (pool.inFlight() == 0 && !deferred.empty()) {
+        // Only the pacer or a socket shortage is holding us back; nothing
+        // to select() on
+        delay(pacerWait < waitMs ? (pacerWait > 0 ? pacerWait : 1) : waitMs);
+    }
+
+    pool.poll(waitMs, [this, &callback](const ConnectCompletion& completion) {
+        handleCompletion(completion, callback);
+    });
+
+    refill(callback);
+
+    if (pool.inFlight() == 0 && exhausted && deferred.empty()) {
+        running = false;
+        endTime = millis();
+
+        #if DEBUG_NETWORK
+        Serial.printf("Sweep finished: %u hosts in %lu ms (%.1f hosts/s), %u alive, %u unprobed\n",
+                      total, getElapsed(), getHostsPerSecond(), aliveCount, unprobedCount);
+        #endif
+    }
+
+    return running;
+}
+
+void SweepEngine::stop() {
+    pool.cancelAll();
+    deferred.clear();
+    if (running) {
+        endTime = millis();
+    }
+    running = false;
+}
+
+bool SweepEngine::isRunning() {
+    return running;
+}
+
+uint32_t SweepEngine::getTotal() {
+    return total;
+}
+
+uint32_t SweepEngine::getCompleted() {
+    return completed;
+}
+
+uint32_t SweepEngine::getAliveCount() {
+    return aliveCount;
+}
+
+uint32_t SweepEngine::getUnprobedCount() {
+    return unprobedCount;
+}
+
+unsigned long SweepEngine::getElapsed() {
+    return (running ? millis() : endTime) - startTime;
+}
+
+float SweepEngine::getHostsPerSecond() {
+    unsigned long elapsed = getElapsed();
+    if (elapsed == 0) {
+        return 0.0f;
+    }
+    return (completed * 1000.0f) / elapsed;
+}
+
+void SweepEngine::refill(SweepCallback& callback) {
+    // Deferred probes first; a host still inside its gap does not hold
+    // up the others behind it
+    for (size_t i = 0; i < deferred.size() && pool.hasFreeSlot();) {
+        if (launch(deferred[i], callback)) {
+            deferred.erase(deferred.begin() + i);
+        } else {
+            i++;
+        }
+    }
+
+    while (pool.hasFreeSlot() && !exhausted && deferred.size() <= pool.capacity()) {
+        IPAddress ip;
+        if (!targets->next(ip)) {
+            exhausted = true;
+            break;
+        }
+
+        if (!shouldProbe(ip)) {
+            completed++;
+            continue;
+        }
+
+        PendingProbe probe = {ip, 0, 0};
+        if (!launch(probe, callback)) {
+            deferred.push_back(probe);
+            break;
+        }
+    }
+}
+
+bool SweepEngine::launch(PendingProbe& probe, SweepCallback& callback) {
+    if (!probePacer.tryAcquire(probe.host, &pacerWait)) {
+        return false;
+    }
+
+    // Tag carries the index into LIVENESS_PORTS being tried
+    unsigned long timeout = rttEstimator.getTimeout(probe.host, PING_TIMEOUT);
+    if (pool.submit(probe.host, LIVENESS_PORTS[probe.portIndex], timeout, probe.portIndex)) {
+        return true;
+    }
+
+    probePacer.release(probe.host);
+    if (pool.inFlight() > 0) {
+        // Out of sockets - retry once a slot frees up
+        return false;
+    }
+
+    // None of ours to wait for; the sockets are held elsewhere (web
+    // server, port probes), so back off and try the host again
+    if (probe.socketRetries < SWEEP_SOCKET_RETRIES) {
+        probe.socketRetries++;
+        pacerWait = SWEEP_SOCKET_BACKOFF;
+        return false;
+    }
+
+    // Still no socket; report the host unprobed rather than drop it
+    completed++;
+    unprobedCount++;
+
+    #if DEBUG_NETWORK
+    Serial.printf("Sweep: no socket for %s, left unprobed\n", probe.host.toString().c_str());
+    #endif
+
+    if (callback) {
+        callback(probe.host, false, 0);
+    }
+    return true;
+}
+
+void SweepEngine::handleCompletion(const ConnectCompletion& completion, SweepCallback& callback) {
+    probePacer.release(completion.target);
+
+    // A refused connection still proves the host is on the wire
+    bool alive = completion.outcome == CONNECT_OPEN ||
+                 completion.outcome == CONNECT_REFUSED;
+
+    if (alive) {
+        rttEstimator.addSample(completion.target, completion.responseTime);
+    } else if (completion.outcome == CONNECT_TIMEOUT) {
+        rttEstimator.addTimeout(completion.target);
+    }
+
+    if (!alive && completion.tag + 1 < sizeof(LIVENESS_PORTS) / sizeof(LIVENESS_PORTS[0])) {
+        // Next liveness port goes through the pacer like any other probe
+        PendingProbe probe = {completion.target, completion.tag + 1, 0};
+        deferred.push_back(probe);
+        return;
+    }
+
+    completed++;
+    if (alive) {
+        aliveCount++;
+    }
+
+    if (callback) {
+        callback(completion.target, alive, completion.responseTime);
+    }
+}
+
+bool SweepEngine::shouldProbe(IPAddress ip) {
+    uint8_t first = ip[0];
+    if (first == 0 || first == 127 || first >= 224) {
+        return false;
+    }
+
+    return ip != ETH.localIP();
+}
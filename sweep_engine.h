@@ -0,0 +1,79 @@
+/*
+ * Sweep Engine Header
+ * Concurrent host liveness sweep built on the connect pool
+ */
+
+#ifndef SWEEP_ENGINE_H
+#define SWEEP_ENGINE_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+#include <IPAddress.h>
+#include "config.h"
+#include "connect_pool.h"
+#include "target_iterator.h"
+
+// Called once per host as soon as its probes have finished
+typedef std::function<void(IPAddress host, bool alive, unsigned long responseTime)> SweepCallback;
+
+struct PendingProbe {
+    IPAddress host;
+    uint32_t portIndex;        // Index into LIVENESS_PORTS
+    uint8_t socketRetries;     // Submits that found no socket with none of ours in flight
+};
+
+class SweepEngine {
+public:
+    SweepEngine();
+
+    // Size the probe pool (defaults to MAX_CONCURRENT_SCANS)
+    void begin(size_t maxInFlight = MAX_CONCURRENT_SCANS);
+
+    // Start sweeping the targets (the iterator must outlive the sweep)
+    void start(TargetIterator* targets);
+
+    // Refill the pool and report completions; returns false once finished
+    bool poll(SweepCallback callback, unsigned long waitMs = SWEEP_POLL_INTERVAL);
+
+    // Abort the sweep
+    void stop();
+
+    // Progress and throughput
+    bool isRunning();
+    uint32_t getTotal();
+    uint32_t getCompleted();
+    uint32_t getAliveCount();
+    uint32_t getUnprobedCount();
+    unsigned long getElapsed();
+    float getHostsPerSecond();
+
+private:
+    ConnectPool pool;
+    bool running;
+    TargetIterator* targets;
+    bool exhausted;
+    std::vector<PendingProbe> deferred;   // Held back by the pacer or out of sockets
+    unsigned long pacerWait;              // Pacer's estimate when it last said no
+    uint32_t total;
+    uint32_t completed;
+    uint32_t aliveCount;
+    uint32_t unprobedCount;               // Given up on without a socket to probe them
+    unsigned long startTime;
+    unsigned long endTime;
+
+    // Submit deferred probes, then new hosts, until the pool is full,
+    // the pacer says wait or the targets are exhausted
+    void refill(SweepCallback& callback);
+
+    // Submit one probe; false if it has to wait for the pacer or a socket
+    bool launch(PendingProbe& probe, SweepCallback& callback);
+
+    // Handle one finished connect attempt
+    void handleCompletion(const ConnectCompletion& completion, SweepCallback& callback);
+
+    // Check if an address should be probed at all
+    bool shouldProbe(IPAddress ip);
+};
+
+#endif // SWEEP_ENGINE_H
@@ -0,0 +1,455 @@
+/*
+ * SYN Scanner Implementation
+ * Half-open TCP port probing with raw SYNs through an lwIP raw PCB
+ */
+
+#include "syn_scanner.h"
+#include "rtt_estimator.h"
+#include "probe_pacer.h"
+#include <lwip/ip4.h>
+#include <lwip/ip_addr.h>
+#include <lwip/inet_chksum.h>
+#include <lwip/priv/tcpip_priv.h>
+
+#define TCP_FLAG_SYN 0x02
+#define TCP_FLAG_RST 0x04
+#define TCP_FLAG_ACK 0x10
+
+// Source ports are picked below lwIP's ephemeral range (0xC000 up), so a
+// scan never collides with a real connection of our own
+#define SYN_PORT_BASE 32768
+#define SYN_PORT_SPAN 16384
+
+// SYN with a single MSS option, like a real stack would send
+#define SYN_HEADER_LEN 24
+#define SYN_MSS 1460
+#define SYN_WINDOW 1024
+
+// Messages passed into the tcpip thread; the call header must come first
+struct SynOpenCall {
+    struct tcpip_api_call_data call;
+    void* scanner;
+    struct raw_pcb* pcb;
+};
+
+struct SynSendCall {
+    struct tcpip_api_call_data call;
+    struct raw_pcb* pcb;
+    uint16_t sourcePort;
+    size_t count;
+    uint32_t targets[SYN_SEND_BATCH];
+    uint16_t ports[SYN_SEND_BATCH];
+    uint32_t seqs[SYN_SEND_BATCH];
+    err_t results[SYN_SEND_BATCH];
+};
+
+static void putU16(uint8_t* p, uint16_t value) {
+    p[0] = (uint8_t)(value >> 8);
+    p[1] = (uint8_t)value;
+}
+
+static void putU32(uint8_t* p, uint32_t value) {
+    putU16(p, (uint16_t)(value >> 16));
+    putU16(p + 2, (uint16_t)value);
+}
+
+static uint16_t getU16(const uint8_t* p) {
+    return ((uint16_t)p[0] << 8) | p[1];
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    return ((uint32_t)getU16(p) << 16) | getU16(p + 2);
+}
+
+SynScanner::SynScanner() {
+    pcb = nullptr;
+    memset(probes, 0, sizeof(probes));
+    used = 0;
+    pacerWait = 0;
+    secret = 0;
+    listenPort = 0;
+    ringHead = 0;
+    ringCount = 0;
+    dropped = 0;
+    lock = portMUX_INITIALIZER_UNLOCKED;
+    replySignal = nullptr;
+}
+
+bool SynScanner::begin() {
+    if (pcb) {
+        return true;
+    }
+
+    replySignal = xSemaphoreCreateBinary();
+    if (!replySignal) {
+        return false;
+    }
+
+    SynOpenCall msg;
+    msg.scanner = this;
+    msg.pcb = nullptr;
+    tcpip_api_call(openPcb, &msg.call);
+    pcb = msg.pcb;
+
+    #if DEBUG_PORT_SCAN
+    Serial.printf("SYN scanner %s\n", pcb ? "ready" : "unavailable (no raw PCB)");
+    #endif
+    return pcb != nullptr;
+}
+
+bool SynScanner::isReady() {
+    return pcb != nullptr;
+}
+
+bool SynScanner::add(IPAddress target, uint16_t port) {
+    if (!pcb || used >= SYN_SCAN_SLOTS) {
+        return false;
+    }
+
+    // A new session gets a fresh source port and cookie secret, so stray
+    // replies to an earlier scan can never be taken for this one
+    if (used == 0) {
+        secret = esp_random();
+        listenPort = SYN_PORT_BASE + (esp_random() % SYN_PORT_SPAN);
+    }
+
+    for (size_t i = 0; i < SYN_SCAN_SLOTS; i++) {
+        Probe& probe = probes[i];
+        if (probe.target == 0) {
+            probe.target = (uint32_t)target;
+            probe.port = port;
+            probe.attempts = 0;
+            probe.sent = false;
+            probe.sentAt = 0;
+            probe.timeout = 0;
+            used++;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SynScanner::poll(PortProbeCallback callback, unsigned long waitMs) {
+    if (!isBusy()) {
+        return false;
+    }
+
+    sendQueued(callback);
+    drainReplies(callback);
+    expireProbes(callback);
+
+    if (!isBusy()) {
+        listenPort = 0;
+        return false;
+    }
+
+    // Sleep until a reply arrives, the next probe expires or the pacer
+    // lets the next SYN out, whichever comes first
+    unsigned long now = millis();
+    unsigned long wait = waitMs;
+    bool waiting = false;
+    for (size_t i = 0; i < SYN_SCAN_SLOTS; i++) {
+        const Probe& probe = probes[i];
+        if (probe.target == 0) {
+            continue;
+        }
+        unsigned long left = 1;
+        if (probe.sent) {
+            unsigned long elapsed = now - probe.sentAt;
+            left = elapsed < probe.timeout ? probe.timeout - elapsed : 0;
+        } else {
+            left = pacerWait > 0 ? pacerWait : 1;
+        }
+        if (left < wait) {
+            wait = left;
+        }
+        waiting = true;
+    }
+
+    if (waiting && wait > 0) {
+        xSemaphoreTake(replySignal, pdMS_TO_TICKS(wait));
+    }
+
+    drainReplies(callback);
+    expireProbes(callback);
+    sendQueued(callback);
+
+    if (!isBusy()) {
+        listenPort = 0;
+        return false;
+    }
+    return true;
+}
+
+void SynScanner::stop() {
+    memset(probes, 0, sizeof(probes));
+    used = 0;
+    listenPort = 0;
+
+    portENTER_CRITICAL(&lock);
+    ringHead = 0;
+    ringCount = 0;
+    portEXIT_CRITICAL(&lock);
+}
+
+bool SynScanner::isBusy() {
+    return used > 0;
+}
+
+size_t SynScanner::getPending() {
+    return used;
+}
+
+uint32_t SynScanner::getDropped() {
+    return dropped;
+}
+
+uint32_t SynScanner::cookie(uint32_t target, uint16_t port) {
+    // Keyed mix of the 4-tuple (murmur3 finalizer); replies are matched
+    // against it, so nothing per-probe has to be looked up in the lwIP thread
+    uint32_t h = secret ^ target;
+    h ^= ((uint32_t)port << 16) | listenPort;
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+void SynScanner::sendQueued(PortProbeCallback& callback) {
+    SynSendCall msg;
+    msg.pcb = pcb;
+    msg.sourcePort = listenPort;
+    msg.count = 0;
+    size_t slots[SYN_SEND_BATCH];
+
+    for (size_t i = 0; i < SYN_SCAN_SLOTS && msg.count < SYN_SEND_BATCH; i++) {
+        Probe& probe = probes[i];
+        if (probe.target == 0 || probe.sent) {
+            continue;
+        }
+        if (!probePacer.tryAcquire(IPAddress(probe.target), &pacerWait)) {
+            continue;
+        }
+
+        msg.targets[msg.count] = probe.target;
+        msg.ports[msg.count] = probe.port;
+        msg.seqs[msg.count] = cookie(probe.target, probe.port);
+        slots[msg.count] = i;
+        msg.count++;
+    }
+
+    if (msg.count == 0) {
+        return;
+    }
+
+    // One trip into the tcpip thread for the whole batch
+    tcpip_api_call(sendBatch, &msg.call);
+
+    unsigned long now = millis();
+    for (size_t k = 0; k < msg.count; k++) {
+        Probe& probe = probes[slots[k]];
+        IPAddress host(probe.target);
+        probe.attempts++;
+
+        if (msg.results[k] == ERR_RTE) {
+            probePacer.release(host);
+            finish(probe, PORT_UNREACHABLE, 0, callback);
+            continue;
+        }
+        if (msg.results[k] != ERR_OK) {
+            // Out of pbufs; counts as a lost SYN
+            probePacer.release(host);
+            if (probe.attempts >= MAX_RETRY_ATTEMPTS) {
+                finish(probe, PORT_FILTERED, 0, callback);
+            }
+            continue;
+        }
+
+        probe.sent = true;
+        probe.sentAt = now;
+        probe.timeout = rttEstimator.getTimeout(host, PORT_TIMEOUT);
+    }
+}
+
+void SynScanner::drainReplies(PortProbeCallback& callback) {
+    Reply replies[SYN_REPLY_RING];
+    size_t count = 0;
+
+    portENTER_CRITICAL(&lock);
+    while (ringCount > 0) {
+        replies[count++] = ring[ringHead];
+        ringHead = (ringHead + 1) % SYN_REPLY_RING;
+        ringCount--;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    for (size_t i = 0; i < count; i++) {
+        const Reply& reply = replies[i];
+        Probe* probe = findProbe(reply.source, reply.sourcePort);
+        if (!probe || !probe->sent) {
+            continue;
+        }
+
+        // Both a SYN-ACK and the RST answering a SYN acknowledge our ISN
+        if (!(reply.flags & TCP_FLAG_ACK) || reply.ack != cookie(probe->target, probe->port) + 1) {
+            continue;
+        }
+
+        PortState state;
+        if (reply.flags & TCP_FLAG_RST) {
+            state = PORT_CLOSED;
+        } else if (reply.flags & TCP_FLAG_SYN) {
+            state = PORT_OPEN;
+        } else {
+            continue;
+        }
+
+        IPAddress host(probe->target);
+        unsigned long rtt = reply.receivedAt - probe->sentAt;
+        rttEstimator.addSample(host, rtt);
+        probePacer.release(host);
+        finish(*probe, state, rtt, callback);
+    }
+}
+
+void SynScanner::expireProbes(PortProbeCallback& callback) {
+    unsigned long now = millis();
+
+    for (size_t i = 0; i < SYN_SCAN_SLOTS; i++) {
+        Probe& probe = probes[i];
+        if (probe.target == 0 || !probe.sent || now - probe.sentAt < probe.timeout) {
+            continue;
+        }
+
+        IPAddress host(probe.target);
+        rttEstimator.addTimeout(host);
+        probePacer.release(host);
+
+        // Same cookie on every attempt, so a late answer to an earlier SYN
+        // still counts
+        if (probe.attempts < MAX_RETRY_ATTEMPTS) {
+            probe.sent = false;
+            continue;
+        }
+        finish(probe, PORT_FILTERED, now - probe.sentAt, callback);
+    }
+}
+
+void SynScanner::finish(Probe& probe, PortState state, unsigned long responseTime, PortProbeCallback& callback) {
+    PortProbeResult result = {IPAddress(probe.target), probe.port, state, responseTime, probe.attempts};
+
+    memset(&probe, 0, sizeof(probe));
+    used--;
+
+    if (callback) {
+        callback(result);
+    }
+}
+
+SynScanner::Probe* SynScanner::findProbe(uint32_t target, uint16_t port) {
+    for (size_t i = 0; i < SYN_SCAN_SLOTS; i++) {
+        if (probes[i].target == target && probes[i].port == port) {
+            return &probes[i];
+        }
+    }
+    return nullptr;
+}
+
+err_t SynScanner::openPcb(struct tcpip_api_call_data* data) {
+    SynOpenCall* msg = (SynOpenCall*)data;
+
+    msg->pcb = raw_new(IP_PROTO_TCP);
+    if (!msg->pcb) {
+        return ERR_MEM;
+    }
+    raw_recv(msg->pcb, receive, msg->scanner);
+    return ERR_OK;
+}
+
+err_t SynScanner::sendBatch(struct tcpip_api_call_data* data) {
+    SynSendCall* msg = (SynSendCall*)data;
+
+    for (size_t i = 0; i < msg->count; i++) {
+        ip4_addr_t dest;
+        dest.addr = msg->targets[i];
+
+        // The checksum covers the source address lwIP will pick
+        struct netif* netif = ip4_route(&dest);
+        if (!netif) {
+            msg->results[i] = ERR_RTE;
+            continue;
+        }
+
+        struct pbuf* p = pbuf_alloc(PBUF_TRANSPORT, SYN_HEADER_LEN, PBUF_RAM);
+        if (!p) {
+            msg->results[i] = ERR_MEM;
+            continue;
+        }
+
+        uint8_t* tcp = (uint8_t*)p->payload;
+        memset(tcp, 0, SYN_HEADER_LEN);
+        putU16(tcp, msg->sourcePort);
+        putU16(tcp + 2, msg->ports[i]);
+        putU32(tcp + 4, msg->seqs[i]);
+        tcp[12] = (SYN_HEADER_LEN / 4) << 4;
+        tcp[13] = TCP_FLAG_SYN;
+        putU16(tcp + 14, SYN_WINDOW);
+        tcp[20] = 2;                  // MSS option
+        tcp[21] = 4;
+        putU16(tcp + 22, SYN_MSS);
+
+        // lwIP returns the checksum already in network order
+        uint16_t checksum = ip4_chksum_pseudo(p, IP_PROTO_TCP, p->tot_len, netif_ip4_addr(netif), &dest);
+        memcpy(tcp + 16, &checksum, sizeof(checksum));
+
+        ip_addr_t target;
+        ip_addr_set_ip4_u32(&target, msg->targets[i]);
+        msg->results[i] = raw_sendto(msg->pcb, p, &target);
+        pbuf_free(p);
+    }
+    return ERR_OK;
+}
+
+u8_t SynScanner::receive(void* arg, struct raw_pcb* pcb, struct pbuf* p, const ip_addr_t* addr) {
+    SynScanner* scanner = (SynScanner*)arg;
+    uint16_t port = scanner->listenPort;
+    if (port == 0) {
+        return 0;
+    }
+
+    // The payload starts at the IPv4 header
+    uint8_t versionLength = 0;
+    if (pbuf_copy_partial(p, &versionLength, 1, 0) != 1) {
+        return 0;
+    }
+    uint16_t headerLength = (versionLength & 0x0F) * 4;
+
+    uint8_t tcp[14];
+    if (pbuf_copy_partial(p, tcp, sizeof(tcp), headerLength) != sizeof(tcp) || getU16(tcp + 2) != port) {
+        return 0;
+    }
+
+    Reply reply;
+    reply.source = ip_2_ip4(addr)->addr;
+    reply.sourcePort = getU16(tcp);
+    reply.ack = getU32(tcp + 8);
+    reply.flags = tcp[13];
+    reply.receivedAt = millis();
+
+    portENTER_CRITICAL(&scanner->lock);
+    if (scanner->ringCount < SYN_REPLY_RING) {
+        scanner->ring[(scanner->ringHead + scanner->ringCount) % SYN_REPLY_RING] = reply;
+        scanner->ringCount++;
+    } else {
+        scanner->dropped++;
+    }
+    portEXIT_CRITICAL(&scanner->lock);
+
+    xSemaphoreGive(scanner->replySignal);
+
+    // Never eaten: lwIP's own TCP finds no connection for the SYN-ACK and
+    // answers it with RST, which is what keeps the scan half-open
+    return 0;
+}
@@ -0,0 +1,95 @@
+/*
+ * SYN Scanner Header
+ * Half-open TCP port probing with raw SYNs through an lwIP raw PCB
+ */
+
+#ifndef SYN_SCANNER_H
+#define SYN_SCANNER_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <lwip/raw.h>
+#include "config.h"
+#include "port_probe_engine.h"
+
+struct tcpip_api_call_data;
+
+class SynScanner {
+public:
+    SynScanner();
+
+    // Open the raw PCB; false if lwIP has none to spare
+    bool begin();
+    bool isReady();
+
+    // Queue a probe; false when every slot is taken (poll, then try again)
+    bool add(IPAddress target, uint16_t port);
+
+    // Send queued SYNs, classify replies and expire silent probes; returns
+    // false once nothing is queued or awaiting a reply
+    bool poll(PortProbeCallback callback, unsigned long waitMs = SWEEP_POLL_INTERVAL);
+
+    // Drop everything queued or awaiting a reply without reporting it
+    void stop();
+
+    bool isBusy();
+    size_t getPending();
+
+    // Replies lost because the ring was full (the probes time out and retry)
+    uint32_t getDropped();
+
+private:
+    struct Probe {
+        uint32_t target;          // Network order, 0 = free slot
+        uint16_t port;
+        uint8_t attempts;         // SYNs sent so far
+        bool sent;                // Waiting on a reply
+        unsigned long sentAt;
+        unsigned long timeout;
+    };
+
+    // TCP header fields of a segment addressed to our source port
+    struct Reply {
+        uint32_t source;          // Network order
+        uint16_t sourcePort;
+        uint32_t ack;
+        uint8_t flags;
+        unsigned long receivedAt;
+    };
+
+    struct raw_pcb* pcb;
+    Probe probes[SYN_SCAN_SLOTS];
+    size_t used;
+    unsigned long pacerWait;
+    uint32_t secret;
+
+    // Source port of the current session; 0 while idle, so the receive
+    // hook ignores everything between scans
+    volatile uint16_t listenPort;
+
+    // Filled by the lwIP thread, drained by poll()
+    Reply ring[SYN_REPLY_RING];
+    size_t ringHead;
+    size_t ringCount;
+    uint32_t dropped;
+    portMUX_TYPE lock;
+    SemaphoreHandle_t replySignal;
+
+    // Sequence number of the SYN to (target, port); replies must ack it + 1
+    uint32_t cookie(uint32_t target, uint16_t port);
+
+    void sendQueued(PortProbeCallback& callback);
+    void drainReplies(PortProbeCallback& callback);
+    void expireProbes(PortProbeCallback& callback);
+    void finish(Probe& probe, PortState state, unsigned long responseTime, PortProbeCallback& callback);
+    Probe* findProbe(uint32_t target, uint16_t port);
+
+    // Run in the lwIP thread
+    static err_t openPcb(struct tcpip_api_call_data* data);
+    static err_t sendBatch(struct tcpip_api_call_data* data);
+    static u8_t receive(void* arg, struct raw_pcb* pcb, struct pbuf* p, const ip_addr_t* addr);
+};
+
+#endif // SYN_SCANNER_H
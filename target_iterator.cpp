@@ -0,0 +1,319 @@
+/*
+ * Target Iterator Implementation
+ * Streams scan targets from CIDR lists in a pseudo-random order
+ */
+
+#include "target_iterator.h"
+#include "net_utils.h"
+
+TargetIterator::TargetIterator() {
+    clear();
+}
+
+void TargetIterator::clear() {
+    includeCount = 0;
+    excludeCount = 0;
+    indexSpace = 0;
+    excludedCount = 0;
+    lastError = "";
+    mask = 0;
+    multiplier = 1;
+    increment = 1;
+    state = 0;
+    stepsLeft = 0;
+    bits = 0;
+    emitted = 0;
+}
+
+bool TargetIterator::addRange(IPAddress first, IPAddress last) {
+    uint32_t from = ipToHost(first);
+    uint32_t to = ipToHost(last);
+
+    if (from > to) {
+        lastError = "Range start is after range end: " + first.toString();
+        return false;
+    }
+    if (includeCount >= TARGET_MAX_RANGES) {
+        lastError = "Too many target ranges (max " + String(TARGET_MAX_RANGES) + ")";
+        return false;
+    }
+    if (overlaps(includes, includeCount, from, to)) {
+        lastError = "Target ranges overlap at " + first.toString();
+        return false;
+    }
+
+    includes[includeCount].first = from;
+    includes[includeCount].last = to;
+    includeCount++;
+    recount();
+    return true;
+}
+
+bool TargetIterator::addCidr(IPAddress network, uint8_t prefixLength) {
+    if (prefixLength < TARGET_MIN_PREFIX || prefixLength > 32) {
+        lastError = "Prefix length must be between /" + String(TARGET_MIN_PREFIX) + " and /32";
+        return false;
+    }
+
+    uint32_t hostMask = (prefixLength == 32) ? 0 : ((1UL << (32 - prefixLength)) - 1);
+
+    uint32_t first = ipToHost(network) & ~hostMask;
+    uint32_t last = first | hostMask;
+
+    // Network and broadcast addresses are not hosts, except on /31 and /32
+    if (prefixLength <= 30) {
+        first++;
+        last--;
+    }
+
+    return addRange(hostToIP(first), hostToIP(last));
+}
+
+bool TargetIterator::addExclude(IPAddress first, IPAddress last) {
+    uint32_t from = ipToHost(first);
+    uint32_t to = ipToHost(last);
+
+    if (from > to) {
+        lastError = "Exclusion start is after exclusion end: " + first.toString();
+        return false;
+    }
+    if (excludeCount >= TARGET_MAX_RANGES) {
+        lastError = "Too many exclusions (max " + String(TARGET_MAX_RANGES) + ")";
+        return false;
+    }
+    if (overlaps(excludes, excludeCount, from, to)) {
+        lastError = "Exclusions overlap at " + first.toString();
+        return false;
+    }
+
+    excludes[excludeCount].first = from;
+    excludes[excludeCount].last = to;
+    excludeCount++;
+    recount();
+    return true;
+}
+
+bool TargetIterator::parse(const String& includeSpec, const String& excludeSpec) {
+    clear();
+
+    if (!parseList(includeSpec, false) || !parseList(excludeSpec, true)) {
+        return false;
+    }
+
+    if (includeCount == 0) {
+        lastError = "No targets given";
+        return false;
+    }
+
+    return true;
+}
+
+String TargetIterator::getLastError() {
+    return lastError;
+}
+
+void TargetIterator::start(uint32_t seed) {
+    bits = 0;
+    while (bits < 32 && (1ULL << bits) < indexSpace) {
+        bits++;
+    }
+    mask = (1ULL << bits) - 1;
+
+    // Hull-Dobell: with a power-of-two modulus the LCG has full period
+    // when the increment is odd and the multiplier is 1 mod 4
+    multiplier = ((((uint64_t)seed * 2654435761UL) << 2) | 1) & mask;
+    if (multiplier <= 1 && bits >= 3) {
+        multiplier = 5;
+    }
+    increment = (((uint64_t)(seed >> 7) * 40503UL) | 1) & mask;
+    if (bits == 0) {
+        multiplier = 1;
+        increment = 0;
+    }
+
+    state = seed & mask;
+    stepsLeft = mask + 1;
+    emitted = 0;
+
+    if (indexSpace == 0) {
+        stepsLeft = 0;
+    }
+}
+
+bool TargetIterator::next(IPAddress& ip) {
+    while (stepsLeft > 0) {
+        state = (multiplier * state + increment) & mask;
+        stepsLeft--;
+
+        // Cycle-walk: states beyond the real index space are skipped
+        uint64_t index = scramble(state);
+        if (index >= indexSpace) {
+            continue;
+        }
+
+        uint32_t address = addressAt(index);
+        if (isExcluded(address)) {
+            continue;
+        }
+
+        emitted++;
+        ip = hostToIP(address);
+        return true;
+    }
+
+    return false;
+}
+
+bool TargetIterator::contains(IPAddress ip) {
+    uint32_t address = ipToHost(ip);
+    for (size_t i = 0; i < includeCount; i++) {
+        if (address >= includes[i].first && address <= includes[i].last) {
+            return !isExcluded(address);
+        }
+    }
+    return false;
+}
+
+uint32_t TargetIterator::getTargetCount() {
+    return (uint32_t)(indexSpace - excludedCount);
+}
+
+uint32_t TargetIterator::getEmitted() {
+    return emitted;
+}
+
+size_t TargetIterator::getRangeCount() {
+    return includeCount;
+}
+
+bool TargetIterator::getRange(size_t index, IPAddress& first, IPAddress& last) {
+    if (index >= includeCount) {
+        return false;
+    }
+
+    first = hostToIP(includes[index].first);
+    last = hostToIP(includes[index].last);
+    return true;
+}
+
+uint32_t TargetIterator::addressAt(uint64_t index) {
+    for (size_t i = includeCount; i-- > 0;) {
+        if (index >= offsets[i]) {
+            return includes[i].first + (uint32_t)(index - offsets[i]);
+        }
+    }
+    return includes[0].first;
+}
+
+uint64_t TargetIterator::scramble(uint64_t value) {
+    // Multiplying by an odd constant and xor-shifting right are both
+    // bijections on a 2^bits space, so the permutation stays complete
+    value = (value * 0x9E3779B1ULL) & mask;
+    value ^= value >> ((bits + 1) / 2);
+    return value & mask;
+}
+
+bool TargetIterator::isExcluded(uint32_t address) {
+    for (size_t i = 0; i < excludeCount; i++) {
+        if (address >= excludes[i].first && address <= excludes[i].last) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TargetIterator::overlaps(const TargetRange* ranges, size_t count, uint32_t first, uint32_t last) {
+    for (size_t i = 0; i < count; i++) {
+        if (first <= ranges[i].last && last >= ranges[i].first) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TargetIterator::parseList(const String& spec, bool exclude) {
+    int start = 0;
+    int length = spec.length();
+
+    while (start < length) {
+        int end = start;
+        while (end < length && spec[end] != ',' && spec[end] != ' ' && spec[end] != '\n') {
+            end++;
+        }
+
+        if (end > start) {
+            String entry = spec.substring(start, end);
+            entry.trim();
+            if (entry.length() > 0 && !parseEntry(entry, exclude)) {
+                return false;
+            }
+        }
+
+        start = end + 1;
+    }
+
+    return true;
+}
+
+bool TargetIterator::parseEntry(const String& entry, bool exclude) {
+    IPAddress first;
+    IPAddress last;
+    int slash = entry.indexOf('/');
+    int dash = entry.indexOf('-');
+
+    if (slash >= 0) {
+        if (!first.fromString(entry.substring(0, slash))) {
+            lastError = "Invalid address: " + entry;
+            return false;
+        }
+
+        int prefixLength = entry.substring(slash + 1).toInt();
+        if (exclude) {
+            // Exclusions cover the whole block, network and broadcast included
+            if (prefixLength < 0 || prefixLength > 32) {
+                lastError = "Invalid prefix: " + entry;
+                return false;
+            }
+            uint32_t hostMask = (prefixLength == 0) ? 0xFFFFFFFF :
+                                (prefixLength == 32) ? 0 : ((1UL << (32 - prefixLength)) - 1);
+            uint32_t base = ipToHost(first) & ~hostMask;
+            return addExclude(hostToIP(base), hostToIP(base | hostMask));
+        }
+        return addCidr(first, (uint8_t)prefixLength);
+    }
+
+    if (dash >= 0) {
+        if (!first.fromString(entry.substring(0, dash)) ||
+            !last.fromString(entry.substring(dash + 1))) {
+            lastError = "Invalid range: " + entry;
+            return false;
+        }
+    } else {
+        if (!first.fromString(entry)) {
+            lastError = "Invalid address: " + entry;
+            return false;
+        }
+        last = first;
+    }
+
+    return exclude ? addExclude(first, last) : addRange(first, last);
+}
+
+void TargetIterator::recount() {
+    indexSpace = 0;
+    for (size_t i = 0; i < includeCount; i++) {
+        offsets[i] = (uint32_t)indexSpace;
+        indexSpace += (uint64_t)(includes[i].last - includes[i].first) + 1;
+    }
+
+    excludedCount = 0;
+    for (size_t e = 0; e < excludeCount; e++) {
+        for (size_t i = 0; i < includeCount; i++) {
+            uint32_t from = (excludes[e].first > includes[i].first) ? excludes[e].first : includes[i].first;
+            uint32_t to = (excludes[e].last < includes[i].last) ? excludes[e].last : includes[i].last;
+            if (from <= to) {
+                excludedCount += (to - from) + 1;
+            }
+        }
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * Target Iterator Header
+ * Streams scan targets from CIDR lists in a pseudo-random order
+ */
+
+#ifndef TARGET_ITERATOR_H
+#define TARGET_ITERATOR_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include "config.h"
+
+struct TargetRange {
+    uint32_t first;           // Host order, inclusive
+    uint32_t last;            // Host order, inclusive
+};
+
+class TargetIterator {
+public:
+    TargetIterator();
+
+    // Remove all ranges
+    void clear();
+
+    // Add targets; ranges may not overlap each other
+    bool addRange(IPAddress first, IPAddress last);
+    bool addCidr(IPAddress network, uint8_t prefixLength);
+
+    // Add addresses to skip; exclusions may not overlap each other
+    bool addExclude(IPAddress first, IPAddress last);
+
+    // Parse comma/space separated lists of "a.b.c.d", "a.b.c.d/nn" or
+    // "a.b.c.d-e.f.g.h"; returns false and leaves the error in lastError
+    bool parse(const String& includeSpec, const String& excludeSpec);
+    String getLastError();
+
+    // Begin a new pass over the targets in a seed-dependent order
+    void start(uint32_t seed);
+
+    // Produce the next target; returns false once every target was visited
+    bool next(IPAddress& ip);
+
+    // True if ip is in an include and not excluded
+    bool contains(IPAddress ip);
+
+    // Counts for progress reporting
+    uint32_t getTargetCount();   // Addresses that will be emitted
+    uint32_t getEmitted();       // Addresses emitted so far
+    size_t getRangeCount();
+    bool getRange(size_t index, IPAddress& first, IPAddress& last);
+
+private:
+    TargetRange includes[TARGET_MAX_RANGES];
+    TargetRange excludes[TARGET_MAX_RANGES];
+    uint32_t offsets[TARGET_MAX_RANGES];   // Index of each include's first address
+    size_t includeCount;
+    size_t excludeCount;
+    uint64_t indexSpace;                   // Sum of include sizes
+    uint32_t excludedCount;                // Include addresses covered by exclusions
+    String lastError;
+
+    // Full-period LCG over 2^bits states, cycle-walked down to indexSpace
+    uint64_t mask;
+    uint64_t multiplier;
+    uint64_t increment;
+    uint64_t state;
+    uint64_t stepsLeft;
+    uint8_t bits;
+    uint32_t emitted;
+
+    // Map an index in [0, indexSpace) to its address
+    uint32_t addressAt(uint64_t index);
+
+    // Bijective mix of an LCG state so neighbouring states scatter
+    uint64_t scramble(uint64_t value);
+
+    bool isExcluded(uint32_t address);
+    bool overlaps(const TargetRange* ranges, size_t count, uint32_t first, uint32_t last);
+    bool parseList(const String& spec, bool exclude);
+    bool parseEntry(const String& entry, bool exclude);
+    void recount();
+};
+
+#endif // TARGET_ITERATOR_H
@@ -0,0 +1,285 @@
+/*
+ * Sweep engine benchmark against a simulated /24
+ *
+ * ConnectPool is replaced by a model of the network: every host answers
+ * (or stays silent) after a fixed delay, on a virtual clock, so minutes of
+ * connect timeouts run in milliseconds. The real SweepEngine, ProbePacer,
+ * RttEstimator and TargetIterator drive it. Reports hosts/s in simulated
+ * time for one probe in flight (the old serial loop) and for the pool
+ * sizes the sweep uses, and checks that every host is reported once.
+ */
+
+#include "host_test.h"
+#include "sweep_engine.h"
+#include "probe_pacer.h"
+#include "rtt_estimator.h"
+#include "net_utils.h"
+#include <ETH.h>
+#include <map>
+
+// How a simulated host treats a connect to port
+enum SimAnswer {
+    SIM_OPEN,
+    SIM_REFUSED,
+    SIM_SILENT
+};
+
+static const IPAddress SIM_NETWORK(10, 20, 30, 0);
+static const unsigned long SIM_RTT_BASE = 2;
+
+// Every fourth host serves HTTP, every fourth refuses it, one in eight
+// only answers on 443 and the rest are not there
+static SimAnswer simAnswer(IPAddress host, uint16_t port) {
+    uint8_t id = host[3];
+    if (id % 4 == 0) {
+        return port == 80 ? SIM_OPEN : SIM_SILENT;
+    }
+    if (id % 4 == 1) {
+        return SIM_REFUSED;
+    }
+    if (id % 8 == 2) {
+        return port == 443 ? SIM_OPEN : SIM_SILENT;
+    }
+    return SIM_SILENT;
+}
+
+static bool simAlive(IPAddress host) {
+    uint8_t id = host[3];
+    return id % 4 == 0 || id % 4 == 1 || id % 8 == 2;
+}
+
+static unsigned long simRtt(IPAddress host) {
+    return SIM_RTT_BASE + host[3] % 7;
+}
+
+// Sockets are held outside the sweep until this time
+static unsigned long simSocketsFreeAt = 0;
+static size_t simMaxInFlight = 0;
+
+ConnectPool::ConnectPool() {
+    activeCount = 0;
+}
+
+ConnectPool::~ConnectPool() {
+}
+
+void ConnectPool::begin(size_t maxSlots) {
+    slots.assign(maxSlots, Slot());
+    for (auto& slot : slots) {
+        slot.active = false;
+    }
+    activeCount = 0;
+}
+
+bool ConnectPool::submit(IPAddress target, uint16_t port, unsigned long timeout,
+                         uint32_t tag, bool keepOpen) {
+    if (millis() < simSocketsFreeAt) {
+        return false;
+    }
+
+    for (auto& slot : slots) {
+        if (!slot.active) {
+            slot.active = true;
+            slot.fd = -1;
+            slot.target = target;
+            slot.port = port;
+            slot.tag = tag;
+            slot.keepOpen = keepOpen;
+            slot.startTime = millis();
+            slot.timeout = timeout;
+            activeCount++;
+            simMaxInFlight = std::max(simMaxInFlight, activeCount);
+            return true;
+        }
+    }
+    return false;
+}
+
+int ConnectPool::poll(unsigned long waitMs, ConnectCallback callback) {
+    // Sleep until the first answer or deadline, as select() would
+    unsigned long now = millis();
+    unsigned long wake = now + waitMs;
+    for (auto& slot : slots) {
+        if (slot.active) {
+            unsigned long due = slot.startTime + (simAnswer(slot.target, slot.port) == SIM_SILENT ?
+                                                  slot.timeout : simRtt(slot.target));
+            wake = std::min(wake, std::max(due, now));
+        }
+    }
+    hostAdvanceClock(wake - now);
+    now = wake;
+
+    int completed = 0;
+    for (auto& slot : slots) {
+        if (!slot.active) {
+            continue;
+        }
+
+        SimAnswer answer = simAnswer(slot.target, slot.port);
+        ConnectCompletion completion;
+        completion.target = slot.target;
+        completion.port = slot.port;
+        completion.tag = slot.tag;
+        completion.fd = -1;
+        completion.responseTime = now - slot.startTime;
+        if (answer != SIM_SILENT && completion.responseTime >= simRtt(slot.target)) {
+            completion.outcome = answer == SIM_OPEN ? CONNECT_OPEN : CONNECT_REFUSED;
+        } else if (completion.responseTime >= slot.timeout) {
+            completion.outcome = CONNECT_TIMEOUT;
+        } else {
+            continue;
+        }
+
+        slot.active = false;
+        activeCount--;
+        completed++;
+        if (callback) {
+            callback(completion);
+        }
+    }
+    return completed;
+}
+
+void ConnectPool::cancelAll() {
+    for (auto& slot : slots) {
+        slot.active = false;
+    }
+    activeCount = 0;
+}
+
+bool ConnectPool::hasFreeSlot() {
+    return activeCount < slots.size();
+}
+
+size_t ConnectPool::inFlight() {
+    return activeCount;
+}
+
+size_t ConnectPool::capacity() {
+    return slots.size();
+}
+
+struct SweepRun {
+    uint32_t reported;
+    uint32_t alive;
+    uint32_t duplicates;
+    uint32_t wrong;
+    uint32_t unprobed;
+    unsigned long elapsed;
+    float hostsPerSecond;
+};
+
+static SweepRun runSweep(size_t inFlight, const PacerSettings& pacer, unsigned long socketsHeldFor = 0) {
+    // Let the pacer's bucket fill up again between runs
+    hostAdvanceClock(10000);
+    simSocketsFreeAt = socketsHeldFor == (unsigned long)-1 ? socketsHeldFor : millis() + socketsHeldFor;
+    probePacer.configure(pacer);
+    rttEstimator.reset();
+    simMaxInFlight = 0;
+
+    TargetIterator targets;
+    targets.addCidr(SIM_NETWORK, 24);
+    targets.start(1);
+
+    SweepEngine engine;
+    engine.begin(inFlight);
+    engine.start(&targets);
+
+    SweepRun run;
+    memset(&run, 0, sizeof(run));
+    std::map<uint32_t, int> seen;
+    SweepCallback onHost = [&](IPAddress host, bool alive, unsigned long) {
+        run.reported++;
+        if (++seen[(uint32_t)host] > 1) {
+            run.duplicates++;
+        }
+        if (alive) {
+            run.alive++;
+        }
+        if (alive != simAlive(host) && engine.getUnprobedCount() == 0) {
+            run.wrong++;
+        }
+    };
+
+    while (engine.poll(onHost)) {
+    }
+
+    run.unprobed = engine.getUnprobedCount();
+    run.elapsed = engine.getElapsed();
+    run.hostsPerSecond = engine.getHostsPerSecond();
+    CHECK_EQ(engine.getCompleted(), engine.getTotal());
+    CHECK(simMaxInFlight <= inFlight);
+    return run;
+}
+
+static uint32_t expectedAlive() {
+    uint32_t alive = 0;
+    for (int id = 1; id < 255; id++) {
+        IPAddress host(10, 20, 30, id);
+        if (host != ETH.localIP() && simAlive(host)) {
+            alive++;
+        }
+    }
+    return alive;
+}
+
+int main() {
+    hostUseVirtualClock(true);
+    ETH.address = IPAddress(10, 20, 30, 1);
+
+    PacerSettings scanDefaults = {PACER_PROBES_PER_SECOND, PACER_HOST_CONCURRENCY, PACER_HOST_GAP};
+    PacerSettings unpaced = {0, 0, 0};
+
+    // The sweep's own address is skipped without a report
+    uint32_t hosts = 253;
+
+    printf("Simulated /24: %u hosts, %u alive, RTT %lu-%lu ms, silent hosts time out\n",
+           hosts, expectedAlive(), SIM_RTT_BASE, SIM_RTT_BASE + 6);
+    printf("%-10s %-8s %10s %10s %8s\n", "in flight", "pacer", "sim ms", "hosts/s", "alive");
+
+    float serial = 0;
+    float pooled = 0;
+    const size_t sizes[] = {1, MAX_CONCURRENT_SCANS, 16};
+    for (size_t inFlight : sizes) {
+        for (int paced = 1; paced >= 0; paced--) {
+            SweepRun run = runSweep(inFlight, paced ? scanDefaults : unpaced);
+            printf("%-10u %-8s %10lu %10.1f %8u\n", (unsigned)inFlight, paced ? "default" : "off",
+                   run.elapsed, run.hostsPerSecond, run.alive);
+
+            CHECK_EQ(run.reported, hosts);
+            CHECK_EQ(run.duplicates, 0);
+            CHECK_EQ(run.wrong, 0);
+            CHECK_EQ(run.alive, expectedAlive());
+            CHECK_EQ(run.unprobed, 0);
+
+            if (paced && inFlight == 1) {
+                serial = run.hostsPerSecond;
+            } else if (paced && inFlight == MAX_CONCURRENT_SCANS) {
+                pooled = run.hostsPerSecond;
+            }
+        }
+    }
+
+    // The pool has to beat the serial loop it replaced
+    CHECK(pooled > 2 * serial);
+
+    // Sockets held elsewhere for a while: hosts wait, none is lost
+    SweepRun held = runSweep(MAX_CONCURRENT_SCANS, scanDefaults, SWEEP_SOCKET_BACKOFF * 5);
+    printf("sockets held for %d ms: %u reported, %u alive, %u unprobed\n",
+           SWEEP_SOCKET_BACKOFF * 5, held.reported, held.alive, held.unprobed);
+    CHECK_EQ(held.reported, hosts);
+    CHECK_EQ(held.duplicates, 0);
+    CHECK_EQ(held.alive, expectedAlive());
+    CHECK_EQ(held.unprobed, 0);
+
+    // Sockets never come back: every host is still reported, as unprobed
+    SweepRun starved = runSweep(MAX_CONCURRENT_SCANS, scanDefaults, (unsigned long)-1);
+    printf("no sockets at all: %u reported, %u alive, %u unprobed\n",
+           starved.reported, starved.alive, starved.unprobed);
+    CHECK_EQ(starved.reported, hosts);
+    CHECK_EQ(starved.duplicates, 0);
+    CHECK_EQ(starved.alive, 0);
+    CHECK_EQ(starved.unprobed, hosts);
+
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,37 @@
+/*
+ * Minimal checks for the host tests: failures are counted and printed,
+ * and HOST_TEST_RESULT() turns the count into the exit status
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <cstdio>
+
+static int hostTestChecks = 0;
+static int hostTestFailures = 0;
+
+#define CHECK(condition) do { \
+        hostTestChecks++; \
+        if (!(condition)) { \
+            hostTestFailures++; \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+        hostTestChecks++; \
+        long long actualValue = (long long)(actual); \
+        long long expectedValue = (long long)(expected); \
+        if (actualValue != expectedValue) { \
+            hostTestFailures++; \
+            fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", \
+                    __FILE__, __LINE__, #actual, #expected, actualValue, expectedValue); \
+        } \
+    } while (0)
+
+#define HOST_TEST_RESULT() ( \
+        printf("%s: %d checks, %d failed\n", __FILE__, hostTestChecks, hostTestFailures), \
+        hostTestFailures == 0 ? 0 : 1)
+
+#endif // HOST_TEST_H
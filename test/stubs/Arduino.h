@@ -0,0 +1,145 @@
+/*
+ * Host stand-in for the parts of the Arduino core the sketch uses, so its
+ * modules can be built with a desktop g++ (see validate_code.py)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cstdarg>
+#include <string>
+#include <algorithm>
+#include <functional>
+
+typedef uint8_t byte;
+
+class String {
+public:
+    String() {}
+    String(const char* text) : s(text ? text : "") {}
+    String(const std::string& text) : s(text) {}
+    String(char c) : s(1, c) {}
+    String(int v) : s(std::to_string(v)) {}
+    String(unsigned v) : s(std::to_string(v)) {}
+    String(long v) : s(std::to_string(v)) {}
+    String(unsigned long v) : s(std::to_string(v)) {}
+    String(long long v) : s(std::to_string(v)) {}
+    String(unsigned long long v) : s(std::to_string(v)) {}
+    String(float v, unsigned decimals = 2) { format(v, decimals); }
+    String(double v, unsigned decimals = 2) { format(v, decimals); }
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned length() const { return s.size(); }
+    bool isEmpty() const { return s.empty(); }
+    bool reserve(unsigned n) { s.reserve(n); return true; }
+    bool concat(const char* text, unsigned n) { s.append(text, n); return true; }
+
+    String& operator+=(const String& o) { s += o.s; return *this; }
+    String& operator+=(const char* o) { s += o; return *this; }
+    String& operator+=(char o) { s += o; return *this; }
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend String operator+(const String& a, const char* b) { return String(a.s + b); }
+    friend String operator+(const char* a, const String& b) { return String(a + b.s); }
+    bool operator==(const String& o) const { return s == o.s; }
+    bool operator==(const char* o) const { return s == o; }
+    bool operator!=(const String& o) const { return s != o.s; }
+    bool operator!=(const char* o) const { return s != o; }
+    bool operator<(const String& o) const { return s < o.s; }
+
+    char operator[](unsigned i) const { return s[i]; }
+    char charAt(unsigned i) const { return s[i]; }
+    int indexOf(char c, unsigned from = 0) const { return found(s.find(c, from)); }
+    int indexOf(const char* text, unsigned from = 0) const { return found(s.find(text, from)); }
+    int indexOf(const String& text, unsigned from = 0) const { return found(s.find(text.s, from)); }
+    int lastIndexOf(char c) const { return found(s.rfind(c)); }
+    String substring(unsigned from) const { return from < s.size() ? String(s.substr(from)) : String(); }
+    String substring(unsigned from, unsigned to) const { return from < s.size() && to > from ? String(s.substr(from, to - from)) : String(); }
+    bool startsWith(const String& prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+    bool endsWith(const String& suffix) const { return s.size() >= suffix.s.size() && s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0; }
+    bool equalsIgnoreCase(const String& o) const { return strcasecmp(s.c_str(), o.s.c_str()) == 0; }
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return (float)atof(s.c_str()); }
+    void trim();
+    void toLowerCase() { for (auto& c : s) c = (char)tolower((unsigned char)c); }
+    void toUpperCase() { for (auto& c : s) c = (char)toupper((unsigned char)c); }
+    void replace(const String& from, const String& to);
+
+private:
+    std::string s;
+
+    static int found(size_t at) { return at == std::string::npos ? -1 : (int)at; }
+    void format(double v, unsigned decimals) { char b[32]; snprintf(b, sizeof(b), "%.*f", (int)decimals, v); s = b; }
+};
+
+inline void String::trim() {
+    size_t first = s.find_first_not_of(" \t\r\n");
+    size_t last = s.find_last_not_of(" \t\r\n");
+    s = first == std::string::npos ? std::string() : s.substr(first, last - first + 1);
+}
+
+inline void String::replace(const String& from, const String& to) {
+    if (from.s.empty()) {
+        return;
+    }
+    for (size_t at = s.find(from.s); at != std::string::npos; at = s.find(from.s, at + to.s.size())) {
+        s.replace(at, from.s.size(), to.s);
+    }
+}
+
+// Serial output is dropped; tests report through stdio
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t) { return 1; }
+    virtual size_t write(const uint8_t*, size_t n) { return n; }
+    size_t print(const String&) { return 0; }
+    size_t print(const char*) { return 0; }
+    size_t print(int) { return 0; }
+    size_t println(const String& = String()) { return 0; }
+    size_t println(const char*) { return 0; }
+    size_t println(int) { return 0; }
+    size_t printf(const char*, ...) { return 0; }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    String readStringUntil(char) { return String(); }
+};
+
+class HardwareSerial : public Stream {
+public:
+    void begin(long) {}
+};
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 0; }
+    uint32_t getMinFreeHeap() { return 0; }
+    uint32_t getMaxAllocHeap() { return 0; }
+    void restart() {}
+};
+extern EspClass ESP;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+uint32_t esp_random();
+
+// Switch millis() and delay() to a clock that only moves when told to,
+// so a benchmark can simulate minutes of timeouts in milliseconds
+void hostUseVirtualClock(bool enable);
+void hostAdvanceClock(unsigned long ms);
+
+#define PROGMEM
+#define F(x) x
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+inline bool isDigit(int c) { return c >= '0' && c <= '9'; }
+
+#include "IPAddress.h"
@@ -0,0 +1,448 @@
+/*
+ * Host stand-in for the part of ArduinoJson 6 the web interface uses.
+ * Documents hold a real tree in a fixed pool, allocated once like the
+ * library's, and serialize to the same compact text, so responses built
+ * with it can be compared byte for byte. Parsing is not supported: every
+ * deserializeJson() fails.
+ */
+
+#pragma once
+
+#include "Arduino.h"
+#include <cstddef>
+#include <type_traits>
+
+enum JsonType : uint8_t {
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_INT,
+    JSON_UINT,
+    JSON_FLOAT,
+    JSON_STRING,
+    JSON_OBJECT,
+    JSON_ARRAY
+};
+
+struct JsonNode {
+    JsonType type;
+    const char* key;          // Member name; nullptr in arrays
+    JsonNode* next;           // Next member or element
+    union {
+        bool b;
+        long long i;
+        unsigned long long u;
+        double f;
+        const char* s;
+        struct {
+            JsonNode* head;
+            JsonNode* tail;
+        } children;
+    };
+};
+
+#define JSON_OBJECT_SIZE(n) ((n) * sizeof(JsonNode))
+#define JSON_ARRAY_SIZE(n) ((n) * sizeof(JsonNode))
+
+// Bump allocator over the document's buffer; running out marks it
+// overflowed and drops the value, as the library does. Strings are packed
+// unaligned, so a document sized for the library fits here too
+struct JsonPool {
+    char* base = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    bool overflow = false;
+
+    void* alloc(size_t n, size_t align) {
+        size_t start = (used + align - 1) & ~(align - 1);
+        if (start + n > capacity) {
+            overflow = true;
+            return nullptr;
+        }
+        used = start + n;
+        return base + start;
+    }
+
+    JsonNode* node() {
+        JsonNode* n = (JsonNode*)alloc(sizeof(JsonNode), alignof(JsonNode));
+        if (n) {
+            memset(n, 0, sizeof(*n));
+        }
+        return n;
+    }
+
+    const char* copy(const char* text) {
+        size_t length = strlen(text);
+        char* p = (char*)alloc(length + 1, 1);
+        if (p) {
+            memcpy(p, text, length + 1);
+        }
+        return p;
+    }
+};
+
+class JsonObject;
+class JsonArray;
+
+class JsonVariant {
+public:
+    JsonVariant() {}
+    JsonVariant(JsonPool* pool, JsonNode* node) : pool(pool), node(node) {}
+
+    // Literal strings are kept by pointer, anything else is copied
+    JsonVariant& operator=(const char* text) { setString(text, false); return *this; }
+    JsonVariant& operator=(char* text) { setString(text, true); return *this; }
+    JsonVariant& operator=(const String& text) { setString(text.c_str(), true); return *this; }
+    JsonVariant& operator=(bool v) { if (node) { node->type = JSON_BOOL; node->b = v; } return *this; }
+    JsonVariant& operator=(float v) { if (node) { node->type = JSON_FLOAT; node->f = v; } return *this; }
+    JsonVariant& operator=(double v) { if (node) { node->type = JSON_FLOAT; node->f = v; } return *this; }
+
+    template<typename T,
+             typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+    JsonVariant& operator=(T v) {
+        if (node && std::is_signed<T>::value) {
+            node->type = JSON_INT;
+            node->i = v;
+        } else if (node) {
+            node->type = JSON_UINT;
+            node->u = v;
+        }
+        return *this;
+    }
+
+    JsonVariant(const JsonVariant&) = default;
+    JsonVariant& operator=(const JsonVariant& other) {
+        if (node && other.node) {
+            JsonNode* next = node->next;
+            const char* key = node->key;
+            *node = *other.node;
+            node->next = next;
+            node->key = key;
+        }
+        return *this;
+    }
+
+    // Members are created on first use, turning a null value into an object.
+    // Like values, literal names are kept by pointer and Strings copied
+    JsonVariant operator[](const char* key) const { return JsonVariant(pool, member(key, false)); }
+    JsonVariant operator[](const String& key) const { return JsonVariant(pool, member(key.c_str(), true)); }
+
+    JsonArray createNestedArray(const char* key = nullptr) const;
+    JsonObject createNestedObject(const char* key = nullptr) const;
+
+    template<typename T> T as() const;
+    template<typename T> T to() const;
+    template<typename T> T operator|(const T& fallback) const { return isNull() ? fallback : as<T>(); }
+    String operator|(const char* fallback) const;
+
+    bool isNull() const { return !node || node->type == JSON_NULL; }
+
+    JsonPool* pool = nullptr;
+    JsonNode* node = nullptr;
+
+    // Tree building, shared by the classes below
+    void setString(const char* text, bool copy) {
+        if (!node) {
+            return;
+        }
+        if (text && copy) {
+            text = pool->copy(text);
+        }
+        node->type = text ? JSON_STRING : JSON_NULL;
+        node->s = text;
+    }
+
+    JsonNode* append(const char* key) const {
+        if (!node || !pool) {
+            return nullptr;
+        }
+        JsonNode* n = pool->node();
+        if (!n) {
+            return nullptr;
+        }
+        n->key = key;
+        if (!node->children.head) {
+            node->children.head = n;
+        } else {
+            node->children.tail->next = n;
+        }
+        node->children.tail = n;
+        return n;
+    }
+
+    JsonNode* member(const char* key, bool copy) const {
+        if (!node) {
+            return nullptr;
+        }
+        if (node->type == JSON_NULL) {
+            reset(JSON_OBJECT);
+        }
+        if (node->type != JSON_OBJECT) {
+            return nullptr;
+        }
+        for (JsonNode* n = node->children.head; n; n = n->next) {
+            if (strcmp(n->key, key) == 0) {
+                return n;
+            }
+        }
+        const char* name = copy ? pool->copy(key) : key;
+        return name ? append(name) : nullptr;
+    }
+
+    JsonNode* reset(JsonType type) const {
+        if (node) {
+            node->type = type;
+            node->children.head = nullptr;
+            node->children.tail = nullptr;
+        }
+        return node;
+    }
+};
+
+class JsonObject : public JsonVariant {
+public:
+    JsonObject() {}
+    JsonObject(JsonPool* pool, JsonNode* node) : JsonVariant(pool, node) {}
+};
+
+class JsonArray : public JsonVariant {
+public:
+    JsonArray() {}
+    JsonArray(JsonPool* pool, JsonNode* node) : JsonVariant(pool, node) {}
+
+    template<typename T> bool add(const T& v) {
+        JsonNode* n = append(nullptr);
+        if (!n) {
+            return false;
+        }
+        JsonVariant(pool, n) = v;
+        return true;
+    }
+
+    JsonObject createNestedObject() const {
+        JsonVariant element(pool, append(nullptr));
+        return JsonObject(pool, element.reset(JSON_OBJECT));
+    }
+    JsonArray createNestedArray() const {
+        JsonVariant element(pool, append(nullptr));
+        return JsonArray(pool, element.reset(JSON_ARRAY));
+    }
+};
+
+inline JsonArray JsonVariant::createNestedArray(const char* key) const {
+    JsonVariant child(pool, key ? member(key, false) : append(nullptr));
+    return JsonArray(pool, child.reset(JSON_ARRAY));
+}
+
+inline JsonObject JsonVariant::createNestedObject(const char* key) const {
+    JsonVariant child(pool, key ? member(key, false) : append(nullptr));
+    return JsonObject(pool, child.reset(JSON_OBJECT));
+}
+
+template<> inline JsonObject JsonVariant::as<JsonObject>() const {
+    return node && node->type == JSON_OBJECT ? JsonObject(pool, node) : JsonObject();
+}
+template<> inline JsonArray JsonVariant::as<JsonArray>() const {
+    return node && node->type == JSON_ARRAY ? JsonArray(pool, node) : JsonArray();
+}
+template<> inline String JsonVariant::as<String>() const {
+    return node && node->type == JSON_STRING ? String(node->s) : String();
+}
+template<> inline bool JsonVariant::as<bool>() const {
+    return node && node->type == JSON_BOOL && node->b;
+}
+template<> inline int JsonVariant::as<int>() const {
+    if (!node) {
+        return 0;
+    }
+    return node->type == JSON_INT ? (int)node->i : node->type == JSON_UINT ? (int)node->u : 0;
+}
+template<> inline JsonObject JsonVariant::to<JsonObject>() const { return JsonObject(pool, reset(JSON_OBJECT)); }
+template<> inline JsonArray JsonVariant::to<JsonArray>() const { return JsonArray(pool, reset(JSON_ARRAY)); }
+
+inline String JsonVariant::operator|(const char* fallback) const {
+    return isNull() ? String(fallback) : as<String>();
+}
+
+// The root lives in the document; the pool holds everything under it
+class JsonDocument : public JsonVariant {
+public:
+    JsonDocument(const JsonDocument&) = delete;
+    JsonDocument& operator=(const JsonDocument&) = delete;
+
+    void clear() {
+        storage.used = 0;
+        storage.overflow = false;
+        memset(&root, 0, sizeof(root));
+    }
+    size_t memoryUsage() const { return storage.used; }
+    bool overflowed() const { return storage.overflow; }
+
+    template<typename T> T to() {
+        clear();
+        return JsonVariant::to<T>();
+    }
+
+protected:
+    JsonDocument() : JsonVariant(&storage, &root) {
+        clear();
+    }
+
+    JsonPool storage;
+    JsonNode root;
+};
+
+class DynamicJsonDocument : public JsonDocument {
+public:
+    explicit DynamicJsonDocument(size_t capacity) {
+        storage.base = (char*)malloc(capacity);
+        storage.capacity = capacity;
+    }
+    ~DynamicJsonDocument() { free(storage.base); }
+};
+
+template<size_t N>
+class StaticJsonDocument : public JsonDocument {
+public:
+    StaticJsonDocument() {
+        storage.base = buffer;
+        storage.capacity = N;
+    }
+
+private:
+    char buffer[N];
+};
+
+class DeserializationError {
+public:
+    explicit operator bool() const { return true; }
+    const char* c_str() const { return "NotSupported"; }
+};
+
+template<typename Source>
+DeserializationError deserializeJson(JsonDocument&, Source&) { return DeserializationError(); }
+
+// Serialization writes to any of these sinks
+class JsonWriter {
+public:
+    virtual ~JsonWriter() {}
+    virtual void write(const char* text, size_t length) = 0;
+
+    void write(const char* text) { write(text, strlen(text)); }
+
+    void string(const char* text) {
+        write("\"", 1);
+        const char* run = text;
+        for (; *text; text++) {
+            char escaped[8];
+            switch (*text) {
+                case '"': strcpy(escaped, "\\\""); break;
+                case '\\': strcpy(escaped, "\\\\"); break;
+                case '\b': strcpy(escaped, "\\b"); break;
+                case '\f': strcpy(escaped, "\\f"); break;
+                case '\n': strcpy(escaped, "\\n"); break;
+                case '\r': strcpy(escaped, "\\r"); break;
+                case '\t': strcpy(escaped, "\\t"); break;
+                default:
+                    if ((unsigned char)*text >= 0x20) {
+                        continue;
+                    }
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", *text);
+            }
+            write(run, text - run);
+            write(escaped);
+            run = text + 1;
+        }
+        write(run, text - run);
+        write("\"", 1);
+    }
+
+    void value(const JsonNode* node) {
+        char number[32];
+        if (!node) {
+            write("null");
+            return;
+        }
+        switch (node->type) {
+            case JSON_NULL: write("null"); break;
+            case JSON_BOOL: write(node->b ? "true" : "false"); break;
+            case JSON_INT: snprintf(number, sizeof(number), "%lld", node->i); write(number); break;
+            case JSON_UINT: snprintf(number, sizeof(number), "%llu", node->u); write(number); break;
+            case JSON_FLOAT: snprintf(number, sizeof(number), "%g", node->f); write(number); break;
+            case JSON_STRING: string(node->s); break;
+            case JSON_OBJECT:
+            case JSON_ARRAY:
+                write(node->type == JSON_OBJECT ? "{" : "[", 1);
+                for (const JsonNode* child = node->children.head; child; child = child->next) {
+                    if (child != node->children.head) {
+                        write(",", 1);
+                    }
+                    if (node->type == JSON_OBJECT) {
+                        string(child->key);
+                        write(":", 1);
+                    }
+                    value(child);
+                }
+                write(node->type == JSON_OBJECT ? "}" : "]", 1);
+                break;
+        }
+    }
+
+    size_t count = 0;
+};
+
+inline size_t serializeJson(const JsonVariant& source, Print& out) {
+    struct Writer : JsonWriter {
+        Print& out;
+        explicit Writer(Print& out) : out(out) {}
+        void write(const char* text, size_t length) override {
+            out.write((const uint8_t*)text, length);
+            count += length;
+        }
+        using JsonWriter::write;
+    } writer(out);
+    writer.value(source.node);
+    return writer.count;
+}
+
+inline size_t serializeJson(const JsonVariant& source, String& out) {
+    struct Writer : JsonWriter {
+        String& out;
+        explicit Writer(String& out) : out(out) {}
+        void write(const char* text, size_t length) override {
+            out.concat(text, length);
+            count += length;
+        }
+        using JsonWriter::write;
+    } writer(out);
+    writer.value(source.node);
+    return writer.count;
+}
+
+// Cut to fit the buffer, which is always terminated
+inline size_t serializeJson(const JsonVariant& source, char* buffer, size_t size) {
+    struct Writer : JsonWriter {
+        char* buffer;
+        size_t size;
+        Writer(char* buffer, size_t size) : buffer(buffer), size(size) {}
+        void write(const char* text, size_t length) override {
+            for (size_t i = 0; i < length && count + 1 < size; i++) {
+                buffer[count++] = text[i];
+            }
+        }
+        using JsonWriter::write;
+    } writer(buffer, size);
+    writer.value(source.node);
+    if (size) {
+        buffer[writer.count] = '\0';
+    }
+    return writer.count;
+}
+
+inline size_t measureJson(const JsonVariant& source) {
+    struct Writer : JsonWriter {
+        void write(const char*, size_t length) override { count += length; }
+        using JsonWriter::write;
+    } writer;
+    writer.value(source.node);
+    return writer.count;
+}
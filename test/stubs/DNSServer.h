@@ -0,0 +1,14 @@
+/*
+ * Host stand-in for the captive portal's DNSServer
+ */
+
+#pragma once
+
+#include "Arduino.h"
+
+class DNSServer {
+public:
+    bool start(uint16_t, const String&, IPAddress) { return true; }
+    void stop() {}
+    void processNextRequest() {}
+};
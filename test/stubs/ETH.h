@@ -0,0 +1,21 @@
+#pragma once
+#include "Arduino.h"
+
+enum { ETH_PHY_LAN8720 };
+enum { ETH_CLOCK_GPIO0_IN };
+
+class ETHClass {
+public:
+    bool begin(int, int, int, int, int, int) { return true; }
+    bool setHostname(const char*) { return true; }
+    IPAddress localIP() { return address; }
+    IPAddress subnetMask() { return mask; }
+    IPAddress gatewayIP() { return IPAddress(); }
+    String macAddress() { return String("00:00:00:00:00:00"); }
+    bool linkUp() { return true; }
+
+    // Set by tests
+    IPAddress address;
+    IPAddress mask;
+};
+extern ETHClass ETH;
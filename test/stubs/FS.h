@@ -0,0 +1,23 @@
+/*
+ * Host stand-in for the Arduino filesystem API: it mounts, but there is
+ * no flash, so no file can be opened
+ */
+
+#pragma once
+
+#include "Arduino.h"
+
+class File : public Stream {
+public:
+    operator bool() const { return false; }
+    void close() {}
+    size_t size() { return 0; }
+};
+
+class FSClass {
+public:
+    bool begin(bool = false) { return true; }
+    File open(const char*, const char* = "r") { return File(); }
+    bool exists(const char*) { return false; }
+    bool remove(const char*) { return false; }
+};
@@ -0,0 +1,32 @@
+/*
+ * Host stand-in for the Arduino IPAddress class (network byte order inside)
+ */
+
+#pragma once
+
+#include <cstdint>
+
+class String;
+
+class IPAddress {
+public:
+    IPAddress() { a.dw = 0; }
+    IPAddress(uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3) { a.b[0] = b0; a.b[1] = b1; a.b[2] = b2; a.b[3] = b3; }
+    IPAddress(uint32_t address) { a.dw = address; }
+
+    operator uint32_t() const { return a.dw; }
+    bool operator==(const IPAddress& o) const { return a.dw == o.a.dw; }
+    bool operator!=(const IPAddress& o) const { return a.dw != o.a.dw; }
+    uint8_t operator[](int i) const { return a.b[i]; }
+    uint8_t& operator[](int i) { return a.b[i]; }
+
+    String toString() const;
+    bool fromString(const char* text);
+    bool fromString(const String& text);
+
+private:
+    union {
+        uint8_t b[4];
+        uint32_t dw;
+    } a;
+};
@@ -0,0 +1,9 @@
+/*
+ * Host stand-in for SPIFFS (see FS.h)
+ */
+
+#pragma once
+
+#include "FS.h"
+
+extern FSClass SPIFFS;
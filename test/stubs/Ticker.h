@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for the ESP32 Ticker: callbacks never fire
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+class Ticker {
+public:
+    void once_ms(uint32_t, std::function<void()>) {}
+};
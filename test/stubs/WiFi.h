@@ -0,0 +1,30 @@
+/*
+ * Host stand-in for the ESP32 WiFi library: the types the sketch's headers
+ * use. Nothing on the host drives the radio, so WiFiClass has no methods
+ */
+
+#pragma once
+
+#include "Arduino.h"
+
+typedef enum {
+    WIFI_AUTH_OPEN,
+    WIFI_AUTH_WEP,
+    WIFI_AUTH_WPA_PSK,
+    WIFI_AUTH_WPA2_PSK,
+    WIFI_AUTH_WPA_WPA2_PSK,
+    WIFI_AUTH_WPA2_ENTERPRISE,
+    WIFI_AUTH_WPA3_PSK,
+    WIFI_AUTH_WPA2_WPA3_PSK,
+    WIFI_AUTH_WAPI_PSK,
+    WIFI_AUTH_MAX
+} wifi_auth_mode_t;
+
+typedef int WiFiEvent_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+class WiFiClass {
+};
+extern WiFiClass WiFi;
@@ -0,0 +1,7 @@
+/*
+ * Host stand-in for WiFiAP.h (declared in WiFi.h)
+ */
+
+#pragma once
+
+#include "WiFi.h"
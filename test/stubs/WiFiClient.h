@@ -0,0 +1,16 @@
+/*
+ * Host stand-in for the Arduino WiFiClient (declarations only)
+ */
+
+#pragma once
+
+#include "Arduino.h"
+
+class WiFiClient : public Stream {
+public:
+    int connect(IPAddress ip, uint16_t port);
+    int connect(IPAddress ip, uint16_t port, int timeout);
+    void setTimeout(unsigned long timeout);
+    void stop();
+    bool connected();
+};
@@ -0,0 +1,21 @@
+/*
+ * Host stand-in for the Arduino WiFiUDP (declarations only)
+ */
+
+#pragma once
+
+#include "Arduino.h"
+
+class WiFiUDP : public Stream {
+public:
+    uint8_t begin(uint16_t port);
+    void stop();
+    int beginPacket(IPAddress ip, uint16_t port);
+    int endPacket();
+    int parsePacket();
+    IPAddress remoteIP();
+    uint16_t remotePort();
+    int read(uint8_t* buffer, size_t length);
+    using Stream::read;
+    using Print::write;
+};
@@ -0,0 +1,18 @@
+#pragma once
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xffffffffUL
+#define pdMS_TO_TICKS(x) ((TickType_t)(x))
+
+// Critical sections share one recursive mutex on the host
+typedef struct { int unused; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+void portENTER_CRITICAL(portMUX_TYPE* mux);
+void portEXIT_CRITICAL(portMUX_TYPE* mux);
@@ -0,0 +1,8 @@
+#pragma once
+#include "FreeRTOS.h"
+
+typedef void* QueueHandle_t;
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
@@ -0,0 +1,8 @@
+#pragma once
+#include "FreeRTOS.h"
+
+typedef void* SemaphoreHandle_t;
+SemaphoreHandle_t xSemaphoreCreateBinary();
+SemaphoreHandle_t xSemaphoreCreateMutex();
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
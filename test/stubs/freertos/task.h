@@ -0,0 +1,11 @@
+#pragma once
+#include "FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char* name, uint32_t stack, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t task);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
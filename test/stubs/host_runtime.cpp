@@ -0,0 +1,173 @@
+/*
+ * Host stand-ins for the Arduino, ESP-IDF and FreeRTOS calls the sketch
+ * makes: a real or virtual millisecond clock, critical sections on one
+ * recursive mutex, semaphores on std::condition_variable and tasks on
+ * std::thread
+ */
+
+#include <Arduino.h>
+#include <ETH.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <thread>
+
+HardwareSerial Serial;
+EspClass ESP;
+ETHClass ETH;
+
+static const auto bootTime = std::chrono::steady_clock::now();
+static std::atomic<bool> virtualClock(false);
+static std::atomic<unsigned long> virtualNow(0);
+
+unsigned long micros() {
+    if (virtualClock) {
+        return virtualNow * 1000;
+    }
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - bootTime).count();
+}
+
+unsigned long millis() {
+    return virtualClock ? (unsigned long)virtualNow : micros() / 1000;
+}
+
+void delay(unsigned long ms) {
+    if (virtualClock) {
+        virtualNow += ms;
+    } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+}
+
+void yield() {
+    std::this_thread::yield();
+}
+
+void hostUseVirtualClock(bool enable) {
+    virtualClock = enable;
+}
+
+void hostAdvanceClock(unsigned long ms) {
+    virtualNow += ms;
+}
+
+uint32_t esp_random() {
+    static std::mt19937 generator(12345);
+    static std::mutex lock;
+    std::lock_guard<std::mutex> guard(lock);
+    return generator();
+}
+
+String IPAddress::toString() const {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", a.b[0], a.b[1], a.b[2], a.b[3]);
+    return String(text);
+}
+
+bool IPAddress::fromString(const char* text) {
+    unsigned b0, b1, b2, b3;
+    char tail;
+    if (!text || sscanf(text, "%u.%u.%u.%u%c", &b0, &b1, &b2, &b3, &tail) != 4 ||
+        b0 > 255 || b1 > 255 || b2 > 255 || b3 > 255) {
+        return false;
+    }
+    *this = IPAddress(b0, b1, b2, b3);
+    return true;
+}
+
+bool IPAddress::fromString(const String& text) {
+    return fromString(text.c_str());
+}
+
+// All critical sections are one lock, like a single-core build
+static std::recursive_mutex criticalLock;
+
+void portENTER_CRITICAL(portMUX_TYPE*) {
+    criticalLock.lock();
+}
+
+void portEXIT_CRITICAL(portMUX_TYPE*) {
+    criticalLock.unlock();
+}
+
+// Binary semaphores and mutexes are both counting semaphores with a
+// maximum of one; they only differ in the starting count
+struct HostSemaphore {
+    std::mutex lock;
+    std::condition_variable changed;
+    int count;
+};
+
+static SemaphoreHandle_t createSemaphore(int count) {
+    HostSemaphore* semaphore = new HostSemaphore;
+    semaphore->count = count;
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return createSemaphore(0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return createSemaphore(1);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t handle) {
+    HostSemaphore* semaphore = (HostSemaphore*)handle;
+    {
+        std::lock_guard<std::mutex> guard(semaphore->lock);
+        if (semaphore->count > 0) {
+            return pdFALSE;
+        }
+        semaphore->count = 1;
+    }
+    semaphore->changed.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t handle, TickType_t ticks) {
+    HostSemaphore* semaphore = (HostSemaphore*)handle;
+    std::unique_lock<std::mutex> guard(semaphore->lock);
+    auto available = [semaphore]() { return semaphore->count > 0; };
+    if (ticks == portMAX_DELAY) {
+        semaphore->changed.wait(guard, available);
+    } else if (!semaphore->changed.wait_for(guard, std::chrono::milliseconds(ticks), available)) {
+        return pdFALSE;
+    }
+    semaphore->count = 0;
+    return pdTRUE;
+}
+
+static thread_local TaskHandle_t currentTask = nullptr;
+static std::atomic<uintptr_t> nextTask(1);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char*, uint32_t, void* arg,
+                                   UBaseType_t, TaskHandle_t* handle, BaseType_t) {
+    TaskHandle_t task = (TaskHandle_t)nextTask++;
+    std::thread([code, arg, task]() {
+        currentTask = task;
+        code(arg);
+    }).detach();
+    if (handle) {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return currentTask;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    delay(ticks);
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) {
+    return 0;
+}
@@ -0,0 +1,15 @@
+/*
+ * Host stand-in for the lwIP error codes
+ */
+
+#pragma once
+
+#include <cstdint>
+
+typedef int8_t err_t;
+typedef uint8_t u8_t;
+
+#define ERR_OK 0
+#define ERR_MEM -1
+#define ERR_RTE -4
+#define ERR_VAL -6
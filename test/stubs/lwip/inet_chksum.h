@@ -0,0 +1,6 @@
+#pragma once
+#include "pbuf.h"
+#include "ip4_addr.h"
+
+uint16_t ip4_chksum_pseudo(struct pbuf* p, uint8_t proto, uint16_t length,
+                           const ip4_addr_t* src, const ip4_addr_t* dest);
@@ -0,0 +1,8 @@
+#pragma once
+#include "netif.h"
+
+#define IP_PROTO_ICMP 1
+#define IP_PROTO_TCP 6
+#define IP_PROTO_UDP 17
+
+struct netif* ip4_route(const ip4_addr_t* dest);
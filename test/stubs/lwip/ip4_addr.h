@@ -0,0 +1,16 @@
+/*
+ * Host stand-in for lwIP's IPv4 address type (an IPv4-only build, where
+ * ip_addr_t and ip4_addr_t are the same thing)
+ */
+
+#pragma once
+
+#include <cstdint>
+
+typedef struct ip4_addr {
+    uint32_t addr;    // Network order
+} ip4_addr_t;
+
+typedef ip4_addr_t ip_addr_t;
+
+#define ip_2_ip4(ipaddr) (ipaddr)
@@ -0,0 +1,5 @@
+#pragma once
+#include "ip4_addr.h"
+
+#define ip4_addr_get_u32(ipaddr) ((ipaddr)->addr)
+#define ip_addr_set_ip4_u32(ipaddr, value) do { (ipaddr)->addr = (value); } while (0)
@@ -0,0 +1,10 @@
+#pragma once
+#include "err.h"
+#include "ip4_addr.h"
+
+struct netif {
+    ip4_addr_t ip_addr;
+    ip4_addr_t netmask;
+};
+
+const ip4_addr_t* netif_ip4_addr(struct netif* netif);
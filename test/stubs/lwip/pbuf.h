@@ -0,0 +1,21 @@
+/*
+ * Host stand-in for lwIP packet buffers: single-segment only
+ */
+
+#pragma once
+
+#include "err.h"
+
+struct pbuf {
+    struct pbuf* next;
+    void* payload;
+    uint16_t tot_len;
+    uint16_t len;
+};
+
+typedef enum { PBUF_TRANSPORT, PBUF_IP, PBUF_LINK, PBUF_RAW } pbuf_layer;
+typedef enum { PBUF_RAM, PBUF_ROM, PBUF_REF, PBUF_POOL } pbuf_type;
+
+struct pbuf* pbuf_alloc(pbuf_layer layer, uint16_t length, pbuf_type type);
+uint8_t pbuf_free(struct pbuf* p);
+uint16_t pbuf_copy_partial(const struct pbuf* p, void* data, uint16_t length, uint16_t offset);
@@ -0,0 +1,15 @@
+/*
+ * Host stand-in for lwIP's tcpip_api_call(); tests decide which thread
+ * plays the tcpip thread
+ */
+
+#pragma once
+
+#include "../err.h"
+
+struct tcpip_api_call_data {
+    int unused;
+};
+
+typedef err_t (*tcpip_api_call_fn)(struct tcpip_api_call_data* call);
+err_t tcpip_api_call(tcpip_api_call_fn fn, struct tcpip_api_call_data* call);
@@ -0,0 +1,11 @@
+#pragma once
+#include "pbuf.h"
+#include "ip_addr.h"
+
+struct raw_pcb;
+typedef u8_t (*raw_recv_fn)(void* arg, struct raw_pcb* pcb, struct pbuf* p, const ip_addr_t* addr);
+
+struct raw_pcb* raw_new(uint8_t proto);
+void raw_remove(struct raw_pcb* pcb);
+void raw_recv(struct raw_pcb* pcb, raw_recv_fn recv, void* arg);
+err_t raw_sendto(struct raw_pcb* pcb, struct pbuf* p, const ip_addr_t* ipaddr);
@@ -0,0 +1,14 @@
+/*
+ * Host stand-in for lwIP's BSD socket layer: the host's own sockets
+ */
+
+#pragma once
+
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
@@ -0,0 +1,329 @@
+/*
+ * BACnet codec tests
+ *
+ * Frames as a B/IP device, a router and a BBMD put them on the wire:
+ * I-Am (local, routed from MS/TP, forwarded by a BBMD), ReadProperty and
+ * ReadPropertyMultiple ACKs, Error, Reject and Abort PDUs. Each is fed
+ * through bacnetParseFrame() and the decoder that would receive it, and
+ * every truncation of the ACK must fail cleanly.
+ */
+
+#include "host_test.h"
+#include "bacnet_codec.h"
+#include "bacnet_client.h"
+#include "bacnet_discovery.h"
+#include <vector>
+
+// I-Am from device 1234 on the local segment: max APDU 1476, no
+// segmentation, vendor 5
+static const uint8_t IAM[] = {
+    0x81, 0x0b, 0x00, 0x14, 0x01, 0x00, 0x10, 0x00, 0xc4, 0x02, 0x00, 0x04,
+    0xd2, 0x22, 0x05, 0xc4, 0x91, 0x03, 0x21, 0x05,
+};
+
+// I-Am from device 101 on MS/TP network 5, MAC 7, relayed by its router
+static const uint8_t IAM_ROUTED[] = {
+    0x81, 0x0b, 0x00, 0x18, 0x01, 0x08, 0x00, 0x05, 0x01, 0x07, 0x10, 0x00,
+    0xc4, 0x02, 0x00, 0x00, 0x65, 0x22, 0x01, 0xe0, 0x91, 0x03, 0x21, 0x18,
+};
+
+// I-Am from device 389001 at 10.1.2.3, forwarded by a BBMD
+static const uint8_t IAM_FORWARDED[] = {
+    0x81, 0x04, 0x00, 0x1a, 0x0a, 0x01, 0x02, 0x03, 0xba, 0xc0, 0x01, 0x00,
+    0x10, 0x00, 0xc4, 0x02, 0x05, 0xef, 0x89, 0x22, 0x05, 0xc4, 0x91, 0x00,
+    0x21, 0x08,
+};
+
+// Who-Is from another workstation
+static const uint8_t WHO_IS[] = {
+    0x81, 0x0b, 0x00, 0x08, 0x01, 0x00, 0x10, 0x08,
+};
+
+// I-Am of an analog-input object, which no device sends
+static const uint8_t IAM_NOT_DEVICE[] = {
+    0x81, 0x0b, 0x00, 0x14, 0x01, 0x00, 0x10, 0x00, 0xc4, 0x00, 0x00, 0x00,
+    0x01, 0x22, 0x05, 0xc4, 0x91, 0x03, 0x21, 0x05,
+};
+
+// I-Am-Router-To-Network (a network layer message)
+static const uint8_t ROUTER_MESSAGE[] = {
+    0x81, 0x0b, 0x00, 0x09, 0x01, 0x80, 0x01, 0x00, 0x05,
+};
+
+// ReadPropertyMultiple-ACK, invoke ID 1, from device 1234: object-name,
+// model-name, description (not asked for), vendor-name, and an
+// unknown-property error for firmware-revision
+static const uint8_t RPM_ACK[] = {
+    0x81, 0x0a, 0x00, 0x60, 0x01, 0x00, 0x30, 0x01, 0x0e, 0x0c, 0x02, 0x00,
+    0x04, 0xd2, 0x1e, 0x29, 0x4d, 0x4e, 0x75, 0x09, 0x00, 0x41, 0x48, 0x55,
+    0x2d, 0x31, 0x32, 0x33, 0x34, 0x4f, 0x29, 0x46, 0x4e, 0x75, 0x0b, 0x00,
+    0x4d, 0x53, 0x2d, 0x4e, 0x41, 0x45, 0x35, 0x35, 0x31, 0x30, 0x4f, 0x29,
+    0x1c, 0x4e, 0x75, 0x05, 0x00, 0x52, 0x6f, 0x6f, 0x66, 0x4f, 0x29, 0x79,
+    0x4e, 0x75, 0x17, 0x00, 0x4a, 0x6f, 0x68, 0x6e, 0x73, 0x6f, 0x6e, 0x20,
+    0x43, 0x6f, 0x6e, 0x74, 0x72, 0x6f, 0x6c, 0x73, 0x2c, 0x20, 0x49, 0x6e,
+    0x63, 0x2e, 0x4f, 0x29, 0x2c, 0x5e, 0x91, 0x02, 0x91, 0x20, 0x5f, 0x1f,
+};
+
+// ReadProperty-ACK, invoke ID 9, object-name of device 101 behind the
+// router, as a UCS-2 string
+static const uint8_t RP_ACK_ROUTED[] = {
+    0x81, 0x0a, 0x00, 0x21, 0x01, 0x08, 0x00, 0x05, 0x01, 0x07, 0x30, 0x09,
+    0x0c, 0x0c, 0x02, 0x00, 0x00, 0x65, 0x19, 0x4d, 0x3e, 0x75, 0x09, 0x04,
+    0x00, 0x4c, 0x00, 0x61, 0x00, 0x62, 0x00, 0x31, 0x3f,
+};
+
+// Error for ReadPropertyMultiple, invoke ID 3: property, unknown-property
+static const uint8_t ERROR_PDU[] = {
+    0x81, 0x0a, 0x00, 0x0d, 0x01, 0x00, 0x50, 0x03, 0x0e, 0x91, 0x02, 0x91,
+    0x20,
+};
+
+// Reject, invoke ID 7: unrecognized-service
+static const uint8_t REJECT_PDU[] = {
+    0x81, 0x0a, 0x00, 0x09, 0x01, 0x00, 0x60, 0x07, 0x09,
+};
+
+// Abort from the server, invoke ID 5: segmentation-not-supported
+static const uint8_t ABORT_PDU[] = {
+    0x81, 0x0a, 0x00, 0x09, 0x01, 0x00, 0x71, 0x05, 0x04,
+};
+
+// First segment of a segmented ComplexACK, invoke ID 2
+static const uint8_t SEGMENTED_ACK[] = {
+    0x81, 0x0a, 0x00, 0x0d, 0x01, 0x00, 0x3c, 0x02, 0x00, 0x04, 0x0e, 0x0c,
+    0x02,
+};
+
+// Decode from an exact-size heap copy, so a read past the datagram
+// touches memory the decoder does not own
+static bool parseReply(const uint8_t* data, size_t length, BacnetReply& reply) {
+    std::vector<uint8_t> copy(data, data + length);
+    memset(&reply, 0x5A, sizeof(reply));
+    return BacnetClient::parseReply(copy.data(), copy.size(), reply);
+}
+
+static bool parseIAm(const uint8_t* data, size_t length, BacnetDevice& device) {
+    std::vector<uint8_t> copy(data, data + length);
+    device.address = IPAddress(192, 168, 1, 50);
+    return BacnetDiscovery::parseIAm(copy.data(), copy.size(), device);
+}
+
+static void checkFrames() {
+    BacnetFrame frame;
+
+    CHECK(bacnetParseFrame(IAM, sizeof(IAM), frame));
+    CHECK(!frame.forwarded);
+    CHECK_EQ(frame.sourceNetwork, 0);
+    CHECK_EQ(frame.sourceAddressLength, 0);
+    CHECK(frame.apdu == IAM + 6);
+    CHECK_EQ(frame.apduLength, sizeof(IAM) - 6);
+
+    CHECK(bacnetParseFrame(IAM_ROUTED, sizeof(IAM_ROUTED), frame));
+    CHECK_EQ(frame.sourceNetwork, 5);
+    CHECK_EQ(frame.sourceAddressLength, 1);
+    CHECK_EQ(frame.sourceAddress[0], 7);
+    CHECK(frame.apdu == IAM_ROUTED + 10);
+
+    CHECK(bacnetParseFrame(IAM_FORWARDED, sizeof(IAM_FORWARDED), frame));
+    CHECK(frame.forwarded);
+    CHECK(frame.origin == IPAddress(10, 1, 2, 3));
+    CHECK(frame.apdu == IAM_FORWARDED + 12);
+
+    // Trailing bytes past the BVLC length are not part of the frame
+    std::vector<uint8_t> padded(IAM, IAM + sizeof(IAM));
+    padded.resize(padded.size() + 8, 0xEE);
+    CHECK(bacnetParseFrame(padded.data(), padded.size(), frame));
+    CHECK_EQ(frame.apduLength, sizeof(IAM) - 6);
+
+    // Not application frames, or not whole ones
+    CHECK(!bacnetParseFrame(ROUTER_MESSAGE, sizeof(ROUTER_MESSAGE), frame));
+    CHECK(!bacnetParseFrame(IAM, sizeof(IAM) - 1, frame));
+    std::vector<uint8_t> other(IAM, IAM + sizeof(IAM));
+    other[1] = 0x05;              // Register-Foreign-Device
+    CHECK(!bacnetParseFrame(other.data(), other.size(), frame));
+    other[1] = 0x0b;
+    other[0] = 0x82;              // Not BACnet/IP
+    CHECK(!bacnetParseFrame(other.data(), other.size(), frame));
+    other[0] = 0x81;
+    other[4] = 0x02;              // NPDU version
+    CHECK(!bacnetParseFrame(other.data(), other.size(), frame));
+
+    // A source address longer than we keep is refused rather than copied
+    std::vector<uint8_t> longMac = {0x81, 0x0b, 0x00, 0x00, 0x01, 0x08, 0x00, 0x05, BACNET_MAX_MAC + 1};
+    longMac.resize(longMac.size() + BACNET_MAX_MAC + 1, 0x11);
+    longMac.push_back(0x10);
+    longMac.push_back(0x08);
+    longMac[3] = (uint8_t)longMac.size();
+    CHECK(!bacnetParseFrame(longMac.data(), longMac.size(), frame));
+}
+
+static void checkIAm() {
+    BacnetDevice device;
+
+    CHECK(parseIAm(IAM, sizeof(IAM), device));
+    CHECK_EQ(device.instance, 1234);
+    CHECK_EQ(device.maxApdu, 1476);
+    CHECK_EQ(device.segmentation, 3);
+    CHECK_EQ(device.vendorId, 5);
+    CHECK_EQ(device.network, 0);
+    CHECK_EQ(device.macLength, 0);
+    CHECK(device.address == IPAddress(192, 168, 1, 50));
+
+    CHECK(parseIAm(IAM_ROUTED, sizeof(IAM_ROUTED), device));
+    CHECK_EQ(device.instance, 101);
+    CHECK_EQ(device.maxApdu, 480);
+    CHECK_EQ(device.vendorId, 24);
+    CHECK_EQ(device.network, 5);
+    CHECK_EQ(device.macLength, 1);
+    CHECK_EQ(device.mac[0], 7);
+
+    // A forwarded I-Am is answered at its origin, not at the BBMD
+    CHECK(parseIAm(IAM_FORWARDED, sizeof(IAM_FORWARDED), device));
+    CHECK_EQ(device.instance, 389001);
+    CHECK_EQ(device.segmentation, 0);
+    CHECK_EQ(device.vendorId, 8);
+    CHECK(device.address == IPAddress(10, 1, 2, 3));
+
+    CHECK(!parseIAm(WHO_IS, sizeof(WHO_IS), device));
+    CHECK(!parseIAm(IAM_NOT_DEVICE, sizeof(IAM_NOT_DEVICE), device));
+    CHECK(!parseIAm(ROUTER_MESSAGE, sizeof(ROUTER_MESSAGE), device));
+    CHECK(!parseIAm(RPM_ACK, sizeof(RPM_ACK), device));
+
+    // Cut short anywhere: refused
+    for (size_t cut = 4; cut < sizeof(IAM); cut++) {
+        std::vector<uint8_t> part(IAM, IAM + cut);
+        part[3] = (uint8_t)cut;
+        CHECK(!parseIAm(part.data(), part.size(), device));
+    }
+}
+
+static void checkReplies() {
+    BacnetReply reply;
+
+    CHECK(parseReply(RPM_ACK, sizeof(RPM_ACK), reply));
+    CHECK_EQ(reply.type, BACNET_REPLY_ACK);
+    CHECK_EQ(reply.invokeId, 1);
+    CHECK_EQ(reply.service, 0x0e);
+    CHECK_EQ(reply.found, (1 << BACNET_READ_OBJECT_NAME) | (1 << BACNET_READ_MODEL_NAME) |
+                          (1 << BACNET_READ_VENDOR_NAME));
+    CHECK_EQ(reply.failed, 1 << BACNET_READ_FIRMWARE_REVISION);
+    CHECK(strcmp(reply.values[BACNET_READ_OBJECT_NAME], "AHU-1234") == 0);
+    CHECK(strcmp(reply.values[BACNET_READ_MODEL_NAME], "MS-NAE5510") == 0);
+    CHECK(strcmp(reply.values[BACNET_READ_VENDOR_NAME], "Johnson Controls, Inc.") == 0);
+
+    CHECK(parseReply(RP_ACK_ROUTED, sizeof(RP_ACK_ROUTED), reply));
+    CHECK_EQ(reply.type, BACNET_REPLY_ACK);
+    CHECK_EQ(reply.invokeId, 9);
+    CHECK_EQ(reply.service, 0x0c);
+    CHECK_EQ(reply.found, 1 << BACNET_READ_OBJECT_NAME);
+    CHECK_EQ(reply.failed, 0);
+    CHECK(strcmp(reply.values[BACNET_READ_OBJECT_NAME], "Lab1") == 0);
+
+    CHECK(parseReply(ERROR_PDU, sizeof(ERROR_PDU), reply));
+    CHECK_EQ(reply.type, BACNET_REPLY_ERROR);
+    CHECK_EQ(reply.invokeId, 3);
+    CHECK_EQ(reply.service, 0x0e);
+
+    CHECK(parseReply(REJECT_PDU, sizeof(REJECT_PDU), reply));
+    CHECK_EQ(reply.type, BACNET_REPLY_REJECT);
+    CHECK_EQ(reply.invokeId, 7);
+
+    CHECK(parseReply(ABORT_PDU, sizeof(ABORT_PDU), reply));
+    CHECK_EQ(reply.type, BACNET_REPLY_ABORT);
+    CHECK_EQ(reply.invokeId, 5);
+
+    // Segments are not reassembled: treated like an abort, so the client
+    // falls back to one ReadProperty at a time
+    CHECK(parseReply(SEGMENTED_ACK, sizeof(SEGMENTED_ACK), reply));
+    CHECK_EQ(reply.type, BACNET_REPLY_ABORT);
+    CHECK_EQ(reply.invokeId, 2);
+
+    // Not an answer to anything we asked
+    CHECK(!parseReply(IAM, sizeof(IAM), reply));
+    CHECK_EQ(reply.type, BACNET_REPLY_OTHER);
+    CHECK(!parseReply(ROUTER_MESSAGE, sizeof(ROUTER_MESSAGE), reply));
+
+    // Every truncation of the ACK (with the BVLC length to match) fails
+    // instead of reading past the end; cut right after the service choice
+    // it is an ACK without results, which is well formed
+    for (size_t cut = 4; cut < sizeof(RPM_ACK); cut++) {
+        if (cut == 9) {
+            continue;
+        }
+        std::vector<uint8_t> part(RPM_ACK, RPM_ACK + cut);
+        part[3] = (uint8_t)cut;
+        CHECK(!parseReply(part.data(), part.size(), reply));
+    }
+    // A BVLC length beyond the datagram is refused outright
+    CHECK(!parseReply(RPM_ACK, sizeof(RPM_ACK) - 1, reply));
+}
+
+static void checkStrings() {
+    BacnetReply reply;
+
+    // Characters that are unsafe in the pages or the CSV become '?', and
+    // long values are cut to fit
+    std::vector<uint8_t> ack(RP_ACK_ROUTED, RP_ACK_ROUTED + 21);
+    std::string name = "Room \"12\" <b>\x01";
+    name += std::string(100, 'x');
+    ack.push_back(0x75);
+    ack.push_back((uint8_t)(name.size() + 1));
+    ack.push_back(0x00);
+    ack.insert(ack.end(), name.begin(), name.end());
+    ack.push_back(0x3f);
+    ack[3] = (uint8_t)ack.size();
+
+    CHECK(parseReply(ack.data(), ack.size(), reply));
+    CHECK_EQ(reply.found, 1 << BACNET_READ_OBJECT_NAME);
+    const char* value = reply.values[BACNET_READ_OBJECT_NAME];
+    CHECK_EQ(strlen(value), BACNET_STRING_LENGTH - 1);
+    CHECK(strncmp(value, "Room ?12? ?b??xxx", 17) == 0);
+}
+
+static void checkRequests() {
+    // A ReadPropertyMultiple for the four Device properties, as sent to
+    // device 1234 on the local segment
+    static const uint8_t expected[] = {
+        0x81, 0x0a, 0x00, 0x19, 0x01, 0x04, 0x00, 0x05, 0x07, 0x0e, 0x0c, 0x02,
+        0x00, 0x04, 0xd2, 0x1e, 0x09, 0x4d, 0x09, 0x46, 0x09, 0x79, 0x09, 0x2c,
+        0x1f,
+    };
+
+    BacnetDevice device;
+    device.address = IPAddress(192, 168, 1, 50);
+    device.network = 0;
+    device.macLength = 0;
+    device.instance = 1234;
+
+    uint8_t buffer[BACNET_FRAME_SIZE];
+    size_t length = BacnetClient::buildReadPropertyMultiple(buffer, sizeof(buffer), device, 7);
+    CHECK_EQ(length, sizeof(expected));
+    CHECK(memcmp(buffer, expected, sizeof(expected)) == 0);
+
+    // Routed: DNET/DADR of the device and a hop count, and the same parser
+    // that reads replies finds its way through the header
+    device.network = 5;
+    device.macLength = 1;
+    device.mac[0] = 7;
+    length = BacnetClient::buildReadProperty(buffer, sizeof(buffer), device, 8, BACNET_READ_VENDOR_NAME);
+    BacnetFrame frame;
+    CHECK(bacnetParseFrame(buffer, length, frame));
+    CHECK_EQ(buffer[5], NPDU_DEST_PRESENT | NPDU_EXPECTING_REPLY);
+    CHECK_EQ(frame.apduLength, 11);
+    CHECK_EQ(frame.apdu[1], 5);
+    CHECK_EQ(frame.apdu[2], 8);
+    CHECK_EQ(frame.apdu[3], 0x0c);
+    CHECK_EQ(frame.apdu[length - (frame.apdu - buffer) - 1], 121);
+
+    // Too small a buffer: nothing written
+    CHECK_EQ(BacnetClient::buildReadPropertyMultiple(buffer, 12, device, 9), 0);
+}
+
+int main() {
+    checkFrames();
+    checkIAm();
+    checkReplies();
+    checkStrings();
+    checkRequests();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,264 @@
+/*
+ * Probe pacer tests
+ *
+ * The wait hints are checked single-threaded on the virtual clock. The
+ * limits themselves are checked with several threads calling acquire,
+ * tryAcquire and release at once on the real clock, the way the sweep,
+ * port and SYN engines share the pacer. A grant happens somewhere between
+ * the millis() read before the call and the one after it, so timing
+ * assertions only fail when the windows prove a limit was broken.
+ */
+
+#include "host_test.h"
+#include "probe_pacer.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Grant {
+    unsigned long before;
+    unsigned long after;
+};
+
+static void checkWaitHints() {
+    hostUseVirtualClock(true);
+    hostAdvanceClock(10000);
+
+    IPAddress host(10, 0, 0, 1);
+    unsigned long wait = 0;
+
+    // Concurrency: the third probe in flight is refused until a release
+    PacerSettings concurrency = {0, 2, 0};
+    probePacer.configure(concurrency);
+    CHECK(probePacer.tryAcquire(host, &wait));
+    CHECK(probePacer.tryAcquire(host, &wait));
+    CHECK(!probePacer.tryAcquire(host, &wait));
+    CHECK_EQ(wait, 1);
+    CHECK(probePacer.tryAcquire(IPAddress(10, 0, 0, 2), &wait));
+    probePacer.release(host);
+    CHECK(probePacer.tryAcquire(host, &wait));
+    CHECK_EQ(probePacer.getGranted(), 4);
+    CHECK_EQ(probePacer.getDeferred(), 1);
+
+    // Gap: the hint is the time left until the gap has passed
+    PacerSettings gap = {0, 0, 30};
+    probePacer.configure(gap);
+    CHECK(probePacer.tryAcquire(host, &wait));
+    hostAdvanceClock(12);
+    CHECK(!probePacer.tryAcquire(host, &wait));
+    CHECK_EQ(wait, 18);
+    CHECK(probePacer.tryAcquire(IPAddress(10, 0, 0, 2), &wait));
+    hostAdvanceClock(18);
+    CHECK(probePacer.tryAcquire(host, &wait));
+
+    // Rate: the burst goes out at once, then one probe per 1000/rate ms
+    PacerSettings rate = {100, 0, 0};
+    probePacer.configure(rate);
+    hostAdvanceClock(1000);
+    for (int i = 0; i < PACER_BURST; i++) {
+        CHECK(probePacer.tryAcquire(IPAddress(10, 0, 1, i + 1), &wait));
+    }
+    CHECK(!probePacer.tryAcquire(host, &wait));
+    CHECK_EQ(wait, 10);
+    hostAdvanceClock(4);
+    CHECK(!probePacer.tryAcquire(host, &wait));
+    CHECK_EQ(wait, 6);
+    hostAdvanceClock(6);
+    CHECK(probePacer.tryAcquire(host, &wait));
+    CHECK(!probePacer.tryAcquire(host, &wait));
+
+    hostUseVirtualClock(false);
+}
+
+// 8 threads send 20 probes each over 4 hosts and hold every probe for a
+// while; the pacer must never let more than the cap through to one host
+static void checkHostConcurrency() {
+    const int hostCount = 4;
+    const uint8_t cap = 2;
+    PacerSettings settings = {0, cap, 0};
+    probePacer.configure(settings);
+
+    std::atomic<int> inFlight[hostCount];
+    std::atomic<int> peak[hostCount];
+    for (int h = 0; h < hostCount; h++) {
+        inFlight[h] = 0;
+        peak[h] = 0;
+    }
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&, t] {
+            for (int k = 0; k < 20; k++) {
+                int h = (t + k) % hostCount;
+                IPAddress host(10, 0, 0, h + 1);
+                if (k % 2 == 0) {
+                    probePacer.acquire(host);
+                } else {
+                    unsigned long wait = 0;
+                    while (!probePacer.tryAcquire(host, &wait)) {
+                        delay(wait);
+                    }
+                }
+
+                int now = ++inFlight[h];
+                int seen = peak[h];
+                while (now > seen && !peak[h].compare_exchange_weak(seen, now)) {
+                }
+                delay(5);
+                --inFlight[h];
+                probePacer.release(host);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    printf("concurrency cap %u:", cap);
+    for (int h = 0; h < hostCount; h++) {
+        printf(" %d", peak[h].load());
+        CHECK(peak[h] <= cap);
+        CHECK(peak[h] >= 1);
+    }
+    printf(" peak in flight per host\n");
+    CHECK_EQ(probePacer.getGranted(), 8 * 20);
+
+    // Every release was counted: each host takes the full cap again
+    for (int h = 0; h < hostCount; h++) {
+        IPAddress host(10, 0, 0, h + 1);
+        for (int i = 0; i < cap; i++) {
+            CHECK(probePacer.tryAcquire(host));
+        }
+        CHECK(!probePacer.tryAcquire(host));
+    }
+}
+
+// 6 threads race for 2 hosts; no two grants to one host may be closer
+// than the gap
+static void checkHostGap() {
+    const int hostCount = 2;
+    const uint16_t gapMs = 25;
+    PacerSettings settings = {0, 0, gapMs};
+    probePacer.configure(settings);
+
+    std::mutex guard;
+    std::vector<Grant> grants[hostCount];
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 6; t++) {
+        threads.emplace_back([&, t] {
+            for (int k = 0; k < 5; k++) {
+                int h = (t + k) % hostCount;
+                IPAddress host(10, 0, 0, h + 1);
+                Grant grant;
+                // Retry every millisecond rather than sleeping the hint, so
+                // a grant that comes early is caught
+                while (true) {
+                    grant.before = millis();
+                    if (probePacer.tryAcquire(host)) {
+                        break;
+                    }
+                    delay(1);
+                }
+                grant.after = millis();
+                probePacer.release(host);
+
+                std::lock_guard<std::mutex> lock(guard);
+                grants[h].push_back(grant);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (int h = 0; h < hostCount; h++) {
+        CHECK_EQ(grants[h].size(), 15);
+
+        std::vector<Grant>& list = grants[h];
+        std::sort(list.begin(), list.end(), [](const Grant& a, const Grant& b) {
+            return a.before < b.before;
+        });
+
+        // The widest the gap between two grants could have been, in either
+        // order; below the setting means they really were too close
+        long closest = LONG_MAX;
+        for (size_t i = 0; i + 1 < list.size(); i++) {
+            long widest = std::max((long)(list[i + 1].after - list[i].before),
+                                   (long)(list[i].after - list[i + 1].before));
+            closest = std::min(closest, widest);
+            CHECK(widest >= gapMs);
+        }
+        printf("host gap %u ms: closest grants to host %d at most %ld ms apart\n", gapMs, h, closest);
+    }
+}
+
+// 8 threads each want 40 probes to their own hosts; the total sent must
+// stay within the burst plus the rate over the elapsed time
+static void checkTokenBucket() {
+    const uint32_t rate = 100;
+    PacerSettings settings = {rate, 0, 0};
+    probePacer.configure(settings);
+
+    // Let the bucket fill to the burst before starting
+    delay(1000 * PACER_BURST / rate + 10);
+
+    std::atomic<uint32_t> sent(0);
+    unsigned long start = millis();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&, t] {
+            for (int k = 0; k < 40; k++) {
+                IPAddress host(10, 0, t + 1, k + 1);
+                if (k % 2 == 0) {
+                    probePacer.acquire(host);
+                } else {
+                    unsigned long wait = 0;
+                    while (!probePacer.tryAcquire(host, &wait)) {
+                        delay(wait);
+                    }
+                }
+                sent++;
+                probePacer.release(host);
+            }
+        });
+    }
+
+    // Sample the count while the threads run: it may never get ahead of
+    // the bucket at any point, not just at the end
+    uint32_t violations = 0;
+    while (sent < 8 * 40) {
+        uint32_t count = sent;
+        unsigned long after = millis();
+        if (count > PACER_BURST + rate * (after - start) / 1000 + 1) {
+            violations++;
+        }
+        delay(20);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    unsigned long elapsed = millis() - start;
+
+    float achieved = sent * 1000.0f / elapsed;
+    printf("token bucket %u/s, burst %d: %u probes in %lu ms = %.1f/s\n",
+           rate, PACER_BURST, sent.load(), elapsed, achieved);
+    CHECK_EQ(violations, 0);
+    CHECK(sent <= PACER_BURST + rate * elapsed / 1000 + 1);
+    // 320 probes at 100/s less the burst: the pacer should not be far
+    // slower than its budget either
+    CHECK(elapsed >= (8 * 40 - PACER_BURST - 1) * 1000 / rate);
+    CHECK(achieved >= rate * 0.5f);
+}
+
+int main() {
+    checkWaitHints();
+    checkHostConcurrency();
+    checkHostGap();
+    checkTokenBucket();
+    return HOST_TEST_RESULT();
+}
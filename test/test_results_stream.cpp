@@ -0,0 +1,549 @@
+/*
+ * Streamed results page and CSV tests
+ *
+ * /results and /download are fetched from the real HttpServer over
+ * loopback, as HTTP/1.1 (chunked) and as HTTP/1.0 (unframed, ended by the
+ * close). The de-chunked bodies must be byte for byte what the String
+ * generators they replaced produced for the same results; those are kept
+ * here as the reference. The WebInterface members they use are private,
+ * so this file opens them up. An /api/results error that quotes the
+ * request is checked for valid JSON too, as is a status event with an
+ * overlong message, and the scan form for keeping and escaping what it
+ * is sent.
+ */
+
+#include "host_test.h"
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <functional>
+#include <string>
+#include <vector>
+#define private public
+#include "web_interface.h"
+#undef private
+#include "scan_task.h"
+#include "wifi_manager.h"
+#include "net_utils.h"
+
+// web_interface.cpp calls into the scan task and the WiFi manager; neither
+// runs on the host, and none of the handlers fetched here reach them
+
+ScanTask scanTask;
+WiFiManager wifiManager;
+FSClass SPIFFS;
+
+ScanTask::ScanTask() {}
+uint32_t ScanTask::submit(ScanJob*) { return 0; }
+void ScanTask::cancel(uint32_t) {}
+uint32_t ScanTask::getCurrentJob() { return 0; }
+bool ScanTask::isBusy() { return false; }
+SweepProgress ScanTask::getProgress() { SweepProgress progress; memset(&progress, 0, sizeof(progress)); return progress; }
+
+WiFiManager::WiFiManager() {}
+WiFiManager::~WiFiManager() {}
+std::vector<WiFiCredentials> WiFiManager::getKnownNetworks() { return std::vector<WiFiCredentials>(); }
+void WiFiManager::addNetwork(const WiFiCredentials&) {}
+void WiFiManager::enableBackupMode() {}
+void WiFiManager::disableBackupMode() {}
+bool WiFiManager::isBackupModeEnabled() { return false; }
+bool WiFiManager::isConnected() { return false; }
+String WiFiManager::getCurrentSSID() { return String(); }
+int WiFiManager::getRSSI() { return 0; }
+bool WiFiManager::startNetworkScan() { return false; }
+bool WiFiManager::collectNetworkScan(std::vector<WiFiNetwork>&) { return true; }
+void WiFiManager::cancelNetworkScan() {}
+String WiFiManager::encryptionTypeStr(wifi_auth_mode_t) { return String(); }
+
+// Every column filled in by some hosts and empty in others, and names with
+// printf conversions and CSV quotes in them
+static void fillResults(WebInterface& web, int hosts) {
+    web.scanResults.clear();
+    for (int h = 0; h < hosts; h++) {
+        ScanResult result;
+        result.host = ipToHost(IPAddress(10, 0, h / 250, h % 250 + 1));
+        result.timestamp = 1000 * h + 12345;
+        result.responseTime = h * 7;
+        if (h % 3) {
+            uint8_t mac[6] = {0x24, 0x0a, 0xc4, (uint8_t)h, 0x34, 0x56};
+            memcpy(result.mac, mac, sizeof(mac));
+            result.hasMac = true;
+        }
+        if (h % 4 == 0) {
+            char name[32];
+            snprintf(name, sizeof(name), h % 8 ? "plc-%d" : "%%s \"100%%\" %d", h);
+            result.hostname = stringPool.intern(name);
+        }
+
+        result.setPort(80, false, PORT_OPEN);
+        result.setPort(443, false, h % 2 ? PORT_CLOSED : PORT_FILTERED);
+        if (h % 5 == 0) {
+            result.setPort(502, false, PORT_OPEN);
+        }
+        if (h % 7 == 0) {
+            result.setPort(8080, false, PORT_UNREACHABLE);
+        }
+        result.setPort(161, true, h % 2 ? PORT_OPEN : PORT_OPEN_FILTERED);
+        result.setPort(1900, true, PORT_CLOSED);
+
+        ServiceFingerprint fingerprint;
+        fingerprint.port = 80;
+        fingerprint.id = FINGERPRINT_HTTP;
+        snprintf(fingerprint.detail, sizeof(fingerprint.detail), "lighttpd/1.4.%d", h);
+        result.addFingerprint(fingerprint);
+        fingerprint.id = FINGERPRINT_HTTP_TITLE;
+        snprintf(fingerprint.detail, sizeof(fingerprint.detail), "Device %d", h % 9);
+        result.addFingerprint(fingerprint);
+
+        if (h % 6 == 0) {
+            for (int d = 0; d < 1 + h % 3; d++) {
+                BacnetDevice device;
+                device.network = d ? 5 : 0;
+                device.macLength = 0;
+                device.instance = 100000 + h * 10 + d;
+                device.maxApdu = 1476;
+                device.segmentation = 0;
+                device.vendorId = 5 + d;
+                device.objectName = String("AHU-") + String(d);
+                device.modelName = "MX";
+                device.vendorName = d ? "" : "Vendor";
+                device.firmwareRevision = "1.2";
+                result.bacnetDevices.push_back(device);
+            }
+        }
+        if (h % 5 == 0) {
+            result.modbus.status = h % 10 ? MODBUS_DEVICE : MODBUS_NOT_MODBUS;
+            for (int u = 0; u < 2; u++) {
+                ModbusUnit unit;
+                unit.unitId = u ? 1 : 255;
+                unit.exceptionCode = 0;
+                unit.vendorName = "Schneider";
+                unit.productCode = "BMX";
+                unit.revision = u ? "" : "v2.1";
+                result.modbus.units.push_back(unit);
+            }
+        }
+        if (h % 8 == 0) {
+            EnipIdentity identity;
+            identity.vendorId = 1;
+            identity.deviceType = 14;
+            identity.productCode = 55 + h;
+            identity.revisionMajor = 20;
+            identity.revisionMinor = h % 100;
+            identity.serialNumber = 0xC0FFEE00u + h;
+            identity.productName = "1756-L71";
+            result.enipIdentities.push_back(identity);
+            result.enipIdentities.push_back(identity);
+        }
+        web.scanResults.push_back(result);
+    }
+}
+
+// The page as generateResultsPage() built it before it was streamed
+static String referencePage(WebInterface& web) {
+    String resultsHtml = R"(
+        <div class="container">
+            <h1>Scan Results</h1>
+            <p>Found <span id="device-count">)" + String((unsigned)web.scanResults.size()) + R"(</span> devices</p>
+            <div class="nav-buttons">
+                <a href="/download" class="btn">Download CSV</a>
+                <a href="/scan" class="btn">New Scan</a>
+                <button onclick='clearResults()' class="btn">Clear Results</button>
+            </div>
+            <table class="results-table">
+                <thead>
+                    <tr>
+                        <th>IP Address</th>
+                        <th>MAC Address</th>
+                        <th>Hostname</th>
+                        <th>Open Ports</th>
+                        <th>Closed Ports</th>
+                        <th>Filtered Ports</th>
+                        <th>Unreachable Ports</th>
+                        <th>UDP Ports</th>
+                        <th>BACnet</th>
+                        <th>Modbus</th>
+                        <th>EtherNet/IP</th>
+                        <th>Fingerprints</th>
+                        <th>Response Time</th>
+                        <th>Timestamp</th>
+                    </tr>
+                </thead>
+                <tbody id="result-rows">
+    )";
+
+    for (const auto& result : web.scanResults) {
+        resultsHtml += "<tr>";
+        resultsHtml += "<td>" + web.ipToString(result.address()) + "</td>";
+        resultsHtml += "<td>" + result.macText() + "</td>";
+        resultsHtml += "<td>" + String(result.hostName()) + "</td>";
+        resultsHtml += "<td class='port-open'>" + web.joinPorts(result, false, PORT_OPEN, ", ") + "</td>";
+        resultsHtml += "<td class='port-closed'>" + web.joinPorts(result, false, PORT_CLOSED, ", ") + "</td>";
+        resultsHtml += "<td class='port-filtered'>" + web.joinPorts(result, false, PORT_FILTERED, ", ") + "</td>";
+        resultsHtml += "<td class='port-unreachable'>" + web.joinPorts(result, false, PORT_UNREACHABLE, ", ") + "</td>";
+        resultsHtml += "<td>" + web.describeUdpPorts(result, "<br>") + "</td>";
+        resultsHtml += "<td>" + web.describeBacnet(result.bacnetDevices) + "</td>";
+        resultsHtml += "<td>" + web.describeModbus(result.modbus) + "</td>";
+        resultsHtml += "<td>" + web.describeEnip(result.enipIdentities) + "</td>";
+        resultsHtml += "<td>" + web.describeFingerprints(result, "<br>") + "</td>";
+        resultsHtml += "<td>" + String(result.responseTime) + " ms</td>";
+        resultsHtml += "<td>" + web.formatTimestamp(result.timestamp) + "</td>";
+        resultsHtml += "</tr>";
+    }
+
+    resultsHtml += R"(
+                </tbody>
+            </table>
+        </div>
+    )";
+
+    return web.generateHTML("Scan Results", resultsHtml);
+}
+
+// The CSV as generateCSV() built it before it was streamed
+static String referenceCSV(WebInterface& web) {
+    String csv = "IP Address,MAC Address,Hostname,Open Ports,Closed Ports,Filtered Ports,Unreachable Ports,"
+                 "UDP Open Ports,UDP Closed Ports,UDP Open|Filtered Ports,UDP Filtered Ports,"
+                 "BACnet Instances,BACnet Vendor IDs,BACnet Max APDU,BACnet Names,BACnet Vendors,"
+                 "BACnet Models,BACnet Firmware,Modbus,Modbus Units,Modbus Vendors,Modbus Products,"
+                 "Modbus Revisions,ENIP Vendor IDs,ENIP Device Types,ENIP Product Codes,ENIP Revisions,"
+                 "ENIP Serials,ENIP Product Names,Fingerprints,Response Time (ms),Timestamp\n";
+
+    for (const auto& result : web.scanResults) {
+        String instances = "";
+        String vendors = "";
+        String maxApdus = "";
+        String names = "";
+        String vendorNames = "";
+        String models = "";
+        String firmware = "";
+        for (size_t i = 0; i < result.bacnetDevices.size(); i++) {
+            const BacnetDevice& device = result.bacnetDevices[i];
+            if (i > 0) {
+                instances += ";";
+                vendors += ";";
+                maxApdus += ";";
+                names += ";";
+                vendorNames += ";";
+                models += ";";
+                firmware += ";";
+            }
+            instances += String(device.instance);
+            vendors += String(device.vendorId);
+            maxApdus += String(device.maxApdu);
+            names += device.objectName;
+            vendorNames += device.vendorName;
+            models += device.modelName;
+            firmware += device.firmwareRevision;
+        }
+
+        String units = "";
+        String modbusVendors = "";
+        String products = "";
+        String revisions = "";
+        for (size_t i = 0; i < result.modbus.units.size(); i++) {
+            const ModbusUnit& unit = result.modbus.units[i];
+            if (i > 0) {
+                units += ";";
+                modbusVendors += ";";
+                products += ";";
+                revisions += ";";
+            }
+            units += String(unit.unitId);
+            modbusVendors += unit.vendorName;
+            products += unit.productCode;
+            revisions += unit.revision;
+        }
+
+        String enipVendors = "";
+        String deviceTypes = "";
+        String productCodes = "";
+        String enipRevisions = "";
+        String serials = "";
+        String productNames = "";
+        for (size_t i = 0; i < result.enipIdentities.size(); i++) {
+            const EnipIdentity& identity = result.enipIdentities[i];
+            if (i > 0) {
+                enipVendors += ";";
+                deviceTypes += ";";
+                productCodes += ";";
+                enipRevisions += ";";
+                serials += ";";
+                productNames += ";";
+            }
+            char serial[9];
+            snprintf(serial, sizeof(serial), "%08X", (unsigned)identity.serialNumber);
+            enipVendors += String(identity.vendorId);
+            deviceTypes += String(identity.deviceType);
+            productCodes += String(identity.productCode);
+            enipRevisions += String(identity.revisionMajor) + "." + String(identity.revisionMinor);
+            serials += serial;
+            productNames += identity.productName;
+        }
+
+        csv += web.ipToString(result.address()) + ",";
+        csv += result.macText() + ",";
+        csv += String(result.hostName()) + ",";
+        csv += "\"" + web.joinPorts(result, false, PORT_OPEN, ";") + "\",";
+        csv += "\"" + web.joinPorts(result, false, PORT_CLOSED, ";") + "\",";
+        csv += "\"" + web.joinPorts(result, false, PORT_FILTERED, ";") + "\",";
+        csv += "\"" + web.joinPorts(result, false, PORT_UNREACHABLE, ";") + "\",";
+        csv += "\"" + web.joinPorts(result, true, PORT_OPEN, ";") + "\",";
+        csv += "\"" + web.joinPorts(result, true, PORT_CLOSED, ";") + "\",";
+        csv += "\"" + web.joinPorts(result, true, PORT_OPEN_FILTERED, ";") + "\",";
+        csv += "\"" + web.joinPorts(result, true, PORT_FILTERED, ";") + "\",";
+        csv += "\"" + instances + "\",";
+        csv += "\"" + vendors + "\",";
+        csv += "\"" + maxApdus + "\",";
+        csv += "\"" + names + "\",";
+        csv += "\"" + vendorNames + "\",";
+        csv += "\"" + models + "\",";
+        csv += "\"" + firmware + "\",";
+        csv += String(modbusStatusName(result.modbus.status)) + ",";
+        csv += "\"" + units + "\",";
+        csv += "\"" + modbusVendors + "\",";
+        csv += "\"" + products + "\",";
+        csv += "\"" + revisions + "\",";
+        csv += "\"" + enipVendors + "\",";
+        csv += "\"" + deviceTypes + "\",";
+        csv += "\"" + productCodes + "\",";
+        csv += "\"" + enipRevisions + "\",";
+        csv += "\"" + serials + "\",";
+        csv += "\"" + productNames + "\",";
+        csv += "\"" + web.describeFingerprints(result, ";") + "\",";
+        csv += String(result.responseTime) + ",";
+        csv += web.formatTimestamp(result.timestamp) + "\n";
+    }
+
+    return csv;
+}
+
+// One request on a fresh connection; everything up to the close
+static bool fetch(uint16_t port, const char* path, bool http10, std::string& head, std::string& body,
+                  const char* form = nullptr) {
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        return false;
+    }
+
+    // A form goes out as a POST body
+    char request[512];
+    int length;
+    if (form) {
+        length = snprintf(request, sizeof(request), "POST %s HTTP/1.1\r\nHost: test\r\nConnection: close\r\n"
+                          "Content-Type: application/x-www-form-urlencoded\r\nContent-Length: %zu\r\n\r\n%s",
+                          path, strlen(form), form);
+    } else {
+        length = snprintf(request, sizeof(request), http10 ? "GET %s HTTP/1.0\r\n\r\n" :
+                          "GET %s HTTP/1.1\r\nHost: test\r\nConnection: close\r\n\r\n", path);
+    }
+    send(fd, request, length, 0);
+
+    std::string response;
+    char buffer[4096];
+    ssize_t received;
+    while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, received);
+    }
+    close(fd);
+
+    size_t end = response.find("\r\n\r\n");
+    if (end == std::string::npos) {
+        return false;
+    }
+    head = response.substr(0, end + 2);
+    body = response.substr(end + 4);
+    return true;
+}
+
+// Undo the chunked transfer coding; false if the framing is broken or
+// anything follows the last chunk
+static bool dechunk(const std::string& framed, std::string& body, size_t& chunks, size_t& largest) {
+    body.clear();
+    chunks = 0;
+    largest = 0;
+    size_t at = 0;
+    for (;;) {
+        size_t lineEnd = framed.find("\r\n", at);
+        if (lineEnd == std::string::npos || lineEnd == at) {
+            return false;
+        }
+        char* sizeEnd;
+        size_t size = strtoul(framed.c_str() + at, &sizeEnd, 16);
+        if (sizeEnd != framed.c_str() + lineEnd) {
+            return false;
+        }
+        at = lineEnd + 2;
+        if (size == 0) {
+            return framed.compare(at, std::string::npos, "\r\n") == 0;
+        }
+        if (at + size + 2 > framed.size() || framed.compare(at + size, 2, "\r\n") != 0) {
+            return false;
+        }
+        body.append(framed, at, size);
+        at += size + 2;
+        chunks++;
+        largest = std::max(largest, size);
+    }
+}
+
+// Byte equality, with the first difference printed when there is one
+static bool sameBytes(const char* what, const std::string& actual, const String& expected) {
+    std::string wanted(expected.c_str(), expected.length());
+    if (actual == wanted) {
+        return true;
+    }
+    size_t at = 0;
+    while (at < actual.size() && at < wanted.size() && actual[at] == wanted[at]) {
+        at++;
+    }
+    fprintf(stderr, "%s: %zu bytes, expected %zu; first difference at %zu:\n  got  \"%.40s\"\n  want \"%.40s\"\n",
+            what, actual.size(), wanted.size(), at,
+            actual.c_str() + std::min(at, actual.size()), wanted.c_str() + std::min(at, wanted.size()));
+    return false;
+}
+
+static void checkDownload(uint16_t port, const char* path, const char* contentType, const String& expected,
+                          int hosts) {
+    std::string head;
+    std::string framed;
+    CHECK(fetch(port, path, false, head, framed));
+    CHECK(head.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+    CHECK(head.find(std::string("Content-Type: ") + contentType + "\r\n") != std::string::npos);
+    CHECK(head.find("Transfer-Encoding: chunked\r\n") != std::string::npos);
+
+    std::string body;
+    size_t chunks = 0;
+    size_t largest = 0;
+    CHECK(dechunk(framed, body, chunks, largest));
+    CHECK(sameBytes(path, body, expected));
+    CHECK(largest <= WEB_SEND_BUFFER_SIZE);
+    // Rows go out whole and are much smaller than the buffer, so chunks
+    // stay mostly full
+    CHECK(chunks <= 2 * (expected.length() / WEB_SEND_BUFFER_SIZE) + 2);
+
+    // HTTP/1.0 gets the same bytes without the framing
+    std::string plain;
+    CHECK(fetch(port, path, true, head, plain));
+    CHECK(head.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+    CHECK(head.find("Transfer-Encoding") == std::string::npos);
+    CHECK(sameBytes(path, plain, expected));
+
+    printf("%4d results: %-9s %7zu B in %3zu chunks, largest %zu B\n", hosts, path, body.size(), chunks, largest);
+}
+
+// A field name with a quote and a backslash comes back escaped, so the
+// error body stays valid JSON
+static void checkErrorBody(uint16_t port) {
+    std::string head;
+    std::string body;
+    CHECK(fetch(port, "/api/results?fields=ip,x%22y%5C", false, head, body));
+    CHECK(head.compare(0, 24, "HTTP/1.1 400 Bad Request") == 0);
+    CHECK(head.find("Content-Type: application/json\r\n") != std::string::npos);
+    CHECK(sameBytes("/api/results error", body, "{\"error\":\"Unknown field: x\\\"y\\\\\"}"));
+}
+
+// Rejected scan targets leave the last good ones in place, and the scan
+// page quotes what it shows back in its fields
+static void checkScanForm(WebInterface& web, uint16_t port) {
+    web.scanConfig.targets = "10.1.0.0/24";
+    web.scanConfig.excludes = "10.1.0.1";
+
+    std::string head;
+    std::string body;
+    CHECK(fetch(port, "/scan", false, head, body, "targets=%22%3E%3Cscript%3E&excludes=10.1.0.2"));
+    CHECK(head.compare(0, 24, "HTTP/1.1 400 Bad Request") == 0);
+    CHECK(body.find("<script>") == std::string::npos);
+    CHECK(web.scanConfig.targets == "10.1.0.0/24");
+    CHECK(web.scanConfig.excludes == "10.1.0.1");
+
+    web.scanConfig.targets = "10.1.0.0/24, \"><script>'&";
+    CHECK(fetch(port, "/scan", false, head, body));
+    CHECK(body.find("value=\"10.1.0.0/24, &quot;&gt;&lt;script&gt;&#39;&amp;\"") != std::string::npos);
+    CHECK(body.find("<script>") == std::string::npos);
+    web.scanConfig.targets = "";
+    web.scanConfig.excludes = "";
+}
+
+// A status message longer than the event slot is cut short, and what is
+// sent is still whole JSON
+static void checkStatusEvent(WebInterface& web, uint16_t port) {
+    web.scanStatus = "Invalid targets: \"";
+    for (int i = 0; i < 300; i++) {
+        web.scanStatus += 'x';
+    }
+    web.scanStatus += '"';
+
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    struct timeval timeout = {2, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    CHECK(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    const char request[] = "GET /events HTTP/1.1\r\nHost: test\r\n\r\n";
+    send(fd, request, sizeof(request) - 1, 0);
+
+    // The stream stays open: read until the first event is complete
+    std::string response;
+    char buffer[1024];
+    ssize_t received;
+    size_t start;
+    size_t end = std::string::npos;
+    while (end == std::string::npos && (received = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, received);
+        start = response.find("event: status\ndata: ");
+        if (start != std::string::npos) {
+            end = response.find("\n\n", start);
+        }
+    }
+    close(fd);
+    web.scanStatus = "Ready";
+
+    CHECK(end != std::string::npos);
+    if (end == std::string::npos) {
+        return;
+    }
+    std::string event = response.substr(start, end + 2 - start);
+    std::string data = event.substr(strlen("event: status\ndata: "), event.size() - strlen("event: status\ndata: ") - 2);
+    CHECK(event.size() <= WEB_EVENT_LATEST_SIZE);
+    const char begins[] = "{\"status\":\"Invalid targets: \\\"xxxxxxxxxx";
+    CHECK(data.compare(0, sizeof(begins) - 1, begins) == 0);
+    CHECK(data.find("...\",\"progress\":0,\"deviceCount\":") != std::string::npos);
+    CHECK(data.compare(data.size() - 20, 20, "\"scanRunning\":false}") == 0);
+}
+
+int main() {
+    WebInterface* web = new WebInterface();
+
+    // Any free port: the server is rebuilt on 0 and asked where it landed
+    delete web->server;
+    web->server = new HttpServer(0);
+    web->begin();
+    struct sockaddr_in addr;
+    socklen_t addrLength = sizeof(addr);
+    CHECK(web->server->listenFd >= 0);
+    CHECK(getsockname(web->server->listenFd, (struct sockaddr*)&addr, &addrLength) == 0);
+    uint16_t port = ntohs(addr.sin_port);
+
+    const int sizes[] = {0, 1, 7, 60, 300};
+    for (int hosts : sizes) {
+        // No request is in flight, so the results can change unlocked
+        fillResults(*web, hosts);
+        String page = referencePage(*web);
+        String csv = referenceCSV(*web);
+        checkDownload(port, "/results", "text/html", page, hosts);
+        checkDownload(port, "/download", "text/csv", csv, hosts);
+    }
+    checkErrorBody(port);
+    checkScanForm(*web, port);
+    checkStatusEvent(*web, port);
+
+    return HOST_TEST_RESULT();
+}
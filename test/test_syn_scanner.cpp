@@ -0,0 +1,392 @@
+/*
+ * SYN scanner tests
+ *
+ * lwIP is replaced by a recording stand-in: SYNs handed to raw_sendto()
+ * are decoded and kept, and replies are crafted IPv4/TCP segments fed
+ * straight into the receive hook the scanner registered. Checks the SYN
+ * itself (header, checksum, cookie ISN) and which replies classify a port
+ * as open or closed and which must be ignored. Runs on the virtual clock.
+ */
+
+#include "host_test.h"
+#include "syn_scanner.h"
+#include "probe_pacer.h"
+#include <lwip/ip4.h>
+#include <lwip/inet_chksum.h>
+#include <lwip/priv/tcpip_priv.h>
+#include <map>
+#include <set>
+#include <vector>
+
+#define FLAG_SYN 0x02
+#define FLAG_RST 0x04
+#define FLAG_ACK 0x10
+
+static const IPAddress LOCAL(10, 0, 0, 2);
+static const IPAddress UNROUTABLE(192, 168, 99, 1);
+
+// A SYN as it left through raw_sendto()
+struct SentSyn {
+    uint32_t target;
+    uint16_t sourcePort;
+    uint16_t port;
+    uint32_t seq;
+    uint8_t headerLength;
+    uint8_t flags;
+    uint16_t mss;
+    bool checksumValid;
+};
+
+struct raw_pcb {
+    raw_recv_fn recv;
+    void* arg;
+};
+
+static raw_pcb simPcb;
+static struct netif simNetif;
+static std::vector<SentSyn> simSent;
+static err_t simSendResult = ERR_OK;
+
+static uint16_t readU16(const uint8_t* p) {
+    return ((uint16_t)p[0] << 8) | p[1];
+}
+
+static uint32_t readU32(const uint8_t* p) {
+    return ((uint32_t)readU16(p) << 16) | readU16(p + 2);
+}
+
+static void writeU16(uint8_t* p, uint16_t value) {
+    p[0] = (uint8_t)(value >> 8);
+    p[1] = (uint8_t)value;
+}
+
+static void writeU32(uint8_t* p, uint32_t value) {
+    writeU16(p, (uint16_t)(value >> 16));
+    writeU16(p + 2, (uint16_t)value);
+}
+
+// One's-complement sum of the TCP pseudo header and segment, unfolded
+static uint32_t checksumSum(const uint8_t* segment, uint16_t length, uint32_t source, uint32_t dest) {
+    uint8_t pseudo[12];
+    memcpy(pseudo, &source, 4);
+    memcpy(pseudo + 4, &dest, 4);
+    pseudo[8] = 0;
+    pseudo[9] = IP_PROTO_TCP;
+    writeU16(pseudo + 10, length);
+
+    uint32_t sum = 0;
+    for (size_t i = 0; i < sizeof(pseudo); i += 2) {
+        sum += readU16(pseudo + i);
+    }
+    for (uint16_t i = 0; i + 1 < length; i += 2) {
+        sum += readU16(segment + i);
+    }
+    if (length & 1) {
+        sum += (uint32_t)segment[length - 1] << 8;
+    }
+    return sum;
+}
+
+static uint16_t checksumFold(uint32_t sum) {
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return (uint16_t)~sum;
+}
+
+err_t tcpip_api_call(tcpip_api_call_fn fn, struct tcpip_api_call_data* call) {
+    return fn(call);
+}
+
+struct raw_pcb* raw_new(uint8_t) {
+    return &simPcb;
+}
+
+void raw_remove(struct raw_pcb*) {
+}
+
+void raw_recv(struct raw_pcb* pcb, raw_recv_fn recv, void* arg) {
+    pcb->recv = recv;
+    pcb->arg = arg;
+}
+
+err_t raw_sendto(struct raw_pcb*, struct pbuf* p, const ip_addr_t* ipaddr) {
+    if (simSendResult != ERR_OK) {
+        return simSendResult;
+    }
+
+    const uint8_t* tcp = (const uint8_t*)p->payload;
+    SentSyn syn;
+    syn.target = ipaddr->addr;
+    syn.sourcePort = readU16(tcp);
+    syn.port = readU16(tcp + 2);
+    syn.seq = readU32(tcp + 4);
+    syn.headerLength = (tcp[12] >> 4) * 4;
+    syn.flags = tcp[13];
+    syn.mss = (p->len >= 24 && tcp[20] == 2 && tcp[21] == 4) ? readU16(tcp + 22) : 0;
+    syn.checksumValid = checksumFold(checksumSum(tcp, p->len, (uint32_t)LOCAL, ipaddr->addr)) == 0;
+    simSent.push_back(syn);
+    return ERR_OK;
+}
+
+struct pbuf* pbuf_alloc(pbuf_layer, uint16_t length, pbuf_type) {
+    struct pbuf* p = new pbuf;
+    p->next = nullptr;
+    p->payload = calloc(1, length);
+    p->len = length;
+    p->tot_len = length;
+    return p;
+}
+
+uint8_t pbuf_free(struct pbuf* p) {
+    free(p->payload);
+    delete p;
+    return 1;
+}
+
+uint16_t pbuf_copy_partial(const struct pbuf* p, void* data, uint16_t length, uint16_t offset) {
+    if (offset >= p->len) {
+        return 0;
+    }
+    uint16_t count = std::min<uint16_t>(length, p->len - offset);
+    memcpy(data, (const uint8_t*)p->payload + offset, count);
+    return count;
+}
+
+// lwIP hands the checksum back in network order
+uint16_t ip4_chksum_pseudo(struct pbuf* p, uint8_t, uint16_t length,
+                           const ip4_addr_t* src, const ip4_addr_t* dest) {
+    uint16_t checksum = checksumFold(checksumSum((const uint8_t*)p->payload, length, src->addr, dest->addr));
+    return (uint16_t)((checksum >> 8) | (checksum << 8));
+}
+
+const ip4_addr_t* netif_ip4_addr(struct netif* netif) {
+    return &netif->ip_addr;
+}
+
+struct netif* ip4_route(const ip4_addr_t* dest) {
+    return dest->addr == (uint32_t)UNROUTABLE ? nullptr : &simNetif;
+}
+
+// Feed a crafted IPv4 + TCP segment from (from, sourcePort) to destPort
+// through the scanner's receive hook; ipWords > 5 adds IP options
+static void deliver(IPAddress from, uint16_t sourcePort, uint16_t destPort, uint32_t ack,
+                    uint8_t flags, uint8_t ipWords = 5) {
+    uint8_t packet[60 + 20];
+    memset(packet, 0, sizeof(packet));
+    size_t ipLength = ipWords * 4;
+    packet[0] = 0x40 | ipWords;
+    packet[9] = IP_PROTO_TCP;
+    uint32_t source = (uint32_t)from;
+    memcpy(packet + 12, &source, 4);
+
+    uint8_t* tcp = packet + ipLength;
+    writeU16(tcp, sourcePort);
+    writeU16(tcp + 2, destPort);
+    writeU32(tcp + 4, 0x1000);
+    writeU32(tcp + 8, ack);
+    tcp[12] = 5 << 4;
+    tcp[13] = flags;
+
+    struct pbuf p;
+    p.next = nullptr;
+    p.payload = packet;
+    p.len = p.tot_len = ipLength + 20;
+    ip_addr_t address;
+    address.addr = source;
+
+    // The hook must never eat a segment: lwIP's TCP has to see the SYN-ACK
+    // to answer it with RST
+    CHECK_EQ(simPcb.recv(simPcb.arg, &simPcb, &p, &address), 0);
+}
+
+typedef std::pair<uint32_t, uint16_t> ProbeKey;
+
+static std::map<ProbeKey, PortProbeResult> results;
+
+static PortProbeCallback record = [](const PortProbeResult& result) {
+    CHECK(results.count(ProbeKey((uint32_t)result.target, result.port)) == 0);
+    results[ProbeKey((uint32_t)result.target, result.port)] = result;
+};
+
+static const SentSyn* lastSyn(IPAddress target, uint16_t port) {
+    for (size_t i = simSent.size(); i > 0; i--) {
+        if (simSent[i - 1].target == (uint32_t)target && simSent[i - 1].port == port) {
+            return &simSent[i - 1];
+        }
+    }
+    return nullptr;
+}
+
+static bool hasResult(IPAddress target, uint16_t port, PortState state) {
+    auto it = results.find(ProbeKey((uint32_t)target, port));
+    return it != results.end() && it->second.state == state;
+}
+
+static void runToEnd(SynScanner& scanner) {
+    for (int i = 0; i < 10 && scanner.poll(record, 0); i++) {
+        hostAdvanceClock(PORT_TIMEOUT);
+    }
+    CHECK(!scanner.isBusy());
+}
+
+int main() {
+    hostUseVirtualClock(true);
+    hostAdvanceClock(1000);
+    simNetif.ip_addr.addr = (uint32_t)LOCAL;
+    PacerSettings unpaced = {0, 0, 0};
+    probePacer.configure(unpaced);
+
+    SynScanner scanner;
+    CHECK(scanner.begin());
+    CHECK(simPcb.recv != nullptr);
+
+    IPAddress hostA(10, 0, 0, 10);
+    IPAddress hostB(10, 0, 0, 11);
+    IPAddress hostC(10, 0, 0, 12);
+    const IPAddress hosts[] = {hostA, hostB, hostC};
+    const uint16_t ports[] = {80, 443};
+
+    for (const IPAddress& host : hosts) {
+        for (uint16_t port : ports) {
+            CHECK(scanner.add(host, port));
+        }
+    }
+    CHECK(scanner.poll(record, 0));
+
+    // The SYNs: one header with an MSS option, a valid checksum, one source
+    // port for the session and a different ISN for every (host, port)
+    CHECK_EQ(simSent.size(), 6);
+    uint16_t session = simSent[0].sourcePort;
+    CHECK(session >= 32768 && session < 49152);
+    std::set<uint32_t> isns;
+    for (const SentSyn& syn : simSent) {
+        CHECK_EQ(syn.flags, FLAG_SYN);
+        CHECK_EQ(syn.headerLength, 24);
+        CHECK_EQ(syn.mss, 1460);
+        CHECK(syn.checksumValid);
+        CHECK_EQ(syn.sourcePort, session);
+        isns.insert(syn.seq);
+    }
+    CHECK_EQ(isns.size(), 6);
+
+    // A retransmission carries the same cookie, so an answer to either
+    // attempt matches
+    std::map<ProbeKey, uint32_t> firstIsn;
+    for (const SentSyn& syn : simSent) {
+        firstIsn[ProbeKey(syn.target, syn.port)] = syn.seq;
+    }
+    hostAdvanceClock(PORT_TIMEOUT);
+    simSent.clear();
+    CHECK(scanner.poll(record, 0));
+    CHECK_EQ(simSent.size(), 6);
+    for (const SentSyn& syn : simSent) {
+        CHECK_EQ(syn.seq, firstIsn[ProbeKey(syn.target, syn.port)]);
+    }
+    CHECK(results.empty());
+
+    hostAdvanceClock(7);
+    uint32_t isnA80 = lastSyn(hostA, 80)->seq;
+    uint32_t isnA443 = lastSyn(hostA, 443)->seq;
+    uint32_t isnB80 = lastSyn(hostB, 80)->seq;
+    uint32_t isnB443 = lastSyn(hostB, 443)->seq;
+    uint32_t isnC80 = lastSyn(hostC, 80)->seq;
+    uint32_t isnC443 = lastSyn(hostC, 443)->seq;
+
+    // SYN-ACK acknowledging the cookie: open
+    deliver(hostA, 80, session, isnA80 + 1, FLAG_SYN | FLAG_ACK);
+    // RST-ACK acknowledging the cookie: closed
+    deliver(hostA, 443, session, isnA443 + 1, FLAG_RST | FLAG_ACK);
+
+    // Ignored: wrong acknowledgement, RST without ACK, a bare ACK, another
+    // tuple's cookie, another destination port, a host never probed
+    deliver(hostB, 80, session, isnB80, FLAG_SYN | FLAG_ACK);
+    deliver(hostB, 80, session, isnB80 + 2, FLAG_SYN | FLAG_ACK);
+    deliver(hostB, 443, session, isnB443 + 1, FLAG_RST);
+    deliver(hostC, 80, session, isnC80 + 1, FLAG_ACK);
+    deliver(hostC, 443, session, isnC80 + 1, FLAG_SYN | FLAG_ACK);
+    deliver(hostC, 443, session + 1, isnC443 + 1, FLAG_SYN | FLAG_ACK);
+    deliver(IPAddress(10, 0, 0, 99), 80, session, isnA80 + 1, FLAG_SYN | FLAG_ACK);
+
+    CHECK(scanner.poll(record, 0));
+    CHECK_EQ(results.size(), 2);
+    CHECK(hasResult(hostA, 80, PORT_OPEN));
+    CHECK(hasResult(hostA, 443, PORT_CLOSED));
+    CHECK_EQ(results[ProbeKey((uint32_t)hostA, 80)].responseTime, 7);
+    CHECK_EQ(results[ProbeKey((uint32_t)hostA, 80)].attempts, 2);
+    CHECK_EQ(scanner.getPending(), 4);
+
+    // A duplicate answer after the port was classified is dropped quietly
+    deliver(hostA, 80, session, isnA80 + 1, FLAG_SYN | FLAG_ACK);
+    // The TCP header is found past IP options too
+    deliver(hostB, 80, session, isnB80 + 1, FLAG_SYN | FLAG_ACK, 6);
+    CHECK(scanner.poll(record, 0));
+    CHECK_EQ(results.size(), 3);
+    CHECK(hasResult(hostB, 80, PORT_OPEN));
+
+    // The rest never answer properly: filtered after every attempt
+    runToEnd(scanner);
+    CHECK_EQ(results.size(), 6);
+    CHECK(hasResult(hostB, 443, PORT_FILTERED));
+    CHECK(hasResult(hostC, 80, PORT_FILTERED));
+    CHECK(hasResult(hostC, 443, PORT_FILTERED));
+    CHECK_EQ(results[ProbeKey((uint32_t)hostC, 80)].attempts, MAX_RETRY_ATTEMPTS);
+
+    // A new session: fresh source port and secret, so the old session's
+    // answers no longer match
+    results.clear();
+    simSent.clear();
+    CHECK(scanner.add(hostA, 80));
+    CHECK(scanner.poll(record, 0));
+    CHECK_EQ(simSent.size(), 1);
+    uint16_t nextSession = simSent[0].sourcePort;
+    uint32_t nextIsn = simSent[0].seq;
+    CHECK(nextSession != session || nextIsn != isnA80);
+    deliver(hostA, 80, session, isnA80 + 1, FLAG_SYN | FLAG_ACK);
+    deliver(hostA, 80, nextSession, isnA80 + 1, FLAG_SYN | FLAG_ACK);
+    CHECK(scanner.poll(record, 0));
+    CHECK(results.empty());
+    deliver(hostA, 80, nextSession, nextIsn + 1, FLAG_RST | FLAG_ACK);
+    CHECK(!scanner.poll(record, 0));
+    CHECK(hasResult(hostA, 80, PORT_CLOSED));
+
+    // Idle between scans: the hook ignores everything
+    uint32_t droppedBefore = scanner.getDropped();
+    for (int i = 0; i < SYN_REPLY_RING + 3; i++) {
+        deliver(hostA, 80, nextSession, nextIsn + 1, FLAG_SYN | FLAG_ACK);
+    }
+    CHECK_EQ(scanner.getDropped(), droppedBefore);
+
+    // More replies than the ring holds before the task drains it: the
+    // excess is counted and the probe still completes from the first
+    results.clear();
+    simSent.clear();
+    CHECK(scanner.add(hostC, 22));
+    CHECK(scanner.poll(record, 0));
+    const SentSyn* syn = lastSyn(hostC, 22);
+    CHECK(syn != nullptr);
+    for (int i = 0; i < SYN_REPLY_RING + 3; i++) {
+        deliver(hostC, 22, syn->sourcePort, syn->seq + 1, FLAG_SYN | FLAG_ACK);
+    }
+    CHECK_EQ(scanner.getDropped(), droppedBefore + 3);
+    CHECK(!scanner.poll(record, 0));
+    CHECK(hasResult(hostC, 22, PORT_OPEN));
+
+    // No route: unreachable at once, without waiting for a timeout
+    results.clear();
+    CHECK(scanner.add(UNROUTABLE, 80));
+    CHECK(!scanner.poll(record, 0));
+    CHECK(hasResult(UNROUTABLE, 80, PORT_UNREACHABLE));
+    CHECK_EQ(results[ProbeKey((uint32_t)UNROUTABLE, 80)].attempts, 1);
+
+    // Out of pbufs: every failed send uses up an attempt
+    results.clear();
+    simSendResult = ERR_MEM;
+    CHECK(scanner.add(hostB, 22));
+    runToEnd(scanner);
+    CHECK(hasResult(hostB, 22, PORT_FILTERED));
+    CHECK_EQ(results[ProbeKey((uint32_t)hostB, 22)].attempts, MAX_RETRY_ATTEMPTS);
+    simSendResult = ERR_OK;
+
+    return HOST_TEST_RESULT();
+}
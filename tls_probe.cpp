@@ -0,0 +1,430 @@
+/*
+ * TLS Probe Implementation
+ * Minimal ClientHello and a streaming ServerHello/Certificate parser
+ */
+
+#include "tls_probe.h"
+
+// Record content types
+#define TLS_ALERT 21
+#define TLS_HANDSHAKE 22
+
+// Handshake message types
+#define TLS_SERVER_HELLO 2
+#define TLS_CERTIFICATE 11
+#define TLS_SERVER_HELLO_DONE 14
+
+// Positions of the TBSCertificate fields (as if the version were present)
+#define TBS_ISSUER 3
+#define TBS_VALIDITY 4
+#define TBS_SUBJECT 5
+
+// Name attribute types (2.5.4.3 commonName, 2.5.4.10 organizationName)
+#define ATTRIBUTE_CN 1
+#define ATTRIBUTE_O 2
+
+const uint8_t TlsProbe::CLIENT_HELLO[TlsProbe::CLIENT_HELLO_LENGTH] = {
+    // Record: handshake, TLS 1.0 for the oldest servers, 116 bytes
+    0x16, 0x03, 0x01, 0x00, 0x74,
+    // ClientHello, 112 bytes, client version TLS 1.2
+    0x01, 0x00, 0x00, 0x70, 0x03, 0x03,
+    // Random (nothing is derived from it; the handshake is never finished)
+    0x4e, 0x65, 0x74, 0x53, 0x63, 0x61, 0x6e, 0x6e, 0x65, 0x72, 0x2d, 0x45, 0x53, 0x50, 0x33, 0x32,
+    0x9d, 0x21, 0x7a, 0x04, 0xc3, 0x5e, 0x18, 0xb6, 0x47, 0xf0, 0x2a, 0x91, 0x6c, 0xd8, 0x33, 0x0f,
+    // No session ID
+    0x00,
+    // 13 cipher suites: ECDHE-ECDSA/RSA GCM and CBC, then plain RSA down to 3DES
+    0x00, 0x1a,
+    0xc0, 0x2b, 0xc0, 0x2f, 0xc0, 0x2c, 0xc0, 0x30, 0xc0, 0x09, 0xc0, 0x13, 0xc0, 0x0a,
+    0xc0, 0x14, 0x00, 0x9c, 0x00, 0x9d, 0x00, 0x2f, 0x00, 0x35, 0x00, 0x0a,
+    // Null compression
+    0x01, 0x00,
+    // Extensions, 45 bytes
+    0x00, 0x2d,
+    // supported_groups: x25519, secp256r1, secp384r1
+    0x00, 0x0a, 0x00, 0x08, 0x00, 0x06, 0x00, 0x1d, 0x00, 0x17, 0x00, 0x18,
+    // ec_point_formats: uncompressed
+    0x00, 0x0b, 0x00, 0x02, 0x01, 0x00,
+    // signature_algorithms: ECDSA, RSA-PSS and PKCS#1 with SHA-256/384, then SHA-1
+    0x00, 0x0d, 0x00, 0x12, 0x00, 0x10,
+    0x04, 0x03, 0x05, 0x03, 0x08, 0x04, 0x08, 0x05, 0x04, 0x01, 0x05, 0x01, 0x02, 0x01, 0x02, 0x03,
+    // renegotiation_info (some stacks refuse hellos without it)
+    0xff, 0x01, 0x00, 0x01, 0x00
+};
+
+TlsProbe::TlsProbe() {
+    reset();
+}
+
+void TlsProbe::reset() {
+    memset(&summary, 0, sizeof(summary));
+    done = false;
+
+    recordHeaderLength = 0;
+    recordRemaining = 0;
+    alertLength = 0;
+
+    handshakeHeaderLength = 0;
+    handshakeRemaining = 0;
+    helloLength = 0;
+    certificateHeaderLength = 0;
+    certificateRemaining = 0;
+
+    depth = 0;
+    derOffset = 0;
+    elementStart = 0;
+    derStage = DER_TAG;
+    derTag = 0;
+    lengthBytes = 0;
+    valueLength = 0;
+    valueRemaining = 0;
+    captureLength = 0;
+    hasVersion = false;
+    tbsField = 0;
+    timesSeen = 0;
+    pendingAttribute = 0;
+    subjectFromCn = false;
+    issuerFromCn = false;
+}
+
+bool TlsProbe::feed(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length && !done; i++) {
+        uint8_t b = data[i];
+
+        if (recordHeaderLength < sizeof(recordHeader)) {
+            recordHeader[recordHeaderLength++] = b;
+            if (recordHeaderLength == 1 && (b < 20 || b > 23)) {
+                // Not a TLS record (plain HTTP on 443, SSLv2, ...)
+                done = true;
+            } else if (recordHeaderLength == sizeof(recordHeader)) {
+                recordRemaining = (recordHeader[3] << 8) | recordHeader[4];
+                if (recordHeader[1] != 0x03 || recordRemaining == 0) {
+                    done = true;
+                }
+            }
+            continue;
+        }
+
+        recordRemaining--;
+        if (recordHeader[0] == TLS_HANDSHAKE) {
+            handshakeByte(b);
+        } else if (recordHeader[0] == TLS_ALERT) {
+            // Level, then description
+            if (++alertLength == 2) {
+                summary.alerted = true;
+                summary.alert = b;
+                done = true;
+            }
+        } else {
+            // ChangeCipherSpec or application data: the plaintext part is over
+            done = true;
+        }
+
+        if (recordRemaining == 0) {
+            recordHeaderLength = 0;
+        }
+    }
+    return done;
+}
+
+bool TlsProbe::isDone() {
+    return done;
+}
+
+const TlsSummary& TlsProbe::getSummary() {
+    return summary;
+}
+
+void TlsProbe::handshakeByte(uint8_t b) {
+    if (handshakeHeaderLength < sizeof(handshakeHeader)) {
+        handshakeHeader[handshakeHeaderLength++] = b;
+        if (handshakeHeaderLength == sizeof(handshakeHeader)) {
+            handshakeRemaining = ((uint32_t)handshakeHeader[1] << 16) | (handshakeHeader[2] << 8) | handshakeHeader[3];
+            helloLength = 0;
+            certificateHeaderLength = 0;
+            if (handshakeRemaining == 0) {
+                finishHandshakeMessage();
+            }
+        }
+        return;
+    }
+
+    handshakeRemaining--;
+    if (handshakeHeader[0] == TLS_SERVER_HELLO) {
+        if (helloLength < sizeof(hello)) {
+            hello[helloLength++] = b;
+        }
+    } else if (handshakeHeader[0] == TLS_CERTIFICATE) {
+        certificateByte(b);
+    }
+    // Anything else (ServerKeyExchange, CertificateRequest) is skipped
+
+    if (handshakeRemaining == 0 && !done) {
+        finishHandshakeMessage();
+    }
+}
+
+void TlsProbe::finishHandshakeMessage() {
+    switch (handshakeHeader[0]) {
+        case TLS_SERVER_HELLO:
+            parseServerHello();
+            break;
+        case TLS_CERTIFICATE:
+        case TLS_SERVER_HELLO_DONE:
+            // Anonymous suites go straight to ServerHelloDone
+            done = true;
+            break;
+    }
+    handshakeHeaderLength = 0;
+}
+
+void TlsProbe::parseServerHello() {
+    // Version (2), random (32), session ID length (1), session ID, cipher (2)
+    if (helloLength < 35) {
+        done = true;
+        return;
+    }
+    uint8_t sessionIdLength = hello[34];
+    if (sessionIdLength > 32 || helloLength < 35 + sessionIdLength + 2) {
+        done = true;
+        return;
+    }
+
+    summary.serverHello = true;
+    summary.version = (hello[0] << 8) | hello[1];
+    summary.cipher = (hello[35 + sessionIdLength] << 8) | hello[36 + sessionIdLength];
+}
+
+void TlsProbe::certificateByte(uint8_t b) {
+    // 24-bit list length, then the 24-bit length of the leaf certificate
+    if (certificateHeaderLength < 6) {
+        if (certificateHeaderLength >= 3) {
+            certificateRemaining = (certificateRemaining << 8) | b;
+        } else {
+            certificateRemaining = 0;
+        }
+        if (++certificateHeaderLength == 6 && certificateRemaining == 0) {
+            done = true;
+        }
+        return;
+    }
+
+    derByte(b);
+    if (--certificateRemaining == 0) {
+        // Only the leaf matters; the chain behind it is not read
+        done = true;
+    }
+}
+
+void TlsProbe::derByte(uint8_t b) {
+    derOffset++;
+
+    switch (derStage) {
+        case DER_TAG:
+            elementStart = derOffset - 1;
+            derTag = b;
+            derStage = DER_LENGTH;
+            break;
+        case DER_LENGTH:
+            if (b < 0x80) {
+                valueLength = b;
+                startElement();
+            } else {
+                lengthBytes = b & 0x7F;
+                valueLength = 0;
+                if (lengthBytes == 0 || lengthBytes > 3) {
+                    // Indefinite or absurd lengths are not DER
+                    done = true;
+                    break;
+                }
+                derStage = DER_LONG_LENGTH;
+            }
+            break;
+        case DER_LONG_LENGTH:
+            valueLength = (valueLength << 8) | b;
+            if (--lengthBytes == 0) {
+                startElement();
+            }
+            break;
+        case DER_VALUE:
+            if (captureLength < sizeof(capture)) {
+                capture[captureLength++] = b;
+            }
+            if (--valueRemaining == 0) {
+                finishPrimitive();
+            }
+            break;
+    }
+}
+
+void TlsProbe::startElement() {
+    // Leave the elements this one follows
+    while (depth > 0 && elementStart >= stack[depth - 1].end) {
+        depth--;
+    }
+
+    if (depth > 0 && derOffset + valueLength > stack[depth - 1].end) {
+        done = true;
+        return;
+    }
+
+    uint8_t index = depth > 0 ? stack[depth - 1].children++ : 0;
+    if (depth == 2) {
+        // Children of the TBSCertificate; v1 certificates have no [0] version
+        if (index == 0 && derTag == 0xA0) {
+            hasVersion = true;
+        }
+        tbsField = hasVersion ? index : index + 1;
+        pendingAttribute = 0;
+        if (tbsField > TBS_SUBJECT) {
+            // Public key and extensions say nothing we report
+            summary.certificate = true;
+            done = true;
+            return;
+        }
+    }
+
+    if (derTag & 0x20) {
+        // Constructed: its children follow directly
+        if (depth == TLS_DER_DEPTH) {
+            done = true;
+            return;
+        }
+        stack[depth].end = derOffset + valueLength;
+        stack[depth].children = 0;
+        depth++;
+        derStage = DER_TAG;
+        return;
+    }
+
+    captureLength = 0;
+    valueRemaining = valueLength;
+    if (valueLength == 0) {
+        finishPrimitive();
+    } else {
+        derStage = DER_VALUE;
+    }
+}
+
+void TlsProbe::finishPrimitive() {
+    derStage = DER_TAG;
+
+    if (tbsField == TBS_ISSUER || tbsField == TBS_SUBJECT) {
+        if (derTag == 0x06) {
+            pendingAttribute = 0;
+            if (captureLength == 3 && capture[0] == 0x55 && capture[1] == 0x04) {
+                if (capture[2] == 0x03) {
+                    pendingAttribute = ATTRIBUTE_CN;
+                } else if (capture[2] == 0x0A) {
+                    pendingAttribute = ATTRIBUTE_O;
+                }
+            }
+        } else if (pendingAttribute != 0) {
+            bool isCn = pendingAttribute == ATTRIBUTE_CN;
+            if (tbsField == TBS_SUBJECT) {
+                storeName(summary.subject, subjectFromCn, isCn);
+            } else {
+                storeName(summary.issuer, issuerFromCn, isCn);
+            }
+            pendingAttribute = 0;
+        }
+    } else if (tbsField == TBS_VALIDITY && (derTag == 0x17 || derTag == 0x18)) {
+        // notBefore, then notAfter
+        if (timesSeen++ == 1) {
+            storeTime();
+        }
+    }
+}
+
+void TlsProbe::storeName(char* name, bool& fromCn, bool isCn) {
+    // The common name wins over the organisation, whichever comes first
+    if (fromCn || (!isCn && name[0] != '\0')) {
+        return;
+    }
+
+    size_t length = captureLength < TLS_NAME_LENGTH - 1 ? captureLength : TLS_NAME_LENGTH - 1;
+    for (size_t i = 0; i < length; i++) {
+        name[i] = capture[i] != 0 ? (char)capture[i] : '?';
+    }
+    name[length] = '\0';
+    fromCn = isCn;
+}
+
+void TlsProbe::storeTime() {
+    // UTCTime YYMMDDhhmmssZ, GeneralizedTime YYYYMMDDhhmmssZ
+    bool utc = derTag == 0x17;
+    size_t dateLength = utc ? 6 : 8;
+    if (captureLength < dateLength) {
+        return;
+    }
+    for (size_t i = 0; i < dateLength; i++) {
+        if (capture[i] < '0' || capture[i] > '9') {
+            return;
+        }
+    }
+
+    char* out = summary.notAfter;
+    const uint8_t* date = capture;
+    if (utc) {
+        // RFC 5280: two-digit years below 50 are 20xx
+        *out++ = date[0] < '5' ? '2' : '1';
+        *out++ = date[0] < '5' ? '0' : '9';
+    } else {
+        *out++ = date[0];
+        *out++ = date[1];
+        date += 2;
+    }
+    *out++ = date[0];
+    *out++ = date[1];
+    *out++ = '-';
+    *out++ = date[2];
+    *out++ = date[3];
+    *out++ = '-';
+    *out++ = date[4];
+    *out++ = date[5];
+    *out = '\0';
+}
+
+const char* TlsProbe::versionName(uint16_t version) {
+    switch (version) {
+        case 0x0300: return "SSL 3.0";
+        case 0x0301: return "TLS 1.0";
+        case 0x0302: return "TLS 1.1";
+        case 0x0303: return "TLS 1.2";
+        case 0x0304: return "TLS 1.3";
+        default: return "TLS ?";
+    }
+}
+
+const char* TlsProbe::cipherName(uint16_t cipher) {
+    // Only the suites the ClientHello offers can come back
+    switch (cipher) {
+        case 0xC02B: return "ECDHE-ECDSA-AES128-GCM-SHA256";
+        case 0xC02F: return "ECDHE-RSA-AES128-GCM-SHA256";
+        case 0xC02C: return "ECDHE-ECDSA-AES256-GCM-SHA384";
+        case 0xC030: return "ECDHE-RSA-AES256-GCM-SHA384";
+        case 0xC009: return "ECDHE-ECDSA-AES128-SHA";
+        case 0xC013: return "ECDHE-RSA-AES128-SHA";
+        case 0xC00A: return "ECDHE-ECDSA-AES256-SHA";
+        case 0xC014: return "ECDHE-RSA-AES256-SHA";
+        case 0x009C: return "AES128-GCM-SHA256";
+        case 0x009D: return "AES256-GCM-SHA384";
+        case 0x002F: return "AES128-SHA";
+        case 0x0035: return "AES256-SHA";
+        case 0x000A: return "DES-CBC3-SHA";
+        default: return "unknown cipher";
+    }
+}
+
+const char* TlsProbe::alertName(uint8_t alert) {
+    switch (alert) {
+        case 40: return "handshake failure";
+        case 47: return "illegal parameter";
+        case 50: return "decode error";
+        case 70: return "protocol version";
+        case 71: return "insufficient security";
+        case 80: return "internal error";
+        case 112: return "unrecognized name";
+        default: return "alert";
+    }
+}
@@ -0,0 +1,114 @@
+/*
+ * TLS Probe Header
+ * Minimal ClientHello and a streaming ServerHello/Certificate parser
+ */
+
+#ifndef TLS_PROBE_H
+#define TLS_PROBE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define TLS_NAME_LENGTH 64          // Longest subject/issuer name kept, including the terminator
+#define TLS_DER_DEPTH 8             // Nested DER elements tracked (names sit at depth 5)
+#define TLS_CAPTURE_SIZE 64         // Primitive DER value bytes kept for inspection
+
+// What the server revealed before the key exchange
+struct TlsSummary {
+    bool serverHello;             // A ServerHello arrived
+    uint16_t version;             // Negotiated protocol version (0x0303 = TLS 1.2)
+    uint16_t cipher;              // Negotiated cipher suite
+    bool alerted;                 // The server answered with an alert instead
+    uint8_t alert;                // Alert description
+    bool certificate;             // The leaf certificate was parsed
+    char subject[TLS_NAME_LENGTH];  // Common name, or organisation without one
+    char issuer[TLS_NAME_LENGTH];
+    char notAfter[11];            // YYYY-MM-DD
+};
+
+class TlsProbe {
+public:
+    // ClientHello offering TLS 1.0-1.2 with common embedded cipher suites.
+    // TLS 1.3 is left out on purpose: its certificate is encrypted
+    static const size_t CLIENT_HELLO_LENGTH = 121;
+    static const uint8_t CLIENT_HELLO[CLIENT_HELLO_LENGTH];
+
+    TlsProbe();
+
+    // Prepare for a new connection
+    void reset();
+
+    // Parse the next bytes of the server's reply; returns true once the
+    // leaf certificate is read or nothing useful can follow
+    bool feed(const uint8_t* data, size_t length);
+
+    bool isDone();
+    const TlsSummary& getSummary();
+
+    // Display names ("TLS 1.2", "ECDHE-RSA-AES128-GCM-SHA256", "handshake failure")
+    static const char* versionName(uint16_t version);
+    static const char* cipherName(uint16_t cipher);
+    static const char* alertName(uint8_t alert);
+
+private:
+    enum DerStage {
+        DER_TAG,
+        DER_LENGTH,
+        DER_LONG_LENGTH,
+        DER_VALUE
+    };
+
+    struct DerFrame {
+        uint32_t end;             // Offset just past the element
+        uint8_t children;         // Child elements started so far
+    };
+
+    TlsSummary summary;
+    bool done;
+
+    // Record layer
+    uint8_t recordHeader[5];
+    uint8_t recordHeaderLength;
+    uint16_t recordRemaining;
+    uint8_t alertLength;
+
+    // Handshake layer (messages may span records)
+    uint8_t handshakeHeader[4];
+    uint8_t handshakeHeaderLength;
+    uint32_t handshakeRemaining;
+    uint8_t hello[72];            // Version, random, session ID and cipher
+    uint8_t helloLength;
+    uint8_t certificateHeaderLength;  // List and leaf length prefixes
+    uint32_t certificateRemaining;
+
+    // DER walk over the leaf certificate
+    DerFrame stack[TLS_DER_DEPTH];
+    uint8_t depth;
+    uint32_t derOffset;
+    uint32_t elementStart;        // Offset of the current element's tag
+    DerStage derStage;
+    uint8_t derTag;
+    uint8_t lengthBytes;
+    uint32_t valueLength;
+    uint32_t valueRemaining;
+    uint8_t capture[TLS_CAPTURE_SIZE];
+    uint8_t captureLength;
+    bool hasVersion;              // The TBS starts with an explicit [0] version
+    uint8_t tbsField;             // Position of the current TBS element
+    uint8_t timesSeen;            // Validity times passed
+    uint8_t pendingAttribute;     // Name attribute whose value comes next
+    bool subjectFromCn;
+    bool issuerFromCn;
+
+    void handshakeByte(uint8_t b);
+    void finishHandshakeMessage();
+    void parseServerHello();
+    void certificateByte(uint8_t b);
+    void derByte(uint8_t b);
+    void startElement();
+    void finishPrimitive();
+    void storeName(char* name, bool& fromCn, bool isCn);
+    void storeTime();
+};
+
+#endif // TLS_PROBE_H
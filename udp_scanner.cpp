@@ -0,0 +1,562 @@
+/*
+ * UDP Scanner Implementation
+ * UDP port probing over one socket, with ICMP port-unreachable correlation
+ */
+
+#include "udp_scanner.h"
+#include "rtt_estimator.h"
+#include "probe_pacer.h"
+#include "service_catalog.h"
+#include <lwip/sockets.h>
+#include <lwip/ip4.h>
+#include <lwip/ip_addr.h>
+#include <lwip/priv/tcpip_priv.h>
+
+#define ICMP_DEST_UNREACHABLE 3
+#define ICMP_PORT_UNREACHABLE 3
+#define ICMP_NET_UNREACHABLE 0
+#define ICMP_HOST_UNREACHABLE 1
+
+// Messages passed into the tcpip thread; the call header must come first
+struct UdpOpenCall {
+    struct tcpip_api_call_data call;
+    void* scanner;
+    struct raw_pcb* pcb;
+};
+
+// What a port gets sent; a service that sees a request it understands
+// answers, which is the only way to call a UDP port open
+struct UdpPayload {
+    ProbePayload id;
+    const uint8_t* data;
+    size_t length;
+};
+
+// DNS: version.bind TXT CH
+static const uint8_t DNS_QUERY[] = {
+    0x4e, 0x53, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x07, 'v', 'e', 'r', 's', 'i', 'o', 'n', 0x04, 'b', 'i', 'n', 'd', 0x00,
+    0x00, 0x10, 0x00, 0x03
+};
+
+// NTP: version 4 client request
+static const uint8_t NTP_REQUEST[48] = {0xe3};
+
+// SNMP: v1 GetRequest for sysDescr.0 with community "public"
+static const uint8_t SNMP_GET[] = {
+    0x30, 0x26, 0x02, 0x01, 0x00, 0x04, 0x06, 'p', 'u', 'b', 'l', 'i', 'c',
+    0xa0, 0x19, 0x02, 0x01, 0x01, 0x02, 0x01, 0x00, 0x02, 0x01, 0x00,
+    0x30, 0x0e, 0x30, 0x0c, 0x06, 0x08, 0x2b, 0x06, 0x01, 0x02, 0x01, 0x01, 0x01, 0x00, 0x05, 0x00
+};
+
+// SSDP: unicast M-SEARCH
+static const uint8_t SSDP_SEARCH[] =
+    "M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nMAN: \"ssdp:discover\"\r\nMX: 1\r\nST: ssdp:all\r\n\r\n";
+
+// DNP3: Request Link Status from master 3 to outstation 1
+static const uint8_t DNP3_LINK_STATUS[] = {0x05, 0x64, 0x05, 0xc9, 0x01, 0x00, 0x03, 0x00, 0x75, 0x3e};
+
+// EtherNet/IP: unicast ListIdentity
+static const uint8_t ENIP_LIST_IDENTITY[24] = {0x63};
+
+// BACnet/IP: ReadProperty of the wildcard device's object-identifier; I-Am
+// answers to a Who-Is go to the broadcast address, this reply comes back
+static const uint8_t BACNET_READ_PROPERTY[] = {
+    0x81, 0x0a, 0x00, 0x11, 0x01, 0x04, 0x00, 0x05, 0x01, 0x0c,
+    0x0c, 0x02, 0x3f, 0xff, 0xff, 0x19, 0x4b
+};
+
+static const UdpPayload UDP_PAYLOADS[] = {
+    {PAYLOAD_DNS,    DNS_QUERY, sizeof(DNS_QUERY)},
+    {PAYLOAD_NTP,    NTP_REQUEST, sizeof(NTP_REQUEST)},
+    {PAYLOAD_SNMP,   SNMP_GET, sizeof(SNMP_GET)},
+    {PAYLOAD_SSDP,   SSDP_SEARCH, sizeof(SSDP_SEARCH) - 1},
+    {PAYLOAD_DNP3,   DNP3_LINK_STATUS, sizeof(DNP3_LINK_STATUS)},
+    {PAYLOAD_ENIP,   ENIP_LIST_IDENTITY, sizeof(ENIP_LIST_IDENTITY)},
+    {PAYLOAD_BACNET, BACNET_READ_PROPERTY, sizeof(BACNET_READ_PROPERTY)},
+    {PAYLOAD_NONE,   nullptr, 0}      // Anything else: an empty datagram
+};
+
+// Payload the service catalog names for a UDP port
+static const UdpPayload& findPayload(uint16_t port) {
+    const ServiceEntry* service = findService(port, SERVICE_UDP);
+    ProbePayload id = service ? service->payload : PAYLOAD_NONE;
+
+    size_t count = sizeof(UDP_PAYLOADS) / sizeof(UDP_PAYLOADS[0]);
+    for (size_t i = 0; i < count - 1; i++) {
+        if (UDP_PAYLOADS[i].id == id) {
+            return UDP_PAYLOADS[i];
+        }
+    }
+    return UDP_PAYLOADS[count - 1];
+}
+
+static uint16_t getU16(const uint8_t* p) {
+    return ((uint16_t)p[0] << 8) | p[1];
+}
+
+UdpScanner::UdpScanner() {
+    pcb = nullptr;
+    fd = -1;
+    memset(probes, 0, sizeof(probes));
+    used = 0;
+    memset(budgets, 0, sizeof(budgets));
+    pacerWait = 0;
+    budgetWait = 0;
+    listenPort = 0;
+    ringHead = 0;
+    ringCount = 0;
+    dropped = 0;
+    lock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+bool UdpScanner::begin() {
+    if (pcb) {
+        return true;
+    }
+
+    UdpOpenCall msg;
+    msg.scanner = this;
+    msg.pcb = nullptr;
+    tcpip_api_call(openPcb, &msg.call);
+    pcb = msg.pcb;
+
+    #if DEBUG_PORT_SCAN
+    Serial.printf("UDP scanner %s\n", pcb ? "ready" : "without ICMP (no raw PCB)");
+    #endif
+    return pcb != nullptr;
+}
+
+bool UdpScanner::isReady() {
+    return pcb != nullptr;
+}
+
+bool UdpScanner::add(IPAddress target, uint16_t port) {
+    if (used >= UDP_SCAN_SLOTS) {
+        return false;
+    }
+
+    for (size_t i = 0; i < UDP_SCAN_SLOTS; i++) {
+        Probe& probe = probes[i];
+        if (probe.target == 0) {
+            probe.target = (uint32_t)target;
+            probe.port = port;
+            probe.attempts = 0;
+            probe.sent = false;
+            probe.sentAt = 0;
+            probe.timeout = 0;
+            used++;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool UdpScanner::poll(PortProbeCallback callback, unsigned long waitMs) {
+    if (!isBusy()) {
+        return false;
+    }
+
+    sendQueued(callback);
+    drainReplies(callback);
+    drainIcmp(callback);
+    expireProbes(callback);
+
+    if (!isBusy()) {
+        closeSocket();
+        return false;
+    }
+
+    // Sleep until a reply arrives, the next probe expires or a host may be
+    // probed again, whichever comes first
+    unsigned long now = millis();
+    unsigned long wait = waitMs;
+    for (size_t i = 0; i < UDP_SCAN_SLOTS; i++) {
+        const Probe& probe = probes[i];
+        if (probe.target == 0) {
+            continue;
+        }
+        unsigned long left = 1;
+        if (probe.sent) {
+            unsigned long elapsed = now - probe.sentAt;
+            left = elapsed < probe.timeout ? probe.timeout - elapsed : 0;
+        } else {
+            unsigned long blocked = pacerWait > budgetWait ? pacerWait : budgetWait;
+            left = blocked > 0 ? blocked : 1;
+        }
+        if (left < wait) {
+            wait = left;
+        }
+    }
+
+    if (fd >= 0 && wait > 0) {
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(fd, &readSet);
+        struct timeval tv;
+        tv.tv_sec = wait / 1000;
+        tv.tv_usec = (wait % 1000) * 1000;
+        select(fd + 1, &readSet, nullptr, nullptr, &tv);
+    } else if (wait > 0) {
+        delay(wait);
+    }
+
+    drainReplies(callback);
+    drainIcmp(callback);
+    expireProbes(callback);
+    sendQueued(callback);
+
+    if (!isBusy()) {
+        closeSocket();
+        return false;
+    }
+    return true;
+}
+
+void UdpScanner::stop() {
+    memset(probes, 0, sizeof(probes));
+    used = 0;
+    closeSocket();
+}
+
+bool UdpScanner::isBusy() {
+    return used > 0;
+}
+
+size_t UdpScanner::getPending() {
+    return used;
+}
+
+uint32_t UdpScanner::getDropped() {
+    return dropped;
+}
+
+bool UdpScanner::openSocket() {
+    fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (fd < 0) {
+        return false;
+    }
+
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+    // Bind to an ephemeral port so ICMP errors quoting it can be matched
+    struct sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = 0;
+    local.sin_addr.s_addr = INADDR_ANY;
+    socklen_t length = sizeof(local);
+    if (bind(fd, (struct sockaddr*)&local, sizeof(local)) < 0 ||
+        getsockname(fd, (struct sockaddr*)&local, &length) < 0) {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+
+    // A new session starts with an empty ring, so stray errors quoting an
+    // earlier scan's port are never taken for this one
+    portENTER_CRITICAL(&lock);
+    ringHead = 0;
+    ringCount = 0;
+    portEXIT_CRITICAL(&lock);
+    listenPort = ntohs(local.sin_port);
+    memset(budgets, 0, sizeof(budgets));
+    return true;
+}
+
+void UdpScanner::closeSocket() {
+    listenPort = 0;
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+bool UdpScanner::takeToken(uint32_t host, unsigned long now) {
+    HostBudget* budget = nullptr;
+    HostBudget* idle = nullptr;
+    for (size_t i = 0; i < UDP_HOST_SLOTS; i++) {
+        if (budgets[i].host == host) {
+            budget = &budgets[i];
+            break;
+        }
+        if (!idle && (budgets[i].host == 0 || !findProbe(budgets[i].host, 0))) {
+            idle = &budgets[i];
+        }
+    }
+
+    if (!budget) {
+        // A host without probes left has nothing to protect
+        if (!idle) {
+            budgetWait = UDP_ICMP_INTERVAL;
+            return false;
+        }
+        budget = idle;
+        budget->host = host;
+        budget->tokens = UDP_ICMP_BURST;
+        budget->refilledAt = now;
+    }
+
+    unsigned long elapsed = now - budget->refilledAt;
+    if (elapsed >= UDP_ICMP_INTERVAL) {
+        unsigned long earned = elapsed / UDP_ICMP_INTERVAL;
+        budget->tokens = earned + budget->tokens >= UDP_ICMP_BURST ? UDP_ICMP_BURST : budget->tokens + earned;
+        budget->refilledAt += earned * UDP_ICMP_INTERVAL;
+        elapsed = now - budget->refilledAt;
+    }
+
+    if (budget->tokens == 0) {
+        unsigned long left = UDP_ICMP_INTERVAL - elapsed;
+        if (budgetWait == 0 || left < budgetWait) {
+            budgetWait = left;
+        }
+        return false;
+    }
+
+    budget->tokens--;
+    return true;
+}
+
+void UdpScanner::sendQueued(PortProbeCallback& callback) {
+    if (fd < 0) {
+        bool waiting = false;
+        for (size_t i = 0; i < UDP_SCAN_SLOTS; i++) {
+            if (probes[i].target != 0 && !probes[i].sent) {
+                waiting = true;
+                break;
+            }
+        }
+        if (!waiting) {
+            return;
+        }
+        if (!openSocket()) {
+            // Out of sockets; counts as a lost datagram for every queued probe
+            for (size_t i = 0; i < UDP_SCAN_SLOTS; i++) {
+                Probe& probe = probes[i];
+                if (probe.target != 0 && !probe.sent && ++probe.attempts >= MAX_RETRY_ATTEMPTS) {
+                    finish(probe, PORT_FILTERED, 0, callback);
+                }
+            }
+            return;
+        }
+    }
+
+    unsigned long now = millis();
+    size_t sent = 0;
+    budgetWait = 0;
+
+    for (size_t i = 0; i < UDP_SCAN_SLOTS && sent < UDP_SEND_BATCH; i++) {
+        Probe& probe = probes[i];
+        if (probe.target == 0 || probe.sent) {
+            continue;
+        }
+        IPAddress host(probe.target);
+        if (!takeToken(probe.target, now)) {
+            continue;
+        }
+        if (!probePacer.tryAcquire(host, &pacerWait)) {
+            // The token is spent but the host is no worse off for it
+            continue;
+        }
+
+        const UdpPayload& payload = findPayload(probe.port);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(probe.port);
+        addr.sin_addr.s_addr = probe.target;
+
+        probe.attempts++;
+        if (sendto(fd, payload.data, payload.length, 0, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            probePacer.release(host);
+            if (errno == EHOSTUNREACH || errno == ENETUNREACH) {
+                finish(probe, PORT_UNREACHABLE, 0, callback);
+            } else if (probe.attempts >= MAX_RETRY_ATTEMPTS) {
+                // Out of pbufs every time
+                finish(probe, PORT_FILTERED, 0, callback);
+            }
+            continue;
+        }
+
+        // Services answer slower than a TCP stack does, so the floor is higher
+        unsigned long timeout = rttEstimator.getTimeout(host, PORT_TIMEOUT);
+        probe.sent = true;
+        probe.sentAt = now;
+        probe.timeout = timeout < UDP_MIN_TIMEOUT ? UDP_MIN_TIMEOUT : timeout;
+        sent++;
+    }
+}
+
+void UdpScanner::drainReplies(PortProbeCallback& callback) {
+    if (fd < 0) {
+        return;
+    }
+
+    // Only the sender matters; a short buffer drops the rest of the datagram
+    uint8_t buffer[16];
+    for (;;) {
+        struct sockaddr_in from;
+        socklen_t length = sizeof(from);
+        int received = recvfrom(fd, buffer, sizeof(buffer), 0, (struct sockaddr*)&from, &length);
+        if (received < 0) {
+            break;
+        }
+
+        Probe* probe = findProbe(from.sin_addr.s_addr, ntohs(from.sin_port));
+        if (!probe || probe->attempts == 0) {
+            continue;
+        }
+
+        // A late answer to an earlier attempt still proves the port open
+        IPAddress host(probe->target);
+        unsigned long rtt = millis() - probe->sentAt;
+        if (probe->sent) {
+            rttEstimator.addSample(host, rtt);
+            probePacer.release(host);
+        }
+        finish(*probe, PORT_OPEN, rtt, callback);
+    }
+}
+
+void UdpScanner::drainIcmp(PortProbeCallback& callback) {
+    IcmpError errors[UDP_ICMP_RING];
+    size_t count = 0;
+
+    portENTER_CRITICAL(&lock);
+    while (ringCount > 0) {
+        errors[count++] = ring[ringHead];
+        ringHead = (ringHead + 1) % UDP_ICMP_RING;
+        ringCount--;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    for (size_t i = 0; i < count; i++) {
+        const IcmpError& error = errors[i];
+        Probe* probe = findProbe(error.target, error.port);
+        if (!probe || probe->attempts == 0) {
+            continue;
+        }
+
+        // Port unreachable is the host's own answer; the others usually
+        // come from a router or firewall on the way
+        PortState state;
+        if (error.code == ICMP_PORT_UNREACHABLE) {
+            state = PORT_CLOSED;
+        } else if (error.code == ICMP_NET_UNREACHABLE || error.code == ICMP_HOST_UNREACHABLE) {
+            state = PORT_UNREACHABLE;
+        } else {
+            state = PORT_FILTERED;
+        }
+
+        IPAddress host(probe->target);
+        unsigned long rtt = error.receivedAt - probe->sentAt;
+        if (probe->sent) {
+            if (state == PORT_CLOSED) {
+                rttEstimator.addSample(host, rtt);
+            }
+            probePacer.release(host);
+        }
+        finish(*probe, state, rtt, callback);
+    }
+}
+
+void UdpScanner::expireProbes(PortProbeCallback& callback) {
+    unsigned long now = millis();
+
+    for (size_t i = 0; i < UDP_SCAN_SLOTS; i++) {
+        Probe& probe = probes[i];
+        if (probe.target == 0 || !probe.sent || now - probe.sentAt < probe.timeout) {
+            continue;
+        }
+
+        // Silence is the normal answer of an open UDP port, so it is not
+        // fed to the RTT estimator as a loss
+        probePacer.release(IPAddress(probe.target));
+
+        if (probe.attempts < MAX_RETRY_ATTEMPTS) {
+            probe.sent = false;
+            continue;
+        }
+        finish(probe, PORT_OPEN_FILTERED, now - probe.sentAt, callback);
+    }
+}
+
+void UdpScanner::finish(Probe& probe, PortState state, unsigned long responseTime, PortProbeCallback& callback) {
+    PortProbeResult result = {IPAddress(probe.target), probe.port, state, responseTime, probe.attempts, nullptr, 0};
+
+    memset(&probe, 0, sizeof(probe));
+    used--;
+
+    if (callback) {
+        callback(result);
+    }
+}
+
+UdpScanner::Probe* UdpScanner::findProbe(uint32_t target, uint16_t port) {
+    // Port 0 matches any probe to the host
+    for (size_t i = 0; i < UDP_SCAN_SLOTS; i++) {
+        if (probes[i].target == target && (port == 0 || probes[i].port == port)) {
+            return &probes[i];
+        }
+    }
+    return nullptr;
+}
+
+err_t UdpScanner::openPcb(struct tcpip_api_call_data* data) {
+    UdpOpenCall* msg = (UdpOpenCall*)data;
+
+    msg->pcb = raw_new(IP_PROTO_ICMP);
+    if (!msg->pcb) {
+        return ERR_MEM;
+    }
+    raw_recv(msg->pcb, receive, msg->scanner);
+    return ERR_OK;
+}
+
+u8_t UdpScanner::receive(void* arg, struct raw_pcb* pcb, struct pbuf* p, const ip_addr_t* addr) {
+    UdpScanner* scanner = (UdpScanner*)arg;
+    uint16_t port = scanner->listenPort;
+    if (port == 0) {
+        return 0;
+    }
+
+    // The payload starts at the IPv4 header; the ICMP error quotes the
+    // IPv4 header and first 8 bytes of the datagram that caused it
+    uint8_t versionLength = 0;
+    if (pbuf_copy_partial(p, &versionLength, 1, 0) != 1) {
+        return 0;
+    }
+    uint16_t headerLength = (versionLength & 0x0F) * 4;
+
+    uint8_t icmp[8 + 20];
+    if (pbuf_copy_partial(p, icmp, sizeof(icmp), headerLength) != sizeof(icmp) ||
+        icmp[0] != ICMP_DEST_UNREACHABLE || icmp[8 + 9] != IP_PROTO_UDP) {
+        return 0;
+    }
+    uint16_t quotedLength = (icmp[8] & 0x0F) * 4;
+
+    uint8_t udp[4];
+    if (pbuf_copy_partial(p, udp, sizeof(udp), headerLength + 8 + quotedLength) != sizeof(udp) ||
+        getU16(udp) != port) {
+        return 0;
+    }
+
+    IcmpError error;
+    memcpy(&error.target, icmp + 8 + 16, sizeof(error.target));
+    error.port = getU16(udp + 2);
+    error.code = icmp[1];
+    error.receivedAt = millis();
+
+    portENTER_CRITICAL(&scanner->lock);
+    if (scanner->ringCount < UDP_ICMP_RING) {
+        scanner->ring[(scanner->ringHead + scanner->ringCount) % UDP_ICMP_RING] = error;
+        scanner->ringCount++;
+    } else {
+        scanner->dropped++;
+    }
+    portEXIT_CRITICAL(&scanner->lock);
+
+    // Never eaten: ping and lwIP's own ICMP handling still see the packet
+    return 0;
+}
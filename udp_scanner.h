@@ -0,0 +1,108 @@
+/*
+ * UDP Scanner Header
+ * UDP port probing over one socket, with ICMP port-unreachable correlation
+ */
+
+#ifndef UDP_SCANNER_H
+#define UDP_SCANNER_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <freertos/FreeRTOS.h>
+#include <lwip/raw.h>
+#include "config.h"
+#include "port_probe_engine.h"
+
+struct tcpip_api_call_data;
+
+class UdpScanner {
+public:
+    UdpScanner();
+
+    // Open the ICMP raw PCB; without one every silent port is open|filtered
+    // and closed ports cannot be told apart
+    bool begin();
+    bool isReady();
+
+    // Queue a probe; false when every slot is taken (poll, then try again)
+    bool add(IPAddress target, uint16_t port);
+
+    // Send queued datagrams, match replies and ICMP errors, and expire
+    // silent probes; returns false once nothing is queued or outstanding
+    bool poll(PortProbeCallback callback, unsigned long waitMs = SWEEP_POLL_INTERVAL);
+
+    // Drop everything queued or outstanding without reporting it
+    void stop();
+
+    bool isBusy();
+    size_t getPending();
+
+    // ICMP errors lost because the ring was full (the probes retry)
+    uint32_t getDropped();
+
+private:
+    struct Probe {
+        uint32_t target;          // Network order, 0 = free slot
+        uint16_t port;
+        uint8_t attempts;         // Datagrams sent so far
+        bool sent;                // Waiting on a reply
+        unsigned long sentAt;
+        unsigned long timeout;
+    };
+
+    // Hosts rate-limit their ICMP errors (Linux: a burst of 6, then one a
+    // second), so each host gets a matching token bucket; probing faster
+    // would turn closed ports into open|filtered ones
+    struct HostBudget {
+        uint32_t host;            // Network order, 0 = free
+        uint8_t tokens;
+        unsigned long refilledAt;
+    };
+
+    // Port unreachable (or another type 3 code) quoting one of our datagrams
+    struct IcmpError {
+        uint32_t target;          // Destination of the quoted datagram, network order
+        uint16_t port;
+        uint8_t code;
+        unsigned long receivedAt;
+    };
+
+    struct raw_pcb* pcb;
+    int fd;
+    Probe probes[UDP_SCAN_SLOTS];
+    size_t used;
+    HostBudget budgets[UDP_HOST_SLOTS];
+    unsigned long pacerWait;
+    unsigned long budgetWait;
+
+    // Local port of the scan socket; 0 while idle, so the ICMP hook
+    // ignores everything between scans
+    volatile uint16_t listenPort;
+
+    // Filled by the lwIP thread, drained by poll()
+    IcmpError ring[UDP_ICMP_RING];
+    size_t ringHead;
+    size_t ringCount;
+    uint32_t dropped;
+    portMUX_TYPE lock;
+
+    // One socket per scan session, closed once the last probe is reported
+    bool openSocket();
+    void closeSocket();
+
+    // Take one probe from a host's budget; sets budgetWait when empty
+    bool takeToken(uint32_t host, unsigned long now);
+
+    void sendQueued(PortProbeCallback& callback);
+    void drainReplies(PortProbeCallback& callback);
+    void drainIcmp(PortProbeCallback& callback);
+    void expireProbes(PortProbeCallback& callback);
+    void finish(Probe& probe, PortState state, unsigned long responseTime, PortProbeCallback& callback);
+    Probe* findProbe(uint32_t target, uint16_t port);
+
+    // Run in the lwIP thread
+    static err_t openPcb(struct tcpip_api_call_data* data);
+    static u8_t receive(void* arg, struct raw_pcb* pcb, struct pbuf* p, const ip_addr_t* addr);
+};
+
+#endif // UDP_SCANNER_H
@@ -6,8 +6,28 @@ Validates the Arduino code structure and syntax
 
 import os
 import re
+import shutil
+import subprocess
 import sys
 
+# Host tests: each test source with the sketch modules it exercises. They
+# are built with g++ against the stand-in headers in test/stubs and run
+HOST_TEST_BUILD_DIR = os.path.join('test', 'build')
+HOST_TEST_STUBS = ['test/stubs/host_runtime.cpp']
+HOST_TESTS = [
+    ('test/bench_sweep_engine.cpp',
+     ['sweep_engine.cpp', 'probe_pacer.cpp', 'rtt_estimator.cpp', 'target_iterator.cpp']),
+    ('test/test_probe_pacer.cpp', ['probe_pacer.cpp']),
+    ('test/test_syn_scanner.cpp', ['syn_scanner.cpp', 'probe_pacer.cpp', 'rtt_estimator.cpp']),
+    ('test/test_bacnet.cpp',
+     ['bacnet_codec.cpp', 'bacnet_client.cpp', 'bacnet_discovery.cpp', 'probe_pacer.cpp', 'target_iterator.cpp']),
+    ('test/test_results_stream.cpp',
+     ['web_interface.cpp', 'http_server.cpp', 'chunked_response.cpp', 'web_assets.cpp', 'scan_result.cpp',
+      'string_pool.cpp', 'service_catalog.cpp', 'fingerprint.cpp', 'tls_probe.cpp', 'modbus_client.cpp',
+      'enip_discovery.cpp', 'bacnet_client.cpp', 'bacnet_discovery.cpp', 'bacnet_codec.cpp',
+      'target_iterator.cpp', 'probe_pacer.cpp', 'rtt_estimator.cpp', 'connect_pool.cpp']),
+]
+
 def validate_file_structure():
     """Check if all required files exist"""
     required_files = [
@@ -20,7 +40,62 @@ def validate_file_structure():
         'web_interface.h',
         'web_interface.cpp',
         'wifi_manager.h',
-        'wifi_manager.cpp'
+        'wifi_manager.cpp',
+        'net_utils.h',
+        'connect_pool.h',
+        'connect_pool.cpp',
+        'sweep_engine.h',
+        'sweep_engine.cpp',
+        'arp_scanner.h',
+        'arp_scanner.cpp',
+        'rtt_estimator.h',
+        'rtt_estimator.cpp',
+        'host_table.h',
+        'host_table.cpp',
+        'target_iterator.h',
+        'target_iterator.cpp',
+        'scan_task.h',
+        'scan_task.cpp',
+        'probe_pacer.h',
+        'probe_pacer.cpp',
+        'port_probe_engine.h',
+        'port_probe_engine.cpp',
+        'syn_scanner.h',
+        'syn_scanner.cpp',
+        'bacnet_discovery.h',
+        'bacnet_discovery.cpp',
+        'bacnet_codec.h',
+        'bacnet_codec.cpp',
+        'bacnet_client.h',
+        'bacnet_client.cpp',
+        'modbus_client.h',
+        'modbus_client.cpp',
+        'enip_discovery.h',
+        'enip_discovery.cpp',
+        'fingerprint.h',
+        'fingerprint.cpp',
+        'banner_grabber.h',
+        'banner_grabber.cpp',
+        'tls_probe.h',
+        'tls_probe.cpp',
+        'udp_scanner.h',
+        'udp_scanner.cpp',
+        'port_result_store.h',
+        'port_result_store.cpp',
+        'string_pool.h',
+        'string_pool.cpp',
+        'scan_result.h',
+        'scan_result.cpp',
+        'service_catalog.h',
+        'service_catalog.cpp',
+        'chunked_response.h',
+        'chunked_response.cpp',
+        'http_server.h',
+        'http_server.cpp',
+        'web_assets.h',
+        'web_assets.cpp',
+        'web/style.css',
+        'web/app.js'
     ]
     
     missing_files = []
@@ -69,7 +144,33 @@ def validate_syntax():
         'network_scanner.cpp',
         'port_scanner.cpp',
         'web_interface.cpp',
-        'wifi_manager.cpp'
+        'wifi_manager.cpp',
+        'connect_pool.cpp',
+        'sweep_engine.cpp',
+        'arp_scanner.cpp',
+        'rtt_estimator.cpp',
+        'host_table.cpp',
+        'target_iterator.cpp',
+        'scan_task.cpp',
+        'probe_pacer.cpp',
+        'port_probe_engine.cpp',
+        'syn_scanner.cpp',
+        'bacnet_discovery.cpp',
+        'bacnet_codec.cpp',
+        'bacnet_client.cpp',
+        'modbus_client.cpp',
+        'enip_discovery.cpp',
+        'fingerprint.cpp',
+        'banner_grabber.cpp',
+        'tls_probe.cpp',
+        'udp_scanner.cpp',
+        'port_result_store.cpp',
+        'string_pool.cpp',
+        'scan_result.cpp',
+        'service_catalog.cpp',
+        'chunked_response.cpp',
+        'http_server.cpp',
+        'web_assets.cpp'
     ]
     
     for file in files_to_check:
@@ -97,7 +198,7 @@ def validate_configuration():
         'ETH_CONNECTION_TIMEOUT',
         'SCAN_TIMEOUT',
         'PORT_TIMEOUT',
-        'TARGET_PORTS'
+        'DEFAULT_SCAN_PROFILE'
     ]
     
     for define in required_defines:
@@ -108,6 +209,45 @@ def validate_configuration():
     print("✅ Configuration validation passed")
     return True
 
+def validate_web_assets():
+    """Check that web_assets.h/.cpp were rebuilt after web/ changed"""
+    import build_web_assets
+    if not build_web_assets.is_current():
+        print("❌ Web assets are stale; run python3 build_web_assets.py")
+        return False
+    print("✅ Web assets are up to date")
+    return True
+
+def validate_host_tests():
+    """Build and run the host tests (skipped when no g++ is installed)"""
+    compiler = shutil.which('g++')
+    if not compiler:
+        print("⚠️  g++ not found; host tests skipped")
+        return True
+
+    os.makedirs(HOST_TEST_BUILD_DIR, exist_ok=True)
+    passed = True
+    for test, sources in HOST_TESTS:
+        name = os.path.splitext(os.path.basename(test))[0]
+        binary = os.path.join(HOST_TEST_BUILD_DIR, name)
+        build = [compiler, '-std=gnu++11', '-O1', '-g', '-Wall', '-Wno-unused-function',
+                 '-Itest/stubs', '-Itest', '-I.', '-o', binary, test] + \
+                sources + HOST_TEST_STUBS + ['-lpthread']
+        result = subprocess.run(build, capture_output=True, text=True)
+        if result.returncode != 0:
+            print(f"❌ {test} failed to build:\n{result.stderr}")
+            passed = False
+            continue
+
+        result = subprocess.run([binary], capture_output=True, text=True, timeout=300)
+        if result.returncode != 0:
+            print(f"❌ {test} failed:\n{result.stdout}{result.stderr}")
+            passed = False
+            continue
+        print(f"✅ {result.stdout.strip().splitlines()[-1]}")
+
+    return passed
+
 def print_compilation_instructions():
     """Print instructions for compiling the code"""
     print("\n" + "="*60)
@@ -153,7 +293,6 @@ To compile and upload this ESP32 network discovery tool:
 7. Required Libraries:
    - ESP32 Arduino Core
    - ArduinoJson (install via Library Manager)
-   - WebServer (included with ESP32 core)
    - SPIFFS (included with ESP32 core)
 
 The tool provides both serial interface and web-based control
@@ -170,6 +309,8 @@ def main():
     validation_passed &= validate_includes()
     validation_passed &= validate_syntax()
     validation_passed &= validate_configuration()
+    validation_passed &= validate_web_assets()
+    validation_passed &= validate_host_tests()
     
     if validation_passed:
         print("\n✅ All validations passed!")
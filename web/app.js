@@ -0,0 +1,125 @@
+// ESP32 Network Discovery - page scripts
+// Served gzipped from flash; run python3 build_web_assets.py after editing
+
+// Scan status on whichever page carries it: status and device count
+// (home, results) and the progress bar of a running scan (scan page)
+function showStatus(data) {
+    const status = document.getElementById('scan-status');
+    if (status) {
+        status.textContent = data.status;
+    }
+    const count = document.getElementById('device-count');
+    if (count) {
+        count.textContent = data.deviceCount;
+    }
+    const progress = document.getElementById('scan-progress');
+    if (progress) {
+        progress.style.display = data.scanRunning ? 'block' : 'none';
+        document.getElementById('progress-fill').style.width = data.progress + '%';
+        document.getElementById('progress-text').textContent = data.status;
+    }
+}
+
+function refreshStatus() {
+    fetch('/api?action=status')
+        .then(response => response.json())
+        .then(showStatus);
+}
+
+// Live updates from /events: the status, each new result row (its id is
+// the row number) and the clearing of the results. Pages fall back to
+// polling when the server has no stream to spare
+function followEvents() {
+    const source = new EventSource('/events');
+    source.addEventListener('status', event => showStatus(JSON.parse(event.data)));
+
+    const rows = document.getElementById('result-rows');
+    if (rows) {
+        source.addEventListener('result', event => {
+            const row = Number(event.lastEventId);
+            if (row > rows.rows.length + 1) {
+                location.reload();      // Rows went missing; the page has them all
+            } else if (row === rows.rows.length + 1) {
+                rows.insertAdjacentHTML('beforeend', event.data);
+            }
+        });
+        source.addEventListener('clear', () => {
+            rows.innerHTML = '';
+        });
+        source.addEventListener('dropped', () => location.reload());
+    }
+
+    source.onerror = () => {
+        // A refused stream is closed for good; a dropped one reconnects
+        if (source.readyState === EventSource.CLOSED) {
+            setInterval(refreshStatus, 2000);
+        }
+    };
+}
+
+// Configuration page
+function toggleStatic() {
+    const checkbox = document.querySelector('input[name="dhcp"]');
+    const staticConfig = document.getElementById('static-config');
+    staticConfig.style.display = checkbox.checked ? 'none' : 'block';
+}
+
+// Results page
+function clearResults() {
+    if (confirm('Are you sure you want to clear all results?')) {
+        fetch('/api?action=clear_results', {method: 'POST'})
+            .then(() => location.reload());
+    }
+}
+
+// WiFi page
+function toggleWiFiStatic() {
+    const checkbox = document.querySelector('input[name="use_static_ip"]');
+    const staticConfig = document.getElementById('wifi-static-config');
+    staticConfig.style.display = checkbox.checked ? 'block' : 'none';
+}
+
+// The device scans in the background; ask again until it has finished
+function scanNetworks() {
+    fetch('/wifi-scan')
+        .then(response => response.json())
+        .then(data => {
+            if (data.scanning) {
+                document.getElementById('network-list').innerHTML = '<p>Scanning...</p>';
+                document.getElementById('scan-results').style.display = 'block';
+                setTimeout(scanNetworks, 1000);
+                return;
+            }
+            let html = '<table class="results-table"><thead><tr><th>SSID</th><th>Signal</th><th>Encryption</th><th>Known</th><th>Action</th></tr></thead><tbody>';
+            data.networks.forEach(network => {
+                html += '<tr>';
+                html += '<td>' + network.ssid + '</td>';
+                html += '<td>' + network.rssi + ' dBm</td>';
+                html += '<td>' + network.encryption + '</td>';
+                html += '<td>' + (network.isKnown ? 'Yes' : 'No') + '</td>';
+                html += '<td><button onclick="selectNetwork(\'' + network.ssid + '\');">Select</button></td>';
+                html += '</tr>';
+            });
+            html += '</tbody></table>';
+            document.getElementById('network-list').innerHTML = html;
+            document.getElementById('scan-results').style.display = 'block';
+        });
+}
+
+function selectNetwork(ssid) {
+    document.querySelector('input[name="ssid"]').value = ssid;
+    document.getElementById('scan-results').style.display = 'none';
+}
+
+function removeNetwork(ssid) {
+    if (confirm('Remove network: ' + ssid + '?')) {
+        // Implementation for removing network would go here
+        location.reload();
+    }
+}
+
+// Pages follow the events by carrying the elements they update; the
+// script is deferred, so the document is parsed by now
+if (document.getElementById('device-count') || document.getElementById('scan-progress')) {
+    followEvents();
+}
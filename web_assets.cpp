@@ -0,0 +1,162 @@
+/*
+ * Web Assets Implementation
+ * Generated by build_web_assets.py from web/; do not edit
+ */
+
+#include "web_assets.h"
+
+// style.css: 1407 bytes, 579 gzipped
+static const uint8_t ASSET_STYLE_CSS[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x7d, 0x54, 0xdb, 0x6a, 0xe3, 0x30,
+    0x10, 0x7d, 0xef, 0x57, 0x08, 0xca, 0xc2, 0x2e, 0x54, 0xc1, 0x4e, 0xec, 0x26, 0x75, 0x9e, 0xf6,
+    0x53, 0xc6, 0xd2, 0xc8, 0x16, 0x55, 0x24, 0x23, 0xc9, 0x4d, 0xca, 0xd2, 0x7f, 0xdf, 0xf1, 0x2d,
+    0xbe, 0x34, 0xbb, 0x98, 0x40, 0xb0, 0x67, 0xce, 0x6d, 0x46, 0x2a, 0x9d, 0xfc, 0x64, 0x7f, 0x98,
+    0x72, 0x36, 0x72, 0x05, 0x17, 0x6d, 0x3e, 0x0b, 0xf6, 0xdb, 0x6b, 0x30, 0x2f, 0x2c, 0x80, 0x0d,
+    0x3c, 0xa0, 0xd7, 0xea, 0xcc, 0x2e, 0xe0, 0x2b, 0x6d, 0x0b, 0xb6, 0x4f, 0x9a, 0xdb, 0x99, 0x95,
+    0x20, 0xde, 0x2b, 0xef, 0x5a, 0x2b, 0xb9, 0x70, 0xc6, 0xf9, 0x82, 0x3d, 0xab, 0xbc, 0x7b, 0xce,
+    0xec, 0xeb, 0x69, 0x27, 0x08, 0x0b, 0xb4, 0x45, 0x4f, 0xb8, 0x17, 0xb8, 0xf1, 0xab, 0x96, 0xb1,
+    0x2e, 0xd8, 0x29, 0xe9, 0x7b, 0x27, 0xa4, 0x84, 0x41, 0x1b, 0xdd, 0x12, 0xab, 0x60, 0xd7, 0x5a,
+    0x47, 0x3c, 0xb3, 0x06, 0xa4, 0xd4, 0xb6, 0xba, 0xb3, 0x39, 0x2f, 0xd1, 0x73, 0x0f, 0x52, 0xb7,
+    0x81, 0x70, 0x86, 0x77, 0x37, 0x1e, 0x6a, 0x90, 0xee, 0xda, 0x21, 0xed, 0x9b, 0x1b, 0xcb, 0xe8,
+    0xe7, 0xab, 0x12, 0x7e, 0x26, 0x2f, 0xfd, 0xb3, 0x4b, 0x7f, 0xf5, 0x6a, 0xca, 0x68, 0x49, 0x87,
+    0xd4, 0xa1, 0x31, 0x40, 0xde, 0xb4, 0x35, 0x24, 0x8d, 0x97, 0xc6, 0x89, 0xf7, 0x05, 0x53, 0x4a,
+    0x4c, 0x23, 0xdd, 0x24, 0x30, 0x5f, 0x3b, 0x25, 0x8f, 0x49, 0x72, 0x2c, 0x15, 0x85, 0x31, 0x7a,
+    0x1e, 0xd5, 0x46, 0xbc, 0x45, 0x2e, 0x51, 0x38, 0x0f, 0x51, 0x3b, 0x6a, 0xb4, 0xce, 0xe2, 0x37,
+    0xd5, 0xd9, 0xec, 0x64, 0xaa, 0x10, 0xad, 0x0f, 0x1d, 0x4e, 0xe3, 0xb4, 0x8d, 0xe8, 0x27, 0xb5,
+    0x45, 0xed, 0x3e, 0xfa, 0xec, 0x36, 0xdc, 0xf9, 0x6b, 0x79, 0xe8, 0x6b, 0x42, 0x84, 0xd8, 0x06,
+    0xde, 0x80, 0x45, 0xb3, 0x2d, 0xc3, 0x37, 0x14, 0xa8, 0x96, 0xc6, 0xf2, 0x07, 0x11, 0x66, 0x4b,
+    0x9f, 0x9d, 0x6b, 0x96, 0xf4, 0xc8, 0x16, 0x3e, 0x78, 0xd9, 0xc6, 0xe8, 0x6c, 0x20, 0xe0, 0xde,
+    0x18, 0x18, 0x5d, 0x51, 0x91, 0xc0, 0x41, 0xe2, 0x83, 0x26, 0xe5, 0xfc, 0x85, 0x77, 0x02, 0x9a,
+    0x7e, 0xde, 0xc3, 0xf7, 0x8e, 0xf6, 0xfb, 0x77, 0x03, 0x65, 0x2f, 0xf9, 0x3e, 0x8d, 0x71, 0x0c,
+    0x43, 0x17, 0x2f, 0x1d, 0x51, 0x5f, 0xc6, 0xe4, 0xfb, 0x8d, 0xbc, 0xa2, 0xae, 0xea, 0x48, 0x75,
+    0xce, 0xc8, 0x2d, 0x98, 0xb6, 0x4d, 0x1b, 0x5f, 0xd8, 0xf2, 0x55, 0x40, 0x83, 0x22, 0x12, 0xc1,
+    0xb8, 0x72, 0x69, 0x92, 0xfc, 0x58, 0x64, 0x71, 0x5a, 0xce, 0x20, 0x25, 0x81, 0xc1, 0x19, 0x2d,
+    0xd9, 0xb3, 0x94, 0xf2, 0x71, 0x44, 0x44, 0xe8, 0x31, 0xb4, 0x26, 0x06, 0x1e, 0xa1, 0x34, 0xb8,
+    0x45, 0x1e, 0x7b, 0x68, 0x1f, 0x0c, 0x34, 0x01, 0x0b, 0x36, 0xfd, 0x7b, 0x18, 0xd4, 0x1a, 0x2a,
+    0xd6, 0xa4, 0x7d, 0xf3, 0x4a, 0x12, 0xc1, 0x6a, 0x25, 0xcf, 0xab, 0x21, 0x18, 0x54, 0xf1, 0x4e,
+    0x3a, 0x85, 0xb5, 0xf5, 0xf1, 0x80, 0x68, 0xb5, 0x24, 0xf3, 0x89, 0x3d, 0xa9, 0x37, 0x05, 0xff,
+    0x0a, 0xba, 0x71, 0x3e, 0x72, 0xd7, 0x60, 0x77, 0x78, 0xa6, 0x8e, 0xfd, 0x09, 0x8e, 0x59, 0xfe,
+    0xdf, 0x0e, 0x61, 0x5c, 0x40, 0xb9, 0xe8, 0x91, 0xe2, 0x90, 0x67, 0xf9, 0x5c, 0xa0, 0xb4, 0xa1,
+    0x45, 0x5a, 0x95, 0x28, 0x79, 0xc4, 0x34, 0x9b, 0x4b, 0x5a, 0xeb, 0x11, 0x44, 0x3d, 0x06, 0x3e,
+    0x55, 0xbd, 0x8a, 0x63, 0x7e, 0x1c, 0x99, 0xbc, 0xab, 0xc8, 0x63, 0xe0, 0x25, 0xf8, 0xed, 0x48,
+    0xea, 0x51, 0xd6, 0xf6, 0xa2, 0x5a, 0x9c, 0x8d, 0xcd, 0xa4, 0x87, 0x9c, 0xbb, 0x33, 0xa7, 0x4c,
+    0x77, 0x9d, 0xd4, 0x5a, 0x4a, 0xb4, 0xf3, 0x04, 0xd3, 0x79, 0x82, 0x77, 0x62, 0x72, 0xd1, 0xed,
+    0xf1, 0x44, 0x36, 0x6e, 0xc3, 0xa3, 0xbb, 0x22, 0x7a, 0xba, 0x45, 0xf5, 0x70, 0x31, 0xf4, 0x42,
+    0x59, 0xb2, 0x3b, 0x04, 0x86, 0xd0, 0x2d, 0xc9, 0xd7, 0xd3, 0x5f, 0xf0, 0x95, 0x52, 0x6b, 0x7f,
+    0x05, 0x00, 0x00
+};
+
+// app.js: 4857 bytes, 1657 gzipped
+static const uint8_t ASSET_APP_JS[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xad, 0x58, 0x5f, 0x6f, 0xdb, 0x36,
+    0x10, 0x7f, 0xcf, 0xa7, 0x20, 0x02, 0x0c, 0x92, 0xd1, 0x58, 0x6e, 0xd7, 0xb7, 0x3a, 0x76, 0x90,
+    0xb6, 0x19, 0x96, 0x2d, 0x4b, 0x8b, 0x38, 0xc0, 0x30, 0xac, 0x43, 0x40, 0x8b, 0x94, 0xc5, 0x46,
+    0x26, 0x35, 0x92, 0x8a, 0xeb, 0xb5, 0xfe, 0xee, 0xbb, 0x3b, 0x4a, 0xb2, 0x6c, 0x27, 0x8d, 0xd3,
+    0xd6, 0x0f, 0xb6, 0x44, 0x1e, 0xef, 0xff, 0xfd, 0xee, 0xe8, 0xc1, 0x80, 0x9d, 0x4d, 0xde, 0xbf,
+    0xfc, 0x99, 0x5d, 0x4a, 0xbf, 0x30, 0xf6, 0x96, 0xbd, 0x55, 0x2e, 0x35, 0x77, 0xd2, 0x2e, 0x59,
+    0x9f, 0x95, 0x7c, 0x26, 0x99, 0x4b, 0xad, 0x2a, 0xbd, 0x3b, 0x18, 0x0c, 0xd8, 0x44, 0xda, 0x3b,
+    0x29, 0xd8, 0xec, 0x3f, 0x55, 0x96, 0xf0, 0x9b, 0x59, 0x33, 0x67, 0x59, 0xc1, 0x5d, 0x3e, 0x64,
+    0xb6, 0xd2, 0xac, 0x5c, 0xfa, 0xdc, 0xe8, 0x97, 0x6c, 0x5a, 0xa9, 0x42, 0xdc, 0x2c, 0xe4, 0xf4,
+    0x86, 0x3b, 0x27, 0xbd, 0x4b, 0xca, 0x25, 0xe3, 0x99, 0x97, 0x96, 0x49, 0xa1, 0xbc, 0xd2, 0xb3,
+    0x03, 0x62, 0x96, 0x72, 0xcd, 0x9c, 0xe7, 0xbe, 0x72, 0xcc, 0x68, 0xb6, 0xc8, 0x55, 0x9a, 0x4b,
+    0x10, 0x1c, 0xa4, 0xa6, 0xdc, 0x5a, 0x25, 0x1d, 0x53, 0xfe, 0x55, 0x43, 0xc4, 0xb5, 0x60, 0x42,
+    0xde, 0xa9, 0x14, 0x76, 0x4d, 0xa5, 0x3d, 0x32, 0x89, 0x73, 0x33, 0x97, 0x47, 0xcc, 0x4a, 0x57,
+    0x15, 0xde, 0xf5, 0x88, 0xc6, 0xe7, 0x92, 0x95, 0xd6, 0xcc, 0x60, 0xd1, 0xb1, 0x29, 0xb7, 0xcc,
+    0x64, 0x8c, 0xa3, 0x82, 0x1a, 0x44, 0x83, 0x39, 0x20, 0x36, 0xa6, 0x6f, 0x14, 0xd4, 0x3b, 0xc8,
+    0x2a, 0x9d, 0x7a, 0x05, 0x1a, 0xb8, 0xdc, 0x2c, 0x26, 0x24, 0x2a, 0x16, 0xdc, 0xf3, 0x1e, 0xfb,
+    0x7c, 0xc0, 0xe0, 0x93, 0x1a, 0xed, 0x7c, 0xa3, 0xc3, 0x88, 0x09, 0x93, 0x56, 0x73, 0xa9, 0x7d,
+    0x32, 0x93, 0xfe, 0xac, 0x90, 0xf8, 0xf8, 0x7a, 0x79, 0x2e, 0xe2, 0x08, 0x59, 0xf6, 0x03, 0x59,
+    0xd4, 0x1b, 0xd2, 0x51, 0x95, 0x81, 0x24, 0x5a, 0x69, 0x98, 0xe1, 0x27, 0xac, 0x24, 0x5e, 0x7e,
+    0xf2, 0x6f, 0x8c, 0xf6, 0xc0, 0x00, 0xd9, 0x82, 0xc4, 0x24, 0xec, 0x84, 0xb3, 0xab, 0x8e, 0x70,
+    0x32, 0xf7, 0x6b, 0xb2, 0x83, 0x5b, 0xfa, 0x44, 0xd7, 0x15, 0x4e, 0x0b, 0x5d, 0xd9, 0xb4, 0x70,
+    0x9f, 0xe8, 0xc0, 0xe1, 0x0d, 0x6e, 0xef, 0xca, 0x6f, 0xbd, 0xf9, 0x98, 0xf9, 0x0d, 0x61, 0x57,
+    0x87, 0x66, 0xad, 0xab, 0x46, 0xb3, 0x06, 0x16, 0x2f, 0x0b, 0x99, 0x08, 0xe5, 0xca, 0x82, 0x2f,
+    0x5b, 0x37, 0x00, 0xab, 0xab, 0x3a, 0x5c, 0x27, 0x2c, 0x9a, 0x16, 0x26, 0xbd, 0x8d, 0xd8, 0x2b,
+    0x16, 0x69, 0xa3, 0x65, 0x34, 0x6c, 0xb9, 0x3c, 0xa8, 0x4b, 0xc3, 0xbe, 0x9f, 0xa9, 0xa2, 0x88,
+    0x7a, 0xb5, 0x94, 0x85, 0x12, 0x3e, 0x6f, 0x64, 0xb4, 0x26, 0x3d, 0x63, 0xd1, 0x4f, 0x4f, 0xe2,
+    0x89, 0xce, 0x03, 0x9e, 0x8f, 0x86, 0x6f, 0x75, 0xb0, 0x4e, 0x2d, 0x2b, 0x33, 0x38, 0x9b, 0xd7,
+    0xd9, 0xd5, 0x78, 0x22, 0x93, 0x3e, 0xcd, 0xe3, 0x68, 0xc0, 0x4b, 0x75, 0xc2, 0x89, 0x70, 0xd4,
+    0xe4, 0x4f, 0xab, 0x4f, 0x02, 0xd9, 0xac, 0x63, 0x38, 0x5c, 0x42, 0x24, 0x24, 0x1b, 0x8d, 0x59,
+    0xf3, 0x9c, 0x7c, 0x74, 0x46, 0xc7, 0xbd, 0x6d, 0xd2, 0x75, 0x16, 0x43, 0x0c, 0x56, 0x54, 0x69,
+    0x17, 0xea, 0x4e, 0xb2, 0xaa, 0x04, 0x1d, 0xa1, 0xa0, 0xa8, 0x68, 0x07, 0x50, 0x68, 0xda, 0xbb,
+    0x57, 0x54, 0x2b, 0x41, 0xe6, 0x11, 0x93, 0x3c, 0xcd, 0x99, 0x96, 0x8b, 0xba, 0x9a, 0x98, 0x35,
+    0x0b, 0x16, 0x2b, 0x0f, 0x35, 0x28, 0x98, 0xa2, 0xfa, 0x47, 0x6a, 0x5c, 0xd5, 0xd5, 0x7c, 0x2a,
+    0xed, 0xba, 0xda, 0xd2, 0x42, 0x72, 0x8b, 0xd1, 0x82, 0x4a, 0x23, 0x9a, 0x50, 0x8e, 0x09, 0x7b,
+    0x0f, 0x15, 0x06, 0x22, 0x79, 0x51, 0x40, 0x21, 0xa6, 0xb7, 0xcc, 0x1b, 0x64, 0x53, 0x9a, 0xa2,
+    0x40, 0xea, 0x05, 0xe8, 0x1b, 0x34, 0x40, 0x5c, 0xb1, 0x2c, 0xe7, 0x8e, 0x69, 0x03, 0xfa, 0x58,
+    0xc9, 0xe7, 0x40, 0xcb, 0x5c, 0xc9, 0xad, 0x5c, 0x7b, 0x31, 0x83, 0x73, 0x66, 0x71, 0x46, 0xaa,
+    0xc7, 0x5b, 0xe5, 0x69, 0x2a, 0x0b, 0xb8, 0x30, 0x22, 0xfd, 0x89, 0x62, 0x42, 0x2b, 0xe0, 0xdd,
+    0x60, 0x6a, 0x93, 0x91, 0x81, 0x30, 0xe1, 0x42, 0x10, 0xd5, 0x85, 0x72, 0x10, 0x41, 0x69, 0x21,
+    0x7f, 0x83, 0xe7, 0xc1, 0x0d, 0x77, 0x14, 0xd2, 0x71, 0x17, 0x0f, 0x7e, 0x9b, 0xbc, 0xbb, 0x4c,
+    0x40, 0x19, 0x27, 0x63, 0xda, 0x4e, 0x08, 0x20, 0x7a, 0xc0, 0xb3, 0xa3, 0x03, 0x78, 0xe6, 0xab,
+    0x15, 0x12, 0xbc, 0xd2, 0x47, 0xb2, 0x6e, 0x7d, 0xe0, 0xfb, 0x06, 0x3c, 0x3c, 0xa4, 0x61, 0x38,
+    0xdf, 0xd5, 0x70, 0x7d, 0x68, 0x43, 0x0b, 0x50, 0xe2, 0x92, 0x22, 0x54, 0x2b, 0x0b, 0x08, 0xed,
+    0x89, 0xd7, 0xb9, 0xe8, 0x0d, 0x37, 0x8e, 0xd4, 0xf2, 0xd9, 0x98, 0x94, 0x4f, 0xe8, 0xab, 0x90,
+    0x7a, 0x06, 0x75, 0xf2, 0x8c, 0xbd, 0xe8, 0x6d, 0x09, 0xc0, 0x0f, 0xd4, 0x22, 0xc7, 0x60, 0x24,
+    0x56, 0x16, 0x86, 0x8b, 0xb8, 0x37, 0x0c, 0xeb, 0x10, 0xd6, 0x2b, 0xb4, 0x7f, 0x81, 0xaa, 0xcd,
+    0x95, 0x73, 0x10, 0xe0, 0x61, 0x80, 0x62, 0x84, 0x73, 0x0c, 0x2d, 0xbc, 0xcc, 0x19, 0xa4, 0xc2,
+    0x06, 0xcf, 0x15, 0x93, 0x05, 0xe4, 0x75, 0xa3, 0xc8, 0x68, 0x34, 0xda, 0x5b, 0x15, 0x22, 0x51,
+    0x50, 0x09, 0xd6, 0x9f, 0x8a, 0x8f, 0x3c, 0x05, 0xc9, 0xbf, 0x5e, 0xff, 0x71, 0x11, 0x47, 0x53,
+    0x99, 0x19, 0x2b, 0xa5, 0x16, 0x8d, 0xaf, 0x42, 0xb8, 0x36, 0x4d, 0x5f, 0xb5, 0x6f, 0xab, 0xce,
+    0xce, 0x83, 0xce, 0xa7, 0x14, 0x07, 0x7e, 0x90, 0x77, 0x3b, 0x8e, 0xaf, 0x15, 0x01, 0x3a, 0x94,
+    0x0f, 0xde, 0x8f, 0x3a, 0x80, 0xb2, 0x17, 0x77, 0x61, 0x0d, 0x76, 0xd4, 0x96, 0xff, 0x8e, 0x97,
+    0x7b, 0x0d, 0xaa, 0x74, 0x93, 0x18, 0xd0, 0xd0, 0x5a, 0x63, 0x41, 0xe0, 0xb6, 0x56, 0x10, 0x8d,
+    0x53, 0x04, 0x9d, 0xca, 0x41, 0x9b, 0xae, 0xeb, 0x49, 0x39, 0xa8, 0x53, 0x83, 0x0b, 0xe0, 0x1d,
+    0x36, 0x33, 0x46, 0x0c, 0xa1, 0x2d, 0xd6, 0x92, 0xa1, 0x03, 0x63, 0xd9, 0x42, 0x0a, 0x69, 0x99,
+    0x42, 0xb3, 0xef, 0x26, 0x48, 0x2d, 0x0d, 0x98, 0x88, 0x25, 0xd6, 0x83, 0xa4, 0x28, 0x75, 0x8a,
+    0x2c, 0x79, 0x73, 0xf1, 0x6e, 0x72, 0xf6, 0x76, 0x3b, 0x46, 0xd0, 0xfa, 0xcf, 0x01, 0x1f, 0xed,
+    0x1d, 0x2f, 0xe2, 0x0d, 0x00, 0x3c, 0x62, 0x3f, 0x3f, 0x7f, 0xfe, 0xbc, 0xe3, 0x97, 0x10, 0x8b,
+    0x55, 0x83, 0x57, 0x00, 0xab, 0x99, 0x9a, 0x55, 0x96, 0x5c, 0x40, 0xf9, 0xb3, 0xc6, 0x00, 0x6f,
+    0x66, 0xb3, 0x42, 0x22, 0x1f, 0x95, 0x6e, 0x61, 0x00, 0x8c, 0x0f, 0xe9, 0xed, 0xd4, 0x7c, 0xea,
+    0xd6, 0xe0, 0xbf, 0x15, 0x4c, 0x32, 0x13, 0x59, 0x80, 0x51, 0x06, 0xfc, 0xac, 0x74, 0x59, 0xf9,
+    0xbf, 0x35, 0x9f, 0xcb, 0xd1, 0xa1, 0xc8, 0xd3, 0xf2, 0xf0, 0x9f, 0xa6, 0x12, 0xd7, 0x5d, 0x5e,
+    0xa5, 0x41, 0xfe, 0x57, 0x9b, 0x1d, 0xd1, 0x41, 0xbf, 0x45, 0xc2, 0x16, 0x5a, 0x3a, 0x87, 0x77,
+    0x1a, 0x5b, 0xa3, 0x5c, 0x42, 0x0f, 0xe0, 0xf0, 0x93, 0xba, 0x9d, 0x61, 0x5f, 0x0b, 0x1d, 0xae,
+    0x31, 0xff, 0x2a, 0xa0, 0xe7, 0x96, 0xe1, 0x94, 0x80, 0xf5, 0x56, 0x6b, 0x78, 0xe8, 0xf1, 0x20,
+    0xd0, 0xce, 0xe3, 0xe8, 0xd4, 0x4a, 0xb6, 0x34, 0x15, 0x73, 0x55, 0xfd, 0xb0, 0xe0, 0x50, 0x8b,
+    0x00, 0xa3, 0x74, 0x14, 0x2b, 0xaf, 0x01, 0xe6, 0x93, 0xa8, 0xd7, 0x0d, 0xd6, 0x3d, 0x7d, 0x88,
+    0x8e, 0xdc, 0xd4, 0xe4, 0x90, 0x96, 0x9f, 0xe7, 0x12, 0x66, 0x3b, 0x01, 0xba, 0xbe, 0x7f, 0x37,
+    0xb9, 0x8e, 0x56, 0xbd, 0x8d, 0x48, 0x87, 0xce, 0xf3, 0x58, 0xea, 0x06, 0xeb, 0xfe, 0x54, 0xbf,
+    0xa8, 0x7b, 0x63, 0x8a, 0x1b, 0x3f, 0x22, 0xae, 0x90, 0xf3, 0x37, 0x21, 0x14, 0x37, 0xea, 0x9b,
+    0x03, 0xbc, 0x50, 0x99, 0xea, 0xff, 0x98, 0x28, 0xef, 0x8c, 0x2f, 0xc1, 0x0f, 0xd7, 0x00, 0x8d,
+    0xf5, 0x34, 0x8b, 0xf3, 0x0e, 0x74, 0xd9, 0xd0, 0x0b, 0xb1, 0x4f, 0xce, 0x2c, 0xcc, 0x61, 0x58,
+    0x9e, 0xee, 0x96, 0xf1, 0x19, 0x87, 0x1d, 0x18, 0xcb, 0x54, 0x01, 0xc3, 0x30, 0x01, 0x69, 0xa6,
+    0xb4, 0x72, 0xb9, 0x14, 0x9d, 0xd1, 0x15, 0x38, 0xd4, 0x03, 0xfc, 0xee, 0x78, 0x11, 0x6c, 0x01,
+    0x8a, 0xef, 0x19, 0x2b, 0x10, 0x41, 0x77, 0x91, 0x0f, 0xf3, 0xaf, 0x1d, 0xd9, 0x70, 0x5e, 0xbb,
+    0x0f, 0xa7, 0x1f, 0x74, 0xb2, 0x0e, 0x1a, 0xf7, 0x0b, 0xc0, 0x41, 0x98, 0xa8, 0x36, 0x10, 0xf4,
+    0xb8, 0x1c, 0x4f, 0x6a, 0x9e, 0x49, 0x92, 0x1c, 0x0f, 0xca, 0x71, 0x34, 0xdc, 0x9f, 0x33, 0x0d,
+    0xa3, 0x4d, 0xf6, 0xf6, 0x76, 0xc2, 0xd4, 0x16, 0xdc, 0x36, 0x43, 0x80, 0xac, 0x6b, 0x35, 0x97,
+    0xa6, 0xf2, 0x71, 0xd7, 0xa5, 0x47, 0xec, 0xc5, 0x26, 0x60, 0xb5, 0xc8, 0x2f, 0x7d, 0x65, 0xf5,
+    0x43, 0x8d, 0x85, 0xfa, 0xa5, 0x84, 0x98, 0xf9, 0x79, 0x41, 0x36, 0x79, 0x3e, 0x2d, 0x70, 0x5a,
+    0x82, 0x6b, 0xd1, 0xe8, 0xb0, 0x56, 0xaf, 0x4f, 0x8b, 0x87, 0xe3, 0x63, 0x70, 0x33, 0x17, 0xf0,
+    0x63, 0xf1, 0x71, 0x3c, 0x99, 0x9c, 0xbf, 0x3d, 0x1e, 0xc0, 0x03, 0xbd, 0xa8, 0x99, 0xe6, 0x45,
+    0xfb, 0x7a, 0xa6, 0x53, 0xbb, 0x2c, 0x31, 0xf0, 0xed, 0xd2, 0xef, 0xda, 0x2c, 0xd6, 0x6f, 0xa7,
+    0xe9, 0x7a, 0x73, 0x80, 0x0c, 0x07, 0x0d, 0xf3, 0xa9, 0x11, 0xcb, 0x6d, 0x4f, 0x52, 0x00, 0xeb,
+    0x58, 0xb8, 0x04, 0x9a, 0xc3, 0x19, 0x0c, 0x82, 0x71, 0xbd, 0xb0, 0x1b, 0x73, 0xfc, 0x90, 0x45,
+    0xcf, 0xc8, 0x24, 0x7b, 0x5f, 0x60, 0x3a, 0xfb, 0x62, 0x1c, 0x41, 0x03, 0xaf, 0xb9, 0x25, 0x30,
+    0x17, 0x08, 0x1c, 0xb9, 0x41, 0x23, 0xf1, 0xa4, 0x83, 0x16, 0x4e, 0xe2, 0x41, 0x26, 0x5e, 0xcf,
+    0x9f, 0x7c, 0x58, 0xb6, 0x0e, 0x7b, 0x92, 0xec, 0xc6, 0x07, 0x89, 0x72, 0xe4, 0x5f, 0xac, 0xe6,
+    0xbf, 0xa4, 0xa3, 0x5a, 0xbe, 0x34, 0x51, 0x6f, 0x6f, 0x66, 0xc7, 0xd3, 0xca, 0x7b, 0x10, 0x6e,
+    0x74, 0x5a, 0xa8, 0xf4, 0x76, 0x74, 0xe8, 0x08, 0xb9, 0xea, 0xf4, 0x8a, 0x3f, 0x44, 0xf7, 0xb9,
+    0xe8, 0x03, 0x20, 0xce, 0xe1, 0x38, 0x60, 0xdc, 0xf1, 0x20, 0x70, 0x18, 0x3f, 0x2e, 0x6e, 0xb0,
+    0x1b, 0x91, 0xd5, 0x56, 0xe6, 0x76, 0x89, 0x29, 0x21, 0xe0, 0x17, 0x93, 0x70, 0x27, 0x31, 0xbe,
+    0xa1, 0x70, 0x91, 0xf7, 0x9e, 0x5c, 0x9e, 0x5a, 0xa4, 0xab, 0x70, 0xa1, 0x59, 0x83, 0xde, 0x86,
+    0x13, 0xd1, 0x6d, 0x0d, 0xfa, 0xec, 0xd3, 0x26, 0x90, 0x1e, 0xbb, 0x43, 0x02, 0xe3, 0x49, 0x85,
+    0x37, 0x07, 0x5c, 0x18, 0x1e, 0x7c, 0x97, 0xc6, 0x6b, 0x80, 0xef, 0xdc, 0xfc, 0xe6, 0xe6, 0x4e,
+    0xde, 0xa7, 0xe4, 0x46, 0xef, 0xbe, 0x22, 0xb2, 0x26, 0x07, 0x20, 0xbf, 0x20, 0x03, 0x9a, 0x44,
+    0xd8, 0xea, 0xd6, 0xd0, 0x3b, 0xce, 0xe7, 0x65, 0x50, 0x8b, 0xd7, 0xf7, 0x22, 0x1b, 0xe4, 0xe0,
+    0xa5, 0xaa, 0xa9, 0xdb, 0x85, 0xa9, 0x0a, 0x01, 0x63, 0x1e, 0xcb, 0x25, 0xdc, 0xa1, 0x1e, 0x1e,
+    0xdf, 0x37, 0x9a, 0x73, 0x7d, 0x5f, 0xa3, 0x7b, 0x16, 0x75, 0xa3, 0x70, 0x79, 0x62, 0xd3, 0x25,
+    0xfd, 0x21, 0xb3, 0x44, 0x01, 0xb4, 0x1c, 0xc4, 0xd3, 0x4c, 0xbf, 0xac, 0xaf, 0x96, 0x34, 0xed,
+    0x23, 0x93, 0xf0, 0x87, 0x11, 0xce, 0x9b, 0x42, 0x66, 0x30, 0xa1, 0x4a, 0x71, 0x04, 0x13, 0x2b,
+    0x9d, 0x6b, 0x3c, 0x8b, 0x9b, 0x74, 0x9d, 0x12, 0xc8, 0x1a, 0x6a, 0xeb, 0x80, 0x3a, 0xc9, 0x7e,
+    0x7f, 0x6f, 0xb0, 0x2f, 0x5f, 0xf6, 0xfe, 0x1b, 0xa2, 0xed, 0x85, 0x1b, 0x57, 0x47, 0x0c, 0xd1,
+    0xff, 0xb9, 0x5f, 0x03, 0x67, 0xf9, 0x12, 0x00, 0x00
+};
+
+const WebAsset WEB_ASSETS[] = {
+    {"/style.css", "text/css", "\"8217c4d76bd21f01\"", ASSET_STYLE_CSS, sizeof(ASSET_STYLE_CSS)},
+    {"/app.js", "application/javascript", "\"b711a3c8f2ac74f1\"", ASSET_APP_JS, sizeof(ASSET_APP_JS)},
+};
+
+const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);
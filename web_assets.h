@@ -0,0 +1,28 @@
+/*
+ * Web Assets Header
+ * Generated by build_web_assets.py from web/; do not edit
+ */
+
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+
+// A gzipped static file kept in flash
+struct WebAsset {
+    const char* path;
+    const char* contentType;
+    const char* etag;             // Quoted, as sent in the ETag header
+    const uint8_t* data;
+    size_t length;
+};
+
+// Versioned URLs for pages to link; the version is the ETag, so a
+// browser may keep what it has under one of them forever
+#define WEB_ASSET_STYLE_CSS "/style.css?v=8217c4d76bd21f01"
+#define WEB_ASSET_APP_JS "/app.js?v=b711a3c8f2ac74f1"
+
+extern const WebAsset WEB_ASSETS[];
+extern const size_t WEB_ASSET_COUNT;
+
+#endif // WEB_ASSETS_H
@@ -4,12 +4,92 @@
  */
 
 #include "web_interface.h"
+#include "scan_task.h"
+#include "wifi_manager.h"
+#include "rtt_estimator.h"
+#include "net_utils.h"
+#include <algorithm>
+#include <Ticker.h>
+
+// Fix for ETH library compatibility across ESP32 board package versions
+#if defined(ARDUINO_ARCH_ESP32) && defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
+  #include "ETH.h"
+#else
+  #include <ETH.h>
+#endif
+
+// Handlers run on the web task and scan events arrive on loop(); whichever
+// reads or changes the scan state holds the lock for the whole of it
+class StateLock {
+public:
+    explicit StateLock(SemaphoreHandle_t lock) {
+        mutex = lock;
+        xSemaphoreTake(mutex, portMAX_DELAY);
+    }
+    
+    ~StateLock() {
+        xSemaphoreGive(mutex);
+    }
+    
+private:
+    SemaphoreHandle_t mutex;
+};
+
+static bool isNumber(const String& text);
+
+// Fields of a result in /api/results; a request picks them with fields=
+enum ResultField : uint16_t {
+    RESULT_FIELD_IP = 1 << 0,
+    RESULT_FIELD_MAC = 1 << 1,
+    RESULT_FIELD_HOSTNAME = 1 << 2,
+    RESULT_FIELD_TCP = 1 << 3,
+    RESULT_FIELD_UDP = 1 << 4,
+    RESULT_FIELD_BACNET = 1 << 5,
+    RESULT_FIELD_MODBUS = 1 << 6,
+    RESULT_FIELD_ENIP = 1 << 7,
+    RESULT_FIELD_FINGERPRINTS = 1 << 8,
+    RESULT_FIELD_RESPONSE_TIME = 1 << 9,
+    RESULT_FIELD_TIMESTAMP = 1 << 10,
+    RESULT_FIELDS_ALL = (1 << 11) - 1,
+    // What a record too big for one chunk is cut back to
+    RESULT_FIELDS_BRIEF = RESULT_FIELD_IP | RESULT_FIELD_MAC | RESULT_FIELD_HOSTNAME | RESULT_FIELD_TCP |
+                          RESULT_FIELD_UDP | RESULT_FIELD_RESPONSE_TIME | RESULT_FIELD_TIMESTAMP
+};
+
+static const struct {
+    const char* name;
+    uint16_t field;
+} RESULT_FIELD_NAMES[] = {
+    {"ip", RESULT_FIELD_IP},
+    {"mac", RESULT_FIELD_MAC},
+    {"hostname", RESULT_FIELD_HOSTNAME},
+    {"tcp", RESULT_FIELD_TCP},
+    {"udp", RESULT_FIELD_UDP},
+    {"bacnet", RESULT_FIELD_BACNET},
+    {"modbus", RESULT_FIELD_MODBUS},
+    {"enip", RESULT_FIELD_ENIP},
+    {"fingerprints", RESULT_FIELD_FINGERPRINTS},
+    {"responseTime", RESULT_FIELD_RESPONSE_TIME},
+    {"timestamp", RESULT_FIELD_TIMESTAMP}
+};
 
 WebInterface::WebInterface() {
-    server = new WebServer(80);
+    server = new HttpServer(WEB_SERVER_PORT);
+    stateLock = xSemaphoreCreateMutex();
     scanRunning = false;
+    scanJobId = 0;
     scanProgress = 0;
     scanStatus = "Ready";
+    wifiUpdatePending = false;
+    wifiUpdateBackup = false;
+    wifiScanWanted = false;
+    wifiScanRunning = false;
+    wifiScanStarted = 0;
+    wifiSnapshot.backupEnabled = false;
+    wifiSnapshot.connected = false;
+    wifiSnapshot.rssi = 0;
+    wifiSnapshot.statusTime = 0;
+    wifiSnapshot.scanTime = 0;
     
     // Initialize default configurations
     networkConfig.useDHCP = true;
@@ -21,7 +101,17 @@ WebInterface::WebInterface() {
     
     scanConfig.startIP = IPAddress(192, 168, 1, 1);
     scanConfig.endIP = IPAddress(192, 168, 1, 254);
-    scanConfig.targetPorts = {80, 443, 502, 47808};
+    scanConfig.targets = "";
+    scanConfig.excludes = "";
+    const ScanProfile& profile = defaultScanProfile();
+    scanConfig.targetPorts.assign(profile.tcpPorts, profile.tcpPorts + profile.tcpCount);
+    scanConfig.udpPorts.assign(profile.udpPorts, profile.udpPorts + profile.udpCount);
+    scanConfig.pacing.probesPerSecond = PACER_PROBES_PER_SECOND;
+    scanConfig.pacing.hostConcurrency = PACER_HOST_CONCURRENCY;
+    scanConfig.pacing.hostGap = PACER_HOST_GAP;
+    scanConfig.scanMethod = PORT_SCAN_CONNECT;
+    scanConfig.modbusUnits.assign(std::begin(MODBUS_UNIT_IDS), std::end(MODBUS_UNIT_IDS));
+    scanConfig.enipDiscovery = true;
     scanConfig.scanTimeout = 3000;
     scanConfig.autoScan = false;
     scanConfig.scanInterval = 300; // 5 minutes
@@ -44,29 +134,37 @@ void WebInterface::begin() {
     loadConfiguration();
     
     // Set up web server routes
-    server->on("/", HTTP_GET, [this]() { handleRoot(); });
-    server->on("/config", HTTP_GET, [this]() { handleConfig(); });
-    server->on("/scan", HTTP_GET, [this]() { handleScan(); });
-    server->on("/results", HTTP_GET, [this]() { handleResults(); });
-    server->on("/download", HTTP_GET, [this]() { handleCSVDownload(); });
-    server->on("/wifi", HTTP_GET, [this]() { handleWiFiConfig(); });
-    server->on("/wifi", HTTP_POST, [this]() { handleWiFiConfig(); });
-    server->on("/wifi-scan", HTTP_GET, [this]() { handleWiFiScan(); });
-    server->on("/api", HTTP_GET, [this]() { handleAPI(); });
-    server->on("/api", HTTP_POST, [this]() { handleAPI(); });
+    server->on("/", HTTP_METHOD_GET, [this]() { handleRoot(); });
+    server->on("/config", HTTP_METHOD_GET, [this]() { handleConfig(); });
+    server->on("/config", HTTP_METHOD_POST, [this]() { handleConfig(); });
+    server->on("/scan", HTTP_METHOD_GET, [this]() { handleScan(); });
+    server->on("/scan", HTTP_METHOD_POST, [this]() { handleScan(); });
+    server->on("/results", HTTP_METHOD_GET, [this]() { handleResults(); });
+    server->on("/download", HTTP_METHOD_GET, [this]() { handleCSVDownload(); });
+    server->on("/wifi", HTTP_METHOD_GET, [this]() { handleWiFiConfig(); });
+    server->on("/wifi", HTTP_METHOD_POST, [this]() { handleWiFiConfig(); });
+    server->on("/wifi-scan", HTTP_METHOD_GET, [this]() { handleWiFiScan(); });
+    server->on("/api", HTTP_METHOD_GET, [this]() { handleAPI(); });
+    server->on("/api", HTTP_METHOD_POST, [this]() { handleAPI(); });
+    server->on("/events", HTTP_METHOD_GET, [this]() { handleEvents(); });
+    server->on("/api/results", HTTP_METHOD_GET, [this]() { handleResultsAPI(); });
     server->onNotFound([this]() { handleNotFound(); });
+    for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+        const WebAsset& asset = WEB_ASSETS[i];
+        server->on(asset.path, HTTP_METHOD_GET, [this, &asset]() { handleAsset(asset); });
+    }
     
     // Start web server
-    server->begin();
-    Serial.println("Web server started on port 80");
+    if (!server->begin()) {
+        Serial.println("Web server unavailable");
+        return;
+    }
+    Serial.printf("Web server started on port %d\n", WEB_SERVER_PORT);
     Serial.printf("Access the interface at: http://%s\n", ETH.localIP().toString().c_str());
 }
 
-void WebInterface::handleClient() {
-    server->handleClient();
-}
-
 void WebInterface::handleRoot() {
+    StateLock lock(stateLock);
     String html = generateHTML("ESP32 Network Discovery", R"(
         <div class="container">
             <h1>ESP32 Network Discovery Tool</h1>
@@ -74,7 +172,7 @@ void WebInterface::handleRoot() {
                 <h3>Current Status</h3>
                 <p><strong>IP Address:</strong> )" + ETH.localIP().toString() + R"(</p>
                 <p><strong>Network Mode:</strong> )" + (networkConfig.useDHCP ? "DHCP" : "Static") + R"(</p>
-                <p><strong>Scan Status:</strong> <span id="scan-status">)" + scanStatus + R"(</span></p>
+                <p><strong>Scan Status:</strong> <span id="scan-status">)" + escapeHTML(scanStatus) + R"(</span></p>
                 <p><strong>Devices Found:</strong> <span id="device-count">)" + String(scanResults.size()) + R"(</span></p>
             </div>
             <div class="nav-buttons">
@@ -85,24 +183,13 @@ void WebInterface::handleRoot() {
                 <a href="/download" class="btn">Download CSV</a>
             </div>
         </div>
-        <script>
-            // Auto-refresh status every 5 seconds
-            setInterval(function() {
-                fetch('/api?action=status')
-                    .then(response => response.json())
-                    .then(data => {
-                        document.getElementById('scan-status').textContent = data.status;
-                        document.getElementById('device-count').textContent = data.deviceCount;
-                    });
-            }, 5000);
-        </script>
     )");
     
     server->send(200, "text/html", html);
 }
 
 void WebInterface::handleConfig() {
-    if (server->method() == HTTP_POST) {
+    if (server->method() == HTTP_METHOD_POST) {
         // Handle configuration update
         networkConfig.useDHCP = server->hasArg("dhcp");
         if (!networkConfig.useDHCP) {
@@ -120,39 +207,84 @@ void WebInterface::handleConfig() {
             "<p>Network configuration updated successfully. The ESP32 will restart to apply changes.</p>"
             "<a href='/'>Return to Home</a>"));
         
-        delay(2000);
-        ESP.restart();
+        // Restart once the page is out; the web task has to keep running
+        // to send it
+        static Ticker restartTimer;
+        restartTimer.once_ms(2000, []() { ESP.restart(); });
     } else {
         server->send(200, "text/html", generateConfigPage());
     }
 }
 
 void WebInterface::handleScan() {
-    if (server->method() == HTTP_POST) {
+    StateLock lock(stateLock);
+    if (server->method() == HTTP_METHOD_POST) {
         // Handle scan configuration and start
+        // The targets are checked before any of them is kept, so a rejected
+        // value never replaces the last good one
+        ScanConfig requested = scanConfig;
         if (server->hasArg("start_ip") && server->hasArg("end_ip")) {
-            scanConfig.startIP = stringToIP(server->arg("start_ip"));
-            scanConfig.endIP = stringToIP(server->arg("end_ip"));
+            requested.startIP = stringToIP(server->arg("start_ip"));
+            requested.endIP = stringToIP(server->arg("end_ip"));
+        }
+        if (server->hasArg("targets")) {
+            requested.targets = server->arg("targets");
+            requested.targets.trim();
+        }
+        if (server->hasArg("excludes")) {
+            requested.excludes = server->arg("excludes");
+            requested.excludes.trim();
+        }
+        
+        TargetIterator targets;
+        if (!getScanTargets(requested, targets)) {
+            server->send(400, "text/html", generateHTML("Invalid Targets", 
+                "<p>" + escapeHTML(targets.getLastError()) + "</p>"
+                "<a href='/scan'>Back</a>"));
+            return;
+        }
+        scanConfig.startIP = requested.startIP;
+        scanConfig.endIP = requested.endIP;
+        scanConfig.targets = requested.targets;
+        scanConfig.excludes = requested.excludes;
+        
+        // Pacing limits; 0 turns a limit off
+        if (server->hasArg("probe_rate")) {
+            scanConfig.pacing.probesPerSecond = constrain(server->arg("probe_rate").toInt(), 0, 100000);
+        }
+        if (server->hasArg("host_concurrency")) {
+            scanConfig.pacing.hostConcurrency = constrain(server->arg("host_concurrency").toInt(), 0, 255);
+        }
+        if (server->hasArg("host_gap")) {
+            scanConfig.pacing.hostGap = constrain(server->arg("host_gap").toInt(), 0, 60000);
+        }
+        
+        // Unchecked boxes are not submitted at all
+        scanConfig.scanMethod = server->hasArg("syn_scan") ? PORT_SCAN_SYN : PORT_SCAN_CONNECT;
+        scanConfig.enipDiscovery = server->hasArg("enip_discovery");
+        
+        if (server->hasArg("modbus_units") && !parseUnitIds(server->arg("modbus_units"), scanConfig.modbusUnits)) {
+            server->send(400, "text/html", generateHTML("Invalid Unit IDs", 
+                "<p>Modbus unit IDs must be numbers or ranges from 0 to 255, e.g. 1-10, 255.</p>"
+                "<a href='/scan'>Back</a>"));
+            return;
         }
         
         if (server->hasArg("ports")) {
-            String portsStr = server->arg("ports");
-            scanConfig.targetPorts.clear();
-            
-            // Parse comma-separated ports
-            int start = 0;
-            int end = portsStr.indexOf(',');
-            while (end != -1) {
-                scanConfig.targetPorts.push_back(portsStr.substring(start, end).toInt());
-                start = end + 1;
-                end = portsStr.indexOf(',', start);
-            }
-            scanConfig.targetPorts.push_back(portsStr.substring(start).toInt());
+            parsePorts(server->arg("ports"), SERVICE_TCP, scanConfig.targetPorts);
+        }
+        if (server->hasArg("udp_ports")) {
+            parsePorts(server->arg("udp_ports"), SERVICE_UDP, scanConfig.udpPorts);
         }
         
-        startScan();
+        if (!startScan()) {
+            server->send(503, "text/html", generateHTML("Scan Queue Full", 
+                "<p>Too many scans are waiting. Try again once the current scan finishes.</p>"
+                "<a href='/scan'>Back</a>"));
+            return;
+        }
         server->send(200, "text/html", generateHTML("Scan Started", 
-            "<p>Network scan started successfully.</p>"
+            "<p>Network scan of " + String(targets.getTargetCount()) + " hosts started successfully.</p>"
             "<a href='/results'>View Results</a> | <a href='/'>Return to Home</a>"));
     } else {
         server->send(200, "text/html", generateScanPage());
@@ -160,32 +292,68 @@ void WebInterface::handleScan() {
 }
 
 void WebInterface::handleResults() {
-    server->send(200, "text/html", generateResultsPage());
+    // Each chunk is written under the lock; results added or cleared in
+    // between show up in (or drop out of) the rest of the page
+    server->sendStream(200, "text/html", [this](ChunkedResponse& out, size_t& cursor) {
+        StateLock lock(stateLock);
+        return writeResultsPage(out, cursor);
+    });
 }
 
 void WebInterface::handleCSVDownload() {
-    String csv = generateCSV();
     server->sendHeader("Content-Disposition", "attachment; filename=network_scan_results.csv");
-    server->send(200, "text/csv", csv);
+    server->sendStream(200, "text/csv", [this](ChunkedResponse& out, size_t& cursor) {
+        StateLock lock(stateLock);
+        return writeCSV(out, cursor);
+    });
 }
 
 void WebInterface::handleAPI() {
+    StateLock lock(stateLock);
     String action = server->arg("action");
     
     if (action == "status") {
         DynamicJsonDocument doc(1024);
-        doc["status"] = scanStatus;
-        doc["progress"] = scanProgress;
-        doc["deviceCount"] = scanResults.size();
-        doc["scanRunning"] = scanRunning;
+        addStatus(doc.to<JsonObject>(), scanStatus);
+        
+        // Per-subnet timeout estimates; per-host detail is under action=rtt
+        JsonObject rtt = doc.createNestedObject("rtt");
+        rtt["hosts"] = rttEstimator.getHostCount();
+        addRttSubnets(rtt);
+        
+        String response;
+        serializeJson(doc, response);
+        server->send(200, "application/json", response);
+    }
+    else if (action == "rtt") {
+        DynamicJsonDocument doc(8192);
+        doc["minTimeout"] = RTT_MIN_TIMEOUT;
+        doc["pingTimeout"] = PING_TIMEOUT;
+        doc["portTimeout"] = PORT_TIMEOUT;
+        addRttSubnets(doc.as<JsonObject>());
+        
+        JsonArray hosts = doc.createNestedArray("hosts");
+        RttStats stats;
+        for (size_t i = 0; rttEstimator.getHostStats(i, stats); i++) {
+            JsonObject host = hosts.createNestedObject();
+            host["ip"] = ipToString(stats.address);
+            host["srtt"] = stats.srtt;
+            host["rttvar"] = stats.rttvar;
+            host["rto"] = stats.rto;
+            host["samples"] = stats.samples;
+            host["backoff"] = stats.backoff;
+        }
         
         String response;
         serializeJson(doc, response);
         server->send(200, "application/json", response);
     }
     else if (action == "start_scan") {
-        startScan();
-        server->send(200, "application/json", "{\"status\":\"started\"}");
+        if (!startScan()) {
+            server->send(503, "application/json", "{\"error\":\"Scan queue full\"}");
+            return;
+        }
+        server->send(200, "application/json", "{\"status\":\"started\",\"job\":" + String(scanJobId) + "}");
     }
     else if (action == "stop_scan") {
         stopScan();
@@ -200,41 +368,421 @@ void WebInterface::handleAPI() {
     }
 }
 
+void WebInterface::handleEvents() {
+    StateLock lock(stateLock);
+    
+    // A page already shows the rows it was served with, so a new stream
+    // starts from the current status
+    if (server->sendEventStream()) {
+        publishStatus();
+    }
+}
+
+void WebInterface::addStatus(JsonObject parent, const String& message) {
+    parent["status"] = message;
+    parent["progress"] = scanProgress;
+    parent["deviceCount"] = scanResults.size();
+    parent["scanRunning"] = scanRunning;
+}
+
+void WebInterface::publishStatus() {
+    if (!server->hasEventClients()) {
+        return;
+    }
+    
+    // Sent as the latest event: a client that is behind skips straight
+    // to the newest status. The slot holds the event line too, so a
+    // status too long for the rest has its message cut short; a cut
+    // serializeJson() would hand the page broken JSON
+    const size_t room = WEB_EVENT_LATEST_SIZE - (sizeof("event: status\ndata: \n\n") - 1);
+    DynamicJsonDocument doc(384);
+    String message = scanStatus;
+    for (;;) {
+        addStatus(doc.to<JsonObject>(), message);
+        size_t length = measureJson(doc);
+        if (!doc.overflowed() && length <= room) {
+            char data[WEB_EVENT_LATEST_SIZE];
+            serializeJson(doc, data, sizeof(data));
+            server->sendLatestEvent("status", data, length);
+            return;
+        }
+        if (message.length() <= 3) {
+            return;
+        }
+        
+        // Every character cut saves at least one byte of JSON; one that
+        // overflowed the document is first cut to what could fit
+        size_t messageLength = message.length();
+        size_t over = doc.overflowed() ? messageLength - std::min(messageLength, room) + 1 : length - room;
+        size_t keep = messageLength > over + 3 ? messageLength - over - 3 : 0;
+        while (keep > 0 && ((uint8_t)message[keep] & 0xC0) == 0x80) {
+            keep--;
+        }
+        message = message.substring(0, keep) + "...";
+    }
+}
+
+void WebInterface::handleResultsAPI() {
+    ResultQuery query;
+    String error;
+    if (!parseResultQuery(query, error)) {
+        // The message can quote the request (a field name): let the
+        // serializer escape it, with room for all of it in the document
+        DynamicJsonDocument doc(JSON_OBJECT_SIZE(1) + error.length() + 1);
+        doc["error"] = error;
+        String response;
+        serializeJson(doc, response);
+        server->send(400, "application/json", response);
+        return;
+    }
+    
+    // Each chunk is written under the lock, as for the results page; the
+    // query travels with the stream and keeps its paging counts
+    server->sendStream(200, "application/json", [this, query](ChunkedResponse& out, size_t& cursor) mutable {
+        StateLock lock(stateLock);
+        return writeResultsJSON(out, cursor, query);
+    });
+}
+
+bool WebInterface::parseResultQuery(ResultQuery& query, String& error) {
+    query.offset = 0;
+    query.limit = WEB_API_RESULTS_LIMIT;
+    query.port = -1;
+    query.tcp = true;
+    query.udp = true;
+    query.network = 0;
+    query.mask = 0;
+    query.hasSince = false;
+    query.since = 0;
+    query.fields = RESULT_FIELDS_ALL;
+    query.total = 0;
+    query.skipped = 0;
+    query.sent = 0;
+    
+    if (server->hasArg("offset")) {
+        String offset = server->arg("offset");
+        if (!isNumber(offset)) {
+            error = "Invalid offset";
+            return false;
+        }
+        query.offset = offset.toInt();
+    }
+    if (server->hasArg("limit")) {
+        String limit = server->arg("limit");
+        if (!isNumber(limit) || limit.toInt() > WEB_API_RESULTS_MAX) {
+            error = "Invalid limit (0-" + String(WEB_API_RESULTS_MAX) + ")";
+            return false;
+        }
+        query.limit = limit.toInt();
+    }
+    if (server->hasArg("port")) {
+        String port = server->arg("port");
+        if (!isNumber(port) || port.toInt() < 1 || port.toInt() > 65535) {
+            error = "Invalid port";
+            return false;
+        }
+        query.port = port.toInt();
+    }
+    if (server->hasArg("protocol")) {
+        String protocol = server->arg("protocol");
+        if (protocol != "tcp" && protocol != "udp") {
+            error = "Invalid protocol (tcp or udp)";
+            return false;
+        }
+        query.tcp = protocol == "tcp";
+        query.udp = protocol == "udp";
+    }
+    if (server->hasArg("ip")) {
+        // An address or a CIDR block
+        String prefix = server->arg("ip");
+        int slash = prefix.indexOf('/');
+        String length = slash >= 0 ? prefix.substring(slash + 1) : String("32");
+        IPAddress address;
+        if (!address.fromString(slash >= 0 ? prefix.substring(0, slash) : prefix) ||
+            !isNumber(length) || length.toInt() > 32) {
+            error = "Invalid ip prefix";
+            return false;
+        }
+        int prefixLength = length.toInt();
+        query.mask = prefixLength == 0 ? 0 : 0xFFFFFFFF << (32 - prefixLength);
+        query.network = ipToHost(address) & query.mask;
+    }
+    if (server->hasArg("since")) {
+        String since = server->arg("since");
+        if (!isNumber(since)) {
+            error = "Invalid since (uptime in ms)";
+            return false;
+        }
+        query.hasSince = true;
+        query.since = strtoul(since.c_str(), nullptr, 10);
+    }
+    if (server->hasArg("fields")) {
+        String fields = server->arg("fields");
+        query.fields = 0;
+        int start = 0;
+        while (start <= (int)fields.length()) {
+            int comma = fields.indexOf(',', start);
+            if (comma < 0) {
+                comma = fields.length();
+            }
+            String name = fields.substring(start, comma);
+            bool known = false;
+            for (const auto& field : RESULT_FIELD_NAMES) {
+                if (name == field.name) {
+                    query.fields |= field.field;
+                    known = true;
+                }
+            }
+            if (!known) {
+                error = "Unknown field: " + name;
+                return false;
+            }
+            start = comma + 1;
+        }
+    }
+    return true;
+}
+
+bool WebInterface::matchesQuery(const ScanResult& result, const ResultQuery& query) {
+    if ((result.host & query.mask) != query.network) {
+        return false;
+    }
+    // millis() wraps after 49 days; the difference still orders the two
+    if (query.hasSince && (int32_t)(result.timestamp - query.since) < 0) {
+        return false;
+    }
+    if (query.port >= 0) {
+        return (query.tcp && result.hasPort(query.port, false, PORT_OPEN)) ||
+               (query.udp && result.hasPort(query.port, true, PORT_OPEN));
+    }
+    if (query.tcp != query.udp) {
+        size_t cursor = 0;
+        uint16_t port;
+        return result.nextPort(cursor, query.udp, PORT_OPEN, port);
+    }
+    return true;
+}
+
+bool WebInterface::writeResultsJSON(ChunkedResponse& out, size_t& cursor, ResultQuery& query) {
+    // Cursor 0 is the envelope and n the nth result, as in writeResultsPage.
+    // Only one record is ever held as a JsonDocument: each is serialized
+    // into the chunk and the document reused for the next
+    if (cursor == 0) {
+        for (const auto& result : scanResults) {
+            if (matchesQuery(result, query)) {
+                query.total++;
+            }
+        }
+        out.printf("{\"uptime\":%lu,\"total\":%u,\"offset\":%u,\"limit\":%u,\"results\":[",
+                   (unsigned long)millis(), (unsigned)query.total, (unsigned)query.offset, (unsigned)query.limit);
+        cursor = 1;
+    }
+    
+    DynamicJsonDocument record(WEB_API_RECORD_SIZE);
+    ChunkedPrint printer(out);
+    for (; cursor <= scanResults.size() && query.sent < query.limit; cursor++) {
+        const ScanResult& result = scanResults[cursor - 1];
+        if (!matchesQuery(result, query)) {
+            continue;
+        }
+        if (query.skipped < query.offset) {
+            query.skipped++;
+            continue;
+        }
+        
+        // A record that does not fit behind others waits for the next
+        // chunk; one too big even for an empty chunk loses its identities
+        // and fingerprints. Only then is it worth measuring
+        record.clear();
+        addResultFields(record.to<JsonObject>(), result, query.fields);
+        if (record.overflowed() || (out.size() == 0 && measureJson(record) + 1 > WEB_SEND_BUFFER_SIZE)) {
+            record.clear();
+            JsonObject brief = record.to<JsonObject>();
+            addResultFields(brief, result, query.fields & RESULT_FIELDS_BRIEF);
+            brief["truncated"] = true;
+        }
+        
+        size_t mark = out.mark();
+        if (query.sent > 0) {
+            out.print(",");
+        }
+        serializeJson(record, printer);
+        if (!out.commit(mark)) {
+            return true;
+        }
+        query.sent++;
+    }
+    
+    size_t mark = out.mark();
+    out.print("]}");
+    return !out.commit(mark);
+}
+
+void WebInterface::addResultFields(JsonObject record, const ScanResult& result, uint16_t fields) {
+    // Strings from the pool and the name tables stay put while the lock is
+    // held, so ArduinoJson keeps pointers to them rather than copies
+    if (fields & RESULT_FIELD_IP) {
+        record["ip"] = ipToString(result.address());
+    }
+    if ((fields & RESULT_FIELD_MAC) && result.hasMac) {
+        record["mac"] = result.macText();
+    }
+    if (fields & RESULT_FIELD_HOSTNAME) {
+        record["hostname"] = result.hostname ? result.hostName() : (const char*)nullptr;
+    }
+    if (fields & RESULT_FIELD_TCP) {
+        addPorts(record.createNestedObject("tcp"), result, false);
+    }
+    if (fields & RESULT_FIELD_UDP) {
+        addPorts(record.createNestedObject("udp"), result, true);
+    }
+    
+    // Protocol identities only for the hosts that gave one
+    if ((fields & RESULT_FIELD_BACNET) && !result.bacnetDevices.empty()) {
+        JsonArray devices = record.createNestedArray("bacnet");
+        for (const auto& device : result.bacnetDevices) {
+            JsonObject entry = devices.createNestedObject();
+            entry["instance"] = device.instance;
+            entry["vendorId"] = device.vendorId;
+            entry["vendor"] = device.vendorName;
+            entry["name"] = device.objectName;
+            entry["model"] = device.modelName;
+            entry["firmware"] = device.firmwareRevision;
+            entry["maxApdu"] = device.maxApdu;
+            if (device.network != 0) {
+                entry["network"] = device.network;
+            }
+        }
+    }
+    if ((fields & RESULT_FIELD_MODBUS) && result.modbus.status != MODBUS_NOT_PROBED) {
+        JsonObject modbus = record.createNestedObject("modbus");
+        modbus["status"] = modbusStatusName(result.modbus.status);
+        JsonArray units = modbus.createNestedArray("units");
+        for (const auto& unit : result.modbus.units) {
+            JsonObject entry = units.createNestedObject();
+            entry["unit"] = unit.unitId;
+            if (unit.exceptionCode != 0) {
+                entry["exception"] = unit.exceptionCode;
+                continue;
+            }
+            entry["vendor"] = unit.vendorName;
+            entry["product"] = unit.productCode;
+            entry["revision"] = unit.revision;
+        }
+    }
+    if ((fields & RESULT_FIELD_ENIP) && !result.enipIdentities.empty()) {
+        JsonArray identities = record.createNestedArray("enip");
+        for (const auto& identity : result.enipIdentities) {
+            JsonObject entry = identities.createNestedObject();
+            entry["vendorId"] = identity.vendorId;
+            entry["deviceType"] = identity.deviceType;
+            entry["productCode"] = identity.productCode;
+            entry["revision"] = String(identity.revisionMajor) + "." + String(identity.revisionMinor);
+            entry["serial"] = identity.serialNumber;
+            entry["productName"] = identity.productName;
+        }
+    }
+    if ((fields & RESULT_FIELD_FINGERPRINTS) && result.fingerprintCount > 0) {
+        JsonArray fingerprints = record.createNestedArray("fingerprints");
+        for (uint8_t i = 0; i < result.fingerprintCount; i++) {
+            JsonObject entry = fingerprints.createNestedObject();
+            entry["port"] = result.fingerprints[i].port;
+            entry["type"] = fingerprintName(result.fingerprints[i].id);
+            entry["detail"] = stringPool.get(result.fingerprints[i].detail);
+        }
+    }
+    
+    if (fields & RESULT_FIELD_RESPONSE_TIME) {
+        record["responseTime"] = result.responseTime;
+    }
+    if (fields & RESULT_FIELD_TIMESTAMP) {
+        record["timestamp"] = result.timestamp;
+    }
+}
+
+void WebInterface::addPorts(JsonObject parent, const ScanResult& result, bool udp) {
+    // One list per state, present only when it has ports
+    static const struct {
+        const char* name;
+        PortState state;
+    } STATES[] = {
+        {"open", PORT_OPEN},
+        {"closed", PORT_CLOSED},
+        {"filtered", PORT_FILTERED},
+        {"unreachable", PORT_UNREACHABLE},
+        {"openFiltered", PORT_OPEN_FILTERED}
+    };
+    
+    for (const auto& group : STATES) {
+        size_t cursor = 0;
+        uint16_t port;
+        if (!result.nextPort(cursor, udp, group.state, port)) {
+            continue;
+        }
+        JsonArray ports = parent.createNestedArray(group.name);
+        do {
+            ports.add(port);
+        } while (result.nextPort(cursor, udp, group.state, port));
+    }
+}
+
+void WebInterface::addRttSubnets(JsonObject parent) {
+    JsonArray subnets = parent.createNestedArray("subnets");
+    RttStats stats;
+    
+    for (size_t i = 0; rttEstimator.getSubnetStats(i, stats); i++) {
+        JsonObject subnet = subnets.createNestedObject();
+        subnet["prefix"] = ipToString(stats.address) + "/" + String(__builtin_popcount(RTT_SUBNET_MASK));
+        subnet["srtt"] = stats.srtt;
+        subnet["rttvar"] = stats.rttvar;
+        subnet["rto"] = stats.rto;
+        subnet["samples"] = stats.samples;
+    }
+}
+
+void WebInterface::handleAsset(const WebAsset& asset) {
+    // The pages link the asset under a URL carrying its ETag, so a cached
+    // copy never goes stale; a revalidation still gets a 304
+    server->sendHeader("Cache-Control", "public, max-age=" + String(WEB_ASSET_MAX_AGE) + ", immutable");
+    server->sendHeader("ETag", asset.etag);
+    if (server->header("If-None-Match").indexOf(asset.etag) >= 0) {
+        server->send(304);
+        return;
+    }
+    
+    // Stored gzipped only; every browser accepts it
+    server->sendHeader("Content-Encoding", "gzip");
+    server->send_P(200, asset.contentType, (const char*)asset.data, asset.length);
+}
+
 void WebInterface::handleNotFound() {
     server->send(404, "text/html", generateHTML("Page Not Found", 
         "<h1>404 - Page Not Found</h1><a href='/'>Return to Home</a>"));
 }
 
-String WebInterface::generateHTML(const String& title, const String& content) {
-    return R"(<!DOCTYPE html>
+// The page shell around every page's content, split so streamed pages
+// can write their rows in between. Styles and scripts are static assets
+// (web/, served by handleAsset); pages only carry their own data
+static const char HTML_PAGE_START[] = R"(<!DOCTYPE html>
 <html>
 <head>
-    <title>)" + title + R"(</title>
+    <title>)";
+
+static const char HTML_PAGE_HEAD[] = R"(</title>
     <meta charset="UTF-8">
     <meta name="viewport" content="width=device-width, initial-scale=1.0">
-    <style>
-        body { font-family: Arial, sans-serif; margin: 20px; background-color: #f5f5f5; }
-        .container { max-width: 800px; margin: 0 auto; background: white; padding: 20px; border-radius: 8px; box-shadow: 0 2px 4px rgba(0,0,0,0.1); }
-        .btn { display: inline-block; padding: 10px 20px; margin: 5px; background: #007bff; color: white; text-decoration: none; border-radius: 4px; border: none; cursor: pointer; }
-        .btn:hover { background: #0056b3; }
-        .status-panel { background: #e9ecef; padding: 15px; border-radius: 4px; margin: 20px 0; }
-        .nav-buttons { text-align: center; margin: 20px 0; }
-        .form-group { margin: 15px 0; }
-        .form-group label { display: block; margin-bottom: 5px; font-weight: bold; }
-        .form-group input, .form-group select { width: 100%; padding: 8px; border: 1px solid #ddd; border-radius: 4px; }
-        .results-table { width: 100%; border-collapse: collapse; margin: 20px 0; }
-        .results-table th, .results-table td { padding: 10px; text-align: left; border-bottom: 1px solid #ddd; }
-        .results-table th { background-color: #f8f9fa; font-weight: bold; }
-        .port-open { color: #28a745; font-weight: bold; }
-        .port-closed { color: #dc3545; }
-        .progress-bar { width: 100%; height: 20px; background: #e9ecef; border-radius: 10px; overflow: hidden; margin: 10px 0; }
-        .progress-fill { height: 100%; background: #007bff; transition: width 0.3s ease; }
-    </style>
+    <link rel="stylesheet" href=")" WEB_ASSET_STYLE_CSS R"(">
+    <script src=")" WEB_ASSET_APP_JS R"(" defer></script>
 </head>
 <body>
-    )" + content + R"(
+    )";
+
+static const char HTML_PAGE_END[] = R"(
 </body>
 </html>)";
+
+String WebInterface::generateHTML(const String& title, const String& content) {
+    return HTML_PAGE_START + title + HTML_PAGE_HEAD + content + HTML_PAGE_END;
 }
 
 String WebInterface::generateConfigPage() {
@@ -247,7 +795,7 @@ String WebInterface::generateConfigPage() {
             <form method="POST">
                 <div class="form-group">
                     <label>
-                        <input type="checkbox" name="dhcp" )" + checked + R"( onchange="toggleStatic()"> Use DHCP
+                        <input type="checkbox" name="dhcp" )" + checked + R"( onchange='toggleStatic()'> Use DHCP
                     </label>
                 </div>
                 <div id="static-config" )" + staticStyle + R"(>
@@ -276,13 +824,6 @@ String WebInterface::generateConfigPage() {
                 <a href="/" class="btn">Cancel</a>
             </form>
         </div>
-        <script>
-            function toggleStatic() {
-                const checkbox = document.querySelector('input[name="dhcp"]');
-                const staticConfig = document.getElementById('static-config');
-                staticConfig.style.display = checkbox.checked ? 'none' : 'block';
-            }
-        </script>
     )");
 }
 
@@ -292,6 +833,15 @@ String WebInterface::generateScanPage() {
         if (i > 0) portsStr += ",";
         portsStr += String(scanConfig.targetPorts[i]);
     }
+    String profileNames = "";
+    for (size_t i = 0; i < SCAN_PROFILE_COUNT; i++) {
+        if (i > 0) profileNames += ", ";
+        profileNames += SCAN_PROFILES[i].name;
+    }
+    String udpPortsStr = joinPorts(scanConfig.udpPorts, ",");
+    String synChecked = scanConfig.scanMethod == PORT_SCAN_SYN ? "checked" : "";
+    String unitIds = joinUnitIds(scanConfig.modbusUnits);
+    String enipChecked = scanConfig.enipDiscovery ? "checked" : "";
     
     return generateHTML("Network Scan", R"(
         <div class="container">
@@ -306,8 +856,46 @@ String WebInterface::generateScanPage() {
                     <input type="text" name="end_ip" value=")" + ipToString(scanConfig.endIP) + R"(">
                 </div>
                 <div class="form-group">
-                    <label>Target Ports (comma-separated):</label>
-                    <input type="text" name="ports" value=")" + portsStr + R"(">
+                    <label>Targets (CIDR blocks or ranges, overrides start/end):</label>
+                    <input type="text" name="targets" placeholder="10.0.0.0/16, 192.168.1.10-192.168.1.50" value=")" + escapeHTML(scanConfig.targets) + R"(">
+                </div>
+                <div class="form-group">
+                    <label>Exclude:</label>
+                    <input type="text" name="excludes" placeholder="10.0.5.0/24, 10.0.0.1" value=")" + escapeHTML(scanConfig.excludes) + R"(">
+                </div>
+                <div class="form-group">
+                    <label>Target Ports (comma-separated ports, service names or a profile: )" + profileNames + R"():</label>
+                    <input type="text" name="ports" placeholder="industrial, 8080, ssh" value=")" + portsStr + R"(">
+                </div>
+                <div class="form-group">
+                    <label>UDP Ports (comma-separated ports, service names or a profile; empty = off):</label>
+                    <input type="text" name="udp_ports" placeholder="161, 1900, 20000" value=")" + udpPortsStr + R"(">
+                </div>
+                <div class="form-group">
+                    <label>Modbus Unit IDs (identified on open 502, empty = off):</label>
+                    <input type="text" name="modbus_units" placeholder="255, 1-32" value=")" + unitIds + R"(">
+                </div>
+                <div class="form-group">
+                    <label>Probe Rate (probes/s, 0 = unlimited):</label>
+                    <input type="number" name="probe_rate" min="0" value=")" + String(scanConfig.pacing.probesPerSecond) + R"(">
+                </div>
+                <div class="form-group">
+                    <label>Max Probes in Flight per Host (0 = unlimited):</label>
+                    <input type="number" name="host_concurrency" min="0" max="255" value=")" + String(scanConfig.pacing.hostConcurrency) + R"(">
+                </div>
+                <div class="form-group">
+                    <label>Minimum Gap per Host (ms):</label>
+                    <input type="number" name="host_gap" min="0" max="60000" value=")" + String(scanConfig.pacing.hostGap) + R"(">
+                </div>
+                <div class="form-group">
+                    <label>
+                        <input type="checkbox" name="syn_scan" )" + synChecked + R"(> Half-open SYN scan (no handshake, no service requests)
+                    </label>
+                </div>
+                <div class="form-group">
+                    <label>
+                        <input type="checkbox" name="enip_discovery" )" + enipChecked + R"(> EtherNet/IP discovery (one ListIdentity broadcast per subnet)
+                    </label>
                 </div>
                 <button type="submit" class="btn">Start Scan</button>
                 <a href="/" class="btn">Cancel</a>
@@ -320,114 +908,191 @@ String WebInterface::generateScanPage() {
                 <p id="progress-text">Scanning...</p>
             </div>
         </div>
-        <script>
-            function updateProgress() {
-                fetch('/api?action=status')
-                    .then(response => response.json())
-                    .then(data => {
-                        if (data.scanRunning) {
-                            document.getElementById('scan-progress').style.display = 'block';
-                            document.getElementById('progress-fill').style.width = data.progress + '%';
-                            document.getElementById('progress-text').textContent = data.status;
-                        } else {
-                            document.getElementById('scan-progress').style.display = 'none';
-                        }
-                    });
-            }
-            setInterval(updateProgress, 1000);
-        </script>
     )");
 }
 
-String WebInterface::generateResultsPage() {
-    String resultsHtml = R"(
+bool WebInterface::writeResultsPage(ChunkedResponse& out, size_t& cursor) {
+    // Cursor 0 is the page head and n the nth row; rows go out whole, as
+    // many per chunk as fit. Same bytes as generateHTML("Scan Results", ...)
+    // would produce
+    if (cursor == 0) {
+        writeResultsHead(out);
+        cursor = 1;
+    }
+    
+    for (; cursor <= scanResults.size(); cursor++) {
+        size_t mark = out.mark();
+        writeResultRow(out, scanResults[cursor - 1]);
+        if (!out.commit(mark)) {
+            return true;
+        }
+    }
+    
+    size_t mark = out.mark();
+    out.print(R"(
+                </tbody>
+            </table>
+        </div>
+    )");
+    out.print(HTML_PAGE_END);
+    return !out.commit(mark);
+}
+
+void WebInterface::writeResultsHead(ChunkedResponse& out) {
+    out.print(HTML_PAGE_START);
+    out.print("Scan Results");
+    out.print(HTML_PAGE_HEAD);
+    out.print(R"(
         <div class="container">
             <h1>Scan Results</h1>
-            <p>Found )" + String(scanResults.size()) + R"( devices</p>
+            <p>Found <span id="device-count">)");
+    out.printf("%u", (unsigned)scanResults.size());
+    out.print(R"(</span> devices</p>
             <div class="nav-buttons">
                 <a href="/download" class="btn">Download CSV</a>
                 <a href="/scan" class="btn">New Scan</a>
-                <button onclick="clearResults()" class="btn">Clear Results</button>
+                <button onclick='clearResults()' class="btn">Clear Results</button>
             </div>
             <table class="results-table">
                 <thead>
                     <tr>
                         <th>IP Address</th>
+                        <th>MAC Address</th>
                         <th>Hostname</th>
                         <th>Open Ports</th>
                         <th>Closed Ports</th>
+                        <th>Filtered Ports</th>
+                        <th>Unreachable Ports</th>
+                        <th>UDP Ports</th>
+                        <th>BACnet</th>
+                        <th>Modbus</th>
+                        <th>EtherNet/IP</th>
+                        <th>Fingerprints</th>
                         <th>Response Time</th>
                         <th>Timestamp</th>
                     </tr>
                 </thead>
-                <tbody>
-    )";
+                <tbody id="result-rows">
+    )");
+}
+
+void WebInterface::writeResultRow(ChunkedResponse& out, const ScanResult& result) {
+    out.print("<tr>");
+    out.print("<td>" + ipToString(result.address()) + "</td>");
+    out.print("<td>" + result.macText() + "</td>");
+    out.printf("<td>%s</td>", result.hostName());
+    out.print("<td class='port-open'>" + joinPorts(result, false, PORT_OPEN, ", ") + "</td>");
+    out.print("<td class='port-closed'>" + joinPorts(result, false, PORT_CLOSED, ", ") + "</td>");
+    out.print("<td class='port-filtered'>" + joinPorts(result, false, PORT_FILTERED, ", ") + "</td>");
+    out.print("<td class='port-unreachable'>" + joinPorts(result, false, PORT_UNREACHABLE, ", ") + "</td>");
+    out.print("<td>" + describeUdpPorts(result, "<br>") + "</td>");
+    out.print("<td>" + describeBacnet(result.bacnetDevices) + "</td>");
+    out.print("<td>" + describeModbus(result.modbus) + "</td>");
+    out.print("<td>" + describeEnip(result.enipIdentities) + "</td>");
+    out.print("<td>" + describeFingerprints(result, "<br>") + "</td>");
+    out.printf("<td>%u ms</td>", (unsigned)result.responseTime);
+    out.print("<td>" + formatTimestamp(result.timestamp) + "</td>");
+    out.print("</tr>");
+}
+
+bool WebInterface::writeCSV(ChunkedResponse& out, size_t& cursor) {
+    // Cursor 0 is the header line and n the nth row, as in writeResultsPage
+    if (cursor == 0) {
+        out.print("IP Address,MAC Address,Hostname,Open Ports,Closed Ports,Filtered Ports,Unreachable Ports,"
+                  "UDP Open Ports,UDP Closed Ports,UDP Open|Filtered Ports,UDP Filtered Ports,"
+                  "BACnet Instances,BACnet Vendor IDs,BACnet Max APDU,BACnet Names,BACnet Vendors,"
+                  "BACnet Models,BACnet Firmware,Modbus,Modbus Units,Modbus Vendors,Modbus Products,"
+                  "Modbus Revisions,ENIP Vendor IDs,ENIP Device Types,ENIP Product Codes,ENIP Revisions,"
+                  "ENIP Serials,ENIP Product Names,Fingerprints,Response Time (ms),Timestamp\n");
+        cursor = 1;
+    }
     
-    for (const auto& result : scanResults) {
-        String openPorts = "";
-        for (size_t i = 0; i < result.openPorts.size(); i++) {
-            if (i > 0) openPorts += ", ";
-            openPorts += String(result.openPorts[i]);
-        }
-        
-        String closedPorts = "";
-        for (size_t i = 0; i < result.closedPorts.size(); i++) {
-            if (i > 0) closedPorts += ", ";
-            closedPorts += String(result.closedPorts[i]);
+    for (; cursor <= scanResults.size(); cursor++) {
+        size_t mark = out.mark();
+        writeCSVRow(out, scanResults[cursor - 1]);
+        if (!out.commit(mark)) {
+            return true;
         }
-        
-        resultsHtml += "<tr>";
-        resultsHtml += "<td>" + ipToString(result.deviceIP) + "</td>";
-        resultsHtml += "<td>" + result.hostname + "</td>";
-        resultsHtml += "<td class='port-open'>" + openPorts + "</td>";
-        resultsHtml += "<td class='port-closed'>" + closedPorts + "</td>";
-        resultsHtml += "<td>" + String(result.responseTime) + " ms</td>";
-        resultsHtml += "<td>" + formatTimestamp(result.timestamp) + "</td>";
-        resultsHtml += "</tr>";
     }
-    
-    resultsHtml += R"(
-                </tbody>
-            </table>
-        </div>
-        <script>
-            function clearResults() {
-                if (confirm('Are you sure you want to clear all results?')) {
-                    fetch('/api?action=clear_results', {method: 'POST'})
-                        .then(() => location.reload());
-                }
-            }
-        </script>
-    )";
-    
-    return generateHTML("Scan Results", resultsHtml);
+    return false;
 }
 
-String WebInterface::generateCSV() {
-    String csv = "IP Address,Hostname,Open Ports,Closed Ports,Response Time (ms),Timestamp\n";
+void WebInterface::writeCSVRow(ChunkedResponse& out, const ScanResult& result) {
+    const struct {
+        bool udp;
+        PortState state;
+    } portColumns[] = {
+        {false, PORT_OPEN}, {false, PORT_CLOSED}, {false, PORT_FILTERED}, {false, PORT_UNREACHABLE},
+        {true, PORT_OPEN}, {true, PORT_CLOSED}, {true, PORT_OPEN_FILTERED}, {true, PORT_FILTERED}
+    };
+    
+    out.print(ipToString(result.address()) + ",");
+    out.print(result.macText() + ",");
+    out.printf("%s,", result.hostName());
+    for (const auto& column : portColumns) {
+        out.print("\"" + joinPorts(result, column.udp, column.state, ";") + "\",");
+    }
     
-    for (const auto& result : scanResults) {
-        String openPorts = "";
-        for (size_t i = 0; i < result.openPorts.size(); i++) {
-            if (i > 0) openPorts += ";";
-            openPorts += String(result.openPorts[i]);
+    // One entry per device; routed devices share their router's row.
+    // Each column lists every device before the next column starts
+    const std::vector<BacnetDevice>& devices = result.bacnetDevices;
+    for (int column = 0; column < 7; column++) {
+        out.print("\"");
+        for (size_t i = 0; i < devices.size(); i++) {
+            const BacnetDevice& device = devices[i];
+            if (i > 0) out.print(";");
+            switch (column) {
+                case 0: out.printf("%lu", (unsigned long)device.instance); break;
+                case 1: out.printf("%u", (unsigned)device.vendorId); break;
+                case 2: out.printf("%lu", (unsigned long)device.maxApdu); break;
+                case 3: out.print(device.objectName); break;
+                case 4: out.print(device.vendorName); break;
+                case 5: out.print(device.modelName); break;
+                default: out.print(device.firmwareRevision); break;
+            }
         }
-        
-        String closedPorts = "";
-        for (size_t i = 0; i < result.closedPorts.size(); i++) {
-            if (i > 0) closedPorts += ";";
-            closedPorts += String(result.closedPorts[i]);
+        out.print("\",");
+    }
+    
+    // One entry per unit that answered; exceptions leave the rest blank
+    const std::vector<ModbusUnit>& units = result.modbus.units;
+    out.printf("%s,", modbusStatusName(result.modbus.status));
+    for (int column = 0; column < 4; column++) {
+        out.print("\"");
+        for (size_t i = 0; i < units.size(); i++) {
+            const ModbusUnit& unit = units[i];
+            if (i > 0) out.print(";");
+            switch (column) {
+                case 0: out.printf("%u", (unsigned)unit.unitId); break;
+                case 1: out.print(unit.vendorName); break;
+                case 2: out.print(unit.productCode); break;
+                default: out.print(unit.revision); break;
+            }
         }
-        
-        csv += ipToString(result.deviceIP) + ",";
-        csv += result.hostname + ",";
-        csv += "\"" + openPorts + "\",";
-        csv += "\"" + closedPorts + "\",";
-        csv += String(result.responseTime) + ",";
-        csv += formatTimestamp(result.timestamp) + "\n";
+        out.print("\",");
+    }
+    
+    const std::vector<EnipIdentity>& identities = result.enipIdentities;
+    for (int column = 0; column < 6; column++) {
+        out.print("\"");
+        for (size_t i = 0; i < identities.size(); i++) {
+            const EnipIdentity& identity = identities[i];
+            if (i > 0) out.print(";");
+            switch (column) {
+                case 0: out.printf("%u", (unsigned)identity.vendorId); break;
+                case 1: out.printf("%u", (unsigned)identity.deviceType); break;
+                case 2: out.printf("%u", (unsigned)identity.productCode); break;
+                case 3: out.printf("%u.%u", (unsigned)identity.revisionMajor, (unsigned)identity.revisionMinor); break;
+                case 4: out.printf("%08X", (unsigned)identity.serialNumber); break;
+                default: out.print(identity.productName); break;
+            }
+        }
+        out.print("\",");
     }
     
-    return csv;
+    out.print("\"" + describeFingerprints(result, ";") + "\",");
+    out.printf("%u,", (unsigned)result.responseTime);
+    out.print(formatTimestamp(result.timestamp) + "\n");
 }
 
 void WebInterface::loadConfiguration() {
@@ -481,24 +1146,119 @@ void WebInterface::saveConfiguration() {
     }
 }
 
-void WebInterface::startScan() {
+bool WebInterface::startScan() {
+    ScanJob* job = new ScanJob();
+    job->source = SCAN_SOURCE_WEB;
+    job->ports = scanConfig.targetPorts;
+    job->udpPorts = scanConfig.udpPorts;
+    job->pacing = scanConfig.pacing;
+    job->scanMethod = scanConfig.scanMethod;
+    job->modbusUnits = scanConfig.modbusUnits;
+    job->enipDiscovery = scanConfig.enipDiscovery;
+    if (!getScanTargets(job->targets)) {
+        scanStatus = "Invalid targets: " + job->targets.getLastError();
+        publishStatus();
+        delete job;
+        return false;
+    }
+    
+    // A new web scan replaces the previous one
+    if (scanRunning) {
+        scanTask.cancel(scanJobId);
+    }
+    
+    uint32_t jobId = scanTask.submit(job);
+    if (jobId == 0) {
+        scanStatus = "Scan queue full";
+        publishStatus();
+        delete job;
+        return false;
+    }
+    
+    scanJobId = jobId;
     scanRunning = true;
     scanProgress = 0;
-    scanStatus = "Starting scan...";
+    scanStatus = "Scan queued...";
     clearScanResults();
+    return true;
 }
 
 void WebInterface::stopScan() {
+    if (scanRunning) {
+        scanTask.cancel(scanJobId);
+    }
     scanRunning = false;
     scanStatus = "Scan stopped";
+    publishStatus();
 }
 
 bool WebInterface::isScanRunning() {
     return scanRunning;
 }
 
+void WebInterface::handleScanEvent(const ScanEvent& event) {
+    StateLock lock(stateLock);
+    
+    // Events from a replaced or stopped job are stale
+    if (event.jobId != scanJobId) {
+        return;
+    }
+    
+    if (event.type == SCAN_EVENT_RESULT) {
+        addScanResult(*event.result);
+        return;
+    }
+    
+    if (!scanRunning) {
+        return;
+    }
+    
+    scanRunning = false;
+    scanProgress = 100;
+    scanStatus = String(event.cancelled ? "Scan cancelled" : "Scan completed") + 
+                 " - found " + String(scanResults.size()) + " devices";
+    publishStatus();
+    
+    Serial.printf("Web scan completed: %u hosts in %lu ms (%.1f hosts/s)\n",
+                  event.progress.total, event.progress.elapsed, event.progress.hostsPerSecond);
+}
+
+void WebInterface::updateScanProgress() {
+    StateLock lock(stateLock);
+    if (!scanRunning) {
+        return;
+    }
+    
+    if (scanTask.getCurrentJob() != scanJobId) {
+        scanStatus = "Waiting for the current scan to finish...";
+        publishStatus();
+        return;
+    }
+    
+    // Counts come from the target iterator and reach 16M on a /8
+    SweepProgress sweep = scanTask.getProgress();
+    if (sweep.total > 0) {
+        scanProgress = (int)(((uint64_t)sweep.completed * 100) / sweep.total);
+        scanStatus = "Scanning... " + String(sweep.completed) + "/" +
+                     String(sweep.total) + " hosts (" +
+                     String(sweep.hostsPerSecond, 1) + " hosts/s)";
+        publishStatus();
+    }
+}
+
 void WebInterface::addScanResult(const ScanResult& result) {
     scanResults.push_back(result);
+    
+    // Results pages append the row. Its id is the row number, so a page
+    // can tell a row it already has from a gap left by a lost event
+    if (server->hasEventClients()) {
+        eventRow.reset(false);
+        writeResultRow(eventRow, result);
+        size_t length;
+        const char* row = eventRow.finish(false, length);
+        server->sendEvent("result", row, length, scanResults.size());
+        publishStatus();
+    }
 }
 
 std::vector<ScanResult> WebInterface::getScanResults() {
@@ -507,10 +1267,19 @@ std::vector<ScanResult> WebInterface::getScanResults() {
 
 void WebInterface::clearScanResults() {
     scanResults.clear();
+    server->sendEvent("clear", "", 0);
+    publishStatus();
+    
+    // A queued or running scan still holds handles in the hosts it has
+    // not reported; the next web scan empties the pool when it starts
+    if (!scanTask.isBusy()) {
+        stringPool.clear();
+    }
 }
 
 void WebInterface::setScanProgress(int progress) {
     scanProgress = progress;
+    publishStatus();
 }
 
 int WebInterface::getScanProgress() {
@@ -519,12 +1288,219 @@ int WebInterface::getScanProgress() {
 
 void WebInterface::setScanStatus(const String& status) {
     scanStatus = status;
+    publishStatus();
 }
 
 String WebInterface::getScanStatus() {
     return scanStatus;
 }
 
+String WebInterface::joinPorts(const std::vector<int>& ports, const char* separator) {
+    String joined = "";
+    for (size_t i = 0; i < ports.size(); i++) {
+        if (i > 0) joined += separator;
+        joined += String(ports[i]);
+    }
+    return joined;
+}
+
+void WebInterface::parsePorts(const String& text, ServiceProtocol protocol, std::vector<int>& ports) {
+    ports.clear();
+    
+    // Comma-separated ports, service names ("ssh") and profile names
+    // ("industrial", adding the profile's ports of this protocol). Empty
+    // entries and repeats are skipped; anything else becomes 0 and is
+    // dropped by the scan task
+    int start = 0;
+    while (start <= (int)text.length()) {
+        int end = text.indexOf(',', start);
+        if (end == -1) {
+            end = text.length();
+        }
+        String entry = text.substring(start, end);
+        entry.trim();
+        start = end + 1;
+        if (entry.length() == 0) {
+            continue;
+        }
+
+        const ScanProfile* profile = findScanProfile(entry.c_str());
+        if (profile) {
+            const uint16_t* profilePorts = protocol == SERVICE_UDP ? profile->udpPorts : profile->tcpPorts;
+            uint8_t count = protocol == SERVICE_UDP ? profile->udpCount : profile->tcpCount;
+            for (uint8_t i = 0; i < count; i++) {
+                if (std::find(ports.begin(), ports.end(), profilePorts[i]) == ports.end()) {
+                    ports.push_back(profilePorts[i]);
+                }
+            }
+            continue;
+        }
+
+        const ServiceEntry* service = findServiceByName(entry.c_str(), protocol);
+        int port = service ? service->port : entry.toInt();
+        if (port == 0 || std::find(ports.begin(), ports.end(), port) == ports.end()) {
+            ports.push_back(port);
+        }
+    }
+}
+
+String WebInterface::describeUdpPorts(const ScanResult& result, const char* separator) {
+    struct {
+        const char* label;
+        PortState state;
+    } groups[] = {
+        {"Open", PORT_OPEN},
+        {"Closed", PORT_CLOSED},
+        {"Open|Filtered", PORT_OPEN_FILTERED},
+        {"Filtered", PORT_FILTERED}
+    };
+    
+    String described = "";
+    for (const auto& group : groups) {
+        String ports = joinPorts(result, true, group.state, ", ");
+        if (ports.length() == 0) {
+            continue;
+        }
+        if (described.length() > 0) described += separator;
+        described += String(group.label) + ": " + ports;
+    }
+    return described;
+}
+
+String WebInterface::joinPorts(const ScanResult& result, bool udp, PortState state, const char* separator) {
+    String joined = "";
+    size_t cursor = 0;
+    uint16_t port;
+    while (result.nextPort(cursor, udp, state, port)) {
+        if (joined.length() > 0) joined += separator;
+        joined += String(port);
+    }
+    return joined;
+}
+
+String WebInterface::describeBacnet(const std::vector<BacnetDevice>& devices) {
+    String described = "";
+    for (size_t i = 0; i < devices.size(); i++) {
+        const BacnetDevice& device = devices[i];
+        if (i > 0) described += "<br>";
+        described += "Device " + String(device.instance);
+        if (device.objectName.length() > 0) {
+            described += " &quot;" + device.objectName + "&quot;";
+        }
+        described += " (vendor " + (device.vendorName.length() > 0 ? device.vendorName : String(device.vendorId)) +
+                     ", APDU " + String(device.maxApdu);
+        if (device.network != 0) {
+            described += ", net " + String(device.network);
+        }
+        described += ")";
+        if (device.modelName.length() > 0 || device.firmwareRevision.length() > 0) {
+            described += "<br>" + device.modelName + " " + device.firmwareRevision;
+        }
+    }
+    return described;
+}
+
+String WebInterface::describeModbus(const ModbusIdentity& modbus) {
+    String described = modbusStatusName(modbus.status);
+    for (const auto& unit : modbus.units) {
+        described += "<br>Unit " + String(unit.unitId) + ": ";
+        if (unit.exceptionCode != 0) {
+            described += "exception " + String(unit.exceptionCode);
+        } else {
+            described += unit.vendorName + " " + unit.productCode + " " + unit.revision;
+        }
+    }
+    return described;
+}
+
+String WebInterface::describeEnip(const std::vector<EnipIdentity>& identities) {
+    String described = "";
+    for (size_t i = 0; i < identities.size(); i++) {
+        const EnipIdentity& identity = identities[i];
+        char serial[9];
+        snprintf(serial, sizeof(serial), "%08X", (unsigned)identity.serialNumber);
+        if (i > 0) described += "<br>";
+        described += "&quot;" + identity.productName + "&quot; (vendor " + String(identity.vendorId) +
+                     ", type " + String(identity.deviceType) + ", product " + String(identity.productCode) +
+                     ", rev " + String(identity.revisionMajor) + "." + String(identity.revisionMinor) +
+                     ", serial " + serial + ")";
+    }
+    return described;
+}
+
+String WebInterface::describeFingerprints(const ScanResult& result, const char* separator) {
+    // Details arrive with quotes and angle brackets already replaced
+    String described = "";
+    for (uint8_t i = 0; i < result.fingerprintCount; i++) {
+        const ResultFingerprint& fingerprint = result.fingerprints[i];
+        if (i > 0) described += separator;
+        described += String(fingerprint.port) + " " + fingerprintName(fingerprint.id) + ": " +
+                     stringPool.get(fingerprint.detail);
+    }
+    return described;
+}
+
+String WebInterface::joinUnitIds(const std::vector<uint8_t>& unitIds) {
+    String joined = "";
+    for (size_t i = 0; i < unitIds.size(); i++) {
+        if (i > 0) joined += ",";
+        joined += String(unitIds[i]);
+    }
+    return joined;
+}
+
+static bool isNumber(const String& text) {
+    if (text.length() == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < text.length(); i++) {
+        if (!isDigit(text.charAt(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool WebInterface::parseUnitIds(const String& text, std::vector<uint8_t>& unitIds) {
+    std::vector<uint8_t> parsed;
+    int start = 0;
+    while (start <= (int)text.length()) {
+        int end = text.indexOf(',', start);
+        if (end < 0) {
+            end = text.length();
+        }
+        String entry = text.substring(start, end);
+        entry.trim();
+        start = end + 1;
+        if (entry.length() == 0) {
+            continue;
+        }
+
+        // A single ID or a first-last range
+        int dash = entry.indexOf('-');
+        String firstText = dash < 0 ? entry : entry.substring(0, dash);
+        String lastText = dash < 0 ? entry : entry.substring(dash + 1);
+        firstText.trim();
+        lastText.trim();
+        if (!isNumber(firstText) || !isNumber(lastText)) {
+            return false;
+        }
+        int first = firstText.toInt();
+        int last = lastText.toInt();
+        if (first > last || last > 255) {
+            return false;
+        }
+        for (int id = first; id <= last; id++) {
+            if (std::find(parsed.begin(), parsed.end(), (uint8_t)id) == parsed.end()) {
+                parsed.push_back((uint8_t)id);
+            }
+        }
+    }
+
+    unitIds = parsed;
+    return true;
+}
+
 String WebInterface::ipToString(IPAddress ip) {
     return ip.toString();
 }
@@ -556,6 +1532,24 @@ String WebInterface::formatTimestamp(unsigned long timestamp) {
            (seconds < 10 ? "0" : "") + String(seconds);
 }
 
+String WebInterface::escapeHTML(const String& text) {
+    // Safe both in element text and inside quoted attributes
+    String escaped;
+    escaped.reserve(text.length());
+    for (unsigned i = 0; i < text.length(); i++) {
+        char c = text[i];
+        switch (c) {
+            case '&': escaped += "&amp;"; break;
+            case '<': escaped += "&lt;"; break;
+            case '>': escaped += "&gt;"; break;
+            case '"': escaped += "&quot;"; break;
+            case '\'': escaped += "&#39;"; break;
+            default: escaped += c; break;
+        }
+    }
+    return escaped;
+}
+
 NetworkConfig WebInterface::getNetworkConfig() {
     return networkConfig;
 }
@@ -568,12 +1562,26 @@ ScanConfig WebInterface::getScanConfig() {
     return scanConfig;
 }
 
+bool WebInterface::getScanTargets(TargetIterator& targets) {
+    return getScanTargets(scanConfig, targets);
+}
+
+bool WebInterface::getScanTargets(const ScanConfig& config, TargetIterator& targets) {
+    // Without a target list the start/end fields describe a single range
+    String includes = config.targets;
+    if (includes.length() == 0) {
+        includes = ipToString(config.startIP) + "-" + ipToString(config.endIP);
+    }
+    
+    return targets.parse(includes, config.excludes);
+}
+
 void WebInterface::setScanConfig(const ScanConfig& config) {
     scanConfig = config;
 }
 
 void WebInterface::handleWiFiConfig() {
-    if (server->method() == HTTP_POST) {
+    if (server->method() == HTTP_METHOD_POST) {
         // Handle WiFi configuration update
         String ssid = server->arg("ssid");
         String password = server->arg("password");
@@ -594,14 +1602,12 @@ void WebInterface::handleWiFiConfig() {
                 creds.dns2 = stringToIP(server->arg("wifi_dns2"));
             }
             
-            // Add network to WiFi manager
-            extern WiFiManager wifiManager;
-            wifiManager.addNetwork(creds);
-            
-            if (enableBackup) {
-                wifiManager.enableBackupMode();
-            } else {
-                wifiManager.disableBackupMode();
+            // loop() adds the network on its next pass (see serviceWiFi)
+            {
+                StateLock lock(stateLock);
+                wifiUpdate = creds;
+                wifiUpdateBackup = enableBackup;
+                wifiUpdatePending = true;
             }
             
             server->send(200, "text/html", generateHTML("WiFi Configuration Updated", 
@@ -615,18 +1621,32 @@ void WebInterface::handleWiFiConfig() {
 
 void WebInterface::handleWiFiScan() {
     extern WiFiManager wifiManager;
-    std::vector<WiFiNetwork> networks = wifiManager.scanNetworks();
-    
     DynamicJsonDocument doc(2048);
-    JsonArray networksArray = doc.createNestedArray("networks");
     
-    for (const auto& network : networks) {
-        JsonObject networkObj = networksArray.createNestedObject();
-        networkObj["ssid"] = network.ssid;
-        networkObj["rssi"] = network.rssi;
-        networkObj["channel"] = network.channel;
-        networkObj["encryption"] = wifiManager.encryptionTypeStr(network.encryption);
-        networkObj["isKnown"] = network.isKnown;
+    {
+        StateLock lock(stateLock);
+        bool fresh = wifiSnapshot.scanTime != 0 &&
+                     millis() - wifiSnapshot.scanTime < WIFI_SCAN_CACHE_AGE;
+        
+        // Scans take seconds: ask loop() for one and let the page poll
+        if (!fresh || wifiScanWanted || wifiScanRunning) {
+            if (!fresh) {
+                wifiScanWanted = true;
+            }
+            doc["scanning"] = true;
+        } else {
+            doc["scanning"] = false;
+            JsonArray networksArray = doc.createNestedArray("networks");
+            
+            for (const auto& network : wifiSnapshot.networks) {
+                JsonObject networkObj = networksArray.createNestedObject();
+                networkObj["ssid"] = network.ssid;
+                networkObj["rssi"] = network.rssi;
+                networkObj["channel"] = network.channel;
+                networkObj["encryption"] = wifiManager.encryptionTypeStr(network.encryption);
+                networkObj["isKnown"] = network.isKnown;
+            }
+        }
     }
     
     String response;
@@ -634,21 +1654,99 @@ void WebInterface::handleWiFiScan() {
     server->send(200, "application/json", response);
 }
 
-String WebInterface::generateWiFiConfigPage() {
+void WebInterface::serviceWiFi() {
     extern WiFiManager wifiManager;
-    std::vector<WiFiCredentials> knownNetworks = wifiManager.getKnownNetworks();
+    bool update = false;
+    bool startScan = false;
+    WiFiCredentials creds;
+    bool enableBackup = false;
+    
+    {
+        StateLock lock(stateLock);
+        if (wifiUpdatePending) {
+            creds = wifiUpdate;
+            enableBackup = wifiUpdateBackup;
+            wifiUpdatePending = false;
+            update = true;
+        }
+        startScan = wifiScanWanted && !wifiScanRunning;
+        wifiScanWanted = false;
+    }
+    
+    if (update) {
+        wifiManager.addNetwork(creds);
+        if (enableBackup) {
+            wifiManager.enableBackupMode();
+        } else {
+            wifiManager.disableBackupMode();
+        }
+    }
+    
+    if (startScan) {
+        if (wifiManager.startNetworkScan()) {
+            StateLock lock(stateLock);
+            wifiScanRunning = true;
+            wifiScanStarted = millis();
+        } else {
+            // Report the failure as an empty scan rather than polling forever
+            StateLock lock(stateLock);
+            wifiSnapshot.networks.clear();
+            wifiSnapshot.scanTime = millis();
+        }
+    }
+    
+    if (wifiScanRunning) {
+        std::vector<WiFiNetwork> networks;
+        bool done = wifiManager.collectNetworkScan(networks);
+        if (!done && millis() - wifiScanStarted >= WIFI_SCAN_TIMEOUT) {
+            wifiManager.cancelNetworkScan();
+            done = true;
+        }
+        
+        if (done) {
+            StateLock lock(stateLock);
+            wifiSnapshot.networks.swap(networks);
+            wifiSnapshot.scanTime = millis();
+            wifiScanRunning = false;
+        }
+    }
+    
+    if (update || wifiSnapshot.statusTime == 0 ||
+        millis() - wifiSnapshot.statusTime >= WIFI_STATUS_REFRESH) {
+        std::vector<WiFiCredentials> knownNetworks = wifiManager.getKnownNetworks();
+        bool backupEnabled = wifiManager.isBackupModeEnabled();
+        bool connected = wifiManager.isConnected();
+        String ssid = wifiManager.getCurrentSSID();
+        int rssi = wifiManager.getRSSI();
+        
+        StateLock lock(stateLock);
+        wifiSnapshot.knownNetworks.swap(knownNetworks);
+        wifiSnapshot.backupEnabled = backupEnabled;
+        wifiSnapshot.connected = connected;
+        wifiSnapshot.ssid = ssid;
+        wifiSnapshot.rssi = rssi;
+        wifiSnapshot.statusTime = millis();
+    }
+}
+
+String WebInterface::generateWiFiConfigPage() {
+    WiFiSnapshot wifi;
+    {
+        StateLock lock(stateLock);
+        wifi = wifiSnapshot;
+    }
     
     String knownNetworksHtml = "";
-    for (const auto& network : knownNetworks) {
+    for (const auto& network : wifi.knownNetworks) {
         knownNetworksHtml += "<tr>";
         knownNetworksHtml += "<td>" + network.ssid + "</td>";
         knownNetworksHtml += "<td>" + String(network.priority) + "</td>";
-        knownNetworksHtml += "<td>" + (network.useStaticIP ? "Static" : "DHCP") + "</td>";
+        knownNetworksHtml += "<td>" + String(network.useStaticIP ? "Static" : "DHCP") + "</td>";
         knownNetworksHtml += "<td><button onclick=\"removeNetwork('" + network.ssid + "')\">Remove</button></td>";
         knownNetworksHtml += "</tr>";
     }
     
-    String backupChecked = wifiManager.isBackupModeEnabled() ? "checked" : "";
+    String backupChecked = wifi.backupEnabled ? "checked" : "";
     
     return generateHTML("WiFi Configuration", R"(
         <div class="container">
@@ -656,9 +1754,9 @@ String WebInterface::generateWiFiConfigPage() {
             
             <div class="status-panel">
                 <h3>Current WiFi Status</h3>
-                <p><strong>Backup Mode:</strong> )" + (wifiManager.isBackupModeEnabled() ? "Enabled" : "Disabled") + R"(</p>
-                <p><strong>Connection:</strong> )" + (wifiManager.isConnected() ? "Connected to " + wifiManager.getCurrentSSID() : "Disconnected") + R"(</p>
-                <p><strong>Signal:</strong> )" + (wifiManager.isConnected() ? String(wifiManager.getRSSI()) + " dBm" : "N/A") + R"(</p>
+                <p><strong>Backup Mode:</strong> )" + String(wifi.backupEnabled ? "Enabled" : "Disabled") + R"(</p>
+                <p><strong>Connection:</strong> )" + (wifi.connected ? "Connected to " + wifi.ssid : "Disconnected") + R"(</p>
+                <p><strong>Signal:</strong> )" + (wifi.connected ? String(wifi.rssi) + " dBm" : "N/A") + R"(</p>
             </div>
             
             <h2>Add New Network</h2>
@@ -666,7 +1764,7 @@ String WebInterface::generateWiFiConfigPage() {
                 <div class="form-group">
                     <label>Network (SSID):</label>
                     <input type="text" name="ssid" required>
-                    <button type="button" onclick="scanNetworks()">Scan Networks</button>
+                    <button type="button" onclick='scanNetworks()'>Scan Networks</button>
                 </div>
                 <div class="form-group">
                     <label>Password:</label>
@@ -683,7 +1781,7 @@ String WebInterface::generateWiFiConfigPage() {
                 </div>
                 <div class="form-group">
                     <label>
-                        <input type="checkbox" name="use_static_ip" onchange="toggleWiFiStatic()"> Use Static IP
+                        <input type="checkbox" name="use_static_ip" onchange='toggleWiFiStatic()'> Use Static IP
                     </label>
                 </div>
                 <div id="wifi-static-config" style="display:none;">
@@ -735,45 +1833,5 @@ String WebInterface::generateWiFiConfigPage() {
                 <div id="network-list"></div>
             </div>
         </div>
-        
-        <script>
-            function toggleWiFiStatic() {
-                const checkbox = document.querySelector('input[name="use_static_ip"]');
-                const staticConfig = document.getElementById('wifi-static-config');
-                staticConfig.style.display = checkbox.checked ? 'block' : 'none';
-            }
-            
-            function scanNetworks() {
-                fetch('/wifi-scan')
-                    .then(response => response.json())
-                    .then(data => {
-                        let html = '<table class="results-table"><thead><tr><th>SSID</th><th>Signal</th><th>Encryption</th><th>Known</th><th>Action</th></tr></thead><tbody>';
-                        data.networks.forEach(network => {
-                            html += '<tr>';
-                            html += '<td>' + network.ssid + '</td>';
-                            html += '<td>' + network.rssi + ' dBm</td>';
-                            html += '<td>' + network.encryption + '</td>';
-                            html += '<td>' + (network.isKnown ? 'Yes' : 'No') + '</td>';
-                            html += '<td><button onclick="selectNetwork(\'' + network.ssid + '\')">Select</button></td>';
-                            html += '</tr>';
-                        });
-                        html += '</tbody></table>';
-                        document.getElementById('network-list').innerHTML = html;
-                        document.getElementById('scan-results').style.display = 'block';
-                    });
-            }
-            
-            function selectNetwork(ssid) {
-                document.querySelector('input[name="ssid"]').value = ssid;
-                document.getElementById('scan-results').style.display = 'none';
-            }
-            
-            function removeNetwork(ssid) {
-                if (confirm('Remove network: ' + ssid + '?')) {
-                    // Implementation for removing network would go here
-                    location.reload();
-                }
-            }
-        </script>
     )");
 }
\ No newline at end of file
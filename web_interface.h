@@ -7,8 +7,9 @@
 #define WEB_INTERFACE_H
 
 #include <Arduino.h>
-#include <WebServer.h>
 #include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 // ESP32 3.2.0 compatibility for filesystem
 #if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
   #include <LittleFS.h>
@@ -20,6 +21,20 @@
 #include <vector>
 #include <IPAddress.h>
 #include "config.h"
+#include "target_iterator.h"
+#include "probe_pacer.h"
+#include "port_scanner.h"
+#include "bacnet_discovery.h"
+#include "modbus_client.h"
+#include "enip_discovery.h"
+#include "fingerprint.h"
+#include "scan_result.h"
+#include "service_catalog.h"
+#include "http_server.h"
+#include "web_assets.h"
+#include "wifi_manager.h"
+
+struct ScanEvent;
 
 struct NetworkConfig {
     bool useDHCP;
@@ -33,20 +48,46 @@ struct NetworkConfig {
 struct ScanConfig {
     IPAddress startIP;
     IPAddress endIP;
+    String targets;           // CIDR/range list; overrides start/end when set
+    String excludes;          // Addresses, ranges or CIDR blocks to skip
     std::vector<int> targetPorts;
+    std::vector<int> udpPorts;          // Probed over UDP on every live host; empty = off
+    PacerSettings pacing;
+    PortScanMethod scanMethod;
+    std::vector<uint8_t> modbusUnits;   // Unit IDs for Modbus identification; empty = off
+    bool enipDiscovery;                 // EtherNet/IP ListIdentity broadcast
     int scanTimeout;
     bool autoScan;
     int scanInterval;
 };
 
-struct ScanResult {
-    IPAddress deviceIP;
-    String hostname;
-    std::vector<int> openPorts;
-    std::vector<int> closedPorts;
-    unsigned long responseTime;
-    unsigned long timestamp;
-    String status;
+// Filters and paging of /api/results, and how far its stream has got
+struct ResultQuery {
+    size_t offset;            // Matching results to skip
+    size_t limit;             // Matching results to send
+    int port;                 // Open port a result must have; -1 = any
+    bool tcp;                 // Protocols the port (or, without one, any open port) may be on
+    bool udp;
+    uint32_t network;         // IP prefix, host order; mask 0 = every address
+    uint32_t mask;
+    bool hasSince;
+    uint32_t since;           // millis(); results found earlier are left out
+    uint16_t fields;          // RESULT_FIELD_* bits
+    size_t total;             // Matching results, counted when the stream starts
+    size_t skipped;
+    size_t sent;
+};
+
+// The WiFi page's view of wifiManager, copied on loop()'s task
+struct WiFiSnapshot {
+    std::vector<WiFiCredentials> knownNetworks;
+    bool backupEnabled;
+    bool connected;
+    String ssid;
+    int rssi;
+    unsigned long statusTime;           // When the fields above were copied
+    std::vector<WiFiNetwork> networks;  // Last scan
+    unsigned long scanTime;             // When it finished; 0 = never
 };
 
 class WebInterface {
@@ -54,12 +95,9 @@ public:
     WebInterface();
     ~WebInterface();
     
-    // Initialize web server
+    // Initialize web server (requests are served on its own task)
     void begin();
     
-    // Handle web server requests
-    void handleClient();
-    
     // Configuration management
     void loadConfiguration();
     void saveConfiguration();
@@ -68,16 +106,25 @@ public:
     ScanConfig getScanConfig();
     void setScanConfig(const ScanConfig& config);
     
-    // Scan management
-    void startScan();
+    // Build the sweep targets from the scan configuration
+    bool getScanTargets(TargetIterator& targets);
+    bool getScanTargets(const ScanConfig& config, TargetIterator& targets);
+    
+    // Scan management (scans run as jobs on the scan task)
+    bool startScan();
     void stopScan();
     bool isScanRunning();
+    void handleScanEvent(const ScanEvent& event);
+    
+    // WiFi changes and scans asked for on the web, run from loop()
+    void serviceWiFi();
+    void updateScanProgress();
     void addScanResult(const ScanResult& result);
     std::vector<ScanResult> getScanResults();
     void clearScanResults();
     
-    // CSV export
-    String generateCSV();
+    // CSV export, streamed row by row (see HttpStreamFiller)
+    bool writeCSV(ChunkedResponse& out, size_t& cursor);
     
     // Status and progress
     void setScanProgress(int progress);
@@ -86,13 +133,25 @@ public:
     String getScanStatus();
     
 private:
-    WebServer* server;
+    HttpServer* server;
+    SemaphoreHandle_t stateLock;        // Scan state: the web task's handlers vs loop()'s events
     NetworkConfig networkConfig;
     ScanConfig scanConfig;
     std::vector<ScanResult> scanResults;
     bool scanRunning;
+    uint32_t scanJobId;
     int scanProgress;
     String scanStatus;
+    ChunkedResponse eventRow;           // A new result's table row, sent as an event
+    
+    // loop() owns wifiManager: handlers queue work here, under stateLock
+    bool wifiUpdatePending;
+    WiFiCredentials wifiUpdate;
+    bool wifiUpdateBackup;
+    bool wifiScanWanted;
+    bool wifiScanRunning;
+    unsigned long wifiScanStarted;
+    WiFiSnapshot wifiSnapshot;
     
     // Web page handlers
     void handleRoot();
@@ -103,7 +162,10 @@ private:
     void handleWiFiConfig();
     void handleWiFiScan();
     void handleAPI();
+    void handleEvents();
+    void handleResultsAPI();
     void handleNotFound();
+    void handleAsset(const WebAsset& asset);
     
     // API endpoints
     void handleGetConfig();
@@ -113,19 +175,44 @@ private:
     void handleGetResults();
     void handleGetStatus();
     void handleClearResults();
+    void addRttSubnets(JsonObject parent);
+    void addStatus(JsonObject parent, const String& message);
+    bool parseResultQuery(ResultQuery& query, String& error);
+    bool matchesQuery(const ScanResult& result, const ResultQuery& query);
+    bool writeResultsJSON(ChunkedResponse& out, size_t& cursor, ResultQuery& query);
+    void addResultFields(JsonObject record, const ScanResult& result, uint16_t fields);
+    void addPorts(JsonObject parent, const ScanResult& result, bool udp);
+    
+    // Live updates for the pages following /events
+    void publishStatus();
     
     // HTML generation
     String generateHTML(const String& title, const String& content);
     String generateConfigPage();
     String generateScanPage();
-    String generateResultsPage();
+    bool writeResultsPage(ChunkedResponse& out, size_t& cursor);
+    void writeResultsHead(ChunkedResponse& out);
+    void writeResultRow(ChunkedResponse& out, const ScanResult& result);
+    void writeCSVRow(ChunkedResponse& out, const ScanResult& result);
+    String generateWiFiConfigPage();
     
     // Utility functions
     String ipToString(IPAddress ip);
+    String joinPorts(const std::vector<int>& ports, const char* separator);
+    String joinPorts(const ScanResult& result, bool udp, PortState state, const char* separator);
+    void parsePorts(const String& text, ServiceProtocol protocol, std::vector<int>& ports);
+    String describeUdpPorts(const ScanResult& result, const char* separator);
+    String describeBacnet(const std::vector<BacnetDevice>& devices);
+    String describeModbus(const ModbusIdentity& modbus);
+    String describeEnip(const std::vector<EnipIdentity>& identities);
+    String describeFingerprints(const ScanResult& result, const char* separator);
+    String joinUnitIds(const std::vector<uint8_t>& unitIds);
+    bool parseUnitIds(const String& text, std::vector<uint8_t>& unitIds);
     IPAddress stringToIP(const String& str);
     void applyNetworkConfig();
     bool validateIPAddress(const String& ip);
     String formatTimestamp(unsigned long timestamp);
+    String escapeHTML(const String& text);
 };
 
 #endif // WEB_INTERFACE_H
\ No newline at end of file
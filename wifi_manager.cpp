@@ -145,17 +145,50 @@ void WiFiManager::stopWiFi() {
 }
 
 std::vector<WiFiNetwork> WiFiManager::scanNetworks() {
-    std::vector<WiFiNetwork> networks;
-    
     Serial.println("Scanning for WiFi networks...");
     
     int networkCount = WiFi.scanNetworks();
     
-    if (networkCount == 0) {
+    if (networkCount <= 0) {
         Serial.println("No networks found");
-        return networks;
+        return std::vector<WiFiNetwork>();
+    }
+    
+    return readScanResults(networkCount);
+}
+
+bool WiFiManager::startNetworkScan() {
+    if (WiFi.scanComplete() == WIFI_SCAN_RUNNING) {
+        return true;
+    }
+    
+    // Drop the results of an earlier scan nobody collected
+    WiFi.scanDelete();
+    return WiFi.scanNetworks(true) == WIFI_SCAN_RUNNING;
+}
+
+bool WiFiManager::collectNetworkScan(std::vector<WiFiNetwork>& networks) {
+    int networkCount = WiFi.scanComplete();
+    if (networkCount == WIFI_SCAN_RUNNING) {
+        return false;
     }
     
+    // A failed scan reports as an empty list
+    networks.clear();
+    if (networkCount > 0) {
+        networks = readScanResults(networkCount);
+    }
+    WiFi.scanDelete();
+    return true;
+}
+
+void WiFiManager::cancelNetworkScan() {
+    WiFi.scanDelete();
+}
+
+std::vector<WiFiNetwork> WiFiManager::readScanResults(int networkCount) {
+    std::vector<WiFiNetwork> networks;
+    
     for (int i = 0; i < networkCount; i++) {
         WiFiNetwork network;
         network.ssid = WiFi.SSID(i);
@@ -74,6 +74,10 @@ public:
     
     // Network scanning
     std::vector<WiFiNetwork> scanNetworks();
+    // Scan without blocking: start it, then poll until collect returns true
+    bool startNetworkScan();
+    bool collectNetworkScan(std::vector<WiFiNetwork>& networks);
+    void cancelNetworkScan();
     std::vector<WiFiCredentials> getKnownNetworks();
     
     // Credential management
@@ -121,6 +125,7 @@ private:
     void sortNetworksByPriority();
     WiFiCredentials* findKnownNetwork(const String& ssid);
     bool isNetworkInRange(const String& ssid);
+    std::vector<WiFiNetwork> readScanResults(int networkCount);
     
     // Configuration file management
     bool saveToFile();